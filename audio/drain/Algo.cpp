@@ -6,24 +6,50 @@
 #include <audio/drain/Algo.hpp>
 #include <etk/Function.hpp>
 #include "debug.hpp"
+#include <atomic>
+
+static std::atomic<uint32_t> g_nameRevision(0); //!< Number of call of setName (all the algos)
+
+uint32_t audio::drain::Algo::getNameRevision() {
+	return g_nameRevision.load(std::memory_order_acquire);
+}
+
+void audio::drain::Algo::nameChanged() {
+	g_nameRevision.fetch_add(1, std::memory_order_release);
+}
 
 audio::drain::Algo::Algo() :
+  m_dotLabelValid(false),
   m_temporary(false),
+  m_statusQueue(null),
   m_outputData(),
+  m_outputBuffer(null),
+  m_outputBufferSize(0),
   m_formatSize(0),
-  m_needProcess(false) {
-	
+  m_inputSilence(false),
+  m_outputSilence(false),
+  m_processBufferNbChunk(4096),
+  m_needProcess(false),
+  m_configurationDepth(0),
+  m_configurationPending(false) {
+	for (size_t iii=0; iii<audio::drain::status_count; ++iii) {
+		m_statusPending[iii].store(0);
+		m_statusPosted[iii] = false;
+	}
 }
 
 void audio::drain::Algo::init() {
 	// set notification callback :
 	m_input.setCallback([=](){audio::drain::Algo::configurationChangeLocal();});
 	m_output.setCallback([=](){audio::drain::Algo::configurationChangeLocal();});
+	// the planar buffers must be explicitly supported by the algo
+	m_supportedLayout.pushBack(audio::drain::layout_interleaved);
 	// first configure ==> update the internal parameters
 	configurationChange();
 }
 
 void audio::drain::Algo::configurationChange() {
+	m_dotLabelValid = false;
 	m_needProcess = false;
 	if (m_input.getFormat() != m_output.getFormat()) {
 		m_needProcess = true;
@@ -34,10 +60,14 @@ void audio::drain::Algo::configurationChange() {
 	if (m_input.getFrequency() != m_output.getFrequency()) {
 		m_needProcess = true;
 	}
+	if (m_input.getLayout() != m_output.getLayout()) {
+		m_needProcess = true;
+	}
 	switch (m_output.getFormat()) {
 		case audio::format_int8:
 			m_formatSize = sizeof(int8_t);
 			break;
+		case audio::format_int8_on_int16:
 		case audio::format_int16:
 			m_formatSize = sizeof(int16_t);
 			break;
@@ -49,6 +79,10 @@ void audio::drain::Algo::configurationChange() {
 		case audio::format_float:
 			m_formatSize = sizeof(float);
 			break;
+		case audio::format_int32_on_int64:
+		case audio::format_int64:
+			m_formatSize = sizeof(int64_t);
+			break;
 		case audio::format_double:
 			m_formatSize = sizeof(double);
 			break;
@@ -73,6 +107,152 @@ etk::String audio::drain::Algo::getDotDesc() {
 	return out;
 }
 
+const etk::String& audio::drain::Algo::getDotLabel() {
+	if (m_dotLabelValid == true) {
+		return m_dotLabel;
+	}
+	m_dotLabel = "ALGO\\ntype='" + m_type + "'";
+	if (m_name != "") {
+		m_dotLabel += "\\nname='" + m_name + "'";
+	}
+	m_dotLabel += getDotDesc();
+	m_dotLabelValid = true;
+	return m_dotLabel;
+}
+
+static void appendKey(audio::drain::NegotiationHash& _hash, float _value) {
+	uint32_t valueBit = 0;
+	memcpy(&valueBit, &_value, sizeof(uint32_t));
+	_hash.add(valueBit);
+}
+
+void audio::drain::Algo::appendSupportedKey(audio::drain::NegotiationHash& _hash) const {
+	appendFormatSupportedKey(_hash);
+	appendFrequencySupportedKey(_hash);
+	appendMapSupportedKey(_hash);
+	appendLayoutSupportedKey(_hash);
+}
+
+void audio::drain::Algo::appendFormatSupportedKey(audio::drain::NegotiationHash& _hash) const {
+	// a configured side give a list of one element
+	const audio::drain::IOFormatInterface* side[2] = {&m_output, &m_input};
+	for (size_t iii=0; iii<2; ++iii) {
+		if (side[iii]->getConfigured() == true) {
+			_hash.add(1);
+			_hash.add(uint32_t(side[iii]->getFormat()));
+			continue;
+		}
+		_hash.add(m_supportedFormat.size());
+		for (size_t jjj=0; jjj<m_supportedFormat.size(); ++jjj) {
+			_hash.add(uint32_t(m_supportedFormat[jjj]));
+		}
+	}
+}
+
+void audio::drain::Algo::appendFrequencySupportedKey(audio::drain::NegotiationHash& _hash) const {
+	const audio::drain::IOFormatInterface* side[2] = {&m_output, &m_input};
+	for (size_t iii=0; iii<2; ++iii) {
+		if (side[iii]->getConfigured() == true) {
+			_hash.add(1);
+			appendKey(_hash, side[iii]->getFrequency());
+			continue;
+		}
+		_hash.add(m_supportedFrequency.size());
+		for (size_t jjj=0; jjj<m_supportedFrequency.size(); ++jjj) {
+			appendKey(_hash, m_supportedFrequency[jjj]);
+		}
+	}
+}
+
+void audio::drain::Algo::appendMapSupportedKey(audio::drain::NegotiationHash& _hash) const {
+	const audio::drain::IOFormatInterface* side[2] = {&m_output, &m_input};
+	for (size_t iii=0; iii<2; ++iii) {
+		if (side[iii]->getConfigured() == true) {
+			const etk::Vector<audio::channel>& map = side[iii]->getMap();
+			_hash.add(1);
+			_hash.add(map.size());
+			for (size_t kkk=0; kkk<map.size(); ++kkk) {
+				_hash.add(uint32_t(map[kkk]));
+			}
+			continue;
+		}
+		_hash.add(m_supportedMap.size());
+		for (size_t jjj=0; jjj<m_supportedMap.size(); ++jjj) {
+			_hash.add(m_supportedMap[jjj].size());
+			for (size_t kkk=0; kkk<m_supportedMap[jjj].size(); ++kkk) {
+				_hash.add(uint32_t(m_supportedMap[jjj][kkk]));
+			}
+		}
+	}
+}
+
+void audio::drain::Algo::appendLayoutSupportedKey(audio::drain::NegotiationHash& _hash) const {
+	const audio::drain::IOFormatInterface* side[2] = {&m_output, &m_input};
+	for (size_t iii=0; iii<2; ++iii) {
+		if (side[iii]->getConfigured() == true) {
+			_hash.add(1);
+			_hash.add(uint32_t(side[iii]->getLayout()));
+			continue;
+		}
+		_hash.add(m_supportedLayout.size());
+		for (size_t jjj=0; jjj<m_supportedLayout.size(); ++jjj) {
+			_hash.add(uint32_t(m_supportedLayout[jjj]));
+		}
+	}
+}
+
+void* audio::drain::Algo::getOutputBuffer(size_t _nbChunk) {
+	size_t size = _nbChunk*m_output.getMap().size()*m_formatSize;
+	if (    m_outputBuffer != null
+	     && m_outputBufferSize >= size) {
+		return m_outputBuffer;
+	}
+	// No buffer from the Process (or too small) ==> use the internal one (only grow: no allocation in the steady state)
+	m_outputData.reserve(size);
+	return m_outputData.data();
+}
+
+void* audio::drain::Algo::getSilenceBuffer(void* _input, size_t _nbChunk) {
+	m_outputSilence = true;
+	if (m_input.getChunkSize() == m_output.getChunkSize()) {
+		// 0 is the silence of all the formats ==> the input is the output
+		return _input;
+	}
+	void* output = getOutputBuffer(_nbChunk);
+	memset(output, 0, _nbChunk*m_output.getChunkSize());
+	return output;
+}
+
+bool audio::drain::isSilence(const void* _data, size_t _size) {
+	const uint8_t* data = static_cast<const uint8_t*>(_data);
+	// the head until the 8 bytes alignment
+	while (    _size > 0
+	        && (reinterpret_cast<uintptr_t>(data) & 7) != 0) {
+		if (*data != 0) {
+			return false;
+		}
+		++data;
+		--_size;
+	}
+	// blocks of 64 bytes: a single test by block (vectorized by the compiler)
+	const uint64_t* block = reinterpret_cast<const uint64_t*>(data);
+	while (_size >= 64) {
+		uint64_t value = block[0] | block[1] | block[2] | block[3] | block[4] | block[5] | block[6] | block[7];
+		if (value != 0) {
+			return false;
+		}
+		block += 8;
+		_size -= 64;
+	}
+	data = reinterpret_cast<const uint8_t*>(block);
+	for (size_t iii=0; iii<_size; ++iii) {
+		if (data[iii] != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
 size_t audio::drain::Algo::needInputData(size_t _output) {
 	size_t input = _output;
 	/* NOT good at all ...
@@ -116,6 +296,37 @@ void audio::drain::Algo::setStatusFunction(algoStatusFunction _newFunction) {
 	m_statusFunction = _newFunction;
 }
 
+void audio::drain::Algo::generateStatus(enum audio::drain::status _status) {
+	if (    m_statusQueue == null
+	     || m_statusQueue->getEnable() == false) {
+		generateStatus(etk::String(audio::drain::getStatusName(_status)));
+		return;
+	}
+	m_statusPending[_status].fetch_add(1, std::memory_order_relaxed);
+	echrono::Steady now = echrono::Steady::now();
+	if (    m_statusPosted[_status] == true
+	     && now - m_statusLastPost[_status] < m_statusQueue->getMinInterval()) {
+		// coalesced with the next post (or taken by the reader)
+		return;
+	}
+	audio::drain::StatusEvent event;
+	event.m_status = _status;
+	event.m_origin = this;
+	event.m_count = takeStatusPending(_status);
+	event.m_time = audio::Time::now();
+	if (event.m_count == 0) {
+		// already taken by the reader
+		return;
+	}
+	if (m_statusQueue->post(event) == false) {
+		// full queue: keep the occurences for the next post
+		m_statusPending[_status].fetch_add(event.m_count, std::memory_order_relaxed);
+		return;
+	}
+	m_statusLastPost[_status] = now;
+	m_statusPosted[_status] = true;
+}
+
 void audio::drain::Algo::generateStatus(const etk::String& _status) {
 	if (m_statusFunction != null) {
 		if (m_name.size() == 0) {
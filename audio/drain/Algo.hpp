@@ -14,6 +14,8 @@
 #include <ememory/memory.hpp>
 #include "AutoLogInOut.hpp"
 #include "IOFormatInterface.hpp"
+#include "AlignedBuffer.hpp"
+#include "StatusQueue.hpp"
 #include <audio/Time.hpp>
 #include <audio/Duration.hpp>
 #include "debug.hpp"
@@ -27,6 +29,38 @@ namespace audio {
 	 */
 	namespace drain{
 		typedef etk::Function<void (const etk::String& _origin, const etk::String& _status)> algoStatusFunction;
+		/**
+		 * @brief Check if a buffer contain only 0 (silence in all the formats).
+		 * @param[in] _data Pointer on the data.
+		 * @param[in] _size Size in byte.
+		 * @return true All the bytes are 0.
+		 */
+		bool isSilence(const void* _data, size_t _size);
+		/**
+		 * @brief Full scale of the int16 samples in float (-1.0 <==> INT16_MIN): the same in all the conversions (FormatUpdate, Volume).
+		 */
+		constexpr float int16FullScale = 32768.0f;
+		/**
+		 * @brief Hash of the values used by the negotiation (FNV-1a on 64 bits, @see Process::getNegotiationKey).
+		 */
+		class NegotiationHash {
+			public:
+				uint64_t m_value; //!< Current hash
+				NegotiationHash() :
+				  m_value(14695981039346656037ULL) {
+					
+				}
+				/**
+				 * @brief Add a value in the hash.
+				 * @param[in] _value Value to add.
+				 */
+				void add(uint32_t _value) {
+					for (size_t iii=0; iii<4; ++iii) {
+						m_value ^= (_value >> (iii*8)) & 0xFF;
+						m_value *= 1099511628211ULL;
+					}
+				}
+		};
 		class Algo : public ememory::EnableSharedFromThis<Algo> {
 			private:
 				etk::String m_name;
@@ -36,7 +70,19 @@ namespace audio {
 				}
 				void setName(const etk::String& _name) {
 					m_name = _name;
+					m_dotLabelValid = false;
+					nameChanged();
 				}
+				/**
+				 * @brief Get the number of change of the name of all the algos (a Process rebuild its index of the names when it changed).
+				 * @return Revision of the names.
+				 */
+				static uint32_t getNameRevision();
+			private:
+				/**
+				 * @brief Increment the revision of the names.
+				 */
+				static void nameChanged();
 			protected:
 				etk::String m_type;
 			public:
@@ -45,9 +91,25 @@ namespace audio {
 				}
 				void setType(const etk::String& _type) {
 					m_type = _type;
+					m_dotLabelValid = false;
 				}
 			public:
 				virtual etk::String getDotDesc();
+			private:
+				etk::String m_dotLabel; //!< Static part of the label of the algo in a graph (type, name and getDotDesc())
+				bool m_dotLabelValid; //!< m_dotLabel is up to date
+			public:
+				/**
+				 * @brief Get the static part of the label of the algo in the graph (rebuild only after a change).
+				 * @return Label in the dot format.
+				 */
+				const etk::String& getDotLabel();
+				/**
+				 * @brief Request a new build of the label at the next graph export (a value used by getDotDesc() changed).
+				 */
+				void invalidateDotLabel() {
+					m_dotLabelValid = false;
+				}
 			private:
 				bool m_temporary;
 			public:
@@ -59,13 +121,134 @@ namespace audio {
 				}
 			private:
 				algoStatusFunction m_statusFunction;
+				audio::drain::StatusQueue* m_statusQueue; //!< Queue of the Process (null if none)
+				std::atomic<uint32_t> m_statusPending[audio::drain::status_count]; //!< Occurences not posted yet (coalesced)
+				echrono::Steady m_statusLastPost[audio::drain::status_count]; //!< Time of the last post of each status
+				bool m_statusPosted[audio::drain::status_count]; //!< The status has already been posted (m_statusLastPost is valid)
 			public:
 				void setStatusFunction(algoStatusFunction _newFunction);
+				/**
+				 * @brief Set the queue where the status are posted when it is enable (set by the Process).
+				 * @param[in] _queue Queue (null to always call the status function).
+				 */
+				void setStatusQueue(audio::drain::StatusQueue* _queue) {
+					m_statusQueue = _queue;
+				}
+				/**
+				 * @brief Get and reset the occurences of a status not posted yet (reader of the queue).
+				 * @param[in] _status Status.
+				 * @return Number of occurence.
+				 */
+				uint32_t takeStatusPending(enum audio::drain::status _status) {
+					return m_statusPending[_status].exchange(0, std::memory_order_acq_rel);
+				}
 			protected:
 				void generateStatus(const etk::String& _status);
+				/**
+				 * @brief Generate a status from the audio thread: posted in the queue of the Process when enable (no
+				 * allocation, coalesced by the minimum interval of the queue), given to the status function otherwise.
+				 * @param[in] _status Status.
+				 */
+				void generateStatus(enum audio::drain::status _status);
 			protected:
-				etk::Vector<int8_t> m_outputData;
+				audio::drain::AlignedBuffer m_outputData; //!< Internal output buffer, aligned on 64 bytes (used when no buffer is provided by the Process)
+				int8_t* m_outputBuffer; //!< Output buffer provided by the Process for the next process call (null if none)
+				size_t m_outputBufferSize; //!< Size in byte of the buffer provided by the Process
 				int8_t m_formatSize; //!< sample size
+			public:
+				/**
+				 * @brief Set the buffer where the next process call can write its output (provided by the Process).
+				 * @param[in] _data Pointer on the buffer (null to use the internal buffer).
+				 * @param[in] _size Size of the buffer in byte.
+				 */
+				void setOutputBuffer(void* _data, size_t _size) {
+					m_outputBuffer = static_cast<int8_t*>(_data);
+					m_outputBufferSize = _size;
+				}
+				/**
+				 * @brief Check if the algo can write its output in its input buffer.
+				 * @return true The output can be the same buffer as the input.
+				 */
+				virtual bool canProcessInPlace() const {
+					return false;
+				}
+				/**
+				 * @brief Check if the process call only forward the input buffer (nothing to do with the current configuration).
+				 * @note The Process does not call the pass-through algos.
+				 * @return true The output is always the input.
+				 */
+				virtual bool isPassThrough() const {
+					return false;
+				}
+			protected:
+				bool m_inputSilence; //!< The input of the current process call contain only 0 (set by the Process)
+				bool m_outputSilence; //!< The output of the last process call contain only 0 (set by the algo)
+			public:
+				/**
+				 * @brief Set the silence state of the input of the next process call (clear the output state).
+				 * @param[in] _value true if all the input samples are 0.
+				 */
+				void setInputSilence(bool _value) {
+					m_inputSilence = _value;
+					m_outputSilence = false;
+				}
+				/**
+				 * @brief Check if the last process call generate only 0 (the next algos can skip their kernels).
+				 * @return true The output is silent.
+				 */
+				bool getOutputSilence() const {
+					return m_outputSilence;
+				}
+			protected:
+				/**
+				 * @brief Get an output full of silence for a silent input (no processing).
+				 * @param[in] _input Input data (already silent: used as output when the chunk size does not change).
+				 * @param[in] _nbChunk Number of chunk.
+				 * @return The output buffer.
+				 */
+				void* getSilenceBuffer(void* _input, size_t _nbChunk);
+			protected:
+				/**
+				 * @brief Get the buffer to write the output data of the current process call.
+				 * @param[in] _nbChunk Number of chunk that will be written.
+				 * @return The buffer provided by the Process if it is big enough, the internal buffer otherwise.
+				 */
+				void* getOutputBuffer(size_t _nbChunk);
+			protected:
+				size_t m_processBufferNbChunk; //!< Maximum number of input chunk of a process call without allocation (set by the Process)
+			public:
+				/**
+				 * @brief Set the maximum number of input chunk of a process call (control thread, default 4096).
+				 * The internal buffers of the algo are allocated here: the process calls up to this size do not allocate.
+				 * @param[in] _nbChunk Number of input chunk.
+				 */
+				void setProcessBufferSize(size_t _nbChunk) {
+					if (_nbChunk == m_processBufferNbChunk) {
+						return;
+					}
+					m_processBufferNbChunk = _nbChunk;
+					processBufferSizeChange();
+				}
+				/**
+				 * @brief Get the maximum number of input chunk of a process call without allocation.
+				 * @return Number of chunk.
+				 */
+				size_t getProcessBufferSize() const {
+					return m_processBufferNbChunk;
+				}
+				/**
+				 * @brief Allocate the internal output buffer (used when the buffer of the Process is too small) out of the audio thread.
+				 * @param[in] _nbChunk Number of output chunk.
+				 */
+				void reserveOutputBuffer(size_t _nbChunk) {
+					m_outputData.reserve(_nbChunk*m_output.getChunkSize());
+				}
+			protected:
+				/**
+				 * @brief Called when the maximum size of a process call change: resize the internal buffers (keep the state of the algo).
+				 */
+				virtual void processBufferSizeChange() {}
+			protected:
 				/**
 				 * @brief Constructor
 				 */
@@ -81,7 +264,7 @@ namespace audio {
 				IOFormatInterface m_input; //!< Input audio property
 			public:
 				void setInputFormat(const IOFormatInterface& _format) {
-					m_input.set(_format.getMap(), _format.getFormat(), _format.getFrequency());
+					m_input.set(_format.getMap(), _format.getFormat(), _format.getFrequency(), _format.getLayout());
 				}
 				const IOFormatInterface& getInputFormat() const {
 					return m_input;
@@ -93,7 +276,7 @@ namespace audio {
 				IOFormatInterface m_output; //!< Output audio property
 			public:
 				void setOutputFormat(const IOFormatInterface& _format) {
-					m_output.set(_format.getMap(), _format.getFormat(), _format.getFrequency());
+					m_output.set(_format.getMap(), _format.getFormat(), _format.getFrequency(), _format.getLayout());
 				}
 				const IOFormatInterface& getOutputFormat() const {
 					return m_output;
@@ -101,13 +284,52 @@ namespace audio {
 				IOFormatInterface& getOutputFormat() {
 					return m_output;
 				}
+				/**
+				 * @brief Set the input and the output format with a single update of the algo.
+				 * @param[in] _input New input format.
+				 * @param[in] _output New output format.
+				 */
+				void setFormat(const IOFormatInterface& _input, const IOFormatInterface& _output) {
+					beginConfiguration();
+					setInputFormat(_input);
+					setOutputFormat(_output);
+					endConfiguration();
+				}
 			private:
+				int32_t m_configurationDepth; //!< Number of beginConfiguration() not closed
+				bool m_configurationPending; //!< A format changed during the configuration
 				void configurationChangeLocal() {
+					if (m_configurationDepth > 0) {
+						m_configurationPending = true;
+						return;
+					}
 					if (    m_output.getConfigured() == true
 					     && m_output.getConfigured() == true) {
 						configurationChange();
 					}
 				}
+			public:
+				/**
+				 * @brief Start a group of format changes: configurationChange() is deferred to the last endConfiguration()
+				 * (the negotiation of a process change the formats many times before having the final ones).
+				 */
+				void beginConfiguration() {
+					m_configurationDepth++;
+				}
+				/**
+				 * @brief End a group of format changes: call configurationChange() once if a format changed.
+				 */
+				void endConfiguration() {
+					if (m_configurationDepth <= 0) {
+						return;
+					}
+					m_configurationDepth--;
+					if (    m_configurationDepth == 0
+					     && m_configurationPending == true) {
+						m_configurationPending = false;
+						configurationChangeLocal();
+					}
+				}
 			public:
 				/**
 				 * @brief Called when a parameter change
@@ -136,6 +358,13 @@ namespace audio {
 				 */
 				// TODO : Manage the change of the timestamp ...
 				virtual size_t needInputData(size_t _output);
+				/**
+				 * @brief Get the delay added by the algo between its input and its output.
+				 * @return Duration of the data kept inside the algo (0 for the algos without memory).
+				 */
+				virtual audio::Duration getLatency() const {
+					return audio::Duration(0);
+				}
 			protected: // note when nothing ==> support all type
 				etk::Vector<audio::format> m_supportedFormat;
 			public:
@@ -193,6 +422,52 @@ namespace audio {
 					}
 					return m_supportedFrequency;
 				};
+			protected: // note when nothing ==> support all type
+				etk::Vector<enum audio::drain::layout> m_supportedLayout; //!< interleaved only by default (set in init)
+			public:
+				virtual etk::Vector<enum audio::drain::layout> getLayoutSupportedInput() {
+					if (m_output.getConfigured() == true) {
+						etk::Vector<enum audio::drain::layout> out;
+						out.pushBack(m_output.getLayout());
+						return out;
+					}
+					return m_supportedLayout;
+				};
+				virtual etk::Vector<enum audio::drain::layout> getLayoutSupportedOutput() {
+					if (m_input.getConfigured() == true) {
+						etk::Vector<enum audio::drain::layout> out;
+						out.pushBack(m_input.getLayout());
+						return out;
+					}
+					return m_supportedLayout;
+				};
+				/**
+				 * @brief Add the supported lists of the algo in the key of the negotiation cache (same values as the getXxxSupportedXxx functions, hashed in place without their copies).
+				 * @note An algo that overloads one of these functions overloads this one too.
+				 * @param[in,out] _hash Hash of the key.
+				 */
+				virtual void appendSupportedKey(audio::drain::NegotiationHash& _hash) const;
+			protected:
+				/**
+				 * @brief Add the result of getFormatSupportedInput and getFormatSupportedOutput in a hash.
+				 * @param[in,out] _hash Hash of the key.
+				 */
+				void appendFormatSupportedKey(audio::drain::NegotiationHash& _hash) const;
+				/**
+				 * @brief Add the result of getFrequencySupportedInput and getFrequencySupportedOutput in a hash.
+				 * @param[in,out] _hash Hash of the key.
+				 */
+				void appendFrequencySupportedKey(audio::drain::NegotiationHash& _hash) const;
+				/**
+				 * @brief Add the result of getMapSupportedInput and getMapSupportedOutput in a hash.
+				 * @param[in,out] _hash Hash of the key.
+				 */
+				void appendMapSupportedKey(audio::drain::NegotiationHash& _hash) const;
+				/**
+				 * @brief Add the result of getLayoutSupportedInput and getLayoutSupportedOutput in a hash.
+				 * @param[in,out] _hash Hash of the key.
+				 */
+				void appendLayoutSupportedKey(audio::drain::NegotiationHash& _hash) const;
 			public:
 				/**
 				 * @brief Set a parameter in the stream flow
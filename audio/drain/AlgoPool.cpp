@@ -0,0 +1,93 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <audio/drain/AlgoPool.hpp>
+#include <audio/drain/FormatUpdate.hpp>
+#include <audio/drain/ChannelReorder.hpp>
+#include <audio/drain/Resampler.hpp>
+#include <audio/drain/debug.hpp>
+
+audio::drain::AlgoPool::AlgoPool() :
+  m_maxSize(32) {
+	
+}
+
+ememory::SharedPtr<audio::drain::AlgoPool> audio::drain::AlgoPool::create() {
+	return ememory::SharedPtr<audio::drain::AlgoPool>(ETK_NEW(audio::drain::AlgoPool));
+}
+
+audio::drain::AlgoPool::~AlgoPool() {
+	clear();
+}
+
+ememory::SharedPtr<audio::drain::Algo> audio::drain::AlgoPool::createAlgo(const etk::String& _type) {
+	ememory::SharedPtr<audio::drain::Algo> algo;
+	if (_type == "FormatUpdate") {
+		algo = audio::drain::FormatUpdate::create();
+	} else if (_type == "ChannelReorder") {
+		algo = audio::drain::ChannelReorder::create();
+	} else if (_type == "Resampler") {
+		algo = audio::drain::Resampler::create();
+	} else {
+		DRAIN_ERROR("Can not create temporary algo '" << _type << "'");
+		return algo;
+	}
+	algo->setTemporary();
+	return algo;
+}
+
+ememory::SharedPtr<audio::drain::Algo> audio::drain::AlgoPool::get(const etk::String& _type) {
+	{
+		ethread::UniqueLock lock(m_lock);
+		for (size_t iii=m_list.size(); iii>0; --iii) {
+			if (m_list[iii-1]->getType() == _type) {
+				ememory::SharedPtr<audio::drain::Algo> algo = m_list[iii-1];
+				m_list.erase(m_list.begin()+iii-1);
+				DRAIN_VERBOSE("Reuse temporary algo '" << _type << "'");
+				return algo;
+			}
+		}
+	}
+	return createAlgo(_type);
+}
+
+void audio::drain::AlgoPool::release(const ememory::SharedPtr<audio::drain::Algo>& _algo) {
+	if (    _algo == null
+	     || _algo->getTemporary() == false) {
+		return;
+	}
+	// the resampler keep the history of the previous stream ==> never reused
+	if (    _algo->getType() != "FormatUpdate"
+	     && _algo->getType() != "ChannelReorder") {
+		return;
+	}
+	// the status callback reference the previous Process
+	_algo->setStatusFunction(null);
+	ethread::UniqueLock lock(m_lock);
+	if (m_list.size() >= m_maxSize) {
+		return;
+	}
+	m_list.pushBack(_algo);
+}
+
+void audio::drain::AlgoPool::clear() {
+	ethread::UniqueLock lock(m_lock);
+	m_list.clear();
+}
+
+size_t audio::drain::AlgoPool::size() {
+	ethread::UniqueLock lock(m_lock);
+	return m_list.size();
+}
+
+void audio::drain::AlgoPool::setMaxSize(size_t _value) {
+	ethread::UniqueLock lock(m_lock);
+	m_maxSize = _value;
+	while (m_list.size() > m_maxSize) {
+		m_list.popBack();
+	}
+}
+
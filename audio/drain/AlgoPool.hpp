@@ -0,0 +1,74 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/String.hpp>
+#include <etk/Vector.hpp>
+#include <ememory/memory.hpp>
+#include <ethread/Mutex.hpp>
+#include <audio/drain/Algo.hpp>
+
+namespace audio {
+	namespace drain{
+		/**
+		 * @brief Pool of temporary algos (FormatUpdate and ChannelReorder) that can be reused by the next chains.
+		 * The temporary algos of a Process are given back to the pool when they are removed of the chain,
+		 * the next negotiation reuse them with their already allocated buffers and format lists.
+		 * @note Share one pool between the Process created by the same thread to avoid the contention on the allocator.
+		 */
+		class AlgoPool {
+			protected:
+				ethread::Mutex m_lock; //!< A pool can be shared by several Process
+				etk::Vector<ememory::SharedPtr<audio::drain::Algo> > m_list; //!< Algos ready to be reused
+				size_t m_maxSize; //!< Maximum number of algo kept
+			protected:
+				AlgoPool();
+			public:
+				static ememory::SharedPtr<audio::drain::AlgoPool> create();
+				virtual ~AlgoPool();
+			public:
+				/**
+				 * @brief Get a temporary algo of the pool, or create a new one.
+				 * @param[in] _type Type of the algo ("FormatUpdate" or "ChannelReorder").
+				 * @return The algo (null if the type can not be created).
+				 */
+				ememory::SharedPtr<audio::drain::Algo> get(const etk::String& _type);
+				/**
+				 * @brief Give back an algo that is not used anymore.
+				 * @param[in] _algo Temporary algo removed of its chain (the other algos are ignored).
+				 */
+				void release(const ememory::SharedPtr<audio::drain::Algo>& _algo);
+				/**
+				 * @brief Free all the algos of the pool.
+				 */
+				void clear();
+				/**
+				 * @brief Get the number of algo ready to be reused.
+				 * @return Number of algo.
+				 */
+				size_t size();
+				/**
+				 * @brief Set the maximum number of algo kept (default 32).
+				 * @param[in] _value Number of algo.
+				 */
+				void setMaxSize(size_t _value);
+				/**
+				 * @brief Get the maximum number of algo kept.
+				 * @return Number of algo.
+				 */
+				size_t getMaxSize() const {
+					return m_maxSize;
+				}
+				/**
+				 * @brief Create a temporary algo without pool.
+				 * @param[in] _type Type of the algo ("FormatUpdate", "ChannelReorder" or "Resampler").
+				 * @return The algo (null if the type is unknown).
+				 */
+				static ememory::SharedPtr<audio::drain::Algo> createAlgo(const etk::String& _type);
+		};
+	}
+}
+
@@ -0,0 +1,69 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <audio/drain/AlignedBuffer.hpp>
+#include <audio/drain/debug.hpp>
+
+//! The capacity is a multiple of this size (a period that change of a few samples does not reallocate)
+static const size_t g_capacityStep = 1024;
+
+audio::drain::AlignedBuffer::AlignedBuffer() :
+  m_data(null),
+  m_size(0),
+  m_capacity(0) {
+	
+}
+
+audio::drain::AlignedBuffer::AlignedBuffer(const audio::drain::AlignedBuffer& _obj) :
+  m_data(null),
+  m_size(0),
+  m_capacity(0) {
+	*this = _obj;
+}
+
+audio::drain::AlignedBuffer& audio::drain::AlignedBuffer::operator=(const audio::drain::AlignedBuffer& _obj) {
+	if (this == &_obj) {
+		return *this;
+	}
+	// the memory can not be copied: the alignment offset depend on the new allocation
+	m_size = 0;
+	resize(_obj.m_size);
+	if (m_size != 0) {
+		memcpy(m_data, _obj.m_data, m_size);
+	}
+	return *this;
+}
+
+audio::drain::AlignedBuffer::~AlignedBuffer() {
+	m_data = null;
+	m_size = 0;
+	m_capacity = 0;
+}
+
+void audio::drain::AlignedBuffer::reserve(size_t _size) {
+	if (_size <= m_capacity) {
+		return;
+	}
+	size_t capacity = ((_size + g_capacityStep - 1) / g_capacityStep) * g_capacityStep;
+	etk::Vector<uint8_t> memory;
+	memory.resize(capacity + audio::drain::bufferAlignment - 1, 0);
+	uintptr_t address = reinterpret_cast<uintptr_t>(&memory[0]);
+	size_t offset = (audio::drain::bufferAlignment - address % audio::drain::bufferAlignment) % audio::drain::bufferAlignment;
+	uint8_t* data = &memory[0] + offset;
+	if (m_size != 0) {
+		memcpy(data, m_data, m_size);
+	}
+	DRAIN_VERBOSE("Aligned buffer: " << m_capacity << " -> " << capacity << " bytes");
+	m_memory.swap(memory);
+	m_data = data;
+	m_capacity = capacity;
+}
+
+void audio::drain::AlignedBuffer::resize(size_t _size) {
+	reserve(_size);
+	m_size = _size;
+}
+
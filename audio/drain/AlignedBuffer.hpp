@@ -0,0 +1,83 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <etk/Vector.hpp>
+
+namespace audio {
+	namespace drain {
+		/**
+		 * @brief Alignment of the audio buffers (one cache line, enough for the AVX-512 aligned load).
+		 */
+		static const size_t bufferAlignment = 64;
+		/**
+		 * @brief Buffer of byte aligned on @ref bufferAlignment.
+		 * The capacity only grow (a smaller resize never free the memory) and it is rounded up to avoid
+		 * a new allocation when the size of the period change of a few samples.
+		 */
+		class AlignedBuffer {
+			protected:
+				etk::Vector<uint8_t> m_memory; //!< Allocated memory (m_data is inside)
+				uint8_t* m_data; //!< First aligned byte of m_memory (null when no memory)
+				size_t m_size; //!< Current size in byte
+				size_t m_capacity; //!< Usable size in byte from m_data
+			public:
+				AlignedBuffer();
+				AlignedBuffer(const AlignedBuffer& _obj);
+				AlignedBuffer& operator=(const AlignedBuffer& _obj);
+				~AlignedBuffer();
+			public:
+				/**
+				 * @brief Change the size of the buffer (the data before the new size are kept).
+				 * @param[in] _size New size in byte.
+				 */
+				void resize(size_t _size);
+				/**
+				 * @brief Allocate memory for a future size (never reduce the capacity).
+				 * @param[in] _size Size in byte.
+				 */
+				void reserve(size_t _size);
+				/**
+				 * @brief Set the size at 0 (the memory is kept).
+				 */
+				void clear() {
+					m_size = 0;
+				}
+				/**
+				 * @brief Get the current size.
+				 * @return Size in byte.
+				 */
+				size_t size() const {
+					return m_size;
+				}
+				/**
+				 * @brief Get the allocated size.
+				 * @return Size in byte that can be used without allocation.
+				 */
+				size_t capacity() const {
+					return m_capacity;
+				}
+				/**
+				 * @brief Get the aligned data.
+				 * @return Pointer on the first byte (null if no memory is allocated).
+				 */
+				uint8_t* data() {
+					return m_data;
+				}
+				const uint8_t* data() const {
+					return m_data;
+				}
+				uint8_t& operator[](size_t _pos) {
+					return m_data[_pos];
+				}
+				const uint8_t& operator[](size_t _pos) const {
+					return m_data[_pos];
+				}
+		};
+	}
+}
+
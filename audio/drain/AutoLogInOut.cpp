@@ -7,11 +7,13 @@
 #include "AutoLogInOut.hpp"
 #include "debug.hpp"
 
-audio::drain::AutoLogInOut::AutoLogInOut(const etk::String& _value) :
-  m_value(_value) {
-	DRAIN_VERBOSE("                 '" << m_value << "' [START]");
-}
-
-audio::drain::AutoLogInOut::~AutoLogInOut() {
-	DRAIN_VERBOSE("                 '" << m_value << "' [STOP]");
-}
+#ifdef DEBUG
+	audio::drain::AutoLogInOut::AutoLogInOut(const char* _value) :
+	  m_value(_value) {
+		DRAIN_VERBOSE("                 '" << m_value << "' [START]");
+	}
+	
+	audio::drain::AutoLogInOut::~AutoLogInOut() {
+		DRAIN_VERBOSE("                 '" << m_value << "' [STOP]");
+	}
+#endif
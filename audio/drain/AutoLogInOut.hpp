@@ -5,17 +5,27 @@
  */
 #pragma once
 
-#include <etk/String.hpp>
+#include <etk/types.hpp>
 #include "debug.hpp"
 
 namespace audio {
 	namespace drain{
+		/**
+		 * @brief Scoped trace of a function ([START] / [STOP] in verbose).
+		 * @note Only store a pointer on the (static) name: no allocation. Everything is removed in release build.
+		 */
 		class AutoLogInOut {
-			private:
-				etk::String m_value;
-			public:
-				AutoLogInOut(const etk::String& _value);
-				~AutoLogInOut();
+			#ifdef DEBUG
+				private:
+					const char* m_value;
+				public:
+					AutoLogInOut(const char* _value);
+					~AutoLogInOut();
+			#else
+				public:
+					AutoLogInOut(const char* _value) {}
+					~AutoLogInOut() {}
+			#endif
 		};
 	}
 }
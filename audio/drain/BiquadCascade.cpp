@@ -0,0 +1,543 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <audio/drain/BiquadCascade.hpp>
+#include <audio/drain/cpu.hpp>
+#include <audio/drain/debug.hpp>
+#include <math.h>
+#include <atomic>
+
+//! Number of point of the theoric response
+static const size_t g_theoryNbPoint = 512;
+//! Number of frame with the same coefficients during a transition
+static const size_t g_interpolationBlock = 32;
+//! Last version given to a bank
+static std::atomic<uint64_t> g_bankVersion(0);
+
+audio::drain::Biquad::Biquad() {
+	setBiquadCoef(1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+void audio::drain::Biquad::setBiquadCoef(float _a0, float _a1, float _a2, float _b0, float _b1) {
+	m_a[0] = _a0;
+	m_a[1] = _a1;
+	m_a[2] = _a2;
+	m_b[0] = _b0;
+	m_b[1] = _b1;
+}
+
+void audio::drain::Biquad::setBiquad(enum audio::algo::drain::biQuadType _type, double _frequencyCut, double _qualityFactor, double _gain, float _sampleRate) {
+	if (    _sampleRate <= 0.0f
+	     || _qualityFactor <= 0.0
+	     || _frequencyCut <= 0.0) {
+		if (_type != audio::algo::drain::biQuadType_none) {
+			DRAIN_ERROR("Can not compute the biquad: frequency=" << _frequencyCut << " quality=" << _qualityFactor << " sampleRate=" << _sampleRate);
+		}
+		setBiquadCoef(1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+		return;
+	}
+	double norm;
+	double V = pow(10.0, fabs(_gain) / 20.0);
+	double K = tan(M_PI * _frequencyCut / _sampleRate);
+	double KK = K * K;
+	double a0 = 1.0;
+	double a1 = 0.0;
+	double a2 = 0.0;
+	double b0 = 0.0;
+	double b1 = 0.0;
+	switch (_type) {
+		case audio::algo::drain::biQuadType_none:
+			break;
+		case audio::algo::drain::biQuadType_lowPass:
+			norm = 1.0 / (1.0 + K / _qualityFactor + KK);
+			a0 = KK * norm;
+			a1 = 2.0 * a0;
+			a2 = a0;
+			b0 = 2.0 * (KK - 1.0) * norm;
+			b1 = (1.0 - K / _qualityFactor + KK) * norm;
+			break;
+		case audio::algo::drain::biQuadType_highPass:
+			norm = 1.0 / (1.0 + K / _qualityFactor + KK);
+			a0 = norm;
+			a1 = -2.0 * a0;
+			a2 = a0;
+			b0 = 2.0 * (KK - 1.0) * norm;
+			b1 = (1.0 - K / _qualityFactor + KK) * norm;
+			break;
+		case audio::algo::drain::biQuadType_bandPass:
+			norm = 1.0 / (1.0 + K / _qualityFactor + KK);
+			a0 = K / _qualityFactor * norm;
+			a1 = 0.0;
+			a2 = -a0;
+			b0 = 2.0 * (KK - 1.0) * norm;
+			b1 = (1.0 - K / _qualityFactor + KK) * norm;
+			break;
+		case audio::algo::drain::biQuadType_notch:
+			norm = 1.0 / (1.0 + K / _qualityFactor + KK);
+			a0 = (1.0 + KK) * norm;
+			a1 = 2.0 * (KK - 1.0) * norm;
+			a2 = a0;
+			b0 = a1;
+			b1 = (1.0 - K / _qualityFactor + KK) * norm;
+			break;
+		case audio::algo::drain::biQuadType_peak:
+			if (_gain >= 0.0) {
+				norm = 1.0 / (1.0 + 1.0/_qualityFactor * K + KK);
+				a0 = (1.0 + V/_qualityFactor * K + KK) * norm;
+				a1 = 2.0 * (KK - 1.0) * norm;
+				a2 = (1.0 - V/_qualityFactor * K + KK) * norm;
+				b0 = a1;
+				b1 = (1.0 - 1.0/_qualityFactor * K + KK) * norm;
+			} else {
+				norm = 1.0 / (1.0 + V/_qualityFactor * K + KK);
+				a0 = (1.0 + 1.0/_qualityFactor * K + KK) * norm;
+				a1 = 2.0 * (KK - 1.0) * norm;
+				a2 = (1.0 - 1.0/_qualityFactor * K + KK) * norm;
+				b0 = a1;
+				b1 = (1.0 - V/_qualityFactor * K + KK) * norm;
+			}
+			break;
+		case audio::algo::drain::biQuadType_lowShelf:
+			if (_gain >= 0.0) {
+				norm = 1.0 / (1.0 + M_SQRT2 * K + KK);
+				a0 = (1.0 + sqrt(2.0*V) * K + V * KK) * norm;
+				a1 = 2.0 * (V * KK - 1.0) * norm;
+				a2 = (1.0 - sqrt(2.0*V) * K + V * KK) * norm;
+				b0 = 2.0 * (KK - 1.0) * norm;
+				b1 = (1.0 - M_SQRT2 * K + KK) * norm;
+			} else {
+				norm = 1.0 / (1.0 + sqrt(2.0*V) * K + V * KK);
+				a0 = (1.0 + M_SQRT2 * K + KK) * norm;
+				a1 = 2.0 * (KK - 1.0) * norm;
+				a2 = (1.0 - M_SQRT2 * K + KK) * norm;
+				b0 = 2.0 * (V * KK - 1.0) * norm;
+				b1 = (1.0 - sqrt(2.0*V) * K + V * KK) * norm;
+			}
+			break;
+		case audio::algo::drain::biQuadType_highShelf:
+			if (_gain >= 0.0) {
+				norm = 1.0 / (1.0 + M_SQRT2 * K + KK);
+				a0 = (V + sqrt(2.0*V) * K + KK) * norm;
+				a1 = 2.0 * (KK - V) * norm;
+				a2 = (V - sqrt(2.0*V) * K + KK) * norm;
+				b0 = 2.0 * (KK - 1.0) * norm;
+				b1 = (1.0 - M_SQRT2 * K + KK) * norm;
+			} else {
+				norm = 1.0 / (V + sqrt(2.0*V) * K + KK);
+				a0 = (1.0 + M_SQRT2 * K + KK) * norm;
+				a1 = 2.0 * (KK - 1.0) * norm;
+				a2 = (1.0 - M_SQRT2 * K + KK) * norm;
+				b0 = 2.0 * (KK - V) * norm;
+				b1 = (V - sqrt(2.0*V) * K + KK) * norm;
+			}
+			break;
+	}
+	setBiquadCoef(a0, a1, a2, b0, b1);
+}
+
+float audio::drain::Biquad::getResponse(double _frequency, float _sampleRate) const {
+	// H(z) = (a0 + a1.z^-1 + a2.z^-2) / (1 + b0.z^-1 + b1.z^-2) with z = e^(jw)
+	double w = 2.0 * M_PI * _frequency / _sampleRate;
+	double numReal = m_a[0] + m_a[1]*cos(w) + m_a[2]*cos(2.0*w);
+	double numImag = -m_a[1]*sin(w) - m_a[2]*sin(2.0*w);
+	double denReal = 1.0 + m_b[0]*cos(w) + m_b[1]*cos(2.0*w);
+	double denImag = -m_b[0]*sin(w) - m_b[1]*sin(2.0*w);
+	double num = numReal*numReal + numImag*numImag;
+	double den = denReal*denReal + denImag*denImag;
+	if (    num <= 0.0
+	     || den <= 0.0) {
+		return -200.0f;
+	}
+	return 10.0 * log10(num / den);
+}
+
+audio::drain::BiquadBank::BiquadBank() :
+  m_nbChannel(0),
+  m_nbStage(0),
+  m_nbLane(0),
+  m_version(0) {
+
+}
+
+void audio::drain::BiquadBank::init(size_t _nbChannel, size_t _nbStage) {
+	m_nbChannel = _nbChannel;
+	m_nbStage = _nbStage;
+	m_nbLane = ((_nbChannel + 7) / 8) * 8;
+	m_version = ++g_bankVersion;
+	m_biquad.clear();
+	m_biquad.resize(m_nbChannel*m_nbStage);
+	m_coefficient.resize(m_nbStage*5*m_nbLane*sizeof(float));
+	float* coefficient = reinterpret_cast<float*>(m_coefficient.data());
+	for (size_t iii=0; iii<m_nbStage*5*m_nbLane; ++iii) {
+		coefficient[iii] = 0.0f;
+	}
+	// pass-through: a0 = 1
+	for (size_t iii=0; iii<m_nbStage; ++iii) {
+		for (size_t jjj=0; jjj<m_nbLane; ++jjj) {
+			coefficient[iii*5*m_nbLane + jjj] = 1.0f;
+		}
+	}
+}
+
+void audio::drain::BiquadBank::setBiquad(size_t _stage, size_t _channel, const audio::drain::Biquad& _biquad) {
+	if (    _stage >= m_nbStage
+	     || _channel >= m_nbChannel) {
+		DRAIN_ERROR("Biquad out of the cascade: stage=" << _stage << "/" << m_nbStage << " channel=" << _channel << "/" << m_nbChannel);
+		return;
+	}
+	m_biquad[_stage*m_nbChannel + _channel] = _biquad;
+	m_version = ++g_bankVersion;
+	float* coefficient = reinterpret_cast<float*>(m_coefficient.data()) + _stage*5*m_nbLane + _channel;
+	coefficient[0] = _biquad.m_a[0];
+	coefficient[m_nbLane] = _biquad.m_a[1];
+	coefficient[2*m_nbLane] = _biquad.m_a[2];
+	coefficient[3*m_nbLane] = _biquad.m_b[0];
+	coefficient[4*m_nbLane] = _biquad.m_b[1];
+}
+
+etk::Vector<etk::Pair<float,float> > audio::drain::BiquadBank::calculateTheory(float _sampleRate, size_t _channel) const {
+	etk::Vector<etk::Pair<float,float> > out;
+	if (_channel >= m_nbChannel) {
+		return out;
+	}
+	for (size_t iii=1; iii<g_theoryNbPoint; ++iii) {
+		double frequency = double(iii) / double(g_theoryNbPoint - 1) * _sampleRate / 2.0;
+		float gain = 0.0f;
+		for (size_t jjj=0; jjj<m_nbStage; ++jjj) {
+			gain += getBiquad(jjj, _channel).getResponse(frequency, _sampleRate);
+		}
+		out.pushBack(etk::makePair<float, float>(float(frequency), gain));
+	}
+	return out;
+}
+
+/**
+ * @brief Generic kernel: one channel at a time.
+ */
+static void processStage(const float* _coefficient, float* _state, float* _data, size_t _nbFrame, size_t _nbChannel, size_t _nbLane, size_t _firstChannel) {
+	for (size_t ccc=_firstChannel; ccc<_nbChannel; ++ccc) {
+		const float a0 = _coefficient[ccc];
+		const float a1 = _coefficient[_nbLane + ccc];
+		const float a2 = _coefficient[2*_nbLane + ccc];
+		const float b0 = _coefficient[3*_nbLane + ccc];
+		const float b1 = _coefficient[4*_nbLane + ccc];
+		float s1 = _state[ccc];
+		float s2 = _state[_nbLane + ccc];
+		float* data = _data + ccc;
+		for (size_t iii=0; iii<_nbFrame; ++iii) {
+			float in = *data;
+			float out = a0 * in + s1;
+			s1 = a1 * in - b0 * out + s2;
+			s2 = a2 * in - b1 * out;
+			*data = out;
+			data += _nbChannel;
+		}
+		_state[ccc] = s1;
+		_state[_nbLane + ccc] = s2;
+	}
+}
+
+static void processStage(const float* _coefficient, float* _state, float* _data, size_t _nbFrame, size_t _nbChannel, size_t _nbLane) {
+	processStage(_coefficient, _state, _data, _nbFrame, _nbChannel, _nbLane, 0);
+}
+
+/**
+ * @brief NB_CHANNEL consecutive channels frame by frame: the recursions of the channels are independent and interleaved (not limited by the latency of one channel).
+ */
+template<size_t NB_CHANNEL>
+static void processStageGroup(const float* _coefficient, float* _state, float* _data, size_t _nbFrame, size_t _nbChannel, size_t _nbLane, size_t _firstChannel) {
+	float a0[NB_CHANNEL];
+	float a1[NB_CHANNEL];
+	float a2[NB_CHANNEL];
+	float b0[NB_CHANNEL];
+	float b1[NB_CHANNEL];
+	float s1[NB_CHANNEL];
+	float s2[NB_CHANNEL];
+	for (size_t ccc=0; ccc<NB_CHANNEL; ++ccc) {
+		a0[ccc] = _coefficient[_firstChannel + ccc];
+		a1[ccc] = _coefficient[_nbLane + _firstChannel + ccc];
+		a2[ccc] = _coefficient[2*_nbLane + _firstChannel + ccc];
+		b0[ccc] = _coefficient[3*_nbLane + _firstChannel + ccc];
+		b1[ccc] = _coefficient[4*_nbLane + _firstChannel + ccc];
+		s1[ccc] = _state[_firstChannel + ccc];
+		s2[ccc] = _state[_nbLane + _firstChannel + ccc];
+	}
+	float* data = _data + _firstChannel;
+	for (size_t iii=0; iii<_nbFrame; ++iii) {
+		for (size_t ccc=0; ccc<NB_CHANNEL; ++ccc) {
+			float in = data[ccc];
+			float out = a0[ccc] * in + s1[ccc];
+			s1[ccc] = a1[ccc] * in - b0[ccc] * out + s2[ccc];
+			s2[ccc] = a2[ccc] * in - b1[ccc] * out;
+			data[ccc] = out;
+		}
+		data += _nbChannel;
+	}
+	for (size_t ccc=0; ccc<NB_CHANNEL; ++ccc) {
+		_state[_firstChannel + ccc] = s1[ccc];
+		_state[_nbLane + _firstChannel + ccc] = s2[ccc];
+	}
+}
+
+/**
+ * @brief Kernel of a number of channel known at the compilation (mono, stereo, 5.1, 7.1 without SIMD).
+ */
+template<size_t NB_CHANNEL>
+static void processStageFixed(const float* _coefficient, float* _state, float* _data, size_t _nbFrame, size_t /*_nbChannel*/, size_t _nbLane) {
+	processStageGroup<NB_CHANNEL>(_coefficient, _state, _data, _nbFrame, NB_CHANNEL, _nbLane, 0);
+}
+
+/**
+ * @brief Channels remaining after the SIMD groups (less than 4).
+ */
+static void processStageRemainder(const float* _coefficient, float* _state, float* _data, size_t _nbFrame, size_t _nbChannel, size_t _nbLane, size_t _firstChannel) {
+	switch (_nbChannel - _firstChannel) {
+		case 0:
+			return;
+		case 2:
+			processStageGroup<2>(_coefficient, _state, _data, _nbFrame, _nbChannel, _nbLane, _firstChannel);
+			return;
+		case 3:
+			processStageGroup<3>(_coefficient, _state, _data, _nbFrame, _nbChannel, _nbLane, _firstChannel);
+			return;
+	}
+	processStage(_coefficient, _state, _data, _nbFrame, _nbChannel, _nbLane, _firstChannel);
+}
+
+#ifdef DRAIN_SIMD_X86
+/**
+ * @brief 4 channels of a stage in the SSE2 lanes (the interleaved frames are loaded directly).
+ */
+DRAIN_TARGET_SSE2 static void processStageSse2Group(const float* _coefficient, float* _state, float* _data, size_t _nbFrame, size_t _nbChannel, size_t _nbLane, size_t _channel) {
+	const __m128 a0 = _mm_load_ps(&_coefficient[_channel]);
+	const __m128 a1 = _mm_load_ps(&_coefficient[_nbLane + _channel]);
+	const __m128 a2 = _mm_load_ps(&_coefficient[2*_nbLane + _channel]);
+	const __m128 b0 = _mm_load_ps(&_coefficient[3*_nbLane + _channel]);
+	const __m128 b1 = _mm_load_ps(&_coefficient[4*_nbLane + _channel]);
+	__m128 s1 = _mm_load_ps(&_state[_channel]);
+	__m128 s2 = _mm_load_ps(&_state[_nbLane + _channel]);
+	float* data = _data + _channel;
+	for (size_t iii=0; iii<_nbFrame; ++iii) {
+		__m128 in = _mm_loadu_ps(data);
+		__m128 out = _mm_add_ps(_mm_mul_ps(a0, in), s1);
+		s1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(a1, in), _mm_mul_ps(b0, out)), s2);
+		s2 = _mm_sub_ps(_mm_mul_ps(a2, in), _mm_mul_ps(b1, out));
+		_mm_storeu_ps(data, out);
+		data += _nbChannel;
+	}
+	_mm_store_ps(&_state[_channel], s1);
+	_mm_store_ps(&_state[_nbLane + _channel], s2);
+}
+
+DRAIN_TARGET_SSE2 static void processStageSse2(const float* _coefficient, float* _state, float* _data, size_t _nbFrame, size_t _nbChannel, size_t _nbLane) {
+	size_t ccc = 0;
+	for (; ccc+4 <= _nbChannel; ccc+=4) {
+		processStageSse2Group(_coefficient, _state, _data, _nbFrame, _nbChannel, _nbLane, ccc);
+	}
+	processStageRemainder(_coefficient, _state, _data, _nbFrame, _nbChannel, _nbLane, ccc);
+}
+
+/**
+ * @brief 8 channels of a stage in the AVX2 lanes.
+ */
+DRAIN_TARGET_AVX2 static void processStageAvx2(const float* _coefficient, float* _state, float* _data, size_t _nbFrame, size_t _nbChannel, size_t _nbLane) {
+	size_t ccc = 0;
+	for (; ccc+8 <= _nbChannel; ccc+=8) {
+		const __m256 a0 = _mm256_load_ps(&_coefficient[ccc]);
+		const __m256 a1 = _mm256_load_ps(&_coefficient[_nbLane + ccc]);
+		const __m256 a2 = _mm256_load_ps(&_coefficient[2*_nbLane + ccc]);
+		const __m256 b0 = _mm256_load_ps(&_coefficient[3*_nbLane + ccc]);
+		const __m256 b1 = _mm256_load_ps(&_coefficient[4*_nbLane + ccc]);
+		__m256 s1 = _mm256_load_ps(&_state[ccc]);
+		__m256 s2 = _mm256_load_ps(&_state[_nbLane + ccc]);
+		float* data = _data + ccc;
+		for (size_t iii=0; iii<_nbFrame; ++iii) {
+			__m256 in = _mm256_loadu_ps(data);
+			__m256 out = _mm256_add_ps(_mm256_mul_ps(a0, in), s1);
+			s1 = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(a1, in), _mm256_mul_ps(b0, out)), s2);
+			s2 = _mm256_sub_ps(_mm256_mul_ps(a2, in), _mm256_mul_ps(b1, out));
+			_mm256_storeu_ps(data, out);
+			data += _nbChannel;
+		}
+		_mm256_store_ps(&_state[ccc], s1);
+		_mm256_store_ps(&_state[_nbLane + ccc], s2);
+	}
+	for (; ccc+4 <= _nbChannel; ccc+=4) {
+		processStageSse2Group(_coefficient, _state, _data, _nbFrame, _nbChannel, _nbLane, ccc);
+	}
+	processStageRemainder(_coefficient, _state, _data, _nbFrame, _nbChannel, _nbLane, ccc);
+}
+#endif
+
+#ifdef DRAIN_SIMD_NEON
+static void processStageNeon(const float* _coefficient, float* _state, float* _data, size_t _nbFrame, size_t _nbChannel, size_t _nbLane) {
+	size_t ccc = 0;
+	for (; ccc+4 <= _nbChannel; ccc+=4) {
+		const float32x4_t a0 = vld1q_f32(&_coefficient[ccc]);
+		const float32x4_t a1 = vld1q_f32(&_coefficient[_nbLane + ccc]);
+		const float32x4_t a2 = vld1q_f32(&_coefficient[2*_nbLane + ccc]);
+		const float32x4_t b0 = vld1q_f32(&_coefficient[3*_nbLane + ccc]);
+		const float32x4_t b1 = vld1q_f32(&_coefficient[4*_nbLane + ccc]);
+		float32x4_t s1 = vld1q_f32(&_state[ccc]);
+		float32x4_t s2 = vld1q_f32(&_state[_nbLane + ccc]);
+		float* data = _data + ccc;
+		for (size_t iii=0; iii<_nbFrame; ++iii) {
+			float32x4_t in = vld1q_f32(data);
+			float32x4_t out = vmlaq_f32(s1, a0, in);
+			s1 = vaddq_f32(vmlsq_f32(vmulq_f32(a1, in), b0, out), s2);
+			s2 = vmlsq_f32(vmulq_f32(a2, in), b1, out);
+			vst1q_f32(data, out);
+			data += _nbChannel;
+		}
+		vst1q_f32(&_state[ccc], s1);
+		vst1q_f32(&_state[_nbLane + ccc], s2);
+	}
+	processStageRemainder(_coefficient, _state, _data, _nbFrame, _nbChannel, _nbLane, ccc);
+}
+#endif
+
+audio::drain::BiquadCascade::BiquadCascade() :
+  m_nbChannel(0),
+  m_nbLane(0),
+  m_nbStage(0),
+  m_function(null),
+  m_interpolation(0),
+  m_version(0),
+  m_rampLength(0),
+  m_rampPosition(0),
+  m_noiseFloor(0.0f),
+  m_noisePhase(0) {
+
+}
+
+void audio::drain::BiquadCascade::init(size_t _nbChannel) {
+	m_nbChannel = _nbChannel;
+	m_nbLane = ((_nbChannel + 7) / 8) * 8;
+	m_nbStage = 0;
+	m_state.clear();
+	m_version = 0;
+	m_rampLength = 0;
+	switch (m_nbChannel) {
+		case 1:
+			m_function = &processStageFixed<1>;
+			break;
+		case 2:
+			m_function = &processStageFixed<2>;
+			break;
+		case 6:
+			m_function = &processStageFixed<6>;
+			break;
+		case 8:
+			m_function = &processStageFixed<8>;
+			break;
+		default:
+			m_function = &processStage;
+			break;
+	}
+	// no SIMD lane to fill in mono and stereo: the scalar kernels are the fastest
+	if (m_nbChannel <= 2) {
+		return;
+	}
+	#ifdef DRAIN_SIMD_X86
+		if (audio::drain::cpu::haveAvx2() == true) {
+			m_function = &processStageAvx2;
+		} else if (audio::drain::cpu::haveSse2() == true) {
+			m_function = &processStageSse2;
+		}
+	#endif
+	#ifdef DRAIN_SIMD_NEON
+		if (audio::drain::cpu::haveNeon() == true) {
+			m_function = &processStageNeon;
+		}
+	#endif
+}
+
+void audio::drain::BiquadCascade::reset() {
+	float* state = reinterpret_cast<float*>(m_state.data());
+	for (size_t iii=0; iii<m_nbStage*2*m_nbLane; ++iii) {
+		state[iii] = 0.0f;
+	}
+}
+
+void audio::drain::BiquadCascade::process(const audio::drain::BiquadBank& _bank, float* _data, size_t _nbFrame) {
+	if (_bank.getNbChannel() != m_nbChannel) {
+		DRAIN_ERROR("Biquad bank with " << _bank.getNbChannel() << " channels on a cascade of " << m_nbChannel << " channels");
+		return;
+	}
+	if (_bank.getNbStage() != m_nbStage) {
+		// new stages start with a clear memory (allocation only when the configuration grow)
+		m_state.resize(_bank.getNbStage()*2*m_nbLane*sizeof(float));
+		float* state = reinterpret_cast<float*>(m_state.data());
+		for (size_t iii=m_nbStage*2*m_nbLane; iii<_bank.getNbStage()*2*m_nbLane; ++iii) {
+			state[iii] = 0.0f;
+		}
+		m_nbStage = _bank.getNbStage();
+	}
+	size_t nbValue = m_nbStage*5*m_nbLane;
+	if (nbValue == 0) {
+		return;
+	}
+	if (m_noiseFloor != 0.0f) {
+		// alternate sign: not removed by the high-pass filters, very low after the low-pass filters
+		float noise = (m_noisePhase & 1) == 0 ? m_noiseFloor : -m_noiseFloor;
+		for (size_t iii=0; iii<_nbFrame; ++iii) {
+			for (size_t ccc=0; ccc<m_nbChannel; ++ccc) {
+				_data[iii*m_nbChannel + ccc] += noise;
+			}
+			noise = -noise;
+		}
+		m_noisePhase += _nbFrame;
+	}
+	const float* target = _bank.getCoefficient(0);
+	if (_bank.getVersion() != m_version) {
+		m_rampLength = 0;
+		if (    m_interpolation != 0
+		     && m_version != 0
+		     && m_coefficient.size() == nbValue*sizeof(float)) {
+			// start from the coefficients really used (can be in the middle of a previous transition)
+			m_rampFrom = m_coefficient;
+			m_rampLength = m_interpolation;
+			m_rampPosition = 0;
+		} else {
+			m_coefficient.resize(nbValue*sizeof(float));
+			memcpy(m_coefficient.data(), target, nbValue*sizeof(float));
+		}
+		m_version = _bank.getVersion();
+	}
+	if (m_rampLength == 0) {
+		processStages(target, _data, _nbFrame);
+		return;
+	}
+	const float* from = reinterpret_cast<const float*>(m_rampFrom.data());
+	float* current = reinterpret_cast<float*>(m_coefficient.data());
+	size_t position = 0;
+	while (position < _nbFrame) {
+		size_t nbFrame = etk::min(g_interpolationBlock, _nbFrame - position);
+		if (m_rampPosition < m_rampLength) {
+			m_rampPosition = etk::min(m_rampPosition + nbFrame, m_rampLength);
+			float ratio = float(m_rampPosition) / float(m_rampLength);
+			for (size_t iii=0; iii<nbValue; ++iii) {
+				current[iii] = from[iii] + (target[iii] - from[iii]) * ratio;
+			}
+			processStages(current, _data + position*m_nbChannel, nbFrame);
+		} else {
+			processStages(target, _data + position*m_nbChannel, nbFrame);
+		}
+		position += nbFrame;
+	}
+	if (m_rampPosition >= m_rampLength) {
+		memcpy(current, target, nbValue*sizeof(float));
+		m_rampLength = 0;
+	}
+}
+
+void audio::drain::BiquadCascade::processStages(const float* _coefficient, float* _data, size_t _nbFrame) {
+	float* state = reinterpret_cast<float*>(m_state.data());
+	for (size_t iii=0; iii<m_nbStage; ++iii) {
+		m_function(_coefficient + iii*5*m_nbLane, state + iii*2*m_nbLane, _data, _nbFrame, m_nbChannel, m_nbLane);
+	}
+}
+
@@ -0,0 +1,190 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <etk/Vector.hpp>
+#include <etk/Pair.hpp>
+#include <audio/algo/drain/Equalizer.hpp>
+#include <audio/drain/AlignedBuffer.hpp>
+
+namespace audio {
+	namespace drain {
+		/**
+		 * @brief Coefficients of a single biquad: y = a0*x + a1*x[-1] + a2*x[-2] - b0*y[-1] - b1*y[-2].
+		 * @note Same naming as the "direct-value" of the equalizer configuration.
+		 */
+		class Biquad {
+			public:
+				float m_a[3]; //!< Coefficients of the input (a0, a1, a2)
+				float m_b[2]; //!< Coefficients of the output (b0, b1)
+			public:
+				/**
+				 * @brief Constructor of a pass-through filter.
+				 */
+				Biquad();
+				/**
+				 * @brief Compute the coefficients of a filter (see http://www.earlevel.com/main/2013/10/13/biquad-calculator-v2/).
+				 * @param[in] _type Type of the filter.
+				 * @param[in] _frequencyCut Cut frequency of the filter.
+				 * @param[in] _qualityFactor Quality of the filter.
+				 * @param[in] _gain Gain in dB (peak and shelf filters).
+				 * @param[in] _sampleRate Frequency of the stream.
+				 */
+				void setBiquad(enum audio::algo::drain::biQuadType _type, double _frequencyCut, double _qualityFactor, double _gain, float _sampleRate);
+				/**
+				 * @brief Set the coefficients directly.
+				 */
+				void setBiquadCoef(float _a0, float _a1, float _a2, float _b0, float _b1);
+				/**
+				 * @brief Get the theoric gain of the filter.
+				 * @param[in] _frequency Frequency to compute.
+				 * @param[in] _sampleRate Frequency of the stream.
+				 * @return Gain in dB.
+				 */
+				float getResponse(double _frequency, float _sampleRate) const;
+		};
+		/**
+		 * @brief Coefficients of a cascade of biquads on all the channels, prepared for the SIMD kernels.
+		 * The coefficients of a stage are stored by lane: a0 of all the channels, then a1 ... (the channels
+		 * without a filter on this stage are pass-through).
+		 */
+		class BiquadBank {
+			protected:
+				size_t m_nbChannel; //!< Number of channel
+				size_t m_nbStage; //!< Number of biquad of the longer channel
+				size_t m_nbLane; //!< m_nbChannel rounded up to 8
+				etk::Vector<audio::drain::Biquad> m_biquad; //!< Biquad of each stage and channel [stage*m_nbChannel+channel]
+				audio::drain::AlignedBuffer m_coefficient; //!< 5*m_nbLane float for each stage
+				uint64_t m_version; //!< Unique id of the coefficients (change at each modification, kept by the copy)
+			public:
+				BiquadBank();
+				/**
+				 * @brief Set the size of the cascade (all the biquads are pass-through).
+				 * @param[in] _nbChannel Number of channel.
+				 * @param[in] _nbStage Number of biquad of each channel.
+				 */
+				void init(size_t _nbChannel, size_t _nbStage);
+				/**
+				 * @brief Get the number of channel.
+				 * @return Number of channel.
+				 */
+				size_t getNbChannel() const {
+					return m_nbChannel;
+				}
+				/**
+				 * @brief Get the number of biquad of each channel.
+				 * @return Number of stage.
+				 */
+				size_t getNbStage() const {
+					return m_nbStage;
+				}
+				/**
+				 * @brief Get the version of the coefficients.
+				 * @return Unique id of the current coefficients.
+				 */
+				uint64_t getVersion() const {
+					return m_version;
+				}
+				/**
+				 * @brief Set a biquad of the cascade.
+				 * @param[in] _stage Id of the biquad in the cascade.
+				 * @param[in] _channel Id of the channel.
+				 * @param[in] _biquad Coefficients.
+				 */
+				void setBiquad(size_t _stage, size_t _channel, const audio::drain::Biquad& _biquad);
+				/**
+				 * @brief Get a biquad of the cascade.
+				 * @param[in] _stage Id of the biquad in the cascade.
+				 * @param[in] _channel Id of the channel.
+				 * @return Coefficients.
+				 */
+				const audio::drain::Biquad& getBiquad(size_t _stage, size_t _channel) const {
+					return m_biquad[_stage*m_nbChannel + _channel];
+				}
+				/**
+				 * @brief Get the coefficients of a stage for the kernels.
+				 * @param[in] _stage Id of the biquad in the cascade.
+				 * @return a0[m_nbLane], a1[m_nbLane], a2[m_nbLane], b0[m_nbLane], b1[m_nbLane].
+				 */
+				const float* getCoefficient(size_t _stage) const {
+					return reinterpret_cast<const float*>(m_coefficient.data()) + _stage*5*m_nbLane;
+				}
+				/**
+				 * @brief Get the theoric response of a channel (for debug & tools).
+				 * @param[in] _sampleRate Frequency of the stream.
+				 * @param[in] _channel Id of the channel.
+				 * @return List of (frequency, gain in dB).
+				 */
+				etk::Vector<etk::Pair<float,float> > calculateTheory(float _sampleRate, size_t _channel=0) const;
+		};
+		/**
+		 * @brief Filter memory of a biquad cascade and its process on interleaved float frames.
+		 * The filters use the transposed direct form II. The channels are processed 8 (AVX2) or 4 (SSE2, NEON)
+		 * at a time in the SIMD lanes, the state of a stage stay in the registers for all the frames.
+		 */
+		class BiquadCascade {
+			protected:
+				size_t m_nbChannel; //!< Number of channel
+				size_t m_nbLane; //!< m_nbChannel rounded up to 8
+				size_t m_nbStage; //!< Number of stage in m_state
+				audio::drain::AlignedBuffer m_state; //!< s1[m_nbLane], s2[m_nbLane] for each stage
+				//! Kernel of one stage on all the channels
+				void (*m_function)(const float* _coefficient, float* _state, float* _data, size_t _nbFrame, size_t _nbChannel, size_t _nbLane);
+				size_t m_interpolation; //!< Number of frame of the transition when the coefficients change (0: instant)
+				uint64_t m_version; //!< Version of the bank of the previous process
+				audio::drain::AlignedBuffer m_coefficient; //!< Coefficients used at the end of the previous process
+				audio::drain::AlignedBuffer m_rampFrom; //!< Coefficients at the start of the transition
+				size_t m_rampLength; //!< Number of frame of the current transition (0: no transition)
+				size_t m_rampPosition; //!< Frames already done in the current transition
+				float m_noiseFloor; //!< Level of the anti-denormal noise (0: disable)
+				size_t m_noisePhase; //!< Sign of the noise of the next frame
+				/**
+				 * @brief Apply all the stages on a block.
+				 * @param[in] _coefficient Coefficients of all the stages.
+				 * @param[in,out] _data Interleaved data.
+				 * @param[in] _nbFrame Number of frame.
+				 */
+				void processStages(const float* _coefficient, float* _data, size_t _nbFrame);
+			public:
+				BiquadCascade();
+				/**
+				 * @brief Configure the cascade (clear the filter memory).
+				 * @param[in] _nbChannel Number of channel.
+				 */
+				void init(size_t _nbChannel);
+				/**
+				 * @brief Clear the filter memory.
+				 */
+				void reset();
+				/**
+				 * @brief Set the duration of the transition when the coefficients change.
+				 * The coefficients are interpolated by blocks of 32 frames (no zipper noise on the UI sliders).
+				 * @param[in] _nbFrame Number of frame of the transition (0: the new coefficients are used immediately).
+				 */
+				void setInterpolation(size_t _nbFrame) {
+					m_interpolation = _nbFrame;
+				}
+				/**
+				 * @brief Add a tiny noise (alternate sign on each frame) to the input of the cascade: the filter memory never
+				 * decay to denormal floats when the stream become silent (they are very slow on x86).
+				 * @param[in] _level Level of the noise (0: disable, ~1e-18 keep a -360 dB floor).
+				 */
+				void setNoiseFloor(float _level) {
+					m_noiseFloor = _level;
+				}
+				/**
+				 * @brief Filter interleaved data in place.
+				 * @note The memory of the stages is kept when the coefficients change (a new stage start with a clear memory).
+				 * @param[in] _bank Coefficients to apply (same number of channel).
+				 * @param[in,out] _data Interleaved data.
+				 * @param[in] _nbFrame Number of frame.
+				 */
+				void process(const audio::drain::BiquadBank& _bank, float* _data, size_t _nbFrame);
+		};
+	}
+}
+
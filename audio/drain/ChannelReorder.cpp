@@ -5,10 +5,491 @@
  */
 
 #include <audio/drain/ChannelReorder.hpp>
+#include <audio/drain/cpu.hpp>
 #include "debug.hpp"
 
 
-audio::drain::ChannelReorder::ChannelReorder() {
+/**
+ * @brief Generic reorder: one pass on the frames.
+ */
+template<typename TYPE>
+static void reorderGeneric(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut) {
+	const TYPE* in = static_cast<const TYPE*>(_input);
+	TYPE* out = static_cast<TYPE*>(_output);
+	for (size_t iii=0; iii<_nbChunk; ++iii) {
+		for (int32_t kkk=0; kkk<_nbChannelOut; ++kkk) {
+			if (_remap[kkk] < 0) {
+				out[kkk] = TYPE(0);
+			} else {
+				out[kkk] = in[_remap[kkk]];
+			}
+		}
+		in += _nbChannelIn;
+		out += _nbChannelOut;
+	}
+}
+
+/**
+ * @brief Reorder with a number of channel known at the compilation (frame loop unrolled).
+ */
+template<typename TYPE, int32_t NB_CHANNEL_IN, int32_t NB_CHANNEL_OUT>
+static void reorderFixed(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t /*_nbChannelIn*/, int32_t /*_nbChannelOut*/) {
+	const TYPE* in = static_cast<const TYPE*>(_input);
+	TYPE* out = static_cast<TYPE*>(_output);
+	int32_t remap[NB_CHANNEL_OUT];
+	for (int32_t kkk=0; kkk<NB_CHANNEL_OUT; ++kkk) {
+		remap[kkk] = _remap[kkk];
+	}
+	for (size_t iii=0; iii<_nbChunk; ++iii) {
+		for (int32_t kkk=0; kkk<NB_CHANNEL_OUT; ++kkk) {
+			out[kkk] = remap[kkk] < 0 ? TYPE(0) : in[remap[kkk]];
+		}
+		in += NB_CHANNEL_IN;
+		out += NB_CHANNEL_OUT;
+	}
+}
+
+/**
+ * @brief Mono output: mean of all the input channels.
+ */
+template<typename TYPE, typename TYPE_ACCUMULATOR>
+static void downMixMono(const void* _input, void* _output, size_t _nbChunk, const int32_t* /*_remap*/, int32_t _nbChannelIn, int32_t /*_nbChannelOut*/) {
+	const TYPE* in = static_cast<const TYPE*>(_input);
+	TYPE* out = static_cast<TYPE*>(_output);
+	for (size_t iii=0; iii<_nbChunk; ++iii) {
+		TYPE_ACCUMULATOR value = 0;
+		for (int32_t jjj=0; jjj<_nbChannelIn; ++jjj) {
+			value += in[jjj];
+		}
+		out[iii] = TYPE(value / TYPE_ACCUMULATOR(_nbChannelIn));
+		in += _nbChannelIn;
+	}
+}
+
+/**
+ * @brief Mono output with a number of input channel known at the compilation (same sum order as downMixMono).
+ */
+template<typename TYPE, typename TYPE_ACCUMULATOR, int32_t NB_CHANNEL_IN>
+static void downMixMonoFixed(const void* _input, void* _output, size_t _nbChunk, const int32_t* /*_remap*/, int32_t /*_nbChannelIn*/, int32_t /*_nbChannelOut*/) {
+	const TYPE* in = static_cast<const TYPE*>(_input);
+	TYPE* out = static_cast<TYPE*>(_output);
+	for (size_t iii=0; iii<_nbChunk; ++iii) {
+		TYPE_ACCUMULATOR value = 0;
+		for (int32_t jjj=0; jjj<NB_CHANNEL_IN; ++jjj) {
+			value += in[jjj];
+		}
+		out[iii] = TYPE(value / TYPE_ACCUMULATOR(NB_CHANNEL_IN));
+		in += NB_CHANNEL_IN;
+	}
+}
+
+/**
+ * @brief Mono to stereo (same sample on the 2 channels).
+ */
+template<typename TYPE>
+static void duplicateMono(const void* _input, void* _output, size_t _nbChunk, const int32_t* /*_remap*/, int32_t /*_nbChannelIn*/, int32_t /*_nbChannelOut*/) {
+	const TYPE* in = static_cast<const TYPE*>(_input);
+	TYPE* out = static_cast<TYPE*>(_output);
+	for (size_t iii=0; iii<_nbChunk; ++iii) {
+		out[iii*2] = in[iii];
+		out[iii*2+1] = in[iii];
+	}
+}
+
+/**
+ * @brief Stereo left <==> right.
+ */
+template<typename TYPE>
+static void swapStereo(const void* _input, void* _output, size_t _nbChunk, const int32_t* /*_remap*/, int32_t /*_nbChannelIn*/, int32_t /*_nbChannelOut*/) {
+	const TYPE* in = static_cast<const TYPE*>(_input);
+	TYPE* out = static_cast<TYPE*>(_output);
+	for (size_t iii=0; iii<_nbChunk; ++iii) {
+		out[iii*2] = in[iii*2+1];
+		out[iii*2+1] = in[iii*2];
+	}
+}
+
+#ifdef DRAIN_SIMD_X86
+DRAIN_TARGET_SSE2 static void duplicateMono__int16__sse2(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut) {
+	const int16_t* in = static_cast<const int16_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	size_t iii = 0;
+	for (; iii+8 <= _nbChunk; iii+=8) {
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii*2]), _mm_unpacklo_epi16(value, value));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii*2+8]), _mm_unpackhi_epi16(value, value));
+	}
+	duplicateMono<int16_t>(&in[iii], &out[iii*2], _nbChunk-iii, _remap, _nbChannelIn, _nbChannelOut);
+}
+DRAIN_TARGET_SSE2 static void duplicateMono__int32__sse2(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut) {
+	const int32_t* in = static_cast<const int32_t*>(_input);
+	int32_t* out = static_cast<int32_t*>(_output);
+	size_t iii = 0;
+	for (; iii+4 <= _nbChunk; iii+=4) {
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii*2]), _mm_unpacklo_epi32(value, value));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii*2+4]), _mm_unpackhi_epi32(value, value));
+	}
+	duplicateMono<int32_t>(&in[iii], &out[iii*2], _nbChunk-iii, _remap, _nbChannelIn, _nbChannelOut);
+}
+DRAIN_TARGET_SSE2 static void swapStereo__int16__sse2(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut) {
+	const int16_t* in = static_cast<const int16_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	size_t iii = 0;
+	for (; iii+4 <= _nbChunk; iii+=4) {
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii*2]));
+		value = _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, 0xB1), 0xB1);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii*2]), value);
+	}
+	swapStereo<int16_t>(&in[iii*2], &out[iii*2], _nbChunk-iii, _remap, _nbChannelIn, _nbChannelOut);
+}
+DRAIN_TARGET_SSE2 static void swapStereo__int32__sse2(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut) {
+	const int32_t* in = static_cast<const int32_t*>(_input);
+	int32_t* out = static_cast<int32_t*>(_output);
+	size_t iii = 0;
+	for (; iii+2 <= _nbChunk; iii+=2) {
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii*2]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii*2]), _mm_shuffle_epi32(value, 0xB1));
+	}
+	swapStereo<int32_t>(&in[iii*2], &out[iii*2], _nbChunk-iii, _remap, _nbChannelIn, _nbChannelOut);
+}
+DRAIN_TARGET_SSE2 static void downMixStereo__int16__sse2(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut) {
+	const int16_t* in = static_cast<const int16_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	const __m128i one = _mm_set1_epi16(1);
+	size_t iii = 0;
+	for (; iii+8 <= _nbChunk; iii+=8) {
+		// left + right in int32_t
+		__m128i low = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii*2])), one);
+		__m128i high = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii*2+8])), one);
+		// division by 2 rounded toward 0 (same as the generic code)
+		low = _mm_srai_epi32(_mm_add_epi32(low, _mm_srli_epi32(low, 31)), 1);
+		high = _mm_srai_epi32(_mm_add_epi32(high, _mm_srli_epi32(high, 31)), 1);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_packs_epi32(low, high));
+	}
+	downMixMono<int16_t, int32_t>(&in[iii*2], &out[iii], _nbChunk-iii, _remap, _nbChannelIn, _nbChannelOut);
+}
+#endif
+
+#ifdef DRAIN_SIMD_NEON
+static void duplicateMono__int16__neon(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut) {
+	const int16_t* in = static_cast<const int16_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	size_t iii = 0;
+	for (; iii+8 <= _nbChunk; iii+=8) {
+		int16x8x2_t value;
+		value.val[0] = vld1q_s16(&in[iii]);
+		value.val[1] = value.val[0];
+		vst2q_s16(&out[iii*2], value);
+	}
+	duplicateMono<int16_t>(&in[iii], &out[iii*2], _nbChunk-iii, _remap, _nbChannelIn, _nbChannelOut);
+}
+static void swapStereo__int16__neon(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut) {
+	const int16_t* in = static_cast<const int16_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	size_t iii = 0;
+	for (; iii+8 <= _nbChunk; iii+=8) {
+		int16x8x2_t value = vld2q_s16(&in[iii*2]);
+		int16x8_t tmp = value.val[0];
+		value.val[0] = value.val[1];
+		value.val[1] = tmp;
+		vst2q_s16(&out[iii*2], value);
+	}
+	swapStereo<int16_t>(&in[iii*2], &out[iii*2], _nbChunk-iii, _remap, _nbChannelIn, _nbChannelOut);
+}
+#endif
+
+/**
+ * @brief Reorder with a change of layout (interleaved and/or planar): one pass by output channel.
+ */
+template<typename TYPE>
+static void reorderLayout(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut, bool _inputPlanar, bool _outputPlanar) {
+	const TYPE* in = static_cast<const TYPE*>(_input);
+	TYPE* out = static_cast<TYPE*>(_output);
+	// distance between 2 samples of a channel and between 2 channels of a sample
+	size_t inStep = _inputPlanar == true ? 1 : _nbChannelIn;
+	size_t inChannel = _inputPlanar == true ? _nbChunk : 1;
+	size_t outStep = _outputPlanar == true ? 1 : _nbChannelOut;
+	size_t outChannel = _outputPlanar == true ? _nbChunk : 1;
+	for (int32_t kkk=0; kkk<_nbChannelOut; ++kkk) {
+		TYPE* dst = out + kkk*outChannel;
+		if (_remap[kkk] < 0) {
+			for (size_t iii=0; iii<_nbChunk; ++iii) {
+				dst[iii*outStep] = TYPE(0);
+			}
+			continue;
+		}
+		const TYPE* src = in + _remap[kkk]*inChannel;
+		for (size_t iii=0; iii<_nbChunk; ++iii) {
+			dst[iii*outStep] = src[iii*inStep];
+		}
+	}
+}
+
+/**
+ * @brief Mono output of a planar input: mean of all the input planes (a mono output is the same in the 2 layouts).
+ */
+template<typename TYPE, typename TYPE_ACCUMULATOR>
+static void downMixMonoPlanar(const void* _input, void* _output, size_t _nbChunk, const int32_t* /*_remap*/, int32_t _nbChannelIn, int32_t /*_nbChannelOut*/, bool /*_inputPlanar*/, bool /*_outputPlanar*/) {
+	const TYPE* in = static_cast<const TYPE*>(_input);
+	TYPE* out = static_cast<TYPE*>(_output);
+	for (size_t iii=0; iii<_nbChunk; ++iii) {
+		TYPE_ACCUMULATOR value = 0;
+		for (int32_t jjj=0; jjj<_nbChannelIn; ++jjj) {
+			value += in[jjj*_nbChunk + iii];
+		}
+		out[iii] = TYPE(value / TYPE_ACCUMULATOR(_nbChannelIn));
+	}
+}
+
+#ifdef DRAIN_SIMD_X86
+DRAIN_TARGET_SSE2 static void interleaveStereo__int16__sse2(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t /*_nbChannelIn*/, int32_t /*_nbChannelOut*/, bool /*_inputPlanar*/, bool /*_outputPlanar*/) {
+	const int16_t* left = static_cast<const int16_t*>(_input) + _remap[0]*_nbChunk;
+	const int16_t* right = static_cast<const int16_t*>(_input) + _remap[1]*_nbChunk;
+	int16_t* out = static_cast<int16_t*>(_output);
+	size_t iii = 0;
+	for (; iii+8 <= _nbChunk; iii+=8) {
+		__m128i valueLeft = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&left[iii]));
+		__m128i valueRight = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&right[iii]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii*2]), _mm_unpacklo_epi16(valueLeft, valueRight));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii*2+8]), _mm_unpackhi_epi16(valueLeft, valueRight));
+	}
+	for (; iii<_nbChunk; ++iii) {
+		out[iii*2] = left[iii];
+		out[iii*2+1] = right[iii];
+	}
+}
+DRAIN_TARGET_SSE2 static void interleaveStereo__int32__sse2(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t /*_nbChannelIn*/, int32_t /*_nbChannelOut*/, bool /*_inputPlanar*/, bool /*_outputPlanar*/) {
+	const int32_t* left = static_cast<const int32_t*>(_input) + _remap[0]*_nbChunk;
+	const int32_t* right = static_cast<const int32_t*>(_input) + _remap[1]*_nbChunk;
+	int32_t* out = static_cast<int32_t*>(_output);
+	size_t iii = 0;
+	for (; iii+4 <= _nbChunk; iii+=4) {
+		__m128i valueLeft = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&left[iii]));
+		__m128i valueRight = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&right[iii]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii*2]), _mm_unpacklo_epi32(valueLeft, valueRight));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii*2+4]), _mm_unpackhi_epi32(valueLeft, valueRight));
+	}
+	for (; iii<_nbChunk; ++iii) {
+		out[iii*2] = left[iii];
+		out[iii*2+1] = right[iii];
+	}
+}
+#endif
+
+typedef void (*reorderFunction)(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut);
+
+/**
+ * @brief Get the reorder function for a specific sample size.
+ */
+template<int32_t NB_CHANNEL_IN, int32_t NB_CHANNEL_OUT>
+static reorderFunction getReorderFixed(int32_t _sampleSize) {
+	switch (_sampleSize) {
+		case 1:
+			return &reorderFixed<int8_t, NB_CHANNEL_IN, NB_CHANNEL_OUT>;
+		case 2:
+			return &reorderFixed<int16_t, NB_CHANNEL_IN, NB_CHANNEL_OUT>;
+		case 4:
+			return &reorderFixed<int32_t, NB_CHANNEL_IN, NB_CHANNEL_OUT>;
+		case 8:
+			return &reorderFixed<int64_t, NB_CHANNEL_IN, NB_CHANNEL_OUT>;
+	}
+	return null;
+}
+
+template<int32_t NB_CHANNEL_IN>
+static reorderFunction getReorderFixed(int32_t _sampleSize, int32_t _nbChannelOut) {
+	switch (_nbChannelOut) {
+		case 2:
+			return getReorderFixed<NB_CHANNEL_IN, 2>(_sampleSize);
+		case 6:
+			return getReorderFixed<NB_CHANNEL_IN, 6>(_sampleSize);
+		case 8:
+			return getReorderFixed<NB_CHANNEL_IN, 8>(_sampleSize);
+	}
+	return null;
+}
+
+/**
+ * @brief Get the reorder function unrolled for the common layouts (mono, stereo, 5.1, 7.1), null for the others.
+ */
+static reorderFunction getReorderFixed(int32_t _sampleSize, int32_t _nbChannelIn, int32_t _nbChannelOut) {
+	switch (_nbChannelIn) {
+		case 1:
+			return getReorderFixed<1>(_sampleSize, _nbChannelOut);
+		case 2:
+			return getReorderFixed<2>(_sampleSize, _nbChannelOut);
+		case 6:
+			return getReorderFixed<6>(_sampleSize, _nbChannelOut);
+		case 8:
+			return getReorderFixed<8>(_sampleSize, _nbChannelOut);
+	}
+	return null;
+}
+
+static reorderFunction getReorderGeneric(int32_t _sampleSize) {
+	switch (_sampleSize) {
+		case 1:
+			return &reorderGeneric<int8_t>;
+		case 2:
+			return &reorderGeneric<int16_t>;
+		case 4:
+			return &reorderGeneric<int32_t>;
+		case 8:
+			return &reorderGeneric<int64_t>;
+	}
+	return null;
+}
+
+static reorderFunction getDuplicateMono(int32_t _sampleSize) {
+	switch (_sampleSize) {
+		case 1:
+			return &duplicateMono<int8_t>;
+		case 2:
+			#ifdef DRAIN_SIMD_X86
+				if (audio::drain::cpu::haveSse2() == true) {
+					return &duplicateMono__int16__sse2;
+				}
+			#endif
+			#ifdef DRAIN_SIMD_NEON
+				if (audio::drain::cpu::haveNeon() == true) {
+					return &duplicateMono__int16__neon;
+				}
+			#endif
+			return &duplicateMono<int16_t>;
+		case 4:
+			#ifdef DRAIN_SIMD_X86
+				if (audio::drain::cpu::haveSse2() == true) {
+					return &duplicateMono__int32__sse2;
+				}
+			#endif
+			return &duplicateMono<int32_t>;
+		case 8:
+			return &duplicateMono<int64_t>;
+	}
+	return null;
+}
+
+static reorderFunction getSwapStereo(int32_t _sampleSize) {
+	switch (_sampleSize) {
+		case 1:
+			return &swapStereo<int8_t>;
+		case 2:
+			#ifdef DRAIN_SIMD_X86
+				if (audio::drain::cpu::haveSse2() == true) {
+					return &swapStereo__int16__sse2;
+				}
+			#endif
+			#ifdef DRAIN_SIMD_NEON
+				if (audio::drain::cpu::haveNeon() == true) {
+					return &swapStereo__int16__neon;
+				}
+			#endif
+			return &swapStereo<int16_t>;
+		case 4:
+			#ifdef DRAIN_SIMD_X86
+				if (audio::drain::cpu::haveSse2() == true) {
+					return &swapStereo__int32__sse2;
+				}
+			#endif
+			return &swapStereo<int32_t>;
+		case 8:
+			return &swapStereo<int64_t>;
+	}
+	return null;
+}
+
+template<typename TYPE, typename TYPE_ACCUMULATOR>
+static reorderFunction getDownMixMono(int32_t _nbChannelIn) {
+	switch (_nbChannelIn) {
+		case 2:
+			return &downMixMonoFixed<TYPE, TYPE_ACCUMULATOR, 2>;
+		case 6:
+			return &downMixMonoFixed<TYPE, TYPE_ACCUMULATOR, 6>;
+		case 8:
+			return &downMixMonoFixed<TYPE, TYPE_ACCUMULATOR, 8>;
+	}
+	return &downMixMono<TYPE, TYPE_ACCUMULATOR>;
+}
+
+static reorderFunction getDownMixMono(enum audio::format _format, int32_t _nbChannelIn) {
+	switch (_format) {
+		case audio::format_int8:
+			return getDownMixMono<int8_t, int32_t>(_nbChannelIn);
+		default:
+		case audio::format_int16:
+			#ifdef DRAIN_SIMD_X86
+				if (    _nbChannelIn == 2
+				     && audio::drain::cpu::haveSse2() == true) {
+					return &downMixStereo__int16__sse2;
+				}
+			#endif
+			return getDownMixMono<int16_t, int32_t>(_nbChannelIn);
+		case audio::format_int16_on_int32:
+		case audio::format_int24:
+		case audio::format_int32:
+			return getDownMixMono<int32_t, int64_t>(_nbChannelIn);
+		case audio::format_float:
+			return getDownMixMono<float, float>(_nbChannelIn);
+		case audio::format_double:
+			return getDownMixMono<double, double>(_nbChannelIn);
+	}
+	return null;
+}
+
+typedef void (*reorderLayoutFunction)(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut, bool _inputPlanar, bool _outputPlanar);
+
+static reorderLayoutFunction getReorderLayout(int32_t _sampleSize) {
+	switch (_sampleSize) {
+		case 1:
+			return &reorderLayout<int8_t>;
+		case 2:
+			return &reorderLayout<int16_t>;
+		case 4:
+			return &reorderLayout<int32_t>;
+		case 8:
+			return &reorderLayout<int64_t>;
+	}
+	return null;
+}
+
+static reorderLayoutFunction getDownMixMonoPlanar(enum audio::format _format) {
+	switch (_format) {
+		case audio::format_int8:
+			return &downMixMonoPlanar<int8_t, int32_t>;
+		default:
+		case audio::format_int16:
+			return &downMixMonoPlanar<int16_t, int32_t>;
+		case audio::format_int16_on_int32:
+		case audio::format_int24:
+		case audio::format_int32:
+			return &downMixMonoPlanar<int32_t, int64_t>;
+		case audio::format_float:
+			return &downMixMonoPlanar<float, float>;
+		case audio::format_double:
+			return &downMixMonoPlanar<double, double>;
+	}
+	return null;
+}
+
+static reorderLayoutFunction getInterleaveStereo(int32_t _sampleSize) {
+	#ifdef DRAIN_SIMD_X86
+		if (audio::drain::cpu::haveSse2() == true) {
+			if (_sampleSize == 2) {
+				return &interleaveStereo__int16__sse2;
+			}
+			if (_sampleSize == 4) {
+				return &interleaveStereo__int32__sse2;
+			}
+		}
+	#endif
+	return getReorderLayout(_sampleSize);
+}
+
+
+audio::drain::ChannelReorder::ChannelReorder() :
+  m_functionReorder(null),
+  m_functionReorderLayout(null) {
 	
 }
 
@@ -16,6 +497,8 @@ audio::drain::ChannelReorder::ChannelReorder() {
 void audio::drain::ChannelReorder::init() {
 	audio::drain::Algo::init();
 	m_type = "ChannelReorder";
+	// convert the layout too
+	m_supportedLayout.pushBack(audio::drain::layout_planar);
 }
 
 ememory::SharedPtr<audio::drain::ChannelReorder> audio::drain::ChannelReorder::create() {
@@ -25,7 +508,7 @@ ememory::SharedPtr<audio::drain::ChannelReorder> audio::drain::ChannelReorder::c
 }
 
 void audio::drain::ChannelReorder::configurationChange() {
-	audio::drain::AutoLogInOut("ChannelReorder (config)");
+	audio::drain::AutoLogInOut tmpLog("ChannelReorder (config)");
 	audio::drain::Algo::configurationChange();
 	if (m_input.getFormat() != m_output.getFormat()) {
 		DRAIN_ERROR("can not support Format Change ...");
@@ -35,12 +518,92 @@ void audio::drain::ChannelReorder::configurationChange() {
 		DRAIN_ERROR("can not support frequency Change ...");
 		m_needProcess = false;
 	}
-	if (m_input.getMap() == m_output.getMap()) {
+	if (    m_input.getMap() == m_output.getMap()
+	     && m_input.getLayout() == m_output.getLayout()) {
 		// nothing to process...
 		m_needProcess = false;
 		DRAIN_INFO(" no need to convert ... " << m_input.getMap() << " ==> " << m_output.getMap());
 		return;
 	}
+	// Pre-compute the channel mapping:
+	m_remap.clear();
+	for (size_t kkk=0; kkk<m_output.getMap().size(); ++kkk) {
+		int32_t convertId = -1;
+		if (    m_input.getMap().size() == 1
+		     && m_input.getMap()[0] == audio::channel_frontCenter) {
+			convertId = 0;
+		} else {
+			for (size_t jjj=0; jjj<m_input.getMap().size(); ++jjj) {
+				if (m_output.getMap()[kkk] == m_input.getMap()[jjj]) {
+					convertId = jjj;
+					break;
+				}
+			}
+		}
+		DRAIN_VERBOSE("    " << convertId << " ==> " << kkk);
+		m_remap.pushBack(convertId);
+	}
+	// select the best function for this layout:
+	int32_t nbChannelIn = m_input.getMap().size();
+	int32_t nbChannelOut = m_output.getMap().size();
+	m_functionReorder = null;
+	m_functionReorderLayout = null;
+	if (    m_input.getLayout() == audio::drain::layout_planar
+	     || m_output.getLayout() == audio::drain::layout_planar) {
+		bool inputPlanar = m_input.getLayout() == audio::drain::layout_planar;
+		bool outputPlanar = m_output.getLayout() == audio::drain::layout_planar;
+		if (    nbChannelOut == 1
+		     && nbChannelIn > 1
+		     && inputPlanar == true) {
+			m_functionReorderLayout = getDownMixMonoPlanar(m_output.getFormat());
+		} else if (    nbChannelOut == 1
+		            && nbChannelIn > 1) {
+			// a mono output is the same in the 2 layouts
+			m_functionReorder = getDownMixMono(m_output.getFormat(), nbChannelIn);
+		} else if (    nbChannelOut == 2
+		            && inputPlanar == true
+		            && outputPlanar == false
+		            && m_remap[0] >= 0
+		            && m_remap[1] >= 0) {
+			m_functionReorderLayout = getInterleaveStereo(m_formatSize);
+		} else {
+			m_functionReorderLayout = getReorderLayout(m_formatSize);
+		}
+		if (    m_functionReorder == null
+		     && m_functionReorderLayout == null) {
+			DRAIN_ERROR("can not reorder sample of " << int32_t(m_formatSize) << " bytes");
+			m_needProcess = false;
+		}
+		return;
+	}
+	if (nbChannelOut == 1) {
+		m_functionReorder = getDownMixMono(m_output.getFormat(), nbChannelIn);
+	} else if (    nbChannelIn == 1
+	            && nbChannelOut == 2) {
+		if (    m_remap[0] == 0
+		     && m_remap[1] == 0) {
+			m_functionReorder = getDuplicateMono(m_formatSize);
+		} else {
+			m_functionReorder = getReorderFixed<1,2>(m_formatSize);
+		}
+	} else if (    nbChannelIn == 2
+	            && nbChannelOut == 2) {
+		if (    m_remap[0] == 1
+		     && m_remap[1] == 0) {
+			m_functionReorder = getSwapStereo(m_formatSize);
+		} else {
+			m_functionReorder = getReorderFixed<2,2>(m_formatSize);
+		}
+	} else {
+		m_functionReorder = getReorderFixed(m_formatSize, nbChannelIn, nbChannelOut);
+		if (m_functionReorder == null) {
+			m_functionReorder = getReorderGeneric(m_formatSize);
+		}
+	}
+	if (m_functionReorder == null) {
+		DRAIN_ERROR("can not reorder sample of " << int32_t(m_formatSize) << " bytes");
+		m_needProcess = false;
+	}
 }
 
 
@@ -57,152 +620,33 @@ bool audio::drain::ChannelReorder::process(audio::Time& _time,
 		return true;
 	}
 	if (_input == null) {
-		_output = &(m_outputData[0]);
+		_output = m_outputData.data();
 		_outputNbChunk = 0;
 		DRAIN_ERROR("null pointer input ... ");
 		return false;
 	}
-	m_outputData.resize(_outputNbChunk*m_output.getMap().size()*m_formatSize);
-	_output = &(m_outputData[0]);
-	// real process: (only depend of data size):
-	switch (m_output.getFormat()) {
-		case audio::format_int8:
-			{
-				DRAIN_VERBOSE("convert " << m_input.getMap() << " ==> " << m_output.getMap() << " format=" << int32_t(m_formatSize));
-				int8_t* in = static_cast<int8_t*>(_input);
-				int8_t* out = static_cast<int8_t*>(_output);
-				for (size_t kkk=0; kkk<m_output.getMap().size(); ++kkk) {
-					int32_t convertId = -1;
-					if (    m_input.getMap().size() == 1
-					     && m_input.getMap()[0] == audio::channel_frontCenter) {
-						convertId = 0;
-					} else {
-						for (size_t jjj=0; jjj<m_input.getMap().size(); ++jjj) {
-							if (m_output.getMap()[kkk] == m_input.getMap()[jjj]) {
-								convertId = jjj;
-								break;
-							}
-						}
-					}
-					DRAIN_VERBOSE("    " << convertId << " ==> " << kkk);
-					if (convertId == -1) {
-						for (size_t iii=0; iii<_outputNbChunk; ++iii) {
-							out[iii*m_output.getMap().size()+kkk] = 0;
-						}
-					} else {
-						for (size_t iii=0; iii<_outputNbChunk; ++iii) {
-							out[iii*m_output.getMap().size()+kkk] = in[iii*m_input.getMap().size()+convertId];
-						}
-					}
-				}
-			}
-			break;
-		default:
-		case audio::format_int16:
-			if (m_output.getMap().size() == 1) {
-				DRAIN_VERBOSE("convert " << m_input.getMap() << " ==> " << m_output.getMap() << " format=" << int32_t(m_formatSize));
-				int16_t* in = static_cast<int16_t*>(_input);
-				int16_t* out = static_cast<int16_t*>(_output);
-				for (size_t iii=0; iii<_outputNbChunk; ++iii) {
-					int32_t val = 0;
-					for (size_t jjj=0; jjj<m_input.getMap().size(); ++jjj) {
-						val += in[iii*m_input.getMap().size()+jjj];
-					}
-					out[iii] = val/m_input.getMap().size();
-				}
-			} else {
-				DRAIN_VERBOSE("convert " << m_input.getMap() << " ==> " << m_output.getMap() << " format=" << int32_t(m_formatSize));
-				int16_t* in = static_cast<int16_t*>(_input);
-				int16_t* out = static_cast<int16_t*>(_output);
-				for (size_t kkk=0; kkk<m_output.getMap().size(); ++kkk) {
-					int32_t convertId = -1;
-					if (    m_input.getMap().size() == 1
-					     && m_input.getMap()[0] == audio::channel_frontCenter) {
-						convertId = 0;
-					} else {
-						for (size_t jjj=0; jjj<m_input.getMap().size(); ++jjj) {
-							if (m_output.getMap()[kkk] == m_input.getMap()[jjj]) {
-								convertId = jjj;
-								break;
-							}
-						}
-					}
-					DRAIN_VERBOSE("    " << convertId << " ==> " << kkk);
-					if (convertId == -1) {
-						for (size_t iii=0; iii<_outputNbChunk; ++iii) {
-							out[iii*m_output.getMap().size()+kkk] = 0;
-						}
-					} else {
-						for (size_t iii=0; iii<_outputNbChunk; ++iii) {
-							out[iii*m_output.getMap().size()+kkk] = in[iii*m_input.getMap().size()+convertId];
-						}
-					}
-				}
-			}
-			break;
-		case audio::format_int16_on_int32:
-		case audio::format_int24:
-		case audio::format_int32:
-		case audio::format_float:
-			{
-				DRAIN_VERBOSE("convert (2) " << m_input.getMap() << " ==> " << m_output.getMap());
-				uint32_t* in = static_cast<uint32_t*>(_input);
-				uint32_t* out = static_cast<uint32_t*>(_output);
-				for (size_t kkk=0; kkk<m_output.getMap().size(); ++kkk) {
-					int32_t convertId = -1;
-					if (    m_input.getMap().size() == 1
-					     && m_input.getMap()[0] == audio::channel_frontCenter) {
-						convertId = 0;
-					} else {
-						for (size_t jjj=0; jjj<m_input.getMap().size(); ++jjj) {
-							if (m_output.getMap()[kkk] == m_input.getMap()[jjj]) {
-								convertId = jjj;
-								break;
-							}
-						}
-					}
-					if (convertId == -1) {
-						for (size_t iii=0; iii<_outputNbChunk; ++iii) {
-							out[iii*m_output.getMap().size()+kkk] = 0;
-						}
-					} else {
-						for (size_t iii=0; iii<_outputNbChunk; ++iii) {
-							out[iii*m_output.getMap().size()+kkk] = in[iii*m_input.getMap().size()+convertId];
-						}
-					}
-				}
-			}
-			break;
-		case audio::format_double:
-			{
-				DRAIN_VERBOSE("convert (2) " << m_input.getMap() << " ==> " << m_output.getMap());
-				uint64_t* in = static_cast<uint64_t*>(_input);
-				uint64_t* out = static_cast<uint64_t*>(_output);
-				for (size_t kkk=0; kkk<m_output.getMap().size(); ++kkk) {
-					int32_t convertId = -1;
-					if (    m_input.getMap().size() == 1
-					     && m_input.getMap()[0] == audio::channel_frontCenter) {
-						convertId = 0;
-					} else {
-						for (size_t jjj=0; jjj<m_input.getMap().size(); ++jjj) {
-							if (m_output.getMap()[kkk] == m_input.getMap()[jjj]) {
-								convertId = jjj;
-								break;
-							}
-						}
-					}
-					if (convertId == -1) {
-						for (size_t iii=0; iii<_outputNbChunk; ++iii) {
-							out[iii*m_output.getMap().size()+kkk] = 0;
-						}
-					} else {
-						for (size_t iii=0; iii<_outputNbChunk; ++iii) {
-							out[iii*m_output.getMap().size()+kkk] = in[iii*m_input.getMap().size()+convertId];
-						}
-					}
-				}
-			}
-			break;
+	if (m_inputSilence == true) {
+		_output = getSilenceBuffer(_input, _outputNbChunk);
+		return true;
+	}
+	_output = getOutputBuffer(_outputNbChunk);
+	DRAIN_VERBOSE("convert " << m_input.getMap() << " ==> " << m_output.getMap() << " format=" << int32_t(m_formatSize));
+	if (m_functionReorderLayout != null) {
+		m_functionReorderLayout(_input,
+		                        _output,
+		                        _outputNbChunk,
+		                        &m_remap[0],
+		                        m_input.getMap().size(),
+		                        m_output.getMap().size(),
+		                        m_input.getLayout() == audio::drain::layout_planar,
+		                        m_output.getLayout() == audio::drain::layout_planar);
+		return true;
 	}
+	m_functionReorder(_input,
+	                  _output,
+	                  _outputNbChunk,
+	                  &m_remap[0],
+	                  m_input.getMap().size(),
+	                  m_output.getMap().size());
 	return true;
 }
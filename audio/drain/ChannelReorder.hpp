@@ -25,11 +25,20 @@ namespace audio {
 			protected:
 				virtual void configurationChange();
 			public:
+				virtual bool isPassThrough() const {
+					return m_needProcess == false;
+				}
 				virtual bool process(audio::Time& _time,
 				                     void* _input,
 				                     size_t _inputNbChunk,
 				                     void*& _output,
 				                     size_t& _outputNbChunk);
+			private:
+				etk::Vector<int32_t> m_remap; //!< for each output channel: id of the input channel (-1 for silence)
+				// reorder function (selected at the configuration):
+				void (*m_functionReorder)(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut);
+				// reorder function when one of the buffers is planar (null for the interleaved ones):
+				void (*m_functionReorderLayout)(const void* _input, void* _output, size_t _nbChunk, const int32_t* _remap, int32_t _nbChannelIn, int32_t _nbChannelOut, bool _inputPlanar, bool _outputPlanar);
 		};
 	}
 }
@@ -6,45 +6,138 @@
 
 #include <audio/drain/CircularBuffer.hpp>
 #include <audio/drain/debug.hpp>
+#if defined(__TARGET_OS__Linux)
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
 
-audio::drain::CircularBuffer::CircularBuffer(const audio::drain::CircularBuffer& _obj) :
+audio::drain::CircularBuffer::CircularBuffer(const audio::drain::CircularBuffer& /*_obj*/) :
   m_data(),
-  m_write(null),
-  m_read(null),
-  m_timeRead(),
+  m_mirror(null),
+  m_mirrorEnable(false),
+  m_write(0),
+  m_read(0),
+  m_timeBase(),
+  m_timeBasePosition(0),
+  m_timeSequence(0),
+  m_frequency(0),
   m_capacity(0),
   m_sizeChunk(0),
-  m_size(0) {
+  m_lockFree(false),
+  m_overwrite(false) {
 	DRAIN_CRITICAL("error");
 };
 /**
  * @brief copy operator.
  */
-audio::drain::CircularBuffer& audio::drain::CircularBuffer::operator=(const audio::drain::CircularBuffer& _obj) {
+audio::drain::CircularBuffer& audio::drain::CircularBuffer::operator=(const audio::drain::CircularBuffer& /*_obj*/) {
 	DRAIN_CRITICAL("error");
 	return *this;
 };
 
 audio::drain::CircularBuffer::CircularBuffer() :
   m_data(),
-  m_write(null),
-  m_read(null),
-  m_timeRead(),
+  m_mirror(null),
+  m_mirrorEnable(false),
+  m_write(0),
+  m_read(0),
+  m_timeBase(),
+  m_timeBasePosition(0),
+  m_timeSequence(0),
+  m_frequency(0),
   m_capacity(0),
   m_sizeChunk(0),
-  m_size(0) {
+  m_lockFree(false),
+  m_overwrite(false) {
 	// nothing to do ...
 }
 
 audio::drain::CircularBuffer::~CircularBuffer() {
+	releaseMirror();
 	m_data.clear();
-	m_read = null;
-	m_write = null;
+	m_read = 0;
+	m_write = 0;
+}
+
+void audio::drain::CircularBuffer::setMirror(bool _value) {
+	if (m_mirrorEnable == _value) {
+		return;
+	}
+	m_mirrorEnable = _value;
+	if (m_capacity != 0) {
+		// force the reallocation
+		size_t capacity = m_capacity;
+		size_t chunkSize = m_sizeChunk;
+		releaseMirror();
+		m_capacity = 0;
+		setCapacity(capacity, chunkSize, m_frequency);
+	}
+}
+
+bool audio::drain::CircularBuffer::createMirror(size_t _size) {
+	#if defined(__TARGET_OS__Linux)
+		int fd = memfd_create("audio-drain-buffer", 0);
+		if (fd < 0) {
+			return false;
+		}
+		if (ftruncate(fd, _size) != 0) {
+			close(fd);
+			return false;
+		}
+		// reserve the 2 views, then map the same file on each one
+		uint8_t* base = static_cast<uint8_t*>(mmap(null, 2*_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+		if (base == MAP_FAILED) {
+			close(fd);
+			return false;
+		}
+		if (    mmap(base, _size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+		     || mmap(base + _size, _size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+			munmap(base, 2*_size);
+			close(fd);
+			return false;
+		}
+		// the mapping keep a reference on the memory
+		close(fd);
+		m_mirror = base;
+		return true;
+	#else
+		// no mirror on this platform: the buffer keep the copy of the wrap
+		(void)_size;
+		return false;
+	#endif
+}
+
+void audio::drain::CircularBuffer::releaseMirror() {
+	if (m_mirror == null) {
+		return;
+	}
+	#if defined(__TARGET_OS__Linux)
+		munmap(m_mirror, 2*m_capacity*m_sizeChunk);
+	#endif
+	m_mirror = null;
 }
 
 void audio::drain::CircularBuffer::setCapacity(size_t _capacity, size_t _chunkSize, uint32_t _frequency) {
+	#if defined(__TARGET_OS__Linux)
+		if (    m_mirrorEnable == true
+		     && _chunkSize != 0
+		     && _capacity != 0) {
+			// The 2 views must start on a page: capacity*chunkSize multiple of the page size
+			size_t pageSize = sysconf(_SC_PAGESIZE);
+			size_t step = pageSize;
+			for (size_t iii=_chunkSize; iii!=0;) {
+				size_t tmp = step % iii;
+				step = iii;
+				iii = tmp;
+			}
+			// step = pageSize / gcd(pageSize, chunkSize)
+			step = pageSize / step;
+			_capacity = ((_capacity + step - 1) / step) * step;
+		}
+	#endif
 	if (    _chunkSize == m_sizeChunk
 	     && _capacity == m_capacity) {
+		m_frequency = _frequency;
 		clear();
 		return;
 	}
@@ -57,22 +150,28 @@ void audio::drain::CircularBuffer::setCapacity(size_t _capacity, size_t _chunkSi
 		DRAIN_ERROR("set a buffer capacity with chunksize = 0 ... (reset default at 8)");
 		_chunkSize = 8;
 	}
+	releaseMirror();
 	m_data.clear();
-	m_write = null;
-	m_read = null;
+	m_write = 0;
+	m_read = 0;
+	m_timeBase = audio::Time();
+	m_timeBasePosition = 0;
 	m_frequency = _frequency;
 	m_capacity = _capacity;
 	m_sizeChunk = _chunkSize;
-	m_size = 0;
 	if (    _capacity == 0
 	     || _chunkSize == 0) {
 		m_capacity = 0;
 		m_sizeChunk = 0;
 		return;
 	}
+	if (m_mirrorEnable == true) {
+		if (createMirror(m_capacity*m_sizeChunk) == true) {
+			return;
+		}
+		DRAIN_WARNING("Can not create the mirrored memory ==> use a standard buffer");
+	}
 	m_data.resize(m_capacity*m_sizeChunk, 0);
-	m_read = &m_data[0];
-	m_write = &m_data[0];
 }
 
 void audio::drain::CircularBuffer::setCapacity(echrono::Duration _capacity, size_t _chunkSize, uint32_t _frequency) {
@@ -81,165 +180,338 @@ void audio::drain::CircularBuffer::setCapacity(echrono::Duration _capacity, size
 	setCapacity(nbSampleNeeded, _chunkSize, _frequency);
 }
 
+void audio::drain::CircularBuffer::copyIn(uint64_t _position, const void* _data, size_t _nbChunk) {
+	uint8_t* data = getData();
+	size_t offset = _position % m_capacity;
+	if (m_mirror != null) {
+		// the data after the end are the start of the buffer
+		memcpy(data + offset*m_sizeChunk, _data, _nbChunk * m_sizeChunk);
+		return;
+	}
+	size_t nbChunkBeforeEnd = etk::min(_nbChunk, m_capacity - offset);
+	memcpy(data + offset*m_sizeChunk, _data, nbChunkBeforeEnd * m_sizeChunk);
+	if (nbChunkBeforeEnd != _nbChunk) {
+		// copy the last data at the start of the buffer
+		memcpy(data,
+		       static_cast<const uint8_t*>(_data) + nbChunkBeforeEnd * m_sizeChunk,
+		       (_nbChunk - nbChunkBeforeEnd) * m_sizeChunk);
+	}
+}
 
-size_t audio::drain::CircularBuffer::getUsedSizeBeforEnd() const {
-	size_t size;
-	if (m_read < m_write) {
-		size = static_cast<uint8_t*>(m_write) - static_cast<uint8_t*>(m_read);
-		// the size result is in bytes we need to have it in element
-		size /= m_sizeChunk;
-	} else if (    m_read == m_write
-	            && m_size == 0) {
-		// no element in the buffer
-		size = 0;
-	} else {
-		size = &m_data[0] + (m_capacity*m_sizeChunk) - static_cast<uint8_t*>(m_read);
-		// the size result is in bytes we need to have it in element
-		size /= m_sizeChunk;
+void audio::drain::CircularBuffer::clearIn(uint64_t _position, size_t _nbChunk) {
+	if (_nbChunk == 0) {
+		return;
+	}
+	uint8_t* data = getData();
+	size_t offset = _position % m_capacity;
+	if (m_mirror != null) {
+		memset(data + offset*m_sizeChunk, 0, _nbChunk * m_sizeChunk);
+		return;
+	}
+	size_t nbChunkBeforeEnd = etk::min(_nbChunk, m_capacity - offset);
+	memset(data + offset*m_sizeChunk, 0, nbChunkBeforeEnd * m_sizeChunk);
+	if (nbChunkBeforeEnd != _nbChunk) {
+		memset(data, 0, (_nbChunk - nbChunkBeforeEnd) * m_sizeChunk);
 	}
-	return size;
 }
 
-size_t audio::drain::CircularBuffer::getFreeSizeBeforEnd() const {
-		size_t size;
-		size =   &m_data[0]
-		       + (m_capacity*m_sizeChunk)
-		       - static_cast<uint8_t*>(m_write);
-		// the size result is in Octet we need to have it in element
-		size /= m_sizeChunk;
-		return size;
+void audio::drain::CircularBuffer::copyOut(uint64_t _position, void* _data, size_t _nbChunk) const {
+	const uint8_t* data = m_mirror;
+	if (data == null) {
+		data = &m_data[0];
+	}
+	size_t offset = _position % m_capacity;
+	if (m_mirror != null) {
+		memcpy(_data, data + offset*m_sizeChunk, _nbChunk * m_sizeChunk);
+		return;
+	}
+	size_t nbChunkBeforeEnd = etk::min(_nbChunk, m_capacity - offset);
+	memcpy(_data, data + offset*m_sizeChunk, nbChunkBeforeEnd * m_sizeChunk);
+	if (nbChunkBeforeEnd != _nbChunk) {
+		// copy the last data from the start of the buffer
+		memcpy(static_cast<uint8_t*>(_data) + nbChunkBeforeEnd * m_sizeChunk,
+		       data,
+		       (_nbChunk - nbChunkBeforeEnd) * m_sizeChunk);
+	}
 }
+
 size_t audio::drain::CircularBuffer::write(const void* _data, size_t _nbChunk) {
-	return write(_data, _nbChunk, audio::Time::now());//m_timeRead + )
+	if (getSize() == 0) {
+		return write(_data, _nbChunk, audio::Time::now());
+	}
+	// continuous data
+	return write(_data, _nbChunk, getWriteTimeStamp());
 }
 
 size_t audio::drain::CircularBuffer::write(const void* _data, size_t _nbChunk, const audio::Time& _time) {
-	if (m_data.size() == 0) {
+	if (m_capacity == 0) {
 		DRAIN_ERROR("EMPTY Buffer");
 		return _nbChunk;
 	}
+	// Only the producer update the write position
+	uint64_t positionWrite = m_write.load(std::memory_order_relaxed);
+	uint64_t positionRead = m_read.load(std::memory_order_acquire);
+	size_t size = positionWrite - positionRead;
+	size_t freeSize = m_capacity - size;
 	size_t nbElementDrop = 0;
-	size_t freeSizeBeforeEnd = getFreeSizeBeforEnd();
-	size_t freeSize = m_capacity - m_size;
+	size_t nbEmpty = 0;
+	size_t nbSkip = placeWrite(_time, positionWrite, size, _nbChunk, nbEmpty);
+	if (nbSkip != 0) {
+		_data = static_cast<const uint8_t*>(_data) + nbSkip * m_sizeChunk;
+		_nbChunk -= nbSkip;
+		if (_nbChunk == 0) {
+			return 0;
+		}
+	}
+	if (    m_lockFree == true
+	     && m_overwrite == false) {
+		// The producer can not move the read position ==> drop the newest element
+		if (freeSize < nbEmpty + _nbChunk) {
+			nbElementDrop = nbEmpty + _nbChunk - freeSize;
+			nbEmpty = etk::min(nbEmpty, freeSize);
+			_nbChunk = freeSize - nbEmpty;
+		}
+		clearIn(positionWrite, nbEmpty);
+		copyIn(positionWrite + nbEmpty, _data, _nbChunk);
+		// publish the data for the consumer
+		m_write.store(positionWrite + nbEmpty + _nbChunk, std::memory_order_release);
+		return nbElementDrop;
+	}
 	// Write element in all case
 	// calculate the number of element that are overwritten
-	if (freeSize < _nbChunk) {
-		nbElementDrop = _nbChunk - freeSize;
+	if (freeSize < nbEmpty + _nbChunk) {
+		nbElementDrop = nbEmpty + _nbChunk - freeSize;
 	}
 	// if User Request a write more important than the size of the buffer ==> update the pointer to feet only on the buffer size
-	if (m_capacity < _nbChunk) {
-		DRAIN_WARNING("CircularBuffer Write too BIG " << _nbChunk << " buffer max size : " << m_capacity << " (keep last Elements)");
+	if (m_capacity < nbEmpty + _nbChunk) {
+		DRAIN_WARNING("CircularBuffer Write too BIG " << nbEmpty + _nbChunk << " buffer max size : " << m_capacity << " (keep last Elements)");
+		size_t nbRemove = nbEmpty + _nbChunk - m_capacity;
+		// remove the empty chunks first
+		size_t nbRemoveEmpty = etk::min(nbRemove, nbEmpty);
+		nbEmpty -= nbRemoveEmpty;
+		positionWrite += nbRemoveEmpty;
+		nbRemove -= nbRemoveEmpty;
 		// Move data pointer
-		_data = static_cast<const uint8_t*>(_data) + (_nbChunk - m_capacity) * m_sizeChunk;
+		_data = static_cast<const uint8_t*>(_data) + nbRemove * m_sizeChunk;
+		positionWrite += nbRemove;
 		// update size
-		_nbChunk = m_capacity;
-	}
-	// if no element in the FIFO ==> first time write or no more data inside ==> start set the file of the read data ...
-	if (m_size == 0) {
-		m_timeRead = _time;
-	}
-	// TODO : Check time to push continuous data ...
-	
-	if (freeSizeBeforeEnd >= _nbChunk) {
-		// all Data will be copy
-		memcpy(m_write, _data, _nbChunk * m_sizeChunk);
-		// update Writing pointer
-		if (freeSizeBeforeEnd == _nbChunk) {
-			// update to the end of FIFO ==> update to the start
-			m_write = &m_data[0];
-		} else {
-			m_write = static_cast<uint8_t*>(m_write) + _nbChunk * m_sizeChunk;
-		}
-		// Update the number of element in the buffer.
-		m_size += _nbChunk;
+		_nbChunk -= nbRemove;
+	}
+	if (    m_lockFree == true
+	     && nbElementDrop > 0) {
+		// the reader is moved before the data are overwritten
+		nbElementDrop = dropRead(positionWrite + nbEmpty + _nbChunk - m_capacity);
+	}
+	clearIn(positionWrite, nbEmpty);
+	copyIn(positionWrite + nbEmpty, _data, _nbChunk);
+	positionWrite += nbEmpty + _nbChunk;
+	m_write.store(positionWrite, std::memory_order_release);
+	if (    m_lockFree == false
+	     && nbElementDrop > 0) {
+		// if drop element we need to update the reading pointer
+		m_read.store(positionWrite - m_capacity, std::memory_order_release);
+	}
+	// return the number of element Overwrite
+	return nbElementDrop;
+}
+
+size_t audio::drain::CircularBuffer::writev(const audio::drain::CircularBufferWriteSpan* _span, size_t _nbSpan) {
+	if (getSize() == 0) {
+		return writev(_span, _nbSpan, audio::Time::now());
+	}
+	// continuous data
+	return writev(_span, _nbSpan, getWriteTimeStamp());
+}
+
+size_t audio::drain::CircularBuffer::writev(const audio::drain::CircularBufferWriteSpan* _span, size_t _nbSpan, const audio::Time& _time) {
+	size_t nbChunk = 0;
+	for (size_t iii=0; iii<_nbSpan; ++iii) {
+		nbChunk += _span[iii].m_nbChunk;
+	}
+	if (m_capacity == 0) {
+		DRAIN_ERROR("EMPTY Buffer");
+		return nbChunk;
+	}
+	// Only the producer update the write position
+	uint64_t positionWrite = m_write.load(std::memory_order_relaxed);
+	uint64_t positionRead = m_read.load(std::memory_order_acquire);
+	size_t size = positionWrite - positionRead;
+	size_t freeSize = m_capacity - size;
+	size_t nbElementDrop = 0;
+	size_t nbEmpty = 0;
+	// chunks at the start of the fragments that are not written
+	size_t nbSkip = placeWrite(_time, positionWrite, size, nbChunk, nbEmpty);
+	size_t nbWrite = nbChunk - nbSkip;
+	if (nbWrite == 0) {
+		return 0;
+	}
+	if (freeSize < nbEmpty + nbWrite) {
+		nbElementDrop = nbEmpty + nbWrite - freeSize;
+	}
+	if (    m_lockFree == true
+	     && m_overwrite == false) {
+		// The producer can not move the read position ==> drop the newest element
+		nbEmpty = etk::min(nbEmpty, freeSize);
+		nbWrite = etk::min(nbWrite, freeSize - nbEmpty);
 	} else {
-		// copy data to the end of buffer
-		memcpy(m_write, _data, freeSizeBeforeEnd * m_sizeChunk);
-		// update Writing pointer ==> end of buffer ==> go to the start
-		m_write = &m_data[0];
-		// update data pointer
-		_data = static_cast<const uint8_t*>(_data) + freeSizeBeforeEnd * m_sizeChunk;
-		m_size += freeSizeBeforeEnd;
-		// get the number of element we need to write
-		_nbChunk -= freeSizeBeforeEnd;
-		// Copy the las data if needed
-		if (_nbChunk != 0) {
-			memcpy(m_write, _data, _nbChunk * m_sizeChunk);
-			// update Writing pointer
-			m_write = static_cast<uint8_t*>(m_write) + _nbChunk * m_sizeChunk;
-			m_size += _nbChunk;
+		if (m_capacity < nbEmpty + nbWrite) {
+			DRAIN_WARNING("CircularBuffer Write too BIG " << nbEmpty + nbWrite << " buffer max size : " << m_capacity << " (keep last Elements)");
+			size_t nbRemove = nbEmpty + nbWrite - m_capacity;
+			// remove the empty chunks first
+			size_t nbRemoveEmpty = etk::min(nbRemove, nbEmpty);
+			nbEmpty -= nbRemoveEmpty;
+			positionWrite += nbRemoveEmpty;
+			nbRemove -= nbRemoveEmpty;
+			nbSkip += nbRemove;
+			positionWrite += nbRemove;
+			nbWrite -= nbRemove;
 		}
+		if (    m_lockFree == true
+		     && nbElementDrop > 0) {
+			// the reader is moved before the data are overwritten
+			nbElementDrop = dropRead(positionWrite + nbEmpty + nbWrite - m_capacity);
+		}
+	}
+	clearIn(positionWrite, nbEmpty);
+	uint64_t position = positionWrite + nbEmpty;
+	for (size_t iii=0; iii<_nbSpan && nbWrite > 0; ++iii) {
+		const uint8_t* data = static_cast<const uint8_t*>(_span[iii].m_data);
+		size_t nbSpanChunk = _span[iii].m_nbChunk;
+		if (nbSkip >= nbSpanChunk) {
+			nbSkip -= nbSpanChunk;
+			continue;
+		}
+		data += nbSkip * m_sizeChunk;
+		nbSpanChunk = etk::min(nbSpanChunk - nbSkip, nbWrite);
+		nbSkip = 0;
+		copyIn(position, data, nbSpanChunk);
+		position += nbSpanChunk;
+		nbWrite -= nbSpanChunk;
 	}
-	if (nbElementDrop > 0) {
+	// publish all the fragments at once for the consumer
+	m_write.store(position, std::memory_order_release);
+	if (    m_lockFree == false
+	     && nbElementDrop > 0) {
 		// if drop element we need to update the reading pointer
-		m_read = m_write;
-		m_size = m_capacity;
+		m_read.store(position - m_capacity, std::memory_order_release);
 	}
-	// return the number of element Overwrite
 	return nbElementDrop;
 }
 
+size_t audio::drain::CircularBuffer::placeWrite(const audio::Time& _time, uint64_t _position, size_t _size, size_t _nbChunk, size_t& _nbEmpty) {
+	_nbEmpty = 0;
+	if (_size == 0) {
+		// first time write or no more data inside ==> the data start the time line
+		setTimeBase(_time, _position);
+		return 0;
+	}
+	if (m_frequency == 0) {
+		return 0;
+	}
+	// check the continuity with the previous data
+	int64_t delta = getNbChunk(_time - getTime(_position));
+	if (delta > 0) {
+		// gap ==> fill with 0
+		_nbEmpty = etk::min(size_t(delta), m_capacity);
+		DRAIN_VERBOSE("Add " << _nbEmpty << " empty chunks in the buffer (gap)");
+		return 0;
+	}
+	if (delta < 0) {
+		// overlap ==> keep the previous data
+		size_t nbSkip = etk::min(size_t(-delta), _nbChunk);
+		DRAIN_VERBOSE("Skip " << nbSkip << " chunks (overlap)");
+		return nbSkip;
+	}
+	return 0;
+}
+
+size_t audio::drain::CircularBuffer::readv(const audio::drain::CircularBufferReadSpan* _span, size_t _nbSpan) {
+	while (true) {
+		size_t nbElementDrop = 0;
+		// Only the consumer update the read position (except the drop of the overwrite mode)
+		uint64_t positionStart = m_read.load(std::memory_order_acquire);
+		uint64_t positionRead = positionStart;
+		size_t size = m_write.load(std::memory_order_acquire) - positionRead;
+		for (size_t iii=0; iii<_nbSpan; ++iii) {
+			uint8_t* data = static_cast<uint8_t*>(_span[iii].m_data);
+			size_t nbChunk = etk::min(_span[iii].m_nbChunk, size);
+			if (nbChunk != 0) {
+				copyOut(positionRead, data, nbChunk);
+				positionRead += nbChunk;
+				size -= nbChunk;
+			}
+			if (nbChunk < _span[iii].m_nbChunk) {
+				// set 0 in last element of the output
+				memset(data + nbChunk*m_sizeChunk, 0, (_span[iii].m_nbChunk - nbChunk)*m_sizeChunk);
+				nbElementDrop += _span[iii].m_nbChunk - nbChunk;
+			}
+		}
+		// release the memory for the producer
+		if (releaseRead(positionStart, positionRead) == true) {
+			return nbElementDrop;
+		}
+		// overwritten during the copy: read the newest data
+	}
+}
+
 size_t audio::drain::CircularBuffer::read(void* _data, size_t _nbChunk) {
-	return read(_data, _nbChunk, m_timeRead);
+	// no time constraint: the next chunks (the time of the read position can change during the read in overwrite mode)
+	audio::drain::CircularBufferReadSpan span;
+	span.m_data = _data;
+	span.m_nbChunk = _nbChunk;
+	return readv(&span, 1);
 }
 
 size_t audio::drain::CircularBuffer::read(void* _data, size_t _nbChunk, const audio::Time& _time) {
 	size_t nbElementDrop = 0;
-	// Critical section (theoriquely protected by Mutex)
-	size_t usedSizeBeforeEnd = getUsedSizeBeforEnd();
+	// Only the consumer update the read position (except the drop of the overwrite mode)
+	uint64_t positionRead = m_read.load(std::memory_order_acquire);
+	size_t size = m_write.load(std::memory_order_acquire) - positionRead;
 	// verify if we have elements in the Buffer
-	if (0 < m_size) {
+	if (0 < size) {
 		// check the time of the read :
-		audio::Duration deltaTime = m_timeRead - _time;
-		if (deltaTime.get() == 0) {
+		int64_t deltaChunk = 0;
+		if (m_frequency != 0) {
+			deltaChunk = getNbChunk(getTime(positionRead) - _time);
+		}
+		if (deltaChunk == 0) {
 			// nothing to do ==> just copy data ...
-		} else if (deltaTime.get() > 0) {
+		} else if (deltaChunk > 0) {
 			// Add empty sample in the output buffer ...
-			size_t nbSampleEmpty = m_frequency*deltaTime.get()/1000000000LL;
-			nbSampleEmpty = etk::min(nbSampleEmpty, _nbChunk);
-			DRAIN_WARNING("add Empty sample in the output buffer " << nbSampleEmpty << " / " << _nbChunk);
+			size_t nbSampleEmpty = etk::min(size_t(deltaChunk), _nbChunk);
+			DRAIN_VERBOSE("add Empty sample in the output buffer " << nbSampleEmpty << " / " << _nbChunk);
 			memset(_data, 0, nbSampleEmpty * m_sizeChunk);
 			if (nbSampleEmpty == _nbChunk) {
 				return 0;
 			}
+			_data = static_cast<uint8_t*>(_data) + nbSampleEmpty * m_sizeChunk;
 			_nbChunk -= nbSampleEmpty;
 		} else {
 			// Remove data from the FIFO
 			setReadPosition(_time);
+			positionRead = m_read.load(std::memory_order_acquire);
+			size = m_write.load(std::memory_order_acquire) - positionRead;
 		}
-		if (m_size < _nbChunk) {
-			nbElementDrop = _nbChunk - m_size;
-			DRAIN_VERBOSE("crop nb sample : m_size=" << m_size << " _nbChunk=" << _nbChunk);
-			_nbChunk = m_size;
-		}
-		m_timeRead += echrono::microseconds(_nbChunk*1000000/m_frequency);
-		if (usedSizeBeforeEnd >= _nbChunk) {
-			// all Data will be copy
-			memcpy(_data, m_read, _nbChunk * m_sizeChunk);
-			// update Writing pointer
-			m_read = static_cast<uint8_t*>(m_read) + _nbChunk * m_sizeChunk;
-			m_size -= _nbChunk;
-			// update output pointer in case of flush with 0 data
-			_data = static_cast<uint8_t*>(_data) + _nbChunk * m_sizeChunk;
-		} else {
-			// copy data to the end of buffer
-			memcpy(_data, m_read, usedSizeBeforeEnd * m_sizeChunk);
-			// update Writing pointer ==> end of buffer ==> go to the start
-			m_read = &m_data[0];
-			_data = static_cast<uint8_t*>(_data) + usedSizeBeforeEnd * m_sizeChunk;
-			m_size -= usedSizeBeforeEnd;
-			// get the number of element we need to write
-			_nbChunk -= usedSizeBeforeEnd;
-			// Copy the last data if needed
-			if (0 != _nbChunk) {
-				memcpy(_data, m_read, _nbChunk * m_sizeChunk);
-				// update Writing pointer
-				m_read = static_cast<uint8_t*>(m_read) + _nbChunk * m_sizeChunk;
-				m_size -= _nbChunk;
-				// update output pointer in case of flush with 0 data
-				_data = static_cast<uint8_t*>(_data) + _nbChunk * m_sizeChunk;
+		size_t nbChunkRequest = _nbChunk;
+		while (true) {
+			if (size < nbChunkRequest) {
+				nbElementDrop = nbChunkRequest - size;
+				DRAIN_VERBOSE("crop nb sample : size=" << size << " _nbChunk=" << nbChunkRequest);
+				_nbChunk = size;
+			}
+			copyOut(positionRead, _data, _nbChunk);
+			// release the memory for the producer
+			if (releaseRead(positionRead, positionRead + _nbChunk) == true) {
+				break;
 			}
+			// overwritten during the copy: read the newest data
+			nbElementDrop = 0;
+			_nbChunk = nbChunkRequest;
+			positionRead = m_read.load(std::memory_order_acquire);
+			size = m_write.load(std::memory_order_acquire) - positionRead;
 		}
+		// update output pointer in case of flush with 0 data
+		_data = static_cast<uint8_t*>(_data) + _nbChunk * m_sizeChunk;
 	} else {
 		nbElementDrop = _nbChunk;
 	}
@@ -252,44 +524,150 @@ size_t audio::drain::CircularBuffer::read(void* _data, size_t _nbChunk, const au
 }
 
 void audio::drain::CircularBuffer::setReadPosition(const audio::Time& _time) {
-	// Critical section (theoriquely protected by Mutex)
-	size_t usedSizeBeforeEnd = getUsedSizeBeforEnd();
-	if (0 < m_size) {
-		// check the time of the read :
-		audio::Duration deltaTime = _time - m_timeRead;
-		size_t nbSampleToRemove = int64_t(m_frequency)*int64_t(deltaTime.get())/1000000000LL;
-		nbSampleToRemove = etk::min(nbSampleToRemove, m_size);
-		DRAIN_VERBOSE("Remove sample in the buffer " << nbSampleToRemove << " / " << m_size);
-		audio::Duration updateTime(0,(int64_t(nbSampleToRemove)*1000000000LL)/int64_t(m_frequency));
-		DRAIN_VERBOSE(" add time : " << updateTime << " / " << deltaTime);
-		if (usedSizeBeforeEnd >= nbSampleToRemove) {
-			usedSizeBeforeEnd -= nbSampleToRemove;
-			m_size -= nbSampleToRemove;
-			m_read = static_cast<uint8_t*>(m_read) + nbSampleToRemove * m_sizeChunk;
-		} else {
-			nbSampleToRemove -= usedSizeBeforeEnd;
-			m_size -= nbSampleToRemove;
-			m_read = &m_data[0] + nbSampleToRemove*m_sizeChunk;
+	uint64_t positionRead = m_read.load(std::memory_order_acquire);
+	size_t size = m_write.load(std::memory_order_acquire) - positionRead;
+	if (    size == 0
+	     || m_frequency == 0) {
+		return;
+	}
+	int64_t nbSampleToRemove = getNbChunk(_time - getTime(positionRead));
+	if (nbSampleToRemove <= 0) {
+		return;
+	}
+	nbSampleToRemove = etk::min(size_t(nbSampleToRemove), size);
+	DRAIN_VERBOSE("Remove sample in the buffer " << nbSampleToRemove << " / " << size);
+	// overwrite mode: the writer can have already dropped them
+	releaseRead(positionRead, positionRead + nbSampleToRemove);
+}
+
+bool audio::drain::CircularBuffer::releaseRead(uint64_t _position, uint64_t _newPosition) {
+	if (m_overwrite == false) {
+		m_read.store(_newPosition, std::memory_order_release);
+		return true;
+	}
+	// the writer move the read position before overwriting the data
+	return m_read.compare_exchange_strong(_position, _newPosition, std::memory_order_acq_rel);
+}
+
+size_t audio::drain::CircularBuffer::dropRead(uint64_t _position) {
+	uint64_t positionRead = m_read.load(std::memory_order_acquire);
+	while (positionRead < _position) {
+		if (m_read.compare_exchange_weak(positionRead, _position, std::memory_order_acq_rel) == true) {
+			return _position - positionRead;
 		}
-		m_timeRead += updateTime;
-		//m_timeRead += deltaTime;
-	} else {
-		m_timeRead = audio::Time();
 	}
+	// the reader already released these data
+	return 0;
 }
 
+void audio::drain::CircularBuffer::setTimeBase(const audio::Time& _time, uint64_t _position) {
+	m_timeSequence.fetch_add(1, std::memory_order_acq_rel);
+	m_timeBase = _time;
+	m_timeBasePosition = _position;
+	m_timeSequence.fetch_add(1, std::memory_order_acq_rel);
+}
+
+audio::Time audio::drain::CircularBuffer::getTime(uint64_t _position) const {
+	// the producer can start a new time line during the read (lock-free mode)
+	audio::Time timeBase;
+	uint64_t timeBasePosition = 0;
+	while (true) {
+		uint32_t sequence = m_timeSequence.load(std::memory_order_acquire);
+		if ((sequence & 1) != 0) {
+			continue;
+		}
+		timeBase = m_timeBase;
+		timeBasePosition = m_timeBasePosition;
+		if (sequence == m_timeSequence.load(std::memory_order_acquire)) {
+			break;
+		}
+	}
+	if (m_frequency == 0) {
+		return timeBase;
+	}
+	// split in second to never overflow
+	int64_t delta = int64_t(_position - timeBasePosition);
+	int64_t second = delta / int64_t(m_frequency);
+	int64_t rest = delta % int64_t(m_frequency);
+	return timeBase + audio::Duration(0, second*1000000000LL + (rest*1000000000LL)/int64_t(m_frequency));
+}
+
+int64_t audio::drain::CircularBuffer::getNbChunk(const audio::Duration& _duration) const {
+	int64_t value = _duration.get();
+	bool negative = value < 0;
+	if (negative == true) {
+		value = -value;
+	}
+	int64_t out = (value/1000000000LL)*int64_t(m_frequency) + ((value%1000000000LL)*int64_t(m_frequency) + 500000000LL)/1000000000LL;
+	if (negative == true) {
+		return -out;
+	}
+	return out;
+}
+
+size_t audio::drain::CircularBuffer::peekContiguous(const void*& _data, size_t _nbChunk) {
+	_data = null;
+	if (m_capacity == 0) {
+		return 0;
+	}
+	uint64_t positionRead = m_read.load(std::memory_order_acquire);
+	size_t size = m_write.load(std::memory_order_acquire) - positionRead;
+	size_t offset = positionRead % m_capacity;
+	size_t nbChunk = etk::min(_nbChunk, size);
+	if (m_mirror == null) {
+		nbChunk = etk::min(nbChunk, m_capacity - offset);
+	}
+	_data = getData() + offset*m_sizeChunk;
+	return nbChunk;
+}
+
+void audio::drain::CircularBuffer::commit(size_t _nbChunk) {
+	uint64_t positionRead = m_read.load(std::memory_order_acquire);
+	size_t size = m_write.load(std::memory_order_acquire) - positionRead;
+	// release the memory for the producer (overwrite mode: the writer can have already dropped them)
+	releaseRead(positionRead, positionRead + etk::min(_nbChunk, size));
+}
+
+size_t audio::drain::CircularBuffer::peekContiguousWrite(void*& _data, size_t _nbChunk) {
+	_data = null;
+	if (m_capacity == 0) {
+		return 0;
+	}
+	uint64_t positionWrite = m_write.load(std::memory_order_relaxed);
+	size_t freeSize = m_capacity - (positionWrite - m_read.load(std::memory_order_acquire));
+	size_t offset = positionWrite % m_capacity;
+	size_t nbChunk = etk::min(_nbChunk, freeSize);
+	if (m_mirror == null) {
+		nbChunk = etk::min(nbChunk, m_capacity - offset);
+	}
+	_data = getData() + offset*m_sizeChunk;
+	return nbChunk;
+}
+
+void audio::drain::CircularBuffer::commitWrite(size_t _nbChunk) {
+	uint64_t positionWrite = m_write.load(std::memory_order_relaxed);
+	size_t size = positionWrite - m_read.load(std::memory_order_acquire);
+	if (size == 0) {
+		// no more data inside ==> start a new time line (same as write without time)
+		setTimeBase(audio::Time::now(), positionWrite);
+	}
+	// publish the data for the consumer
+	m_write.store(positionWrite + etk::min(_nbChunk, m_capacity - size), std::memory_order_release);
+}
 
 size_t audio::drain::CircularBuffer::getFreeSize() const {
-	return m_capacity - m_size;
+	return m_capacity - getSize();
 }
 
 void audio::drain::CircularBuffer::clear() {
 	DRAIN_DEBUG("buffer clear()");
-	// set pointer to the start
-	m_read  = &m_data[0];
-	m_write = &m_data[0];
-	// Clean the number of element in the buffer
-	m_size = 0;
+	// set position to the start
+	m_read = 0;
+	m_write = 0;
+	m_timeBase = audio::Time();
+	m_timeBasePosition = 0;
 	// Clean all element inside :
-	memset(&m_data[0], 0, m_sizeChunk * m_capacity);
+	if (getData() != null) {
+		memset(getData(), 0, m_sizeChunk * m_capacity);
+	}
 }
@@ -10,10 +10,29 @@
 #include <echrono/Steady.hpp>
 #include <audio/Time.hpp>
 #include <audio/Duration.hpp>
+#include <atomic>
 
 namespace audio {
 	namespace drain {
 		/**
+		 * @brief Fragment of data written by CircularBuffer::writev.
+		 */
+		class CircularBufferWriteSpan {
+			public:
+				const void* m_data; //!< First chunk of the fragment
+				size_t m_nbChunk; //!< Number of chunk of the fragment
+		};
+		/**
+		 * @brief Fragment of memory filled by CircularBuffer::readv.
+		 */
+		class CircularBufferReadSpan {
+			public:
+				void* m_data; //!< First chunk of the fragment
+				size_t m_nbChunk; //!< Number of chunk of the fragment
+		};
+		/**
+		 * The read and write positions are free running counters of chunk (never reset to 0 when the end of the buffer is reached).
+		 * The number of chunk in the buffer is (m_write - m_read) and the position in m_data is (position % m_capacity).
 		 * For these functions we have 4 solutions :
 		 *  - Free Buffer
 		 *             ----------------------------------------------------------
@@ -21,7 +40,7 @@ namespace audio {
 		 *             ----------------------------------------------------------
 		 *                                          m_write
 		 *                                          m_read
-		 *  - Full Buffer
+		 *  - Full Buffer (m_write - m_read == m_capacity)
 		 *             ----------------------------------------------------------
 		 *      m_data |****************************|***************************|
 		 *             ----------------------------------------------------------
@@ -36,19 +55,27 @@ namespace audio {
 		 *             ----------------------------------------------------------
 		 *      m_data |****************|                    |******************|
 		 *             ----------------------------------------------------------
-		 *                              m_read                m_write
+		 *                              m_write               m_read
+		 * In lock-free mode, the buffer is a single producer / single consumer FIFO:
+		 *  - only the writer thread update m_write (and never m_read)
+		 *  - only the reader thread update m_read (and never m_write)
+		 * No mutex is needed between the producer and the consumer in this mode.
 		 */
 		class CircularBuffer {
 			private:
 				etk::Vector<uint8_t> m_data; //!< data pointer
-				void* m_write; //!< write pointer
-				void* m_read; //!< read pointer
-				audio::Time m_timeRead; //!< current read time
+				uint8_t* m_mirror; //!< Same memory mapped twice back to back (null if not used) ==> no wrap in the copy
+				bool m_mirrorEnable; //!< Use the mirrored memory when available
+				std::atomic<uint64_t> m_write; //!< number of chunk written since the last clear (updated by the producer)
+				std::atomic<uint64_t> m_read; //!< number of chunk read since the last clear (updated by the consumer)
+				audio::Time m_timeBase; //!< Time of the chunk at the position m_timeBasePosition
+				uint64_t m_timeBasePosition; //!< Position (in chunk) of m_timeBase (the time of a position is computed from it ==> no drift)
+				std::atomic<uint32_t> m_timeSequence; //!< Odd while the producer update m_timeBase and m_timeBasePosition
 				uint32_t m_frequency;
-				// TODO : Remove the m_size ==> this is a bad element to be mutex-less
-				size_t m_size; //!< number of chunk availlable in this buffer
 				size_t m_capacity; //!< number of chunk available in this Buffer
 				size_t m_sizeChunk; //!< Size of one chunk (in byte)
+				bool m_lockFree; //!< Single producer / single consumer mode (the writer never update the read position)
+				bool m_overwrite; //!< Lock-free mode: a write in a full buffer move the read position with a CAS (drop the oldest data)
 			public:
 				CircularBuffer();
 				~CircularBuffer();
@@ -62,6 +89,51 @@ namespace audio {
 				 * @param[in] _obj Circular buffer object
 				 */
 				CircularBuffer& operator=(const audio::drain::CircularBuffer& _obj);
+				/**
+				 * @brief Set the single producer / single consumer mode.
+				 * In this mode a write in a full buffer drop the new data instead of the oldest one (the time line is still set by the writer).
+				 * @param[in] _value true to activate the lock-free mode.
+				 */
+				void setLockFree(bool _value) {
+					m_lockFree = _value;
+				}
+				/**
+				 * @brief Get the single producer / single consumer mode.
+				 * @return true if the lock-free mode is active.
+				 */
+				bool getLockFree() const {
+					return m_lockFree;
+				}
+				/**
+				 * @brief Drop the oldest data on a write in a full buffer in lock-free mode.
+				 * The writer move the read position with a compare and swap before overwriting the data: a read of these data
+				 * fail its own compare and swap and is done again on the newest data (no mutex).
+				 * @note The producer and the consumer must be stopped.
+				 * @param[in] _value true to overwrite the oldest data, false to drop the newest data.
+				 */
+				void setOverwrite(bool _value) {
+					m_overwrite = _value;
+				}
+				/**
+				 * @brief Get the behavior of a write in a full buffer in lock-free mode.
+				 * @return true if the oldest data are overwritten.
+				 */
+				bool getOverwrite() const {
+					return m_overwrite;
+				}
+				/**
+				 * @brief Map the buffer memory twice back to back (Linux only, reset the buffer): all the data are contiguous.
+				 * @note The capacity is rounded up to a multiple of the memory page size.
+				 * @param[in] _value New state.
+				 */
+				void setMirror(bool _value);
+				/**
+				 * @brief Check if the buffer memory is mirrored.
+				 * @return true All the data can be accessed contiguously.
+				 */
+				bool getMirror() const {
+					return m_mirror != null;
+				}
 				/**
 				 * @brief set the capacity of the circular buffer.
 				 * @param[in] _capacity Number of chunk in the buffer.
@@ -86,7 +158,7 @@ namespace audio {
 				 * @return number of chunk.
 				 */
 				size_t getSize() const {
-					return m_size;
+					return m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_acquire);
 				}
 				/**
 				 * @brief Get number of chunk that can be set in the buffer.
@@ -95,15 +167,33 @@ namespace audio {
 				size_t getCapacity() const {
 					return m_capacity;
 				}
+				/**
+				 * @brief Get the size of one chunk.
+				 * @return Size in byte.
+				 */
+				size_t getChunkSize() const {
+					return m_sizeChunk;
+				}
 				/**
 				 * @brief Write chunk in the buffer.
 				 * @param[in] _data Pointer on the data.
 				 * @param[in] _nbChunk number of chunk to copy.
-				 * @param[in] _time Time to start write data (if before end ==> not replace data, write only if after end)
-				 * @return Number of chunk copied.
+				 * @param[in] _time Time to start write data (if before end ==> not replace data, write only if after end, a gap is filled with 0).
+				 * @return Number of chunk dropped (overwritten, or not written in lock-free mode).
 				 */
 				size_t write(const void* _data, size_t _nbChunk, const audio::Time& _time);
+				//! @brief Write chunk just after the previous data (continuous stream).
 				size_t write(const void* _data, size_t _nbChunk);
+				/**
+				 * @brief Write a list of fragments with a single update of the write position.
+				 * @param[in] _span List of fragments (written in order).
+				 * @param[in] _nbSpan Number of fragment.
+				 * @param[in] _time Time of the first chunk of the first fragment (same time line as write).
+				 * @return Number of chunk dropped (same rules as write).
+				 */
+				size_t writev(const audio::drain::CircularBufferWriteSpan* _span, size_t _nbSpan, const audio::Time& _time);
+				//! @brief Write a list of fragments just after the previous data (continuous stream).
+				size_t writev(const audio::drain::CircularBufferWriteSpan* _span, size_t _nbSpan);
 				/**
 				 * @brief Read Chunk from the buffer to the pointer data.
 				 * @param[out] _data Pointer on the data.
@@ -114,26 +204,144 @@ namespace audio {
 				size_t read(void* _data, size_t _nbChunk, const audio::Time& _time);
 				//! @previous
 				size_t read(void* _data, size_t _nbChunk);
+				/**
+				 * @brief Read the next chunks in a list of fragments with a single update of the read position.
+				 * @param[in] _span List of fragments (filled in order).
+				 * @param[in] _nbSpan Number of fragment.
+				 * @return Number of chunk missing (set at 0 at the end of the fragments).
+				 */
+				size_t readv(const audio::drain::CircularBufferReadSpan* _span, size_t _nbSpan);
 				void setReadPosition(const audio::Time& _time);
+				/**
+				 * @brief Get a direct access on the next chunks to read (consumer side).
+				 * @param[out] _data Pointer on the first chunk.
+				 * @param[in] _nbChunk Number of chunk requested.
+				 * @return Number of contiguous chunk available at _data (all the requested data in mirror mode, until the end of the buffer otherwise).
+				 * @note Overwrite mode: the writer can overwrite the data before the commit (it is ignored then).
+				 */
+				size_t peekContiguous(const void*& _data, size_t _nbChunk);
+				/**
+				 * @brief Release the chunks read with peekContiguous (consumer side).
+				 * @param[in] _nbChunk Number of chunk to release.
+				 */
+				void commit(size_t _nbChunk);
+				/**
+				 * @brief Get a direct access on the free space to write (producer side).
+				 * @param[out] _data Pointer on the first free chunk.
+				 * @param[in] _nbChunk Number of chunk requested.
+				 * @return Number of contiguous chunk that can be written at _data.
+				 */
+				size_t peekContiguousWrite(void*& _data, size_t _nbChunk);
+				/**
+				 * @brief Publish the chunks written with peekContiguousWrite (producer side, continuous stream).
+				 * @param[in] _nbChunk Number of chunk to publish.
+				 */
+				void commitWrite(size_t _nbChunk);
 				
-				audio::Time getReadTimeStamp() {
-					return m_timeRead;
+				/**
+				 * @brief Get the time of the next chunk to read.
+				 * @return Time of the chunk.
+				 */
+				audio::Time getReadTimeStamp() const {
+					return getTime(m_read.load(std::memory_order_acquire));
+				}
+				/**
+				 * @brief Get the time of the next chunk to write (end of the data).
+				 * @return Time of the chunk.
+				 */
+				audio::Time getWriteTimeStamp() const {
+					return getTime(m_write.load(std::memory_order_acquire));
 				}
 				/**
 				 * @brief Clear the buffer.
+				 * @note In lock-free mode, the producer and the consumer must be stopped.
 				 */
 				void clear();
 			private:
 				/**
-				 * @brief Get number of free chunks before end of buffer.
-				 * @return Number of chunk.
+				 * @brief Get the memory of the buffer.
+				 * @return Pointer on the first chunk (null if no capacity).
+				 */
+				uint8_t* getData() {
+					if (m_mirror != null) {
+						return m_mirror;
+					}
+					if (m_data.size() == 0) {
+						return null;
+					}
+					return &m_data[0];
+				}
+				/**
+				 * @brief Create the mirrored memory.
+				 * @param[in] _size Size in byte of one view (multiple of the page size).
+				 * @return true if the memory is mapped.
+				 */
+				bool createMirror(size_t _size);
+				/**
+				 * @brief Release the mirrored memory.
+				 */
+				void releaseMirror();
+				/**
+				 * @brief Release the chunks read (consumer side).
+				 * @param[in] _position Read position used for the copy.
+				 * @param[in] _newPosition Position after the chunks read.
+				 * @return false The writer dropped the chunks during the copy (overwrite mode): the data copied are not valid.
 				 */
-				size_t getFreeSizeBeforEnd() const;
+				bool releaseRead(uint64_t _position, uint64_t _newPosition);
 				/**
-				 * @brief Get number of used chunks before end of buffer.
-				 * @return Number of chunk.
+				 * @brief Drop the oldest chunks before overwriting them (producer side, overwrite mode).
+				 * @param[in] _position New minimum read position.
+				 * @return Number of chunk dropped.
+				 */
+				size_t dropRead(uint64_t _position);
+				/**
+				 * @brief Start a new time line (producer side, the consumer can read the time at the same time).
+				 * @param[in] _time Time of the chunk at the position _position.
+				 * @param[in] _position Position (in chunk) of the first chunk of the time line.
+				 */
+				void setTimeBase(const audio::Time& _time, uint64_t _position);
+				/**
+				 * @brief Place the data of a write on the time line (producer side, shared by write and writev).
+				 * @param[in] _time Time of the first chunk to write.
+				 * @param[in] _position Write position.
+				 * @param[in] _size Number of chunk in the buffer.
+				 * @param[in] _nbChunk Number of chunk to write.
+				 * @param[out] _nbEmpty Number of chunk at 0 to write before the data (gap).
+				 * @return Number of chunk at the start of the data that are already in the buffer (overlap, not written).
+				 */
+				size_t placeWrite(const audio::Time& _time, uint64_t _position, size_t _size, size_t _nbChunk, size_t& _nbEmpty);
+				/**
+				 * @brief Get the time of a position in the stream.
+				 * @param[in] _position Position (in chunk).
+				 * @return Time of the chunk (base time + exact sample offset).
+				 */
+				audio::Time getTime(uint64_t _position) const;
+				/**
+				 * @brief Get the number of chunk in a duration.
+				 * @param[in] _duration Duration.
+				 * @return Number of chunk (rounded at the nearest).
+				 */
+				int64_t getNbChunk(const audio::Duration& _duration) const;
+				/**
+				 * @brief Set chunks at 0 in the buffer at a specific position (manage the end of buffer).
+				 * @param[in] _position Position (in chunk) of the first element to set.
+				 * @param[in] _nbChunk number of chunk to set.
+				 */
+				void clearIn(uint64_t _position, size_t _nbChunk);
+				/**
+				 * @brief Copy chunks in the buffer at a specific position (manage the end of buffer).
+				 * @param[in] _position Position (in chunk) of the first element to write.
+				 * @param[in] _data Pointer on the data.
+				 * @param[in] _nbChunk number of chunk to copy.
+				 */
+				void copyIn(uint64_t _position, const void* _data, size_t _nbChunk);
+				/**
+				 * @brief Copy chunks from the buffer at a specific position (manage the end of buffer).
+				 * @param[in] _position Position (in chunk) of the first element to read.
+				 * @param[out] _data Pointer on the data.
+				 * @param[in] _nbChunk number of chunk to copy.
 				 */
-				size_t getUsedSizeBeforEnd() const;
+				void copyOut(uint64_t _position, void* _data, size_t _nbChunk) const;
 		};
 	}
 }
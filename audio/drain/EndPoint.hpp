@@ -6,11 +6,13 @@
 #pragma once
 
 #include <audio/drain/Algo.hpp>
+#include <audio/drain/Metric.hpp>
 
 namespace audio {
 	namespace drain{
 		class EndPoint : public Algo {
 			protected:
+				audio::drain::EndPointMetric m_metric; //!< Live counters of the end-point (updated in the process)
 				/**
 				 * @brief Constructor
 				 */
@@ -25,6 +27,19 @@ namespace audio {
 				virtual ~EndPoint() {
 					
 				};
+				/**
+				 * @brief Get the live counters of the end-point (can be called from any thread).
+				 * @param[out] _snapshot Copy of the counters.
+				 */
+				void getMetric(audio::drain::EndPointMetricSnapshot& _snapshot) const {
+					m_metric.getSnapshot(_snapshot);
+				}
+				/**
+				 * @brief Clear the live counters of the end-point.
+				 */
+				void resetMetric() {
+					m_metric.reset();
+				}
 		};
 	}
 }
@@ -10,7 +10,8 @@
 
 audio::drain::EndPointCallback::EndPointCallback() :
   m_outputFunction(null),
-  m_inputFunction(null) {
+  m_inputFunction(null),
+  m_outputClear(true) {
 	
 }
 
@@ -62,24 +63,25 @@ bool audio::drain::EndPointCallback::process(audio::Time& _time,
 		return true;
 	}
 	if (m_outputFunction != null) {
-		// update buffer size ...
-		m_outputData.resize(_inputNbChunk*m_output.getMap().size()*m_formatSize);
-		// clean output to prevent errors ...
-		memset(&m_outputData[0], 0, m_outputData.size());
+		// the user write directly in the buffer of the next algo (or in the final buffer of the Process)
+		_output = getOutputBuffer(_inputNbChunk);
+		_outputNbChunk = _inputNbChunk;
+		if (_output == null) {
+			_outputNbChunk = 0;
+			return true;
+		}
+		if (m_outputClear == true) {
+			// clean output to prevent errors ...
+			memset(_output, 0, _inputNbChunk*m_output.getMap().size()*m_formatSize);
+		}
 		// call user
 		DRAIN_VERBOSE("call user get " << _inputNbChunk << "*" << m_output.getMap().size() << " map=" << m_output.getMap() << " datasize=" << int32_t(m_formatSize));
-		m_outputFunction(&m_outputData[0],
+		m_outputFunction(_output,
 		                 _time,
 		                 _inputNbChunk,
 		                 m_output.getFormat(),
 		                 m_output.getFrequency(),
 		                 m_output.getMap());
-		if (m_outputData.size() != _inputNbChunk*m_output.getMap().size()*m_formatSize) {
-			DRAIN_ERROR(" can not get enough data from user ... " << m_outputData.size() << " != " << _inputNbChunk*m_output.getMap().size());
-			return false;
-		}
-		_output = &m_outputData[0];
-		_outputNbChunk = _inputNbChunk;
 		return true;
 	}
 	return false;
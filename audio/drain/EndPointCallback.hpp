@@ -26,6 +26,7 @@ namespace audio {
 			private:
 				playbackFunction m_outputFunction;
 				recordFunction m_inputFunction;
+				bool m_outputClear; //!< Set the playback buffer at 0 before calling the user
 			protected:
 				/**
 				 * @brief Constructor
@@ -46,6 +47,20 @@ namespace audio {
 				                     size_t _inputNbChunk,
 				                     void*& _output,
 				                     size_t& _outputNbChunk);
+				/**
+				 * @brief Select if the playback buffer is cleared before calling the user (enable by default).
+				 * @param[in] _value false if the user callback always write all the requested chunks.
+				 */
+				void setOutputClear(bool _value) {
+					m_outputClear = _value;
+				}
+				/**
+				 * @brief Get the clear mode of the playback buffer.
+				 * @return true if the buffer is set at 0 before calling the user.
+				 */
+				bool getOutputClear() const {
+					return m_outputClear;
+				}
 		};
 	}
 }
@@ -8,14 +8,26 @@
 #include <audio/drain/debug.hpp>
 
 
-audio::drain::EndPointRead::EndPointRead() {
-	
+audio::drain::EndPointRead::EndPointRead() :
+  m_function(null),
+  m_timeSequence(0),
+  m_bufferSizeMicroseconds(1000000),
+  m_bufferSizeChunk(32),
+  m_bufferOverFlowSize(0) {
+	// The audio thread write in the buffer and the user read it ==> no mutex needed in the process
+	m_buffer.setLockFree(true);
 }
 
 
 void audio::drain::EndPointRead::init() {
 	audio::drain::EndPoint::init();
 	m_type = "EndPointRead";
+	if (    audio::getFormatBytes(m_input.getFormat())*m_input.getMap().size() != 0
+	     && m_input.getFrequency() != 0) {
+		m_buffer.setCapacity(m_bufferSizeMicroseconds,
+		                     audio::getFormatBytes(m_input.getFormat())*m_input.getMap().size(),
+		                     m_input.getFrequency());
+	}
 }
 
 ememory::SharedPtr<audio::drain::EndPointRead> audio::drain::EndPointRead::create() {
@@ -26,6 +38,19 @@ ememory::SharedPtr<audio::drain::EndPointRead> audio::drain::EndPointRead::creat
 
 void audio::drain::EndPointRead::configurationChange() {
 	audio::drain::EndPoint::configurationChange();
+	// update the buffer size ...
+	if (    audio::getFormatBytes(m_input.getFormat())*m_input.getMap().size() != 0
+	     && m_input.getFrequency() != 0) {
+		if (m_bufferSizeMicroseconds.get() != 0) {
+			m_buffer.setCapacity(m_bufferSizeMicroseconds,
+			                     audio::getFormatBytes(m_input.getFormat())*m_input.getMap().size(),
+			                     m_input.getFrequency());
+		} else {
+			m_buffer.setCapacity(m_bufferSizeChunk,
+			                     audio::getFormatBytes(m_input.getFormat())*m_input.getMap().size(),
+			                     m_input.getFrequency());
+		}
+	}
 	m_needProcess = true;
 }
 
@@ -36,34 +61,126 @@ bool audio::drain::EndPointRead::process(audio::Time& _time,
                                          void*& _output,
                                          size_t& _outputNbChunk){
 	audio::drain::AutoLogInOut tmpLog("EndPointRead");
-	return false;
+	// the data continue in the chain (nothing to change)
+	_output = _input;
+	_outputNbChunk = _inputNbChunk;
+	if (    _input == null
+	     || _inputNbChunk == 0) {
+		return true;
+	}
+	if (m_buffer.getCapacity() == 0) {
+		DRAIN_ERROR("Buffer not configured");
+		return false;
+	}
+	// never wait the user: when the buffer is full, the new data are dropped
+	m_timeSequence.fetch_add(1, std::memory_order_acq_rel);
+	size_t nbOverflow = m_buffer.write(_input, _inputNbChunk);
+	size_t nbChunkWritten = _inputNbChunk - nbOverflow;
+	m_timeWrite = _time + audio::Duration(0, int64_t(nbChunkWritten)*1000000000LL/int64_t(m_input.getFrequency()));
+	m_timeSequence.fetch_add(1, std::memory_order_acq_rel);
+	m_metric.addFill(m_buffer.getSize(), m_buffer.getCapacity());
+	if (nbOverflow != 0) {
+		m_metric.addOverflow(nbOverflow);
+		if (m_bufferOverFlowSize == 0) {
+			DRAIN_WARNING("User buffer full (drop " << nbOverflow << " chunks)");
+		}
+		m_bufferOverFlowSize += nbOverflow;
+		generateStatus(audio::drain::status_endPointReadOverflow);
+	} else if (m_bufferOverFlowSize != 0) {
+		DRAIN_WARNING("User buffer full (drop " << m_bufferOverFlowSize << " chunks [In the past])");
+		m_bufferOverFlowSize = 0;
+	}
+	if (    m_function != null
+	     && nbChunkWritten != 0) {
+		m_function(_time, nbChunkWritten, m_input.getFormat(), m_input.getFrequency(), m_input.getMap());
+	}
+	return true;
+}
+
+size_t audio::drain::EndPointRead::read(void* _value, size_t _nbChunk) {
+	audio::Time time;
+	return read(_value, _nbChunk, time);
+}
+
+size_t audio::drain::EndPointRead::read(void* _value, size_t _nbChunk, audio::Time& _time) {
+	// get a coherent couple (number of chunk, time of the last chunk) without locking the process
+	size_t bufferSize = 0;
+	audio::Time timeWrite;
+	while (true) {
+		uint32_t sequence = m_timeSequence.load(std::memory_order_acquire);
+		if ((sequence & 1) != 0) {
+			continue;
+		}
+		bufferSize = m_buffer.getSize();
+		timeWrite = m_timeWrite;
+		if (sequence == m_timeSequence.load(std::memory_order_acquire)) {
+			break;
+		}
+	}
+	size_t nbChunk = etk::min(_nbChunk, bufferSize);
+	if (nbChunk == 0) {
+		return 0;
+	}
+	_time = timeWrite - audio::Duration(0, int64_t(bufferSize)*1000000000LL/int64_t(m_input.getFrequency()));
+	DRAIN_VERBOSE("[ASYNC] Read data : " << nbChunk << " chunks" << " ==> " << m_input);
+	size_t nbUnderflow = m_buffer.read(_value, nbChunk);
+	return nbChunk - nbUnderflow;
+}
+
+audio::Duration audio::drain::EndPointRead::getLatency() const {
+	if (m_input.getFrequency() == 0) {
+		return audio::Duration(0);
+	}
+	return audio::Duration(0, int64_t(m_buffer.getSize())*1000000000LL/int64_t(m_input.getFrequency()));
 }
 
 void audio::drain::EndPointRead::setBufferSize(size_t _nbChunk) {
-	DRAIN_TODO("...");
+	m_bufferSizeMicroseconds = echrono::microseconds(0);
+	m_bufferSizeChunk = _nbChunk;
+	if (    audio::getFormatBytes(m_input.getFormat())*m_input.getMap().size() != 0
+	     && m_input.getFrequency() != 0) {
+		m_buffer.setCapacity(_nbChunk,
+		                     audio::getFormatBytes(m_input.getFormat())*m_input.getMap().size(),
+		                     float(m_input.getFrequency()));
+	}
 }
 
 void audio::drain::EndPointRead::setBufferSize(const echrono::microseconds& _time) {
-	DRAIN_TODO("...");
+	m_bufferSizeMicroseconds = _time;
+	m_bufferSizeChunk = 0;
+	if (    audio::getFormatBytes(m_input.getFormat())*m_input.getMap().size() != 0
+	     && m_input.getFrequency() != 0) {
+		m_buffer.setCapacity(_time,
+		                     audio::getFormatBytes(m_input.getFormat())*m_input.getMap().size(),
+		                     float(m_input.getFrequency()));
+	}
 }
 
 size_t audio::drain::EndPointRead::getBufferSize() {
-	DRAIN_TODO("...");
-	return 0;
+	if (m_bufferSizeChunk != 0) {
+		return m_bufferSizeChunk;
+	}
+	return (int64_t(m_input.getFrequency())*m_bufferSizeMicroseconds.get())/1000000000LL;
 }
 
 echrono::microseconds audio::drain::EndPointRead::getBufferSizeMicrosecond() {
-	DRAIN_TODO("...");
-	return echrono::microseconds(0);
+	if (m_bufferSizeMicroseconds.get() != 0) {
+		return m_bufferSizeMicroseconds;
+	}
+	if (m_input.getFrequency() == 0) {
+		return echrono::microseconds(0);
+	}
+	return echrono::microseconds(m_bufferSizeChunk*1000000LL/int64_t(m_input.getFrequency()));
 }
 
 size_t audio::drain::EndPointRead::getBufferFillSize() {
-	DRAIN_TODO("...");
-	return 0;
+	return m_buffer.getSize();
 }
 
 echrono::microseconds audio::drain::EndPointRead::getBufferFillSizeMicrosecond() {
-	DRAIN_TODO("...");
-	return echrono::microseconds(0);
+	if (m_input.getFrequency() == 0) {
+		return echrono::microseconds(0);
+	}
+	return echrono::microseconds(getBufferFillSize()*1000000LL/int64_t(m_input.getFrequency()));
 }
 
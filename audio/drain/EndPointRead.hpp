@@ -6,10 +6,23 @@
 #pragma once
 
 #include <audio/drain/EndPoint.hpp>
+#include <etk/Function.hpp>
+#include <audio/drain/CircularBuffer.hpp>
+#include <atomic>
 
 namespace audio {
 	namespace drain{
+		typedef etk::Function<void (const audio::Time& _time,
+		                              size_t _nbChunk,
+		                              enum audio::format _format,
+		                              uint32_t _frequency,
+		                              const etk::Vector<audio::channel>& _map)> recordFunctionRead;
 		class EndPointRead : public EndPoint {
+			private:
+				audio::drain::CircularBuffer m_buffer; //!< single producer (process) / single consumer (read) FIFO
+				recordFunctionRead m_function;
+				std::atomic<uint32_t> m_timeSequence; //!< Odd while the process update the buffer and m_timeWrite
+				audio::Time m_timeWrite; //!< Time of the chunk after the last chunk written in the buffer
 			protected:
 				/**
 				 * @brief Constructor
@@ -28,6 +41,38 @@ namespace audio {
 				                     size_t _inputNbChunk,
 				                     void*& _output,
 				                     size_t& _outputNbChunk);
+				/**
+				 * @brief Read data from the internal buffer (lock-free: must be called by only one thread).
+				 * @param[out] _value Pointer on the data.
+				 * @param[in] _nbChunk Number of chunk requested.
+				 * @return Number of chunk read (can be less than requested).
+				 */
+				virtual size_t read(void* _value, size_t _nbChunk);
+				/**
+				 * @brief Read data from the internal buffer with the time of the first chunk (lock-free: must be called by only one thread).
+				 * @param[out] _value Pointer on the data.
+				 * @param[in] _nbChunk Number of chunk requested.
+				 * @param[out] _time Capture time of the first chunk read.
+				 * @return Number of chunk read (can be less than requested).
+				 */
+				virtual size_t read(void* _value, size_t _nbChunk, audio::Time& _time);
+				/**
+				 * @brief Get the delay of the data captured and not read by the user yet.
+				 * @return Duration of the data in the buffer.
+				 */
+				virtual audio::Duration getLatency() const;
+				/**
+				 * @brief Set the function called when new data are available in the buffer (called in the process thread).
+				 * @param[in] _function Function to call.
+				 */
+				virtual void setCallback(recordFunctionRead _function) {
+					m_function = _function;
+				}
+			protected:
+				echrono::microseconds m_bufferSizeMicroseconds; // 0 if m_bufferSizeChunk != 0
+				size_t m_bufferSizeChunk; // 0 if m_bufferSizeMicroseconds != 0
+				size_t m_bufferOverFlowSize; //!< Limit display of overflow in the process
+			public:
 				/**
 				 * @brief Set buffer size in chunk number
 				 * @param[in] _nbChunk Number of chunk in the buffer
@@ -5,14 +5,32 @@
  */
 #include <audio/drain/EndPointWrite.hpp>
 #include <audio/drain/debug.hpp>
+#include <type_traits>
 
 
 audio::drain::EndPointWrite::EndPointWrite() :
   m_function(null),
+  m_overflowPolicy(audio::drain::overflowPolicy_dropNewest),
   m_bufferSizeMicroseconds(1000000),
   m_bufferSizeChunk(32),
-  m_bufferUnderFlowSize(0) {
-	
+  m_bufferUnderFlowSize(0),
+  m_bufferPending(0),
+  m_lowWatermark(0),
+  m_highWatermark(0),
+  m_watermarkAutoTune(false),
+  m_watermarkTuneChunk(0),
+  m_watermarkTuneCount(0),
+  m_driftCompensation(false),
+  m_driftTarget(0),
+  m_driftMaxCorrection(1000),
+  m_driftRatio(1.0),
+  m_driftFill(-1.0),
+  m_driftIntegral(0.0),
+  m_driftPhase(0.0),
+  m_driftPrimed(false),
+  m_driftFunction(null) {
+	// The user write in the buffer and the audio thread read it ==> no mutex needed in the process
+	m_buffer.setLockFree(true);
 }
 
 void audio::drain::EndPointWrite::init() {
@@ -32,8 +50,60 @@ ememory::SharedPtr<audio::drain::EndPointWrite> audio::drain::EndPointWrite::cre
 	return tmp;
 }
 
+/**
+ * @brief Linear interpolation of the output chunks at a fractional position of the input.
+ */
+template<typename TYPE>
+static void driftInterpolate(const void* _input, void* _output, size_t _nbChunk, size_t _nbChannel, double _position, double _ratio) {
+	const TYPE* in = static_cast<const TYPE*>(_input);
+	TYPE* out = static_cast<TYPE*>(_output);
+	for (size_t iii=0; iii<_nbChunk; ++iii) {
+		size_t id = size_t(_position);
+		double coef = _position - double(id);
+		const TYPE* first = &in[id*_nbChannel];
+		const TYPE* second = first + _nbChannel;
+		for (size_t jjj=0; jjj<_nbChannel; ++jjj) {
+			double value = double(first[jjj]) + (double(second[jjj]) - double(first[jjj])) * coef;
+			if (std::is_integral<TYPE>::value == true) {
+				// between 2 values of the type: no saturation needed
+				value = value < 0.0 ? value - 0.5 : value + 0.5;
+			}
+			*out++ = TYPE(value);
+		}
+		_position += _ratio;
+	}
+}
+
 void audio::drain::EndPointWrite::configurationChange() {
 	audio::drain::EndPoint::configurationChange();
+	m_bufferPending = 0;
+	m_driftPrimed = false;
+	m_driftPhase = 0.0;
+	m_driftFill = -1.0;
+	m_driftIntegral = 0.0;
+	m_driftRatio = 1.0;
+	switch (m_output.getFormat()) {
+		case audio::format_int16:
+			m_driftFunction = &driftInterpolate<int16_t>;
+			break;
+		case audio::format_int16_on_int32:
+		case audio::format_int32:
+			m_driftFunction = &driftInterpolate<int32_t>;
+			break;
+		case audio::format_float:
+			m_driftFunction = &driftInterpolate<float>;
+			break;
+		case audio::format_double:
+			m_driftFunction = &driftInterpolate<double>;
+			break;
+		default:
+			m_driftFunction = null;
+			break;
+	}
+	if (    m_driftCompensation == true
+	     && m_driftFunction == null) {
+		DRAIN_WARNING("No drift compensation for the format " << m_output.getFormat());
+	}
 	// update the buffer size ...
 	if (    audio::getFormatBytes(m_output.getFormat())*m_output.getMap().size() != 0
 	     && m_output.getFrequency() != 0) {
@@ -47,6 +117,7 @@ void audio::drain::EndPointWrite::configurationChange() {
 			                     m_output.getFrequency());
 		}
 	}
+	updateDriftBuffer();
 	m_needProcess = true;
 }
 
@@ -57,22 +128,39 @@ bool audio::drain::EndPointWrite::process(audio::Time& _time,
                                           void*& _output,
                                           size_t& _outputNbChunk){
 	audio::drain::AutoLogInOut tmpLog("EndPointWrite");
+	if (m_bufferPending != 0) {
+		// the previous data are not used anymore by the next algos
+		m_buffer.commit(m_bufferPending);
+		m_bufferPending = 0;
+	}
 	//DRAIN_INFO("                              nb Sample in buffer : " << m_buffer.size());
 	if (m_function != null) {
-		// TODO : Rework this ...
-		if (m_buffer.getSize() <= 20000) {
-			m_function(_time, _inputNbChunk, m_output.getFormat(), m_output.getFrequency(), m_output.getMap());
+		size_t low = 0;
+		size_t high = 0;
+		getWatermarkChunk(low, high);
+		size_t fillSize = m_buffer.getSize();
+		if (fillSize <= low) {
+			// request enough data to reach the high watermark (and at least this period)
+			size_t nbChunk = etk::max(high, _inputNbChunk) - fillSize;
+			m_function(_time, nbChunk, m_output.getFormat(), m_output.getFrequency(), m_output.getMap());
 		}
 	}
+	return processBuffer(_inputNbChunk, _output, _outputNbChunk);
+}
+
+bool audio::drain::EndPointWrite::processBuffer(size_t _inputNbChunk,
+                                                void*& _output,
+                                                size_t& _outputNbChunk) {
 	// resize output buffer:
 	//DRAIN_INFO("    resize : " << (int32_t)m_formatSize << "*" << (int32_t)_inputNbChunk << "*" << (int32_t)m_outputMap.size());
-	m_outputData.resize(m_formatSize*_inputNbChunk*m_output.getMap().size());
 	// set output pointer:
-	_outputNbChunk = m_outputData.size()/(m_formatSize*m_output.getMap().size());
-	_output = &m_outputData[0];
-	ethread::UniqueLock lock(m_mutex);
+	_outputNbChunk = _inputNbChunk;
+	_output = getOutputBuffer(_outputNbChunk);
 	// check if data in the tmpBuffer
-	if (m_buffer.getSize() == 0) {
+	size_t bufferSize = m_buffer.getSize();
+	m_metric.addFill(bufferSize, m_buffer.getCapacity());
+	if (bufferSize == 0) {
+		m_metric.addUnderflow(_outputNbChunk);
 		if (m_bufferUnderFlowSize == 0) {
 			DRAIN_WARNING("No data in the user buffer (write null data ... " << _outputNbChunk << " chunks)");
 			m_bufferUnderFlowSize = 1;
@@ -82,26 +170,61 @@ bool audio::drain::EndPointWrite::process(audio::Time& _time,
 			}
 			m_bufferUnderFlowSize += _outputNbChunk;
 		}
-		// clear the buffer to force the flush on the next elements ...
-		m_outputData.clear();
+		// send no data to force the flush on the next elements ...
 		_outputNbChunk = 0;
-		generateStatus("EPW_UNDERFLOW");
+		generateStatus(audio::drain::status_endPointWriteUnderflow);
 		// just send no data ...
 		return true;
 	} else if (m_bufferUnderFlowSize > 1) {
 		DRAIN_WARNING("No data in the user buffer (write null data ... " << m_bufferUnderFlowSize << " chunks [In the past])");
 	}
 	m_bufferUnderFlowSize = 0;
+	if (    m_driftCompensation == true
+	     && m_driftFunction != null) {
+		updateDriftRatio();
+		if (processDrift(_output, _outputNbChunk) == true) {
+			return true;
+		}
+		// not enough data: direct copy, the interpolation restart on the next period
+		m_driftPrimed = false;
+		m_driftPhase = 0.0;
+	}
 	DRAIN_VERBOSE("Write " << _outputNbChunk << " chunks");
 	// check if we have enought data:
-	int32_t nbChunkToCopy = etk::min(_inputNbChunk, m_buffer.getSize());
+	size_t nbChunkToCopy = etk::min(_inputNbChunk, bufferSize);
 	if (nbChunkToCopy != _inputNbChunk) {
-		generateStatus("EPW_UNDERFLOW");
+		m_metric.addUnderflow(_inputNbChunk - nbChunkToCopy);
+		generateStatus(audio::drain::status_endPointWriteUnderflow);
 	}
-	DRAIN_VERBOSE("      " << nbChunkToCopy << " chunks ==> " << nbChunkToCopy*m_output.getMap().size()*m_formatSize << " Byte sizeBuffer=" << m_buffer.getSize());
+	if (m_watermarkAutoTune == true) {
+		size_t low = 0;
+		size_t high = 0;
+		getWatermarkChunk(low, high);
+		if (nbChunkToCopy != _inputNbChunk) {
+			// underflow ==> keep one more period in the buffer
+			m_watermarkTuneChunk = etk::min(low + _inputNbChunk, high);
+			m_watermarkTuneCount = 0;
+		} else if (++m_watermarkTuneCount >= 1024) {
+			// stable ==> reduce the latency of 1/8 period (never less than one period)
+			m_watermarkTuneChunk = etk::max(low - etk::min(low, _inputNbChunk/8), _inputNbChunk);
+			m_watermarkTuneCount = 0;
+		}
+	}
+	DRAIN_VERBOSE("      " << nbChunkToCopy << " chunks ==> " << nbChunkToCopy*m_output.getMap().size()*m_formatSize << " Byte sizeBuffer=" << bufferSize);
 	_outputNbChunk = nbChunkToCopy;
+	if (    m_buffer.getMirror() == true
+	     && m_driftCompensation == false
+	     && m_overflowPolicy.load() != audio::drain::overflowPolicy_dropOldest) {
+		// (the writer can overwrite the data given in place in overwrite mode)
+		// the data are contiguous ==> give them in place (released on the next call)
+		const void* data = null;
+		_outputNbChunk = m_buffer.peekContiguous(data, nbChunkToCopy);
+		_output = const_cast<void*>(data);
+		m_bufferPending = _outputNbChunk;
+		return true;
+	}
 	// copy data to the output:
-	int32_t nbUnderflow = m_buffer.read(_output, nbChunkToCopy);
+	size_t nbUnderflow = m_buffer.read(_output, nbChunkToCopy);
 	if (nbUnderflow != 0) {
 		DRAIN_WARNING("Undeflow in FIFO ...");
 		_outputNbChunk -= nbUnderflow;
@@ -109,18 +232,85 @@ bool audio::drain::EndPointWrite::process(audio::Time& _time,
 	return true;
 }
 
-void audio::drain::EndPointWrite::write(const void* _value, size_t _nbChunk) {
-	ethread::UniqueLock lock(m_mutex);
+size_t audio::drain::EndPointWrite::write(const void* _value, size_t _nbChunk) {
 	DRAIN_VERBOSE("[ASYNC] Write data : " << _nbChunk << " chunks" << " ==> " << m_output);
-	int32_t nbOverflow = m_buffer.write(_value, _nbChunk);
+	switch (m_overflowPolicy.load()) {
+		case audio::drain::overflowPolicy_reject:
+			if (m_buffer.getFreeSize() < _nbChunk) {
+				// the producer retry later with the same data
+				DRAIN_VERBOSE("Reject the write: " << _nbChunk << " chunks for " << m_buffer.getFreeSize() << " free");
+				return 0;
+			}
+			m_buffer.write(_value, _nbChunk);
+			return _nbChunk;
+		case audio::drain::overflowPolicy_dropOldest: {
+				size_t nbOverflow = m_buffer.write(_value, _nbChunk);
+				if (nbOverflow > 0) {
+					DRAIN_WARNING("Overflow in output buffer : " << nbOverflow << " old chunks dropped");
+					m_metric.addOverflow(nbOverflow);
+				}
+				// only the end of a block bigger than the buffer is kept
+				return etk::min(_nbChunk, m_buffer.getCapacity());
+			}
+		case audio::drain::overflowPolicy_dropNewest:
+			break;
+	}
+	size_t nbOverflow = m_buffer.write(_value, _nbChunk);
 	if (nbOverflow > 0) {
 		DRAIN_ERROR("Overflow in output buffer : " << nbOverflow << " / " << _nbChunk);
+		m_metric.addOverflow(nbOverflow);
+	}
+	return _nbChunk - nbOverflow;
+}
+
+size_t audio::drain::EndPointWrite::writev(const audio::drain::CircularBufferWriteSpan* _span, size_t _nbSpan) {
+	size_t nbChunk = 0;
+	for (size_t iii=0; iii<_nbSpan; ++iii) {
+		nbChunk += _span[iii].m_nbChunk;
+	}
+	DRAIN_VERBOSE("[ASYNC] Write data : " << _nbSpan << " fragments, " << nbChunk << " chunks" << " ==> " << m_output);
+	switch (m_overflowPolicy.load()) {
+		case audio::drain::overflowPolicy_reject:
+			if (m_buffer.getFreeSize() < nbChunk) {
+				DRAIN_VERBOSE("Reject the write: " << nbChunk << " chunks for " << m_buffer.getFreeSize() << " free");
+				return 0;
+			}
+			m_buffer.writev(_span, _nbSpan);
+			return nbChunk;
+		case audio::drain::overflowPolicy_dropOldest: {
+				size_t nbOverflow = m_buffer.writev(_span, _nbSpan);
+				if (nbOverflow > 0) {
+					DRAIN_WARNING("Overflow in output buffer : " << nbOverflow << " old chunks dropped");
+					m_metric.addOverflow(nbOverflow);
+				}
+				return etk::min(nbChunk, m_buffer.getCapacity());
+			}
+		case audio::drain::overflowPolicy_dropNewest:
+			break;
+	}
+	size_t nbOverflow = m_buffer.writev(_span, _nbSpan);
+	if (nbOverflow > 0) {
+		DRAIN_ERROR("Overflow in output buffer : " << nbOverflow << " / " << nbChunk);
+		m_metric.addOverflow(nbOverflow);
+	}
+	return nbChunk - nbOverflow;
+}
+
+bool audio::drain::EndPointWrite::setOverflowPolicy(enum audio::drain::overflowPolicy _value) {
+	if (m_buffer.getSize() != 0) {
+		DRAIN_ERROR("Can not change the overflow policy with data in the buffer (stop the stream first)");
+		return false;
 	}
+	m_overflowPolicy.store(_value);
+	// only the drop of the oldest data need to move the read position from the writer
+	m_buffer.setOverwrite(_value == audio::drain::overflowPolicy_dropOldest);
+	return true;
 }
 
 void audio::drain::EndPointWrite::setBufferSize(size_t _nbChunk) {
 	m_bufferSizeMicroseconds = echrono::microseconds(0);
 	m_bufferSizeChunk = _nbChunk;
+	m_bufferPending = 0;
 	if (    audio::getFormatBytes(m_output.getFormat())*m_output.getMap().size() != 0
 	     && m_output.getFrequency() != 0) {
 		m_buffer.setCapacity(_nbChunk,
@@ -132,6 +322,7 @@ void audio::drain::EndPointWrite::setBufferSize(size_t _nbChunk) {
 void audio::drain::EndPointWrite::setBufferSize(const echrono::microseconds& _time) {
 	m_bufferSizeMicroseconds = _time;
 	m_bufferSizeChunk = 0;
+	m_bufferPending = 0;
 	m_buffer.setCapacity(_time,
 	                     audio::getFormatBytes(m_output.getFormat())*m_output.getMap().size(),
 	                     float(m_output.getFrequency()));
@@ -151,8 +342,143 @@ echrono::microseconds audio::drain::EndPointWrite::getBufferSizeMicrosecond() {
 	return echrono::microseconds(m_bufferSizeChunk*1000000LL/int64_t(m_output.getFrequency()));
 }
 
+audio::Duration audio::drain::EndPointWrite::getLatency() const {
+	if (m_output.getFrequency() == 0) {
+		return audio::Duration(0);
+	}
+	// the chunks given in place to the next algos are already played
+	size_t nbChunk = m_buffer.getSize();
+	nbChunk -= etk::min(nbChunk, m_bufferPending);
+	return audio::Duration(0, int64_t(nbChunk)*1000000000LL/int64_t(m_output.getFrequency()));
+}
+
 size_t audio::drain::EndPointWrite::getBufferFillSize() {
-	return m_buffer.getSize()/(audio::getFormatBytes(m_output.getFormat())*m_output.getMap().size());
+	return m_buffer.getSize();
+}
+
+void audio::drain::EndPointWrite::setWatermark(const echrono::microseconds& _low, const echrono::microseconds& _high) {
+	m_lowWatermark = _low;
+	m_highWatermark = _high;
+	m_watermarkTuneChunk = 0;
+	m_watermarkTuneCount = 0;
+}
+
+void audio::drain::EndPointWrite::setWatermarkAutoTune(bool _value) {
+	m_watermarkAutoTune = _value;
+	m_watermarkTuneChunk = 0;
+	m_watermarkTuneCount = 0;
+}
+
+void audio::drain::EndPointWrite::setDriftCompensation(bool _value) {
+	m_driftCompensation = _value;
+	m_driftPrimed = false;
+	m_driftPhase = 0.0;
+	m_driftFill = -1.0;
+	m_driftIntegral = 0.0;
+	m_driftRatio = 1.0;
+	m_metric.setDrift(m_driftRatio);
+	if (    m_driftCompensation == true
+	     && m_driftFunction == null
+	     && m_output.getConfigured() == true) {
+		DRAIN_WARNING("No drift compensation for the format " << m_output.getFormat());
+	}
+}
+
+void audio::drain::EndPointWrite::setDriftTarget(const echrono::microseconds& _target, int32_t _maxCorrection) {
+	m_driftTarget = _target;
+	m_driftMaxCorrection = etk::max(_maxCorrection, int32_t(0));
+	m_driftIntegral = 0.0;
+	updateDriftBuffer();
+}
+
+void audio::drain::EndPointWrite::processBufferSizeChange() {
+	updateDriftBuffer();
+}
+
+void audio::drain::EndPointWrite::updateDriftBuffer() {
+	size_t chunkSize = m_output.getChunkSize();
+	if (chunkSize == 0) {
+		return;
+	}
+	// chunks read by the biggest process call at the fastest read speed (phase < 1), after the 2 chunks of history
+	double maxRatio = 1.0 + double(m_driftMaxCorrection) * 0.000001;
+	size_t nbRead = size_t(2.0 + double(getProcessBufferSize())*maxRatio) + 1;
+	m_driftBuffer.resize((nbRead+2)*chunkSize);
+	m_driftHistory.resize(2*chunkSize);
+}
+
+void audio::drain::EndPointWrite::updateDriftRatio() {
+	double target = double(m_buffer.getCapacity()/2);
+	if (m_driftTarget.get() != 0) {
+		target = double(int64_t(m_output.getFrequency())*m_driftTarget.get())/1000000000.0;
+	}
+	target = etk::max(target, 1.0);
+	double fill = double(m_buffer.getSize());
+	if (m_driftFill < 0.0) {
+		m_driftFill = fill;
+	} else {
+		// the user write by block: only the mean level is followed
+		m_driftFill += (fill - m_driftFill) / 16.0;
+	}
+	double maxCorrection = double(m_driftMaxCorrection) * 0.000001;
+	double error = (m_driftFill - target) / target;
+	m_driftIntegral = etk::avg(-maxCorrection, m_driftIntegral + error*maxCorrection/64.0, maxCorrection);
+	// buffer too full ==> read faster
+	m_driftRatio = 1.0 + etk::avg(-maxCorrection, error*maxCorrection + m_driftIntegral, maxCorrection);
+	m_metric.setDrift(m_driftRatio);
+}
+
+bool audio::drain::EndPointWrite::processDrift(void* _output, size_t _nbChunk) {
+	if (_nbChunk == 0) {
+		return true;
+	}
+	size_t chunkSize = m_output.getChunkSize();
+	// chunk needed after the history: the last output is between the chunk nbRead-1 and nbRead
+	size_t nbRead = size_t(m_driftPhase + 1.0 + double(_nbChunk-1)*m_driftRatio);
+	size_t nbNeeded = nbRead;
+	if (m_driftPrimed == false) {
+		nbNeeded++;
+	}
+	if (m_buffer.getSize() < nbNeeded) {
+		return false;
+	}
+	if (    m_driftBuffer.size() < (nbRead+2)*chunkSize
+	     || m_driftHistory.size() < 2*chunkSize) {
+		// bigger than the process buffer size (@see updateDriftBuffer): direct copy for this period
+		DRAIN_WARNING("Drift buffer too small for " << _nbChunk << " chunks");
+		return false;
+	}
+	if (m_driftPrimed == false) {
+		// start on the first chunk of the buffer
+		m_buffer.read(&m_driftBuffer[chunkSize], 1);
+		memcpy(&m_driftBuffer[0], &m_driftBuffer[chunkSize], chunkSize);
+		m_driftPhase = 0.0;
+		m_driftPrimed = true;
+	} else {
+		memcpy(&m_driftBuffer[0], &m_driftHistory[0], 2*chunkSize);
+	}
+	m_buffer.read(&m_driftBuffer[2*chunkSize], nbRead);
+	// the phase is relative to the last chunk of the previous period (id 1 of the buffer, can be a little negative)
+	m_driftFunction(&m_driftBuffer[0], _output, _nbChunk, m_output.getMap().size(), m_driftPhase + 1.0, m_driftRatio);
+	memcpy(&m_driftHistory[0], &m_driftBuffer[nbRead*chunkSize], 2*chunkSize);
+	m_driftPhase += double(_nbChunk)*m_driftRatio - double(nbRead);
+	return true;
+}
+
+void audio::drain::EndPointWrite::getWatermarkChunk(size_t& _low, size_t& _high) {
+	size_t capacity = m_buffer.getCapacity();
+	_high = capacity;
+	if (m_highWatermark.get() != 0) {
+		_high = etk::min(capacity, size_t((int64_t(m_output.getFrequency())*m_highWatermark.get())/1000000000LL));
+	}
+	if (m_watermarkTuneChunk != 0) {
+		_low = m_watermarkTuneChunk;
+	} else if (m_lowWatermark.get() != 0) {
+		_low = size_t((int64_t(m_output.getFrequency())*m_lowWatermark.get())/1000000000LL);
+	} else {
+		_low = capacity/2;
+	}
+	_low = etk::min(_low, _high);
 }
 
 echrono::microseconds audio::drain::EndPointWrite::getBufferFillSizeMicrosecond() {
@@ -7,11 +7,19 @@
 
 #include <audio/drain/EndPoint.hpp>
 #include <etk/Function.hpp>
-#include <ethread/Mutex.hpp>
 #include <audio/drain/CircularBuffer.hpp>
+#include <atomic>
 
 namespace audio {
 	namespace drain{
+		/**
+		 * @brief Behavior of EndPointWrite::write when the data does not fit in the buffer.
+		 */
+		enum overflowPolicy {
+			overflowPolicy_dropNewest, //!< Keep the data of the buffer, write only the chunks that fit (lock-free)
+			overflowPolicy_dropOldest, //!< Overwrite the oldest data of the buffer (lock-free: the writer move the read position with a compare and swap)
+			overflowPolicy_reject, //!< Write nothing if all the chunks does not fit (lock-free)
+		};
 		typedef etk::Function<void (const audio::Time& _time,
 		                              size_t _nbChunk,
 		                              enum audio::format _format,
@@ -19,9 +27,15 @@ namespace audio {
 		                              const etk::Vector<audio::channel>& _map)> playbackFunctionWrite;
 		class EndPointWrite : public EndPoint {
 			private:
-				audio::drain::CircularBuffer m_buffer;
+				audio::drain::CircularBuffer m_buffer; //!< single producer (write) / single consumer (process) FIFO
 				playbackFunctionWrite m_function;
-				ethread::Mutex m_mutex;
+				std::atomic<enum audio::drain::overflowPolicy> m_overflowPolicy; //!< Behavior of write on a full buffer (changed only when the stream is stopped)
+				/**
+				 * @brief Get the data of the period from the buffer (after the write callback).
+				 */
+				bool processBuffer(size_t _inputNbChunk,
+				                   void*& _output,
+				                   size_t& _outputNbChunk);
 			protected:
 				/**
 				 * @brief Constructor
@@ -35,12 +49,54 @@ namespace audio {
 				 */
 				virtual ~EndPointWrite() {};
 				virtual void configurationChange();
+			protected:
+				virtual void processBufferSizeChange();
+			public:
 				virtual bool process(audio::Time& _time,
 				                     void* _input,
 				                     size_t _inputNbChunk,
 				                     void*& _output,
 				                     size_t& _outputNbChunk);
-				virtual void write(const void* _value, size_t _nbChunk);
+				/**
+				 * @brief Write data in the internal buffer (must be called by only one thread).
+				 * @param[in] _value Pointer on the data.
+				 * @param[in] _nbChunk Number of chunk to write.
+				 * @return Number of chunk accepted (the others are dropped, @see setOverflowPolicy).
+				 */
+				virtual size_t write(const void* _value, size_t _nbChunk);
+				/**
+				 * @brief Write a list of fragments (network packets, codec frames ...) in the internal buffer with a single update of the buffer.
+				 * @param[in] _span List of fragments (written in order).
+				 * @param[in] _nbSpan Number of fragment.
+				 * @return Number of chunk accepted (@see write).
+				 */
+				virtual size_t writev(const audio::drain::CircularBufferWriteSpan* _span, size_t _nbSpan);
+				/**
+				 * @brief Get the number of chunk that can be written without overflow.
+				 * @return Number of free chunk in the buffer.
+				 */
+				size_t getAvailableSpace() const {
+					return m_buffer.getFreeSize();
+				}
+				/**
+				 * @brief Set the behavior of write when the buffer is full.
+				 * @note Only while the stream is stopped (the buffer must be empty).
+				 * @param[in] _value New policy (default overflowPolicy_dropNewest).
+				 * @return true if the policy is changed.
+				 */
+				bool setOverflowPolicy(enum audio::drain::overflowPolicy _value);
+				/**
+				 * @brief Get the behavior of write when the buffer is full.
+				 * @return The current policy.
+				 */
+				enum audio::drain::overflowPolicy getOverflowPolicy() const {
+					return m_overflowPolicy.load();
+				}
+				/**
+				 * @brief Get the delay of the data written by the user and not played yet.
+				 * @return Duration of the data in the buffer.
+				 */
+				virtual audio::Duration getLatency() const;
 				virtual void setCallback(playbackFunctionWrite _function) {
 					m_function = _function;
 				}
@@ -48,12 +104,111 @@ namespace audio {
 				echrono::microseconds m_bufferSizeMicroseconds; // 0 if m_bufferSizeChunk != 0
 				size_t m_bufferSizeChunk; // 0 if m_bufferSizeMicroseconds != 0
 				size_t m_bufferUnderFlowSize; //!< Limit display of underflow in the write callback
+				size_t m_bufferPending; //!< Number of chunk given in place to the next algos (released on the next process)
+				echrono::microseconds m_lowWatermark; //!< Call the user when the buffer contain less (0: half of the buffer)
+				echrono::microseconds m_highWatermark; //!< Fill level requested to the user (0: all the buffer)
+				bool m_watermarkAutoTune; //!< Increase the low watermark on underflow and decrease it slowly when no underflow
+				size_t m_watermarkTuneChunk; //!< Low watermark (in chunk) found by the auto tune (0 when not started)
+				size_t m_watermarkTuneCount; //!< Number of period without underflow
+				typedef void (*driftFunction)(const void* _input, void* _output, size_t _nbChunk, size_t _nbChannel, double _position, double _ratio);
+				bool m_driftCompensation; //!< Adapt the read speed to keep the buffer at the target fill level
+				echrono::microseconds m_driftTarget; //!< Target fill level (0: half of the buffer)
+				int32_t m_driftMaxCorrection; //!< Maximum correction of the read speed in ppm
+				double m_driftRatio; //!< Current read speed (input chunk by output chunk)
+				double m_driftFill; //!< Filtered fill level of the buffer (-1 before the first period)
+				double m_driftIntegral; //!< Integral part of the correction
+				double m_driftPhase; //!< Fractional position of the next output after the last input chunk
+				bool m_driftPrimed; //!< m_driftHistory contain the 2 last chunks read
+				etk::Vector<int8_t> m_driftHistory; //!< 2 last chunks read (interpolation between periods)
+				etk::Vector<int8_t> m_driftBuffer; //!< History followed by the chunks read for the current period
+				driftFunction m_driftFunction; //!< Interpolation kernel of the output format (null if not supported)
+				/**
+				 * @brief Update the read speed with the fill level of the buffer.
+				 */
+				void updateDriftRatio();
+				/**
+				 * @brief Read the buffer at the current read speed (linear interpolation).
+				 * @param[in] _output Output buffer.
+				 * @param[in] _nbChunk Number of chunk to generate.
+				 * @return false Not enough data in the buffer (nothing done).
+				 */
+				bool processDrift(void* _output, size_t _nbChunk);
+				/**
+				 * @brief Allocate the drift buffers for a process call at the maximum correction (no allocation in the process).
+				 */
+				void updateDriftBuffer();
+				/**
+				 * @brief Get the watermarks in chunk.
+				 * @param[out] _low Low watermark in chunk.
+				 * @param[out] _high High watermark in chunk.
+				 */
+				void getWatermarkChunk(size_t& _low, size_t& _high);
 			public:
+				/**
+				 * @brief Set the fill level that trigger the write callback (the callback receive the number of chunk to reach the high watermark).
+				 * @param[in] _low The callback is called when the buffer contain less than this duration (0: half of the buffer).
+				 * @param[in] _high The callback is requested to fill the buffer up to this duration (0: all the buffer).
+				 */
+				void setWatermark(const echrono::microseconds& _low, const echrono::microseconds& _high);
+				/**
+				 * @brief Get the low watermark.
+				 * @return Duration of the low watermark (0: half of the buffer).
+				 */
+				const echrono::microseconds& getLowWatermark() const {
+					return m_lowWatermark;
+				}
+				/**
+				 * @brief Get the high watermark.
+				 * @return Duration of the high watermark (0: all the buffer).
+				 */
+				const echrono::microseconds& getHighWatermark() const {
+					return m_highWatermark;
+				}
+				/**
+				 * @brief Adapt the low watermark to the underflows (start at the requested low watermark).
+				 * @param[in] _value New state.
+				 */
+				void setWatermarkAutoTune(bool _value);
+				/**
+				 * @brief Compensate the drift between the clock of the producer and the clock of the device: the buffer is
+				 * read a little faster or slower (fractional resampling of some ppm) to stay at the target fill level.
+				 * @note Available for the formats int16, int16_on_int32, int32, float and double.
+				 * @param[in] _value New state.
+				 */
+				void setDriftCompensation(bool _value);
+				/**
+				 * @brief Get the state of the drift compensation.
+				 * @return true The read speed follow the fill level.
+				 */
+				bool getDriftCompensation() const {
+					return m_driftCompensation;
+				}
+				/**
+				 * @brief Set the fill level kept by the drift compensation.
+				 * @param[in] _target Duration of data in the buffer (0: half of the buffer).
+				 * @param[in] _maxCorrection Maximum correction of the read speed in ppm (1000: 0.1%).
+				 */
+				void setDriftTarget(const echrono::microseconds& _target, int32_t _maxCorrection=1000);
+				/**
+				 * @brief Get the current read speed of the drift compensation.
+				 * @return Number of chunk read by chunk played (1.0 without drift).
+				 */
+				double getDriftRatio() const {
+					return m_driftRatio;
+				}
 				/**
 				 * @brief Set buffer size in chunk number
 				 * @param[in] _nbChunk Number of chunk in the buffer
 				 */
 				virtual void setBufferSize(size_t _nbChunk);
+				/**
+				 * @brief Use a mirrored memory for the buffer: the next algos read the data directly in it (no copy).
+				 * @param[in] _value New state.
+				 */
+				void setBufferMirror(bool _value) {
+					m_bufferPending = 0;
+					m_buffer.setMirror(_value);
+				}
 				/**
 				 * @brief Set buffer size size of the buffer with the stored time in s
 				 * @param[in] _time Time in microsecond of the buffer
@@ -11,16 +11,65 @@
 // see http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt
 // see http://www.earlevel.com/main/2013/10/13/biquad-calculator-v2/
 
-audio::drain::Equalizer::Equalizer() {
+audio::drain::EqualizerBand::EqualizerBand() :
+  m_type(audio::algo::drain::biQuadType_none),
+  m_frequencyCut(0.0),
+  m_qualityFactor(0.0),
+  m_gain(0.0),
+  m_direct(false) {
+	
+}
+
+bool audio::drain::EqualizerBand::parse(const ejson::Object& _object) {
+	etk::String typeString = _object["type"].toString().get("none");
+	if (typeString == "direct-value") {
+		m_direct = true;
+		m_coefficient.setBiquadCoef(_object["a0"].toNumber().get(0.0),
+		                            _object["a1"].toNumber().get(0.0),
+		                            _object["a2"].toNumber().get(0.0),
+		                            _object["b0"].toNumber().get(0.0),
+		                            _object["b1"].toNumber().get(0.0));
+		return true;
+	}
+	m_direct = false;
+	m_type = audio::algo::drain::biQuadType_none;
+	if (etk::from_string(m_type, typeString) == false) {
+		DRAIN_ERROR("Can not parse equalizer type:'" << typeString << "'");
+		return false;
+	}
+	m_gain = _object["gain"].toNumber().get(0.0);
+	m_frequencyCut = _object["cut-frequency"].toNumber().get(0.0);
+	m_qualityFactor = _object["quality"].toNumber().get(0.0);
+	return true;
+}
+
+void audio::drain::EqualizerBand::compute(float _sampleRate, audio::drain::Biquad& _biquad) const {
+	if (m_direct == true) {
+		_biquad = m_coefficient;
+		return;
+	}
+	_biquad.setBiquad(m_type, m_frequencyCut, m_qualityFactor, m_gain, _sampleRate);
+}
+
+audio::drain::Equalizer::Equalizer() :
+  m_nativeEngine(true),
+  m_interpolation(0.0f),
+  m_antiDenormal(false),
+  m_resetRequest(false),
+  m_silentMemory(true) {
 	
 }
 
 void audio::drain::Equalizer::init() {
 	audio::drain::Algo::init();
 	audio::drain::Algo::m_type = "Equalizer";
+	// int16 and float have a dedicated engine, int32 is filtered in float
 	m_supportedFormat.pushBack(audio::format_int16);
-	m_supportedFormat.pushBack(audio::format_int16);
+	m_supportedFormat.pushBack(audio::format_float);
+	m_supportedFormat.pushBack(audio::format_int32);
+	ethread::UniqueLock lock(m_configLock);
 	configureBiQuad();
+	m_algo.update();
 }
 
 ememory::SharedPtr<audio::drain::Equalizer> audio::drain::Equalizer::create() {
@@ -35,7 +84,31 @@ audio::drain::Equalizer::~Equalizer() {
 
 void audio::drain::Equalizer::configurationChange() {
 	audio::drain::Algo::configurationChange();
+	if (m_input.getFormat() != m_output.getFormat()) {
+		DRAIN_ERROR("can not support Format Change ...");
+	}
+	m_cascade.init(m_output.getMap().size());
+	processBufferSizeChange();
+	m_resetRequest.store(false);
+	m_silentMemory = true;
+	ethread::UniqueLock lock(m_configLock);
 	configureBiQuad();
+	// the format change immediately: do not wait the next period
+	m_algo.update();
+}
+
+void audio::drain::Equalizer::processBufferSizeChange() {
+	// the integer formats are filtered in float
+	if (m_output.getFormat() == audio::format_float) {
+		m_floatBuffer.clear();
+		return;
+	}
+	m_floatBuffer.resize(getProcessBufferSize()*m_output.getMap().size());
+}
+
+bool audio::drain::Equalizer::canProcessInPlace() const {
+	// same format in input and output, the filters work sample per sample
+	return true;
 }
 
 bool audio::drain::Equalizer::process(audio::Time& _time,
@@ -48,103 +121,443 @@ bool audio::drain::Equalizer::process(audio::Time& _time,
 	if (_input == null) {
 		return false;
 	}
-	m_algo.process(_output, _input, _inputNbChunk);
+	// take the engine published by the control thread since the previous period
+	if (m_algo.update() == true) {
+		m_cascade.setInterpolation(m_algo.get().m_interpolation);
+		m_cascade.setNoiseFloor(m_algo.get().m_noiseFloor);
+	}
+	if (m_resetRequest.exchange(false) == true) {
+		m_cascade.reset();
+		m_silentMemory = true;
+	}
+	const audio::drain::EqualizerParameter& parameter = m_algo.get();
+	if (    parameter.m_bank == null
+	     && parameter.m_algo == null) {
+		m_outputSilence = m_inputSilence;
+		return true;
+	}
+	if (m_inputSilence == false) {
+		m_silentMemory = false;
+	} else if (    m_silentMemory == true
+	            && parameter.m_bank != null) {
+		// no input and the tail of the filters is finished
+		_output = getSilenceBuffer(_input, _inputNbChunk);
+		return true;
+	}
+	// the input can be read by other algos (user buffer, branches of a graph): never write on it
+	_output = getOutputBuffer(_inputNbChunk);
+	processEngine(parameter, _input, _output, _inputNbChunk);
+	if (    m_inputSilence == true
+	     && parameter.m_bank != null
+	     && isTailFinished(_output, _inputNbChunk) == true) {
+		// the remaining memory is under the precision of the output
+		m_cascade.reset();
+		m_silentMemory = true;
+	}
 	return true;
 }
 
+bool audio::drain::Equalizer::isTailFinished(const void* _data, size_t _nbChunk) const {
+	size_t nbSample = _nbChunk*m_output.getMap().size();
+	if (m_output.getFormat() != audio::format_float) {
+		return audio::drain::isSilence(_data, nbSample*audio::getFormatBytes(m_output.getFormat()));
+	}
+	const float* data = static_cast<const float*>(_data);
+	float value = 0.0f;
+	for (size_t iii=0; iii<nbSample; ++iii) {
+		value = etk::max(value, etk::abs(data[iii]));
+	}
+	// -140 dB: under the precision of a 24 bits output
+	return value < 1.0e-7f;
+}
+
+void audio::drain::Equalizer::processEngine(const audio::drain::EqualizerParameter& _parameter, const void* _input, void* _output, size_t _nbChunk) {
+	if (m_output.getFormat() == audio::format_float) {
+		if (_parameter.m_bank != null) {
+			// the cascade filter in place
+			if (_output != _input) {
+				memcpy(_output, _input, _nbChunk*m_output.getChunkSize());
+			}
+			m_cascade.process(*_parameter.m_bank, static_cast<float*>(_output), _nbChunk);
+		} else {
+			_parameter.m_algo->process(_output, _input, _nbChunk);
+		}
+		return;
+	}
+	if (    m_output.getFormat() == audio::format_int16
+	     && _parameter.m_algo != null) {
+		// fixed point engine
+		_parameter.m_algo->process(_output, _input, _nbChunk);
+		return;
+	}
+	size_t nbChunkMax = m_floatBuffer.size() / etk::max(m_output.getMap().size(), size_t(1));
+	if (_nbChunk > nbChunkMax) {
+		// bigger than the process buffer size (@see processBufferSizeChange): filter by blocks
+		DRAIN_ASSERT(nbChunkMax != 0, "Equalizer float buffer not allocated");
+		if (nbChunkMax == 0) {
+			return;
+		}
+		size_t chunkSize = m_output.getChunkSize();
+		for (size_t iii=0; iii<_nbChunk; iii+=nbChunkMax) {
+			processEngine(_parameter,
+			              static_cast<const int8_t*>(_input) + iii*chunkSize,
+			              static_cast<int8_t*>(_output) + iii*chunkSize,
+			              etk::min(nbChunkMax, _nbChunk-iii));
+		}
+		return;
+	}
+	size_t nbSample = _nbChunk*m_output.getMap().size();
+	if (m_output.getFormat() == audio::format_int16) {
+		const int16_t* input = static_cast<const int16_t*>(_input);
+		int16_t* output = static_cast<int16_t*>(_output);
+		for (size_t iii=0; iii<nbSample; ++iii) {
+			m_floatBuffer[iii] = float(input[iii]) * (1.0f/audio::drain::int16FullScale);
+		}
+		m_cascade.process(*_parameter.m_bank, &m_floatBuffer[0], _nbChunk);
+		for (size_t iii=0; iii<nbSample; ++iii) {
+			output[iii] = int16_t(etk::min(etk::max(-32768.0f, m_floatBuffer[iii]*audio::drain::int16FullScale), 32767.0f));
+		}
+		return;
+	}
+	const int32_t* input = static_cast<const int32_t*>(_input);
+	int32_t* output = static_cast<int32_t*>(_output);
+	for (size_t iii=0; iii<nbSample; ++iii) {
+		m_floatBuffer[iii] = float(input[iii]) * (1.0f/2147483648.0f);
+	}
+	if (_parameter.m_bank != null) {
+		m_cascade.process(*_parameter.m_bank, &m_floatBuffer[0], _nbChunk);
+	} else {
+		_parameter.m_algo->process(&m_floatBuffer[0], &m_floatBuffer[0], _nbChunk);
+	}
+	for (size_t iii=0; iii<nbSample; ++iii) {
+		output[iii] = int32_t(etk::min(etk::max(-2147483648.0f, m_floatBuffer[iii]*2147483648.0f), 2147483520.0f));
+	}
+}
+
 bool audio::drain::Equalizer::setParameter(const etk::String& _parameter, const etk::String& _value) {
 	//DRAIN_WARNING("set : " << _parameter << " " << _value);
 	if (_parameter == "config") {
-		m_config = ejson::Object(_value);
+		// parse out of the lock
+		ejson::Object config(_value);
+		ethread::UniqueLock lock(m_configLock);
+		m_config = config;
+		m_bandUpdate.clear();
 		configureBiQuad();
+		return true;
+	} else if (_parameter == "band") {
+		// {channel:'front-left', id:2, type:'peak', cut-frequency:1000, quality:2, gain:3} (no channel: all the channels)
+		ejson::Object object(_value);
+		audio::drain::EqualizerBand band;
+		if (band.parse(object) == false) {
+			return false;
+		}
+		int32_t channel = -1;
+		etk::String channelName = object["channel"].toString().get("");
+		if (channelName != "") {
+			for (size_t iii=0; iii<getOutputFormat().getMap().size(); ++iii) {
+				if (etk::toString(getOutputFormat().getMap()[iii]) == channelName) {
+					channel = iii;
+				}
+			}
+			if (channel < 0) {
+				DRAIN_ERROR("Can not set band ... : channel '" << channelName << "' not in " << getOutputFormat().getMap());
+				return false;
+			}
+		}
+		double id = object["id"].toNumber().get(-1.0);
+		if (id < 0.0) {
+			DRAIN_ERROR("Can not set band ... : no 'id' in '" << _value << "'");
+			return false;
+		}
+		return setBand(channel, size_t(id), band);
+	} else if (_parameter == "interpolation") {
+		float value = 0;
+		if (    sscanf(_value.c_str(), "%fms", &value) != 1
+		     || value < 0
+		     || value > 10000) {
+			DRAIN_ERROR("Can not set interpolation ... : '" << _value << "' out of range : [0..10000]ms");
+			return false;
+		}
+		setInterpolation(value);
+		return true;
+	} else if (_parameter == "engine") {
+		ethread::UniqueLock lock(m_configLock);
+		if (_value == "native") {
+			m_nativeEngine = true;
+		} else if (_value == "audio-algo") {
+			m_nativeEngine = false;
+		} else {
+			DRAIN_ERROR("Can not set engine ... : '" << _value << "' not in [native,audio-algo]");
+			return false;
+		}
+		configureBiQuad();
+		return true;
+	} else if (_parameter == "anti-denormal") {
+		ethread::UniqueLock lock(m_configLock);
+		if (_value == "enable") {
+			m_antiDenormal = true;
+		} else if (_value == "disable") {
+			m_antiDenormal = false;
+		} else {
+			DRAIN_ERROR("Can not set anti-denormal ... : '" << _value << "' not in [enable,disable]");
+			return false;
+		}
+		publish();
+		return true;
 	} else if (_parameter == "reset") {
-		// TODO : m_algo.reset();
+		reset();
 		return true;
 	}
 	return false;
 }
 
 etk::String audio::drain::Equalizer::getParameter(const etk::String& _parameter) const {
+	if (_parameter == "engine") {
+		if (m_nativeEngine == true) {
+			return "native";
+		}
+		return "audio-algo";
+	}
+	if (_parameter == "interpolation") {
+		return etk::toString(m_interpolation) + "ms";
+	}
+	if (_parameter == "anti-denormal") {
+		if (m_antiDenormal == true) {
+			return "enable";
+		}
+		return "disable";
+	}
 	return "error";
 }
 
 etk::String audio::drain::Equalizer::getParameterProperty(const etk::String& _parameter) const {
+	if (_parameter == "engine") {
+		return "[native,audio-algo]";
+	}
+	if (_parameter == "interpolation") {
+		return "[0..10000]ms";
+	}
+	if (_parameter == "anti-denormal") {
+		return "[enable,disable]";
+	}
 	return "error";
 }
 
-void audio::drain::Equalizer::addBiquad(int32_t _idBiquad, const ejson::Object& _object) {
-	// get type:
-	etk::String typeString = _object["type"].toString().get("none");
-	if (typeString == "direct-value") {
-		double a0 = _object["a0"].toNumber().get(0.0);
-		double a1 = _object["a1"].toNumber().get(0.0);
-		double a2 = _object["a2"].toNumber().get(0.0);
-		double b0 = _object["b0"].toNumber().get(0.0);
-		double b1 = _object["b1"].toNumber().get(0.0);
-		if (_idBiquad < 0) {
-			m_algo.addBiquad(a0, a1, a2, b0, b1);
-		} else {
-			m_algo.addBiquad(_idBiquad, a0, a1, a2, b0, b1);
+bool audio::drain::Equalizer::setBand(int32_t _channel, size_t _id, const audio::drain::EqualizerBand& _band) {
+	ethread::UniqueLock lock(m_configLock);
+	const etk::Vector<audio::channel>& map = getOutputFormat().getMap();
+	if (    _channel >= int32_t(map.size())
+	     || (    _channel < 0
+	          && _channel != -1)) {
+		DRAIN_ERROR("Can not set band ... : channel " << _channel << " not in [-1.." << int32_t(map.size())-1 << "]");
+		return false;
+	}
+	// keep the update for the next configurations
+	audio::drain::EqualizerBandUpdate update;
+	update.m_allChannel = _channel < 0;
+	update.m_channel = audio::channel_unknow;
+	if (_channel >= 0) {
+		update.m_channel = map[_channel];
+	}
+	update.m_id = _id;
+	update.m_band = _band;
+	for (size_t iii=0; iii<m_bandUpdate.size(); ++iii) {
+		if (    m_bandUpdate[iii].m_id == _id
+		     && (    update.m_allChannel == true
+		          || (    m_bandUpdate[iii].m_allChannel == false
+		               && m_bandUpdate[iii].m_channel == update.m_channel))) {
+			// replaced by the new band
+			m_bandUpdate.erase(m_bandUpdate.begin()+iii);
+			--iii;
 		}
-	} else {
-		enum audio::algo::drain::biQuadType type;
-		if (etk::from_string(type, typeString) == false) {
-			DRAIN_ERROR("Can not parse equalizer type:'" << typeString << "'");
-		}
-		double gain = _object["gain"].toNumber().get(0.0);
-		double frequency = _object["cut-frequency"].toNumber().get(0.0);
-		double quality = _object["quality"].toNumber().get(0.0);
-		if (_idBiquad < 0) {
-			m_algo.addBiquad(type, frequency, quality, gain);
-		} else {
-			m_algo.addBiquad(_idBiquad, type, frequency, quality, gain);
+	}
+	m_bandUpdate.pushBack(update);
+	if (    m_last.m_bank == null
+	     || _id >= m_last.m_bank->getNbStage()
+	     || m_last.m_bank->getNbChannel() != map.size()) {
+		// new stage or audio-algo-drain engine: rebuild all the cascade
+		configureBiQuad();
+		return true;
+	}
+	// only this band is computed, the process keep the memory of all the filters
+	audio::drain::Biquad biquad;
+	_band.compute(getOutputFormat().getFrequency(), biquad);
+	ememory::SharedPtr<audio::drain::BiquadBank> bank(ETK_NEW(audio::drain::BiquadBank, *m_last.m_bank));
+	if (bank == null) {
+		DRAIN_ERROR("Can not allocate the equalizer");
+		return false;
+	}
+	for (size_t iii=0; iii<map.size(); ++iii) {
+		if (    _channel < 0
+		     || int32_t(iii) == _channel) {
+			bank->setBiquad(_id, iii, biquad);
 		}
 	}
+	m_last.m_bank = bank;
+	publish();
+	return true;
+}
+
+void audio::drain::Equalizer::setInterpolation(float _durationMs) {
+	ethread::UniqueLock lock(m_configLock);
+	m_interpolation = etk::max(0.0f, _durationMs);
+	publish();
+}
+
+void audio::drain::Equalizer::reset() {
+	ethread::UniqueLock lock(m_configLock);
+	if (m_nativeEngine == true) {
+		m_resetRequest.store(true);
+		return;
+	}
+	// no access to the memory of audio-algo-drain: use a new engine
+	configureBiQuad();
+}
+
+void audio::drain::Equalizer::publish() {
+	m_last.m_interpolation = size_t(m_interpolation * getOutputFormat().getFrequency() / 1000.0f);
+	m_last.m_noiseFloor = 0.0f;
+	if (m_antiDenormal == true) {
+		// -360 dB: far under the precision of the signal, far over the denormal floats
+		m_last.m_noiseFloor = 1.0e-18f;
+	}
+	m_algo.set(m_last);
 }
 
 void audio::drain::Equalizer::configureBiQuad() {
-	m_algo.init(getOutputFormat().getFrequency(),
-	            getOutputFormat().getMap().size(),
-	            getOutputFormat().getFormat());
-	if (m_config.exist() == false) {
+	if (m_nativeEngine == true) {
+		ememory::SharedPtr<audio::drain::BiquadBank> bank(ETK_NEW(audio::drain::BiquadBank));
+		if (bank == null) {
+			DRAIN_ERROR("Can not allocate the equalizer");
+			return;
+		}
+		// the coefficients are computed here, the process only take the pointer
+		configureBiQuad(*bank);
+		m_last = audio::drain::EqualizerParameter();
+		m_last.m_bank = bank;
+		publish();
 		return;
 	}
-	// check for a global config:
-	const ejson::Array global = m_config["global"].toArray();
-	if (global.exist() == true) {
-		// only global configuration get all elements:
-		for (size_t kkk=0; kkk<global.size(); ++kkk) {
-			const ejson::Object tmpObject = global[kkk].toObject();
-			if (tmpObject.exist() == false) {
-				DRAIN_ERROR("Parse the configuration error : not a correct parameter:" << kkk);
-				continue;
+	ememory::SharedPtr<audio::algo::drain::Equalizer> algo(ETK_NEW(audio::algo::drain::Equalizer));
+	if (algo == null) {
+		DRAIN_ERROR("Can not allocate the equalizer");
+		return;
+	}
+	enum audio::format format = getOutputFormat().getFormat();
+	if (format == audio::format_int32) {
+		format = audio::format_float;
+	}
+	algo->init(getOutputFormat().getFrequency(),
+	           getOutputFormat().getMap().size(),
+	           format);
+	// the filters are computed here, the process only take the pointer
+	configureBiQuad(*algo);
+	m_last = audio::drain::EqualizerParameter();
+	m_last.m_algo = algo;
+	publish();
+}
+
+bool audio::drain::Equalizer::getChannelBiquad(etk::Vector<etk::Vector<audio::drain::Biquad> >& _list) {
+	const etk::Vector<audio::channel>& map = getOutputFormat().getMap();
+	float sampleRate = getOutputFormat().getFrequency();
+	bool isGlobal = true;
+	_list.clear();
+	_list.resize(map.size());
+	if (m_config.exist() == true) {
+		// check for a global config:
+		const ejson::Array global = m_config["global"].toArray();
+		isGlobal = global.exist();
+		for (size_t iii=0; iii<map.size(); ++iii) {
+			ejson::Array channelConfig = global;
+			if (isGlobal == false) {
+				channelConfig = m_config[etk::toString(map[iii])].toArray();
+				if (channelConfig.exist() == false) {
+					// no config ... not a problem ...
+					continue;
+				}
+			}
+			for (size_t kkk=0; kkk<channelConfig.size(); ++kkk) {
+				const ejson::Object tmpObject = channelConfig[kkk].toObject();
+				if (tmpObject.exist() == false) {
+					DRAIN_ERROR("Parse the configuration error : not a correct parameter:" << kkk);
+					continue;
+				}
+				audio::drain::EqualizerBand band;
+				band.parse(tmpObject);
+				audio::drain::Biquad biquad;
+				band.compute(sampleRate, biquad);
+				_list[iii].pushBack(biquad);
 			}
-			// Add biquad...
-			addBiquad(-1, tmpObject);
 		}
-		return;
 	}
-	for (size_t iii=0; iii<getOutputFormat().getMap().size(); ++iii) {
-		etk::String channelName = etk::toString(getOutputFormat().getMap()[iii]);
-		const ejson::Array channelConfig = m_config[channelName].toArray();
-		if (channelConfig.exist() == false) {
-			// no config ... not a problem ...
-			continue;
-		}
-		// only global configuration get all elements:
-		for (size_t kkk=0; kkk<channelConfig.size(); ++kkk) {
-			const ejson::Object tmpObject = channelConfig[kkk].toObject();
-			if (tmpObject.exist() == false) {
-				DRAIN_ERROR("Parse the configuration error : not a correct parameter:" << kkk);
+	// the bands changed after the configuration (in the order of the changes)
+	for (size_t jjj=0; jjj<m_bandUpdate.size(); ++jjj) {
+		const audio::drain::EqualizerBandUpdate& update = m_bandUpdate[jjj];
+		if (update.m_allChannel == false) {
+			isGlobal = false;
+		}
+		audio::drain::Biquad biquad;
+		update.m_band.compute(sampleRate, biquad);
+		for (size_t iii=0; iii<map.size(); ++iii) {
+			if (    update.m_allChannel == false
+			     && update.m_channel != map[iii]) {
 				continue;
 			}
-			// add biquad:
-			addBiquad(kkk, tmpObject);
+			if (update.m_id >= _list[iii].size()) {
+				// pass-through up to the new band
+				_list[iii].resize(update.m_id+1);
+			}
+			_list[iii][update.m_id] = biquad;
+		}
+	}
+	return isGlobal;
+}
+
+void audio::drain::Equalizer::configureBiQuad(audio::algo::drain::Equalizer& _algo) {
+	etk::Vector<etk::Vector<audio::drain::Biquad> > list;
+	bool isGlobal = getChannelBiquad(list);
+	if (list.size() == 0) {
+		return;
+	}
+	if (isGlobal == true) {
+		// global configuration get all elements:
+		for (size_t kkk=0; kkk<list[0].size(); ++kkk) {
+			const audio::drain::Biquad& biquad = list[0][kkk];
+			_algo.addBiquad(biquad.m_a[0], biquad.m_a[1], biquad.m_a[2], biquad.m_b[0], biquad.m_b[1]);
+		}
+		return;
+	}
+	for (size_t iii=0; iii<list.size(); ++iii) {
+		for (size_t kkk=0; kkk<list[iii].size(); ++kkk) {
+			const audio::drain::Biquad& biquad = list[iii][kkk];
+			_algo.addBiquad(int32_t(iii), biquad.m_a[0], biquad.m_a[1], biquad.m_a[2], biquad.m_b[0], biquad.m_b[1]);
+		}
+	}
+}
+
+void audio::drain::Equalizer::configureBiQuad(audio::drain::BiquadBank& _bank) {
+	etk::Vector<etk::Vector<audio::drain::Biquad> > list;
+	getChannelBiquad(list);
+	// the shorter channels are completed with pass-through stages
+	size_t nbStage = 0;
+	for (size_t iii=0; iii<list.size(); ++iii) {
+		nbStage = etk::max(nbStage, list[iii].size());
+	}
+	_bank.init(list.size(), nbStage);
+	for (size_t iii=0; iii<list.size(); ++iii) {
+		for (size_t kkk=0; kkk<list[iii].size(); ++kkk) {
+			_bank.setBiquad(kkk, iii, list[iii][kkk]);
 		}
 	}
-	return;
 }
 
 etk::Vector<etk::Pair<float,float> > audio::drain::Equalizer::calculateTheory() {
-	return m_algo.calculateTheory();
-}
\ No newline at end of file
+	ethread::UniqueLock lock(m_configLock);
+	if (m_last.m_bank != null) {
+		return m_last.m_bank->calculateTheory(getOutputFormat().getFrequency());
+	}
+	if (m_last.m_algo == null) {
+		return etk::Vector<etk::Pair<float,float> >();
+	}
+	return m_last.m_algo->calculateTheory();
+}
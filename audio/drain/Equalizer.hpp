@@ -7,11 +7,70 @@
 
 #include <audio/drain/Algo.hpp>
 #include <ememory/memory.hpp>
+#include <ethread/Mutex.hpp>
 #include <ejson/Object.hpp>
+#include <audio/drain/ParameterBlock.hpp>
+#include <audio/drain/BiquadCascade.hpp>
 #include <audio/algo/drain/Equalizer.hpp>
+#include <atomic>
 
 namespace audio {
 	namespace drain {
+		/**
+		 * @brief Description of a band of the equalizer (a biquad of the configuration).
+		 */
+		class EqualizerBand {
+			public:
+				EqualizerBand();
+				enum audio::algo::drain::biQuadType m_type; //!< Type of the filter
+				double m_frequencyCut; //!< Cut frequency
+				double m_qualityFactor; //!< Quality factor
+				double m_gain; //!< Gain in dB
+				bool m_direct; //!< The coefficients are given by the user ("direct-value")
+				audio::drain::Biquad m_coefficient; //!< User coefficients (when m_direct)
+				/**
+				 * @brief Parse the json description of a band.
+				 * @param[in] _object Description (same as an element of the "config").
+				 * @return true The type is valid.
+				 */
+				bool parse(const ejson::Object& _object);
+				/**
+				 * @brief Compute the coefficients of the band.
+				 * @param[in] _sampleRate Frequency of the stream.
+				 * @param[out] _biquad Coefficients.
+				 */
+				void compute(float _sampleRate, audio::drain::Biquad& _biquad) const;
+		};
+		/**
+		 * @brief Band changed after the configuration (kept when the format change).
+		 */
+		class EqualizerBandUpdate {
+			public:
+				bool m_allChannel; //!< The band is set on all the channels
+				enum audio::channel m_channel; //!< Channel of the band (when not m_allChannel)
+				size_t m_id; //!< Position of the band in the cascade
+				audio::drain::EqualizerBand m_band; //!< New band
+		};
+		/**
+		 * @brief Engine built by the control thread for the next periods (only one is set).
+		 */
+		class EqualizerParameter {
+			public:
+				EqualizerParameter() :
+				  m_interpolation(0),
+				  m_noiseFloor(0.0f) {
+					
+				}
+				ememory::SharedPtr<audio::drain::BiquadBank> m_bank; //!< Coefficients of the native engine
+				ememory::SharedPtr<audio::algo::drain::Equalizer> m_algo; //!< Engine of audio-algo-drain
+				size_t m_interpolation; //!< Number of frame of the transition when the coefficients of the native engine change
+				float m_noiseFloor; //!< Level of the anti-denormal noise of the native engine (0: disable)
+		};
+		/**
+		 * @brief Cascade of biquads on each channel (configured with a json, @see setParameter "config").
+		 * The native engine filter all the formats in float with the channels in the SIMD lanes (@see audio::drain::BiquadCascade).
+		 * With the audio-algo-drain engine, float and int16 are filtered by the matching engine, int32 by the float engine.
+		 */
 		class Equalizer : public Algo {
 			protected:
 				/**
@@ -27,25 +86,90 @@ namespace audio {
 				virtual ~Equalizer();
 			protected:
 				virtual void configurationChange();
+				virtual void processBufferSizeChange();
 			public:
 				virtual bool process(audio::Time& _time,
 				                     void* _input,
 				                     size_t _inputNbChunk,
 				                     void*& _output,
 				                     size_t& _outputNbChunk);
+				virtual bool canProcessInPlace() const;
 			protected:
+				ethread::Mutex m_configLock; //!< Protect m_config, m_nativeEngine and m_last (control threads only)
 				ejson::Object m_config; // configuration of the equalizer.
+				etk::Vector<audio::drain::EqualizerBandUpdate> m_bandUpdate; //!< Bands changed since the last "config"
+				bool m_nativeEngine; //!< Use the native biquad cascade (else audio-algo-drain)
+				float m_interpolation; //!< Duration of the coefficients transition in milli-second
+				bool m_antiDenormal; //!< Add a noise under the float precision in the native engine
+				std::atomic<bool> m_resetRequest; //!< The filter memory must be cleared at the next period
 			public:
 				virtual bool setParameter(const etk::String& _parameter, const etk::String& _value);
 				virtual etk::String getParameter(const etk::String& _parameter) const;
 				virtual etk::String getParameterProperty(const etk::String& _parameter) const;
+				/**
+				 * @brief Change a single band: only its coefficients are computed and the filter memory is kept.
+				 * @note The band is created (and the cascade rebuilt) when _id is after the last band.
+				 * @param[in] _channel Id of the channel in the map (-1 for all the channels).
+				 * @param[in] _id Position of the band in the cascade.
+				 * @param[in] _band New band.
+				 * @return true The band is published for the next period.
+				 */
+				bool setBand(int32_t _channel, size_t _id, const audio::drain::EqualizerBand& _band);
+				/**
+				 * @brief Set the duration of the transition when the coefficients change (native engine only).
+				 * @param[in] _durationMs Duration in milli-second (0: the new coefficients are used immediately).
+				 */
+				void setInterpolation(float _durationMs);
+				/**
+				 * @brief Clear the filter memory (at the start of the next period).
+				 */
+				void reset();
 			protected:
-				void addBiquad(int32_t _idBiquad, const ejson::Object& _object);
-				audio::algo::drain::Equalizer m_algo;
+				//! Engine used by the process, a new one is built off the audio thread at each configuration
+				audio::drain::ParameterBlock<audio::drain::EqualizerParameter> m_algo;
+				audio::drain::EqualizerParameter m_last; //!< Last engine published
+				audio::drain::BiquadCascade m_cascade; //!< Filter memory of the native engine (audio thread)
+				etk::Vector<float> m_floatBuffer; //!< Temporary buffer to filter the integer formats in float
+				bool m_silentMemory; //!< The memory of the native engine is 0 (a silent input give a silent output)
+				/**
+				 * @brief Filter the data with the current engine.
+				 * @param[in] _parameter Engine to use.
+				 * @param[in] _input Interleaved input data (never written).
+				 * @param[out] _output Interleaved output data (can be _input).
+				 * @param[in] _nbChunk Number of chunk.
+				 */
+				void processEngine(const audio::drain::EqualizerParameter& _parameter, const void* _input, void* _output, size_t _nbChunk);
 				/**
-				 * @brief Configure biquad with the  user spec.
+				 * @brief Check if the tail of the filters is under the precision of the output format.
+				 * @param[in] _data Output data of a silent input.
+				 * @param[in] _nbChunk Number of chunk.
+				 * @return true The remaining memory can be cleared.
+				 */
+				bool isTailFinished(const void* _data, size_t _nbChunk) const;
+				/**
+				 * @brief Build a new engine with the user spec and publish it for the next period (m_configLock must be locked).
 				 */
 				void configureBiQuad();
+				/**
+				 * @brief Add the biquads of the user spec in an engine.
+				 * @param[in] _algo Engine to configure.
+				 */
+				void configureBiQuad(audio::algo::drain::Equalizer& _algo);
+				/**
+				 * @brief Set the biquads of the user spec in a native bank.
+				 * @param[in] _bank Bank to configure.
+				 */
+				void configureBiQuad(audio::drain::BiquadBank& _bank);
+				/**
+				 * @brief Compute the biquads of each channel (configuration and band updates).
+				 * @param[out] _list Biquads of each channel of the map.
+				 * @return true The same biquads are used on all the channels.
+				 */
+				bool getChannelBiquad(etk::Vector<etk::Vector<audio::drain::Biquad> >& _list);
+				/**
+				 * @brief Publish the last engine with the current interpolation.
+				 */
+				void publish();
 			public:
 				// for debug & tools only
 				etk::Vector<etk::Pair<float,float> > calculateTheory();
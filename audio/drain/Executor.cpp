@@ -0,0 +1,151 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <audio/drain/Executor.hpp>
+#include <ethread/tools.hpp>
+#include <thread>
+#include <audio/drain/debug.hpp>
+
+audio::drain::Executor::Executor() :
+  m_task(null),
+  m_nbTaskDone(0),
+  m_nbWorkerActive(0),
+  m_stop(false),
+  m_deadline(0),
+  m_nbDeadlineMissReported(0) {
+	m_slot.resize(1);
+}
+
+audio::drain::Executor::~Executor() {
+	stop();
+}
+
+void audio::drain::Executor::start(size_t _nbWorker) {
+	stop();
+	ethread::UniqueLock lock(m_lock);
+	m_stop = false;
+	m_slot.resize(_nbWorker+1);
+	for (size_t iii=0; iii<_nbWorker; ++iii) {
+		m_wakeUp.pushBack(ETK_NEW(ethread::Semaphore));
+	}
+	for (size_t iii=0; iii<_nbWorker; ++iii) {
+		size_t slotId = iii+1;
+		m_thread.pushBack(ETK_NEW(ethread::Thread, [=](){ threadCallback(slotId);}, "audio-drain-worker"));
+	}
+	DRAIN_INFO("Start executor with " << _nbWorker << " worker(s)");
+}
+
+void audio::drain::Executor::stop() {
+	ethread::UniqueLock lock(m_lock);
+	if (m_thread.size() == 0) {
+		return;
+	}
+	m_stop = true;
+	for (size_t iii=0; iii<m_wakeUp.size(); ++iii) {
+		m_wakeUp[iii]->post();
+	}
+	for (size_t iii=0; iii<m_thread.size(); ++iii) {
+		m_thread[iii]->join();
+		ETK_DELETE(ethread::Thread, m_thread[iii]);
+	}
+	m_thread.clear();
+	for (size_t iii=0; iii<m_wakeUp.size(); ++iii) {
+		ETK_DELETE(ethread::Semaphore, m_wakeUp[iii]);
+	}
+	m_wakeUp.clear();
+	m_slot.resize(1);
+}
+
+void audio::drain::Executor::executeSlot(size_t _slotId) {
+	size_t nbSlot = m_slot.size();
+	for (size_t iii=0; iii<nbSlot; ++iii) {
+		// start with the own slot, then steal in the next ones
+		audio::drain::ExecutorSlot& slot = m_slot[(_slotId+iii)%nbSlot];
+		while (true) {
+			size_t taskId = slot.m_next.fetch_add(1);
+			if (taskId >= slot.m_end) {
+				break;
+			}
+			(*m_task)(taskId);
+			m_nbTaskDone.fetch_add(1);
+		}
+	}
+}
+
+void audio::drain::Executor::threadCallback(size_t _slotId) {
+	ethread::setName("audio-drain-worker");
+	while (true) {
+		m_wakeUp[_slotId-1]->wait();
+		if (m_stop == true) {
+			break;
+		}
+		executeSlot(_slotId);
+		m_nbWorkerActive.fetch_sub(1);
+	}
+}
+
+bool audio::drain::Executor::execute(size_t _nbTask, const etk::Function<void (size_t _taskId)>& _task) {
+	if (_nbTask == 0) {
+		return true;
+	}
+	ethread::UniqueLock lock(m_lock);
+	echrono::Steady startTime = echrono::Steady::now();
+	size_t nbSlot = m_slot.size();
+	if (    nbSlot == 1
+	     || _nbTask == 1) {
+		for (size_t iii=0; iii<_nbTask; ++iii) {
+			_task(iii);
+		}
+	} else {
+		// split the tasks in contiguous ranges
+		for (size_t iii=0; iii<nbSlot; ++iii) {
+			m_slot[iii].m_next = (_nbTask*iii)/nbSlot;
+			m_slot[iii].m_end = (_nbTask*(iii+1))/nbSlot;
+		}
+		m_task = &_task;
+		m_nbTaskDone = 0;
+		m_nbWorkerActive = nbSlot-1;
+		for (size_t iii=0; iii<m_wakeUp.size(); ++iii) {
+			m_wakeUp[iii]->post();
+		}
+		executeSlot(0);
+		// all the tasks are started ==> wait the end of the last ones
+		while (    m_nbTaskDone.load() != _nbTask
+		        || m_nbWorkerActive.load() != 0) {
+			std::this_thread::yield();
+		}
+		m_task = null;
+	}
+	// no log here (real time thread): the miss are counted and logged by reportDeadlineMiss
+	int64_t duration = (echrono::Steady::now() - startTime).get();
+	int64_t deadline = m_deadline.load(std::memory_order_relaxed);
+	m_metric.addPeriod(uint64_t(duration), uint64_t(etk::max(deadline, int64_t(0))));
+	if (    deadline > 0
+	     && duration > deadline) {
+		return false;
+	}
+	return true;
+}
+
+uint64_t audio::drain::Executor::reportDeadlineMiss() {
+	audio::drain::ProcessMetricSnapshot metric;
+	m_metric.getSnapshot(metric);
+	if (metric.m_nbDeadlineMiss <= m_nbDeadlineMissReported) {
+		m_nbDeadlineMissReported = metric.m_nbDeadlineMiss;
+		return 0;
+	}
+	uint64_t nbMiss = metric.m_nbDeadlineMiss - m_nbDeadlineMissReported;
+	m_nbDeadlineMissReported = metric.m_nbDeadlineMiss;
+	DRAIN_WARNING("Executor deadline missed " << nbMiss << " time(s) (deadline=" << metric.m_deadlineLast/1000 << "us, slower execution=" << metric.m_timeMax/1000 << "us)");
+	return nbMiss;
+}
+
+audio::drain::dispatchFunction audio::drain::Executor::getDispatchFunction() {
+	return [=](size_t _nbTask, const etk::Function<void (size_t _taskId)>& _task) {
+	           execute(_nbTask, _task);
+	       };
+}
+
@@ -0,0 +1,132 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/Vector.hpp>
+#include <etk/Function.hpp>
+#include <ethread/Mutex.hpp>
+#include <ethread/Semaphore.hpp>
+#include <ethread/Thread.hpp>
+#include <echrono/Steady.hpp>
+#include <audio/drain/ProcessGroup.hpp>
+#include <audio/drain/Metric.hpp>
+#include <atomic>
+
+namespace audio {
+	namespace drain{
+		/**
+		 * @brief Range of task own by one thread of the Executor (the other threads can steal in it).
+		 */
+		class alignas(64) ExecutorSlot {
+			public:
+				std::atomic<size_t> m_next; //!< Next task to execute (can be bigger than m_end)
+				size_t m_end; //!< End of the range
+				ExecutorSlot() :
+				  m_next(0),
+				  m_end(0) {
+
+				}
+				ExecutorSlot(const ExecutorSlot& _obj) :
+				  m_next(_obj.m_next.load()),
+				  m_end(_obj.m_end) {
+
+				}
+		};
+		/**
+		 * @brief Pool of thread that execute independent tasks (one task for each chain or each batch of chain).
+		 * The tasks are split in a range for each thread (the caller thread is one of them), a thread without
+		 * task steal the next task of the other ranges. Each task write only its own result, so the result does
+		 * not depend on the thread that executed it.
+		 */
+		class Executor {
+			public:
+				Executor();
+				virtual ~Executor();
+			protected:
+				ethread::Mutex m_lock; //!< Only one execution at a time
+				etk::Vector<ethread::Thread*> m_thread; //!< Worker threads
+				etk::Vector<ethread::Semaphore*> m_wakeUp; //!< Wake up of each worker
+				etk::Vector<audio::drain::ExecutorSlot> m_slot; //!< Range of task of each thread (0 is the caller thread)
+				const etk::Function<void (size_t _taskId)>* m_task; //!< Current task (null when no execution)
+				std::atomic<size_t> m_nbTaskDone; //!< Number of task done in the current execution
+				std::atomic<size_t> m_nbWorkerActive; //!< Number of worker that can still access to the current execution
+				std::atomic<bool> m_stop; //!< Request the worker to stop
+				std::atomic<int64_t> m_deadline; //!< Maximum duration of an execution in ns (0 to disable)
+				audio::drain::ProcessMetric m_metric; //!< Duration of the executions (written by execute, read by the control threads)
+				uint64_t m_nbDeadlineMissReported; //!< Number of miss already logged by reportDeadlineMiss
+			public:
+				/**
+				 * @brief Start the worker threads (stop the previous one).
+				 * @param[in] _nbWorker Number of worker thread (0: execute all the tasks in the caller thread).
+				 */
+				void start(size_t _nbWorker);
+				/**
+				 * @brief Stop all the worker threads.
+				 */
+				void stop();
+				/**
+				 * @brief Get the number of worker thread.
+				 * @return Number of thread (without the caller thread).
+				 */
+				size_t getNbWorker() const {
+					return m_thread.size();
+				}
+				/**
+				 * @brief Set the deadline of an execution.
+				 * @param[in] _deadline Maximum duration (0 to disable).
+				 */
+				void setDeadline(const echrono::Duration& _deadline) {
+					m_deadline.store(_deadline.get(), std::memory_order_relaxed);
+				}
+				/**
+				 * @brief Get the number of execution that finish after the deadline.
+				 * @return Number of miss.
+				 */
+				uint64_t getNbDeadlineMiss() const {
+					audio::drain::ProcessMetricSnapshot metric;
+					m_metric.getSnapshot(metric);
+					return metric.m_nbDeadlineMiss;
+				}
+				/**
+				 * @brief Get a copy of the counters of the executions (one period for each execution).
+				 * @param[out] _snapshot Current values.
+				 */
+				void getMetric(audio::drain::ProcessMetricSnapshot& _snapshot) const {
+					m_metric.getSnapshot(_snapshot);
+				}
+				/**
+				 * @brief Log the deadline missed since the previous call (call it from a control thread: the execution never log).
+				 * @return Number of new miss.
+				 */
+				uint64_t reportDeadlineMiss();
+				/**
+				 * @brief Execute tasks and wait the end of all of them.
+				 * @param[in] _nbTask Number of task.
+				 * @param[in] _task Task to execute (called with the id of the task).
+				 * @return true All the tasks are done before the deadline.
+				 * @return false The deadline is missed (all the tasks are done anyway).
+				 */
+				bool execute(size_t _nbTask, const etk::Function<void (size_t _taskId)>& _task);
+				/**
+				 * @brief Get a function to execute the batches of a ProcessGroup on this Executor.
+				 * @return Dispatch function (the Executor must exist while it is used).
+				 */
+				audio::drain::dispatchFunction getDispatchFunction();
+			protected:
+				/**
+				 * @brief Execute the task of a slot, then steal in the other slots.
+				 * @param[in] _slotId Id of the slot owned by the thread.
+				 */
+				void executeSlot(size_t _slotId);
+				/**
+				 * @brief Main loop of a worker thread.
+				 * @param[in] _slotId Id of the slot of the worker.
+				 */
+				void threadCallback(size_t _slotId);
+		};
+	}
+}
+
@@ -5,6 +5,7 @@
  */
 
 #include <audio/drain/FormatUpdate.hpp>
+#include <audio/drain/cpu.hpp>
 #include <audio/drain/debug.hpp>
 
 #ifndef INT16_MAX
@@ -21,6 +22,12 @@
 #endif
 
 
+// the conversion use a multiplication instead of a division
+static const float g_int16ToFloat = 1.0f/audio::drain::int16FullScale;
+static const float g_int32ToFloat = 1.0f/static_cast<float>(INT32_MAX);
+// the biggest float that can be converted in an int32_t (float(INT32_MAX) is rounded at 2^31)
+static const float g_floatInt32Max = 2147483520.0f;
+
 static void convert__int16__to__int16_on_int32(void* _input, void* _output, size_t _nbSample) {
 	int16_t* in = static_cast<int16_t*>(_input);
 	int32_t* out = static_cast<int32_t*>(_output);
@@ -39,8 +46,7 @@ static void convert__int16__to__float(void* _input, void* _output, size_t _nbSam
 	int16_t* in = static_cast<int16_t*>(_input);
 	float* out = static_cast<float*>(_output);
 	for (size_t iii=0; iii<_nbSample; ++iii) {
-		// TODO : Set * intead of /
-		out[iii] = static_cast<float>(in[iii])/static_cast<float>(INT16_MAX);
+		out[iii] = static_cast<float>(in[iii]) * g_int16ToFloat;
 	}
 }
 
@@ -63,8 +69,7 @@ static void convert__int16_on_int32__to__float(void* _input, void* _output, size
 	int32_t* in = static_cast<int32_t*>(_input);
 	float* out = static_cast<float*>(_output);
 	for (size_t iii=0; iii<_nbSample; ++iii) {
-		// TODO : Set * intead of /
-		out[iii] = static_cast<float>(in[iii])/static_cast<float>(INT16_MAX);
+		out[iii] = static_cast<float>(in[iii]) * g_int16ToFloat;
 	}
 }
 
@@ -72,13 +77,13 @@ static void convert__int32__to__int16(void* _input, void* _output, size_t _nbSam
 	int32_t* in = static_cast<int32_t*>(_input);
 	int16_t* out = static_cast<int16_t*>(_output);
 	for (size_t iii=0; iii<_nbSample; ++iii) {
-		int32_t value = in[iii] >> 16;
-		out[iii] = static_cast<int16_t>(etk::min(etk::max(INT16_MIN, value), INT16_MAX));
+		// always in the int16_t range
+		out[iii] = static_cast<int16_t>(in[iii] >> 16);
 	}
 }
 static void convert__int32__to__int16_on_int32(void* _input, void* _output, size_t _nbSample) {
 	int32_t* in = static_cast<int32_t*>(_input);
-	int16_t* out = static_cast<int16_t*>(_output);
+	int32_t* out = static_cast<int32_t*>(_output);
 	for (size_t iii=0; iii<_nbSample; ++iii) {
 		out[iii] = in[iii] >> 16;
 	}
@@ -87,8 +92,7 @@ static void convert__int32__to__float(void* _input, void* _output, size_t _nbSam
 	int32_t* in = static_cast<int32_t*>(_input);
 	float* out = static_cast<float*>(_output);
 	for (size_t iii=0; iii<_nbSample; ++iii) {
-		// TODO : Set * intead of /
-		out[iii] = static_cast<float>(in[iii])/static_cast<float>(INT32_MAX);
+		out[iii] = static_cast<float>(in[iii]) * g_int32ToFloat;
 	}
 }
 
@@ -96,7 +100,7 @@ static void convert__float__to__int16(void* _input, void* _output, size_t _nbSam
 	float* in = static_cast<float*>(_input);
 	int16_t* out = static_cast<int16_t*>(_output);
 	for (size_t iii=0; iii<_nbSample; ++iii) {
-		float value = in[iii] * static_cast<float>(INT16_MAX);
+		float value = in[iii] * audio::drain::int16FullScale;
 		value = etk::min(etk::max(static_cast<float>(INT16_MIN), value), static_cast<float>(INT16_MAX));
 		out[iii] = static_cast<int16_t>(value);
 		//DRAIN_DEBUG(iii << " in=" << in[iii] << " out=" << out[iii]);
@@ -106,8 +110,8 @@ static void convert__float__to__int16_on_int32(void* _input, void* _output, size
 	float* in = static_cast<float*>(_input);
 	int32_t* out = static_cast<int32_t*>(_output);
 	for (size_t iii=0; iii<_nbSample; ++iii) {
-		float value = in[iii] * static_cast<float>(INT16_MAX);
-		value = etk::min(etk::max(static_cast<float>(INT32_MIN), value), static_cast<float>(INT32_MAX));
+		float value = in[iii] * audio::drain::int16FullScale;
+		value = etk::min(etk::max(static_cast<float>(INT32_MIN), value), g_floatInt32Max);
 		out[iii] = static_cast<int32_t>(value);
 	}
 }
@@ -116,20 +120,576 @@ static void convert__float__to__int32(void* _input, void* _output, size_t _nbSam
 	int32_t* out = static_cast<int32_t*>(_output);
 	for (size_t iii=0; iii<_nbSample; ++iii) {
 		float value = in[iii] * static_cast<float>(INT32_MAX);
-		value = etk::min(etk::max(static_cast<float>(INT32_MIN), value), static_cast<float>(INT32_MAX));
+		value = etk::min(etk::max(static_cast<float>(INT32_MIN), value), g_floatInt32Max);
 		out[iii] = static_cast<int32_t>(value);
 	}
 }
 
+// ---------------------------------------------------------------------------------
+//   SIMD kernels: process the main part of the buffer and the generic kernel end it.
+// ---------------------------------------------------------------------------------
+#ifdef DRAIN_SIMD_X86
+DRAIN_TARGET_SSE2 static void convert__int16__to__int16_on_int32__sse2(void* _input, void* _output, size_t _nbSample) {
+	int16_t* in = static_cast<int16_t*>(_input);
+	int32_t* out = static_cast<int32_t*>(_output);
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]));
+		// sign extension
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii+4]), _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16));
+	}
+	convert__int16__to__int16_on_int32(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_SSE2 static void convert__int16__to__int32__sse2(void* _input, void* _output, size_t _nbSample) {
+	int16_t* in = static_cast<int16_t*>(_input);
+	int32_t* out = static_cast<int32_t*>(_output);
+	const __m128i zero = _mm_setzero_si128();
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]));
+		// the sample is set in the 16 upper bits
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_unpacklo_epi16(zero, value));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii+4]), _mm_unpackhi_epi16(zero, value));
+	}
+	convert__int16__to__int32(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_SSE2 static void convert__int16__to__float__sse2(void* _input, void* _output, size_t _nbSample) {
+	int16_t* in = static_cast<int16_t*>(_input);
+	float* out = static_cast<float*>(_output);
+	const __m128 coef = _mm_set1_ps(g_int16ToFloat);
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]));
+		__m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+		__m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16);
+		_mm_storeu_ps(&out[iii], _mm_mul_ps(_mm_cvtepi32_ps(low), coef));
+		_mm_storeu_ps(&out[iii+4], _mm_mul_ps(_mm_cvtepi32_ps(high), coef));
+	}
+	convert__int16__to__float(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_SSE2 static void convert__int16_on_int32__to__int16__sse2(void* _input, void* _output, size_t _nbSample) {
+	int32_t* in = static_cast<int32_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]));
+		__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii+4]));
+		// saturation pack == clip in [INT16_MIN..INT16_MAX]
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_packs_epi32(low, high));
+	}
+	convert__int16_on_int32__to__int16(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_SSE2 static void convert__int16_on_int32__to__float__sse2(void* _input, void* _output, size_t _nbSample) {
+	int32_t* in = static_cast<int32_t*>(_input);
+	float* out = static_cast<float*>(_output);
+	const __m128 coef = _mm_set1_ps(g_int16ToFloat);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]));
+		_mm_storeu_ps(&out[iii], _mm_mul_ps(_mm_cvtepi32_ps(value), coef));
+	}
+	convert__int16_on_int32__to__float(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_SSE2 static void convert__int32__to__int16__sse2(void* _input, void* _output, size_t _nbSample) {
+	int32_t* in = static_cast<int32_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m128i low = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii])), 16);
+		__m128i high = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii+4])), 16);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_packs_epi32(low, high));
+	}
+	convert__int32__to__int16(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_SSE2 static void convert__int32__to__float__sse2(void* _input, void* _output, size_t _nbSample) {
+	int32_t* in = static_cast<int32_t*>(_input);
+	float* out = static_cast<float*>(_output);
+	const __m128 coef = _mm_set1_ps(g_int32ToFloat);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]));
+		_mm_storeu_ps(&out[iii], _mm_mul_ps(_mm_cvtepi32_ps(value), coef));
+	}
+	convert__int32__to__float(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_SSE2 static void convert__float__to__int16__sse2(void* _input, void* _output, size_t _nbSample) {
+	float* in = static_cast<float*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	const __m128 coef = _mm_set1_ps(audio::drain::int16FullScale);
+	const __m128 minValue = _mm_set1_ps(static_cast<float>(INT16_MIN));
+	const __m128 maxValue = _mm_set1_ps(static_cast<float>(INT16_MAX));
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m128 low = _mm_mul_ps(_mm_loadu_ps(&in[iii]), coef);
+		__m128 high = _mm_mul_ps(_mm_loadu_ps(&in[iii+4]), coef);
+		low = _mm_min_ps(_mm_max_ps(low, minValue), maxValue);
+		high = _mm_min_ps(_mm_max_ps(high, minValue), maxValue);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_packs_epi32(_mm_cvttps_epi32(low), _mm_cvttps_epi32(high)));
+	}
+	convert__float__to__int16(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_SSE2 static void convert__float__to__int16_on_int32__sse2(void* _input, void* _output, size_t _nbSample) {
+	float* in = static_cast<float*>(_input);
+	int32_t* out = static_cast<int32_t*>(_output);
+	const __m128 coef = _mm_set1_ps(audio::drain::int16FullScale);
+	const __m128 minValue = _mm_set1_ps(static_cast<float>(INT32_MIN));
+	const __m128 maxValue = _mm_set1_ps(g_floatInt32Max);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		__m128 value = _mm_mul_ps(_mm_loadu_ps(&in[iii]), coef);
+		value = _mm_min_ps(_mm_max_ps(value, minValue), maxValue);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_cvttps_epi32(value));
+	}
+	convert__float__to__int16_on_int32(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_SSE2 static void convert__float__to__int32__sse2(void* _input, void* _output, size_t _nbSample) {
+	float* in = static_cast<float*>(_input);
+	int32_t* out = static_cast<int32_t*>(_output);
+	const __m128 coef = _mm_set1_ps(static_cast<float>(INT32_MAX));
+	const __m128 minValue = _mm_set1_ps(static_cast<float>(INT32_MIN));
+	const __m128 maxValue = _mm_set1_ps(g_floatInt32Max);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		__m128 value = _mm_mul_ps(_mm_loadu_ps(&in[iii]), coef);
+		value = _mm_min_ps(_mm_max_ps(value, minValue), maxValue);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_cvttps_epi32(value));
+	}
+	convert__float__to__int32(&in[iii], &out[iii], _nbSample-iii);
+}
+
+DRAIN_TARGET_AVX2 static void convert__int16__to__int32__avx2(void* _input, void* _output, size_t _nbSample) {
+	int16_t* in = static_cast<int16_t*>(_input);
+	int32_t* out = static_cast<int32_t*>(_output);
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m256i value = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii])));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(&out[iii]), _mm256_slli_epi32(value, 16));
+	}
+	convert__int16__to__int32(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_AVX2 static void convert__int16__to__float__avx2(void* _input, void* _output, size_t _nbSample) {
+	int16_t* in = static_cast<int16_t*>(_input);
+	float* out = static_cast<float*>(_output);
+	const __m256 coef = _mm256_set1_ps(g_int16ToFloat);
+	size_t iii = 0;
+	for (; iii+16 <= _nbSample; iii+=16) {
+		__m256i low = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii])));
+		__m256i high = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii+8])));
+		_mm256_storeu_ps(&out[iii], _mm256_mul_ps(_mm256_cvtepi32_ps(low), coef));
+		_mm256_storeu_ps(&out[iii+8], _mm256_mul_ps(_mm256_cvtepi32_ps(high), coef));
+	}
+	convert__int16__to__float(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_AVX2 static void convert__int32__to__int16__avx2(void* _input, void* _output, size_t _nbSample) {
+	int32_t* in = static_cast<int32_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	size_t iii = 0;
+	for (; iii+16 <= _nbSample; iii+=16) {
+		__m256i low = _mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&in[iii])), 16);
+		__m256i high = _mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&in[iii+8])), 16);
+		// the pack work on each 128 bits lane ==> reorder the 64 bits blocks
+		__m256i value = _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(&out[iii]), value);
+	}
+	convert__int32__to__int16(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_AVX2 static void convert__int32__to__float__avx2(void* _input, void* _output, size_t _nbSample) {
+	int32_t* in = static_cast<int32_t*>(_input);
+	float* out = static_cast<float*>(_output);
+	const __m256 coef = _mm256_set1_ps(g_int32ToFloat);
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&in[iii]));
+		_mm256_storeu_ps(&out[iii], _mm256_mul_ps(_mm256_cvtepi32_ps(value), coef));
+	}
+	convert__int32__to__float(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_AVX2 static void convert__float__to__int16__avx2(void* _input, void* _output, size_t _nbSample) {
+	float* in = static_cast<float*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	const __m256 coef = _mm256_set1_ps(audio::drain::int16FullScale);
+	const __m256 minValue = _mm256_set1_ps(static_cast<float>(INT16_MIN));
+	const __m256 maxValue = _mm256_set1_ps(static_cast<float>(INT16_MAX));
+	size_t iii = 0;
+	for (; iii+16 <= _nbSample; iii+=16) {
+		__m256 low = _mm256_mul_ps(_mm256_loadu_ps(&in[iii]), coef);
+		__m256 high = _mm256_mul_ps(_mm256_loadu_ps(&in[iii+8]), coef);
+		low = _mm256_min_ps(_mm256_max_ps(low, minValue), maxValue);
+		high = _mm256_min_ps(_mm256_max_ps(high, minValue), maxValue);
+		__m256i value = _mm256_packs_epi32(_mm256_cvttps_epi32(low), _mm256_cvttps_epi32(high));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(&out[iii]), _mm256_permute4x64_epi64(value, 0xD8));
+	}
+	convert__float__to__int16(&in[iii], &out[iii], _nbSample-iii);
+}
+DRAIN_TARGET_AVX2 static void convert__float__to__int32__avx2(void* _input, void* _output, size_t _nbSample) {
+	float* in = static_cast<float*>(_input);
+	int32_t* out = static_cast<int32_t*>(_output);
+	const __m256 coef = _mm256_set1_ps(static_cast<float>(INT32_MAX));
+	const __m256 minValue = _mm256_set1_ps(static_cast<float>(INT32_MIN));
+	const __m256 maxValue = _mm256_set1_ps(g_floatInt32Max);
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m256 value = _mm256_mul_ps(_mm256_loadu_ps(&in[iii]), coef);
+		value = _mm256_min_ps(_mm256_max_ps(value, minValue), maxValue);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(&out[iii]), _mm256_cvttps_epi32(value));
+	}
+	convert__float__to__int32(&in[iii], &out[iii], _nbSample-iii);
+}
+#endif
+
+#ifdef DRAIN_SIMD_NEON
+static void convert__int16__to__int32__neon(void* _input, void* _output, size_t _nbSample) {
+	int16_t* in = static_cast<int16_t*>(_input);
+	int32_t* out = static_cast<int32_t*>(_output);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		vst1q_s32(&out[iii], vshll_n_s16(vld1_s16(&in[iii]), 16));
+	}
+	convert__int16__to__int32(&in[iii], &out[iii], _nbSample-iii);
+}
+static void convert__int16__to__float__neon(void* _input, void* _output, size_t _nbSample) {
+	int16_t* in = static_cast<int16_t*>(_input);
+	float* out = static_cast<float*>(_output);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		float32x4_t value = vcvtq_f32_s32(vmovl_s16(vld1_s16(&in[iii])));
+		vst1q_f32(&out[iii], vmulq_n_f32(value, g_int16ToFloat));
+	}
+	convert__int16__to__float(&in[iii], &out[iii], _nbSample-iii);
+}
+static void convert__int32__to__int16__neon(void* _input, void* _output, size_t _nbSample) {
+	int32_t* in = static_cast<int32_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		vst1_s16(&out[iii], vshrn_n_s32(vld1q_s32(&in[iii]), 16));
+	}
+	convert__int32__to__int16(&in[iii], &out[iii], _nbSample-iii);
+}
+static void convert__int32__to__float__neon(void* _input, void* _output, size_t _nbSample) {
+	int32_t* in = static_cast<int32_t*>(_input);
+	float* out = static_cast<float*>(_output);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		vst1q_f32(&out[iii], vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(&in[iii])), g_int32ToFloat));
+	}
+	convert__int32__to__float(&in[iii], &out[iii], _nbSample-iii);
+}
+static void convert__float__to__int16__neon(void* _input, void* _output, size_t _nbSample) {
+	float* in = static_cast<float*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	const float32x4_t minValue = vdupq_n_f32(static_cast<float>(INT16_MIN));
+	const float32x4_t maxValue = vdupq_n_f32(static_cast<float>(INT16_MAX));
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		float32x4_t value = vmulq_n_f32(vld1q_f32(&in[iii]), audio::drain::int16FullScale);
+		value = vminq_f32(vmaxq_f32(value, minValue), maxValue);
+		vst1_s16(&out[iii], vqmovn_s32(vcvtq_s32_f32(value)));
+	}
+	convert__float__to__int16(&in[iii], &out[iii], _nbSample-iii);
+}
+static void convert__float__to__int32__neon(void* _input, void* _output, size_t _nbSample) {
+	float* in = static_cast<float*>(_input);
+	int32_t* out = static_cast<int32_t*>(_output);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		// the float to int conversion saturate
+		vst1q_s32(&out[iii], vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&in[iii]), static_cast<float>(INT32_MAX))));
+	}
+	convert__float__to__int32(&in[iii], &out[iii], _nbSample-iii);
+}
+#endif
+
+typedef void (*convertFunction)(void* _input, void* _output, size_t _nbSample);
+struct simdConvertFunction {
+	convertFunction generic;
+	convertFunction sse2;
+	convertFunction avx2;
+	convertFunction neon;
+};
+#ifdef DRAIN_SIMD_X86
+	#define DRAIN_X86_FUNC(name) &name
+#else
+	#define DRAIN_X86_FUNC(name) null
+#endif
+#ifdef DRAIN_SIMD_NEON
+	#define DRAIN_NEON_FUNC(name) &name
+#else
+	#define DRAIN_NEON_FUNC(name) null
+#endif
+/**
+ * @brief Get the id of a format in the converter table (the other formats are managed as int16).
+ * @param[in] _format Format of the data.
+ * @return Id in [0..3].
+ */
+static size_t getFormatId(enum audio::format _format) {
+	switch (_format) {
+		case audio::format_int16_on_int32:
+			return 1;
+		case audio::format_int32:
+			return 2;
+		case audio::format_float:
+			return 3;
+		default:
+			return 0;
+	}
+}
+//! Converter of each couple [input][output] (generic, SSE2, AVX2, NEON), order of the id of getFormatId
+static constexpr simdConvertFunction g_convertTable[4][4] = {
+	{ // from int16
+		{ null, null, null, null },
+		{ &convert__int16__to__int16_on_int32, DRAIN_X86_FUNC(convert__int16__to__int16_on_int32__sse2), null, null },
+		{ &convert__int16__to__int32, DRAIN_X86_FUNC(convert__int16__to__int32__sse2), DRAIN_X86_FUNC(convert__int16__to__int32__avx2), DRAIN_NEON_FUNC(convert__int16__to__int32__neon) },
+		{ &convert__int16__to__float, DRAIN_X86_FUNC(convert__int16__to__float__sse2), DRAIN_X86_FUNC(convert__int16__to__float__avx2), DRAIN_NEON_FUNC(convert__int16__to__float__neon) }
+	}, { // from int16 on int32
+		{ &convert__int16_on_int32__to__int16, DRAIN_X86_FUNC(convert__int16_on_int32__to__int16__sse2), null, null },
+		{ null, null, null, null },
+		{ &convert__int16_on_int32__to__int32, null, null, null },
+		{ &convert__int16_on_int32__to__float, DRAIN_X86_FUNC(convert__int16_on_int32__to__float__sse2), null, null }
+	}, { // from int32
+		{ &convert__int32__to__int16, DRAIN_X86_FUNC(convert__int32__to__int16__sse2), DRAIN_X86_FUNC(convert__int32__to__int16__avx2), DRAIN_NEON_FUNC(convert__int32__to__int16__neon) },
+		{ &convert__int32__to__int16_on_int32, null, null, null },
+		{ null, null, null, null },
+		{ &convert__int32__to__float, DRAIN_X86_FUNC(convert__int32__to__float__sse2), DRAIN_X86_FUNC(convert__int32__to__float__avx2), DRAIN_NEON_FUNC(convert__int32__to__float__neon) }
+	}, { // from float
+		{ &convert__float__to__int16, DRAIN_X86_FUNC(convert__float__to__int16__sse2), DRAIN_X86_FUNC(convert__float__to__int16__avx2), DRAIN_NEON_FUNC(convert__float__to__int16__neon) },
+		{ &convert__float__to__int16_on_int32, DRAIN_X86_FUNC(convert__float__to__int16_on_int32__sse2), null, null },
+		{ &convert__float__to__int32, DRAIN_X86_FUNC(convert__float__to__int32__sse2), DRAIN_X86_FUNC(convert__float__to__int32__avx2), DRAIN_NEON_FUNC(convert__float__to__int32__neon) },
+		{ null, null, null, null }
+	}
+};
+
+/**
+ * @brief Get the best implementation of a converter for the current CPU.
+ * @param[in] _function Converter and its optimized versions.
+ * @return Optimized converter (or the generic one).
+ */
+static convertFunction getSimdFunction(const simdConvertFunction& _function) {
+	if (    _function.avx2 != null
+	     && audio::drain::cpu::haveAvx2() == true) {
+		return _function.avx2;
+	}
+	if (    _function.sse2 != null
+	     && audio::drain::cpu::haveSse2() == true) {
+		return _function.sse2;
+	}
+	if (    _function.neon != null
+	     && audio::drain::cpu::haveNeon() == true) {
+		return _function.neon;
+	}
+	return _function.generic;
+}
+
+
+//! Scale of the TPDF noise: each half of a random give an uniform value in [0..1[ LSB
+static const float g_ditherScale = 1.0f/65536.0f;
+
+/**
+ * @brief xorshift32 random generator: only some shift and xor (same in the SIMD lanes).
+ * @param[in,out] _state State of the generator (never 0).
+ * @return New random value.
+ */
+static inline uint32_t ditherRandom(uint32_t& _state) {
+	_state ^= _state << 13;
+	_state ^= _state >> 17;
+	_state ^= _state << 5;
+	return _state;
+}
+/**
+ * @brief Get a triangular noise in ]-1..1[ LSB: difference of the 2 uniform halves of a random value.
+ * @param[in,out] _state State of the generator.
+ * @return Noise in LSB of int16_t.
+ */
+static inline float ditherTpdf(uint32_t& _state) {
+	uint32_t value = ditherRandom(_state);
+	return float(int32_t(value & 0xFFFF) - int32_t(value >> 16)) * g_ditherScale;
+}
+static inline float ditherLoad(float _value) {
+	return _value * audio::drain::int16FullScale;
+}
+static inline float ditherLoad(int32_t _value) {
+	return static_cast<float>(_value) * g_ditherScale;
+}
+/**
+ * @brief Round a value in LSB of int16_t (with saturation).
+ * @param[in] _value Value to store.
+ * @return Nearest int16_t.
+ */
+static inline int16_t ditherStore(float _value) {
+	_value = etk::min(etk::max(static_cast<float>(INT16_MIN), _value), static_cast<float>(INT16_MAX));
+	// positive value ==> the truncation is a floor
+	return static_cast<int16_t>(static_cast<int32_t>(_value + 32768.5f) - 32768);
+}
+
+template<typename TYPE>
+static void dither__to__int16(void* _input, void* _output, size_t _nbSample, uint32_t* _random) {
+	TYPE* in = static_cast<TYPE*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	uint32_t random = _random[0];
+	for (size_t iii=0; iii<_nbSample; ++iii) {
+		out[iii] = ditherStore(ditherLoad(in[iii]) + ditherTpdf(random));
+	}
+	_random[0] = random;
+}
+
+template<typename TYPE>
+static void ditherShaped__to__int16(void* _input, void* _output, size_t _nbChunk, size_t _nbChannel, uint32_t* _random, float* _error) {
+	TYPE* in = static_cast<TYPE*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	uint32_t random = _random[0];
+	for (size_t iii=0; iii<_nbChunk; ++iii) {
+		for (size_t jjj=0; jjj<_nbChannel; ++jjj) {
+			// remove the error of the previous sample: noise filtered by (1 - z^-1)
+			float value = ditherLoad(in[jjj]) - _error[jjj];
+			int16_t sample = ditherStore(value + ditherTpdf(random));
+			out[jjj] = sample;
+			// limited: a saturation must not accumulate in the feedback
+			_error[jjj] = etk::min(etk::max(-2.0f, static_cast<float>(sample) - value), 2.0f);
+		}
+		in += _nbChannel;
+		out += _nbChannel;
+	}
+	_random[0] = random;
+}
+
+/**
+ * @brief Noise shaping with a number of channel known at the compilation: the frame is unrolled and the error stay in registers.
+ */
+template<typename TYPE, size_t NB_CHANNEL>
+static void ditherShapedFixed__to__int16(void* _input, void* _output, size_t _nbChunk, size_t /*_nbChannel*/, uint32_t* _random, float* _error) {
+	TYPE* in = static_cast<TYPE*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	uint32_t random = _random[0];
+	float error[NB_CHANNEL];
+	for (size_t jjj=0; jjj<NB_CHANNEL; ++jjj) {
+		error[jjj] = _error[jjj];
+	}
+	for (size_t iii=0; iii<_nbChunk; ++iii) {
+		for (size_t jjj=0; jjj<NB_CHANNEL; ++jjj) {
+			float value = ditherLoad(in[jjj]) - error[jjj];
+			int16_t sample = ditherStore(value + ditherTpdf(random));
+			out[jjj] = sample;
+			error[jjj] = etk::min(etk::max(-2.0f, static_cast<float>(sample) - value), 2.0f);
+		}
+		in += NB_CHANNEL;
+		out += NB_CHANNEL;
+	}
+	for (size_t jjj=0; jjj<NB_CHANNEL; ++jjj) {
+		_error[jjj] = error[jjj];
+	}
+	_random[0] = random;
+}
+
+typedef void (*ditherShapedFunction)(void* _input, void* _output, size_t _nbChunk, size_t _nbChannel, uint32_t* _random, float* _error);
+
+/**
+ * @brief Get the noise shaping specialized for the common layouts (mono, stereo, 5.1, 7.1) or the generic one.
+ */
+template<typename TYPE>
+static ditherShapedFunction getDitherShaped(size_t _nbChannel) {
+	switch (_nbChannel) {
+		case 1:
+			return &ditherShapedFixed__to__int16<TYPE, 1>;
+		case 2:
+			return &ditherShapedFixed__to__int16<TYPE, 2>;
+		case 6:
+			return &ditherShapedFixed__to__int16<TYPE, 6>;
+		case 8:
+			return &ditherShapedFixed__to__int16<TYPE, 8>;
+	}
+	return &ditherShaped__to__int16<TYPE>;
+}
+
+#ifdef DRAIN_SIMD_X86
+/**
+ * @brief Get 4 triangular noise in ]-1..1[ LSB (4 xorshift32 in parallel).
+ * @param[in,out] _random State of the 4 generators.
+ * @return Noise in LSB of int16_t.
+ */
+DRAIN_TARGET_SSE2 static inline __m128 ditherTpdf__sse2(__m128i& _random) {
+	_random = _mm_xor_si128(_random, _mm_slli_epi32(_random, 13));
+	_random = _mm_xor_si128(_random, _mm_srli_epi32(_random, 17));
+	_random = _mm_xor_si128(_random, _mm_slli_epi32(_random, 5));
+	__m128i low = _mm_and_si128(_random, _mm_set1_epi32(0xFFFF));
+	__m128i high = _mm_srli_epi32(_random, 16);
+	return _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(low, high)), _mm_set1_ps(g_ditherScale));
+}
+/**
+ * @brief Add the noise and round 8 values in LSB of int16_t (with saturation).
+ */
+DRAIN_TARGET_SSE2 static inline __m128i ditherStore__sse2(__m128 _low, __m128 _high, __m128i& _random) {
+	const __m128 minValue = _mm_set1_ps(static_cast<float>(INT16_MIN));
+	const __m128 maxValue = _mm_set1_ps(static_cast<float>(INT16_MAX));
+	_low = _mm_add_ps(_low, ditherTpdf__sse2(_random));
+	_high = _mm_add_ps(_high, ditherTpdf__sse2(_random));
+	_low = _mm_min_ps(_mm_max_ps(_low, minValue), maxValue);
+	_high = _mm_min_ps(_mm_max_ps(_high, minValue), maxValue);
+	// default rounding mode of the conversion: to the nearest
+	return _mm_packs_epi32(_mm_cvtps_epi32(_low), _mm_cvtps_epi32(_high));
+}
+DRAIN_TARGET_SSE2 static void dither__float__to__int16__sse2(void* _input, void* _output, size_t _nbSample, uint32_t* _random) {
+	float* in = static_cast<float*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	const __m128 coef = _mm_set1_ps(audio::drain::int16FullScale);
+	__m128i random = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_random));
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m128 low = _mm_mul_ps(_mm_loadu_ps(&in[iii]), coef);
+		__m128 high = _mm_mul_ps(_mm_loadu_ps(&in[iii+4]), coef);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), ditherStore__sse2(low, high, random));
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(_random), random);
+	dither__to__int16<float>(&in[iii], &out[iii], _nbSample-iii, _random);
+}
+DRAIN_TARGET_SSE2 static void dither__int32__to__int16__sse2(void* _input, void* _output, size_t _nbSample, uint32_t* _random) {
+	int32_t* in = static_cast<int32_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	const __m128 coef = _mm_set1_ps(g_ditherScale);
+	__m128i random = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_random));
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m128 low = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]))), coef);
+		__m128 high = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii+4]))), coef);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), ditherStore__sse2(low, high, random));
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(_random), random);
+	dither__to__int16<int32_t>(&in[iii], &out[iii], _nbSample-iii, _random);
+}
+#endif
+
+etk::Stream& audio::drain::operator <<(etk::Stream& _os, enum audio::drain::dither _obj) {
+	switch (_obj) {
+		case audio::drain::dither_none:
+			_os << "none";
+			break;
+		case audio::drain::dither_tpdf:
+			_os << "tpdf";
+			break;
+		case audio::drain::dither_shaped:
+			_os << "shaped";
+			break;
+	}
+	return _os;
+}
 
 audio::drain::FormatUpdate::FormatUpdate() :
-  m_functionConvert(null) {
-	
+  m_functionConvert(null),
+  m_dither(audio::drain::dither_none),
+  m_functionDither(null),
+  m_functionDitherShaped(null) {
+	// any not null seed, different in each lane
+	m_ditherRandom[0] = 0x9E3779B9U;
+	m_ditherRandom[1] = 0x85EBCA6BU;
+	m_ditherRandom[2] = 0xC2B2AE35U;
+	m_ditherRandom[3] = 0x27D4EB2FU;
 }
 
 void audio::drain::FormatUpdate::init() {
 	audio::drain::Algo::init();
 	m_type = "FormatUpdate";
+	// conversion by sample: same kernels for the 2 layouts
+	m_supportedLayout.pushBack(audio::drain::layout_planar);
 }
 
 ememory::SharedPtr<audio::drain::FormatUpdate> audio::drain::FormatUpdate::create() {
@@ -148,98 +708,58 @@ void audio::drain::FormatUpdate::configurationChange() {
 		DRAIN_ERROR("can not support frequency Change ...");
 		m_needProcess = false;
 	}
+	if (m_input.getLayout() != m_output.getLayout()) {
+		DRAIN_ERROR("can not support layout Change ...");
+		m_needProcess = false;
+	}
+	m_functionDither = null;
+	m_functionDitherShaped = null;
 	if (m_input.getFormat() == m_output.getFormat()) {
 		// nothing to process...
 		m_needProcess = false;
 		return;
 	}
-	switch (m_input.getFormat()) {
-		default:
-		case audio::format_int16:
-			switch (m_output.getFormat()) {
-				default:
-				case audio::format_int16:
-					DRAIN_ERROR(" Impossible case 1");
-					break;
-				case audio::format_int16_on_int32:
-					m_functionConvert = &convert__int16__to__int16_on_int32;
-					DRAIN_DEBUG(" use converter : 'convert__int16__to__int16_on_int32' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_int32:
-					m_functionConvert = &convert__int16__to__int32;
-					DRAIN_DEBUG(" use converter : 'convert__int16__to__int32' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_float:
-					m_functionConvert = &convert__int16__to__float;
-					DRAIN_DEBUG(" use converter : 'convert__int16__to__float' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-			}
-			break;
-		case audio::format_int16_on_int32:
-			switch (m_output.getFormat()) {
-				default:
-				case audio::format_int16:
-					m_functionConvert = &convert__int16_on_int32__to__int16;
-					DRAIN_DEBUG(" use converter : 'convert__int16_on_int32__to__int16' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_int16_on_int32:
-					DRAIN_ERROR(" Impossible case 2");
-					break;
-				case audio::format_int32:
-					m_functionConvert = &convert__int16_on_int32__to__int32;
-					DRAIN_DEBUG(" use converter : 'convert__int16_on_int32__to__int32' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_float:
-					m_functionConvert = &convert__int16_on_int32__to__float;
-					DRAIN_DEBUG(" use converter : 'convert__int16_on_int32__to__float' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-			}
-			break;
-		case audio::format_int32:
-			switch (m_output.getFormat()) {
-				default:
-				case audio::format_int16:
-					m_functionConvert = &convert__int32__to__int16;
-					DRAIN_DEBUG(" use converter : 'convert__int32__to__int16' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_int16_on_int32:
-					m_functionConvert = &convert__int32__to__int16_on_int32;
-					DRAIN_DEBUG(" use converter : 'convert__int32__to__int16_on_int32' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_int32:
-					DRAIN_ERROR(" Impossible case 3");
-					break;
-				case audio::format_float:
-					m_functionConvert = &convert__int32__to__float;
-					DRAIN_DEBUG(" use converter : 'convert__int32__to__float' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-			}
-			break;
-		case audio::format_float:
-			switch (m_output.getFormat()) {
-				default:
-				case audio::format_int16:
-					m_functionConvert = &convert__float__to__int16;
-					DRAIN_DEBUG(" use converter : 'convert__float__to__int16' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_int16_on_int32:
-					m_functionConvert = &convert__float__to__int16_on_int32;
-					DRAIN_DEBUG(" use converter : 'convert__float__to__int16_on_int32' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_int32:
-					m_functionConvert = &convert__float__to__int32;
-					DRAIN_DEBUG(" use converter : 'convert__float__to__int32' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_float:
-					DRAIN_ERROR(" Impossible case 4");
-					break;
-			}
-			break;
+	// the planes are processed as single channel streams
+	size_t nbChannelDither = m_input.getMap().size();
+	if (m_input.getLayout() == audio::drain::layout_planar) {
+		nbChannelDither = 1;
+	}
+	if (m_output.getFormat() == audio::format_int16) {
+		// the conversions that reduce the resolution
+		if (m_input.getFormat() == audio::format_float) {
+			m_functionDither = &dither__to__int16<float>;
+			m_functionDitherShaped = getDitherShaped<float>(nbChannelDither);
+			#ifdef DRAIN_SIMD_X86
+				if (audio::drain::cpu::haveSse2() == true) {
+					m_functionDither = &dither__float__to__int16__sse2;
+				}
+			#endif
+		} else if (m_input.getFormat() == audio::format_int32) {
+			m_functionDither = &dither__to__int16<int32_t>;
+			m_functionDitherShaped = getDitherShaped<int32_t>(nbChannelDither);
+			#ifdef DRAIN_SIMD_X86
+				if (audio::drain::cpu::haveSse2() == true) {
+					m_functionDither = &dither__int32__to__int16__sse2;
+				}
+			#endif
+		}
+	}
+	m_ditherError.resize(m_output.getMap().size());
+	for (size_t iii=0; iii<m_ditherError.size(); ++iii) {
+		m_ditherError[iii] = 0.0f;
+	}
+	// direct access to the converter of the couple of formats
+	const simdConvertFunction& function = g_convertTable[getFormatId(m_input.getFormat())][getFormatId(m_output.getFormat())];
+	m_functionConvert = getSimdFunction(function);
+	if (m_functionConvert == null) {
+		DRAIN_ERROR("No converter for " << m_input.getFormat() << " to " << m_output.getFormat());
+		return;
 	}
+	DRAIN_DEBUG(" use converter for " << m_input.getFormat() << " to " << m_output.getFormat());
 }
 
 
-bool audio::drain::FormatUpdate::process(audio::Time& _time,
+bool audio::drain::FormatUpdate::process(audio::Time& /*_time*/,
                                          void* _input,
                                          size_t _inputNbChunk,
                                          void*& _output,
@@ -252,18 +772,55 @@ bool audio::drain::FormatUpdate::process(audio::Time& _time,
 		return true;
 	}
 	if (_input == null) {
-		_output = &(m_outputData[0]);
+		_output = m_outputData.data();
 		_outputNbChunk = 0;
 		DRAIN_ERROR("null pointer input ... ");
 		return false;
 	}
 	_outputNbChunk = _inputNbChunk;
-	m_outputData.resize(_outputNbChunk*m_input.getMap().size()*m_formatSize);
-	_output = &(m_outputData[0]);
+	if (m_inputSilence == true) {
+		_output = getSilenceBuffer(_input, _outputNbChunk);
+		return true;
+	}
+	_output = getOutputBuffer(_outputNbChunk);
 	if (m_functionConvert == null) {
 		DRAIN_ERROR("null function ptr");
 		return false;
 	}
-	m_functionConvert(_input, _output, _outputNbChunk*m_input.getMap().size());
+	size_t nbChannel = m_input.getMap().size();
+	// read once: the dither can change during the process
+	enum audio::drain::dither dither = m_dither.load();
+	if (    dither == audio::drain::dither_shaped
+	     && m_functionDitherShaped != null
+	     && m_ditherError.size() == nbChannel) {
+		if (m_input.getLayout() == audio::drain::layout_planar) {
+			// each plane is a single channel stream
+			size_t inputPlaneSize = _outputNbChunk*audio::getFormatBytes(m_input.getFormat());
+			size_t outputPlaneSize = _outputNbChunk*audio::getFormatBytes(m_output.getFormat());
+			for (size_t iii=0; iii<nbChannel; ++iii) {
+				m_functionDitherShaped(static_cast<uint8_t*>(_input) + iii*inputPlaneSize,
+				                       static_cast<uint8_t*>(_output) + iii*outputPlaneSize,
+				                       _outputNbChunk, 1, m_ditherRandom, &m_ditherError[iii]);
+			}
+		} else {
+			m_functionDitherShaped(_input, _output, _outputNbChunk, nbChannel, m_ditherRandom, &m_ditherError[0]);
+		}
+		return true;
+	}
+	if (    dither != audio::drain::dither_none
+	     && m_functionDither != null) {
+		m_functionDither(_input, _output, _outputNbChunk*nbChannel, m_ditherRandom);
+		return true;
+	}
+	m_functionConvert(_input, _output, _outputNbChunk*nbChannel);
 	return true;
 }
+
+bool audio::drain::FormatUpdate::needDither() const {
+	if (m_dither.load() == audio::drain::dither_none) {
+		return false;
+	}
+	return    m_output.getFormat() == audio::format_int16
+	       && (    m_input.getFormat() == audio::format_float
+	            || m_input.getFormat() == audio::format_int32);
+}
@@ -6,9 +6,19 @@
 #pragma once
 
 #include <audio/drain/Algo.hpp>
+#include <atomic>
 
 namespace audio {
 	namespace drain {
+		/**
+		 * @brief Dither of the requantization in int16_t (float or int32_t input).
+		 */
+		enum dither {
+			dither_none, //!< Rounding only (truncation of the int32_t)
+			dither_tpdf, //!< Triangular noise of +/-1 LSB before the rounding (decorrelate the error from the signal)
+			dither_shaped, //!< TPDF and first order noise shaping: the error is pushed in the high frequencies
+		};
+		etk::Stream& operator <<(etk::Stream& _os, enum audio::drain::dither _obj);
 		class FormatUpdate : public Algo {
 			protected:
 				/**
@@ -25,6 +35,9 @@ namespace audio {
 			protected:
 				virtual void configurationChange();
 			public:
+				virtual bool isPassThrough() const {
+					return m_needProcess == false;
+				}
 				virtual bool process(audio::Time& _time,
 				                     void* _input,
 				                     size_t _inputNbChunk,
@@ -32,6 +45,33 @@ namespace audio {
 				                     size_t& _outputNbChunk);
 			private:
 				void (*m_functionConvert)(void* _input, void* _output, size_t _nbSample);
+			protected:
+				std::atomic<enum audio::drain::dither> m_dither; //!< Dither of the requantization in int16_t (set by the control thread on a running chain)
+				uint32_t m_ditherRandom[4]; //!< State of the random generator of the dither (one by SIMD lane)
+				etk::Vector<float> m_ditherError; //!< Quantization error of the previous sample of each channel (noise shaping)
+				void (*m_functionDither)(void* _input, void* _output, size_t _nbSample, uint32_t* _random);
+				void (*m_functionDitherShaped)(void* _input, void* _output, size_t _nbChunk, size_t _nbChannel, uint32_t* _random, float* _error);
+			public:
+				/**
+				 * @brief Set the dither of the requantization in int16_t (applied in the conversion: no extra pass).
+				 * @note Only the float and int32_t to int16_t conversions reduce the resolution: the other ones are not dithered.
+				 * @param[in] _value New dither (taken on the next process).
+				 */
+				void setDither(enum audio::drain::dither _value) {
+					m_dither.store(_value);
+				}
+				/**
+				 * @brief Get the dither of the requantization in int16_t.
+				 * @return Current dither.
+				 */
+				enum audio::drain::dither getDither() const {
+					return m_dither.load();
+				}
+				/**
+				 * @brief Check if the conversion is dithered (a dither is set and the conversion reduce the resolution).
+				 * @return true The output is dithered.
+				 */
+				bool needDither() const;
 		};
 	}
 }
@@ -7,6 +7,18 @@
 #include "IOFormatInterface.hpp"
 #include "debug.hpp"
 
+etk::Stream& audio::drain::operator <<(etk::Stream& _os, enum audio::drain::layout _obj) {
+	switch (_obj) {
+		case audio::drain::layout_interleaved:
+			_os << "interleaved";
+			break;
+		case audio::drain::layout_planar:
+			_os << "planar";
+			break;
+	}
+	return _os;
+}
+
 etk::Stream& audio::drain::operator <<(etk::Stream& _os, const IOFormatInterface& _obj) {
 	_os << "{";
 	if (_obj.getConfigured() == false) {
@@ -15,6 +27,9 @@ etk::Stream& audio::drain::operator <<(etk::Stream& _os, const IOFormatInterface
 		_os << "format=" << _obj.getFormat();
 		_os << ", frequency=" << _obj.getFrequency();
 		_os << ", map=" << _obj.getMap();
+		if (_obj.getLayout() != audio::drain::layout_interleaved) {
+			_os << ", layout=" << _obj.getLayout();
+		}
 	}
 	_os << "}";
 	return _os;
@@ -24,20 +39,28 @@ audio::drain::IOFormatInterface::IOFormatInterface() :
   m_configured(false),
   m_format(audio::format_unknow),
   m_map(),
-  m_frequency(0) {
+  m_frequency(0),
+  m_layout(audio::drain::layout_interleaved) {
 	m_map.pushBack(audio::channel_frontLeft);
 	m_map.pushBack(audio::channel_frontRight);
 }
 
-audio::drain::IOFormatInterface::IOFormatInterface(etk::Vector<enum audio::channel> _map, enum audio::format _format, float _frequency) :
+audio::drain::IOFormatInterface::IOFormatInterface(etk::Vector<enum audio::channel> _map,
+                                                   enum audio::format _format,
+                                                   float _frequency,
+                                                   enum audio::drain::layout _layout) :
   m_configured(true),
   m_format(_format),
   m_map(_map),
-  m_frequency(_frequency) {
+  m_frequency(_frequency),
+  m_layout(_layout) {
 	
 }
 
-void audio::drain::IOFormatInterface::set(etk::Vector<enum audio::channel> _map, enum audio::format _format, float _frequency) {
+void audio::drain::IOFormatInterface::set(etk::Vector<enum audio::channel> _map,
+                                          enum audio::format _format,
+                                          float _frequency,
+                                          enum audio::drain::layout _layout) {
 	bool hasChange = false;
 	if (m_map != _map) {
 		m_map = _map;
@@ -51,12 +74,24 @@ void audio::drain::IOFormatInterface::set(etk::Vector<enum audio::channel> _map,
 		m_frequency = _frequency;
 		hasChange = true;
 	}
+	if (m_layout != _layout) {
+		m_layout = _layout;
+		hasChange = true;
+	}
 	if (hasChange == true) {
 		m_configured = true;
 		configurationChange();
 	}
 }
 
+bool audio::drain::IOFormatInterface::operator==(const audio::drain::IOFormatInterface& _obj) const {
+	return    m_configured == _obj.m_configured
+	       && m_format == _obj.m_format
+	       && m_map == _obj.m_map
+	       && m_frequency == _obj.m_frequency
+	       && m_layout == _obj.m_layout;
+}
+
 void audio::drain::IOFormatInterface::setConfigured(bool _value) {
 	m_configured = _value;
 }
@@ -104,6 +139,19 @@ void audio::drain::IOFormatInterface::setFrequency(float _value) {
 	configurationChange();
 }
 
+enum audio::drain::layout audio::drain::IOFormatInterface::getLayout() const {
+	return m_layout;
+}
+
+void audio::drain::IOFormatInterface::setLayout(enum audio::drain::layout _value) {
+	if (m_layout == _value) {
+		return;
+	}
+	m_configured = true;
+	m_layout = _value;
+	configurationChange();
+}
+
 void audio::drain::IOFormatInterface::configurationChange() {
 	if (m_ioChangeFunctor != null) {
 		m_ioChangeFunctor();
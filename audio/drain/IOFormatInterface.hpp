@@ -17,11 +17,25 @@
 
 namespace audio {
 	namespace drain{
+		/**
+		 * @brief Organisation of the samples in a buffer.
+		 */
+		enum layout {
+			layout_interleaved, //!< L0 R0 L1 R1 L2 R2 ... (one chunk contain all the channels)
+			layout_planar, //!< L0 L1 L2 ... R0 R1 R2 ... (one contiguous plane of nbChunk samples by channel)
+		};
+		etk::Stream& operator <<(etk::Stream& _os, enum audio::drain::layout _obj);
 		class IOFormatInterface {
 			public:
 				IOFormatInterface();
-				IOFormatInterface(etk::Vector<enum audio::channel> _map, enum audio::format _format=audio::format_int16, float _frequency=48000.0f);
-				void set(etk::Vector<enum audio::channel> _map, enum audio::format _format=audio::format_int16, float _frequency=48000.0f);
+				IOFormatInterface(etk::Vector<enum audio::channel> _map,
+				                  enum audio::format _format=audio::format_int16,
+				                  float _frequency=48000.0f,
+				                  enum audio::drain::layout _layout=audio::drain::layout_interleaved);
+				void set(etk::Vector<enum audio::channel> _map,
+				         enum audio::format _format=audio::format_int16,
+				         float _frequency=48000.0f,
+				         enum audio::drain::layout _layout=audio::drain::layout_interleaved);
 			protected:
 				bool m_configured;
 			public:
@@ -66,12 +80,34 @@ namespace audio {
 				 * @param[in] _value New frequency.
 				 */
 				void setFrequency(float _value);
+			protected:
+				enum audio::drain::layout m_layout; //!< Organisation of the samples in the buffer
+			public:
+				/**
+				 * @brief Get the buffer layout.
+				 * @return the current layout.
+				 */
+				enum audio::drain::layout getLayout() const;
+				/**
+				 * @brief Set the buffer layout.
+				 * @param[in] _value New layout.
+				 */
+				void setLayout(enum audio::drain::layout _value);
 			public:
 				/**
 				 * @brief Get the Chunk size in byte.
 				 * @return the number of byte used by chunk.
 				 */
 				int32_t getChunkSize() const;
+				/**
+				 * @brief Check if 2 interfaces describe the same samples (map, format, frequency and layout).
+				 * @param[in] _obj Other interface.
+				 * @return true The buffers of one can be read with the other.
+				 */
+				bool operator==(const IOFormatInterface& _obj) const;
+				bool operator!=(const IOFormatInterface& _obj) const {
+					return !(*this == _obj);
+				}
 			protected:
 				etk::Function<void()> m_ioChangeFunctor; //!< function pointer on the upper class
 				void configurationChange();
@@ -0,0 +1,160 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <audio/drain/Metric.hpp>
+#include <audio/drain/debug.hpp>
+
+audio::drain::EndPointMetricSnapshot::EndPointMetricSnapshot() :
+  m_nbProcess(0),
+  m_nbUnderflow(0),
+  m_underflowChunk(0),
+  m_nbOverflow(0),
+  m_overflowChunk(0),
+  m_fillLevel(0),
+  m_fillCapacity(0),
+  m_driftPpm(0) {
+	for (size_t iii=0; iii<audio::drain::metricFillBucket; ++iii) {
+		m_fillHistogram[iii] = 0;
+	}
+}
+
+etk::Stream& audio::drain::operator <<(etk::Stream& _os, const audio::drain::EndPointMetricSnapshot& _obj) {
+	_os << "{process=" << _obj.m_nbProcess;
+	_os << ", underflow=" << _obj.m_nbUnderflow << "(" << _obj.m_underflowChunk << " chunks)";
+	_os << ", overflow=" << _obj.m_nbOverflow << "(" << _obj.m_overflowChunk << " chunks)";
+	_os << ", fill=" << _obj.m_fillLevel << "/" << _obj.m_fillCapacity;
+	_os << ", histogram=[";
+	for (size_t iii=0; iii<audio::drain::metricFillBucket; ++iii) {
+		if (iii != 0) {
+			_os << ",";
+		}
+		_os << _obj.m_fillHistogram[iii];
+	}
+	_os << "]";
+	if (_obj.m_driftPpm != 0) {
+		_os << ", drift=" << _obj.m_driftPpm << "ppm";
+	}
+	_os << "}";
+	return _os;
+}
+
+audio::drain::EndPointMetric::EndPointMetric() :
+  m_nbProcess(0),
+  m_nbUnderflow(0),
+  m_underflowChunk(0),
+  m_nbOverflow(0),
+  m_overflowChunk(0),
+  m_fillLevel(0),
+  m_fillCapacity(0),
+  m_driftPpm(0) {
+	for (size_t iii=0; iii<audio::drain::metricFillBucket; ++iii) {
+		m_fillHistogram[iii].store(0, std::memory_order_relaxed);
+	}
+}
+
+void audio::drain::EndPointMetric::addFill(size_t _nbChunk, size_t _capacity) {
+	m_nbProcess.fetch_add(1, std::memory_order_relaxed);
+	m_fillLevel.store(_nbChunk, std::memory_order_relaxed);
+	m_fillCapacity.store(_capacity, std::memory_order_relaxed);
+	if (_capacity == 0) {
+		return;
+	}
+	size_t bucket = etk::min(_nbChunk*audio::drain::metricFillBucket/_capacity, audio::drain::metricFillBucket-1);
+	m_fillHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void audio::drain::EndPointMetric::getSnapshot(audio::drain::EndPointMetricSnapshot& _snapshot) const {
+	_snapshot.m_nbProcess = m_nbProcess.load(std::memory_order_relaxed);
+	_snapshot.m_nbUnderflow = m_nbUnderflow.load(std::memory_order_relaxed);
+	_snapshot.m_underflowChunk = m_underflowChunk.load(std::memory_order_relaxed);
+	_snapshot.m_nbOverflow = m_nbOverflow.load(std::memory_order_relaxed);
+	_snapshot.m_overflowChunk = m_overflowChunk.load(std::memory_order_relaxed);
+	for (size_t iii=0; iii<audio::drain::metricFillBucket; ++iii) {
+		_snapshot.m_fillHistogram[iii] = m_fillHistogram[iii].load(std::memory_order_relaxed);
+	}
+	_snapshot.m_fillLevel = m_fillLevel.load(std::memory_order_relaxed);
+	_snapshot.m_fillCapacity = m_fillCapacity.load(std::memory_order_relaxed);
+	_snapshot.m_driftPpm = m_driftPpm.load(std::memory_order_relaxed);
+}
+
+void audio::drain::EndPointMetric::reset() {
+	m_nbProcess.store(0, std::memory_order_relaxed);
+	m_nbUnderflow.store(0, std::memory_order_relaxed);
+	m_underflowChunk.store(0, std::memory_order_relaxed);
+	m_nbOverflow.store(0, std::memory_order_relaxed);
+	m_overflowChunk.store(0, std::memory_order_relaxed);
+	for (size_t iii=0; iii<audio::drain::metricFillBucket; ++iii) {
+		m_fillHistogram[iii].store(0, std::memory_order_relaxed);
+	}
+}
+
+audio::drain::ProcessMetricSnapshot::ProcessMetricSnapshot() :
+  m_nbPeriod(0),
+  m_nbDeadlineMiss(0),
+  m_timeTotal(0),
+  m_timeLast(0),
+  m_timeMax(0),
+  m_deadlineTotal(0),
+  m_deadlineLast(0) {
+
+}
+
+etk::Stream& audio::drain::operator <<(etk::Stream& _os, const audio::drain::ProcessMetricSnapshot& _obj) {
+	_os << "{period=" << _obj.m_nbPeriod;
+	_os << ", deadlineMiss=" << _obj.m_nbDeadlineMiss;
+	_os << ", time=" << _obj.m_timeLast << "ns(max=" << _obj.m_timeMax << "ns)";
+	_os << ", load=" << int32_t(_obj.getLoad()*100.0f) << "%(last=" << int32_t(_obj.getLoadLast()*100.0f) << "%)";
+	_os << "}";
+	return _os;
+}
+
+audio::drain::ProcessMetric::ProcessMetric() :
+  m_nbPeriod(0),
+  m_nbDeadlineMiss(0),
+  m_timeTotal(0),
+  m_timeLast(0),
+  m_timeMax(0),
+  m_deadlineTotal(0),
+  m_deadlineLast(0) {
+
+}
+
+void audio::drain::ProcessMetric::addPeriod(uint64_t _time, uint64_t _deadline) {
+	m_nbPeriod.fetch_add(1, std::memory_order_relaxed);
+	m_timeTotal.fetch_add(_time, std::memory_order_relaxed);
+	m_timeLast.store(_time, std::memory_order_relaxed);
+	// only the audio thread write: no compare-exchange needed
+	if (_time > m_timeMax.load(std::memory_order_relaxed)) {
+		m_timeMax.store(_time, std::memory_order_relaxed);
+	}
+	m_deadlineTotal.fetch_add(_deadline, std::memory_order_relaxed);
+	m_deadlineLast.store(_deadline, std::memory_order_relaxed);
+	if (    _deadline != 0
+	     && _time > _deadline) {
+		m_nbDeadlineMiss.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void audio::drain::ProcessMetric::getSnapshot(audio::drain::ProcessMetricSnapshot& _snapshot) const {
+	_snapshot.m_nbPeriod = m_nbPeriod.load(std::memory_order_relaxed);
+	_snapshot.m_nbDeadlineMiss = m_nbDeadlineMiss.load(std::memory_order_relaxed);
+	_snapshot.m_timeTotal = m_timeTotal.load(std::memory_order_relaxed);
+	_snapshot.m_timeLast = m_timeLast.load(std::memory_order_relaxed);
+	_snapshot.m_timeMax = m_timeMax.load(std::memory_order_relaxed);
+	_snapshot.m_deadlineTotal = m_deadlineTotal.load(std::memory_order_relaxed);
+	_snapshot.m_deadlineLast = m_deadlineLast.load(std::memory_order_relaxed);
+}
+
+void audio::drain::ProcessMetric::reset() {
+	m_nbPeriod.store(0, std::memory_order_relaxed);
+	m_nbDeadlineMiss.store(0, std::memory_order_relaxed);
+	m_timeTotal.store(0, std::memory_order_relaxed);
+	m_timeLast.store(0, std::memory_order_relaxed);
+	m_timeMax.store(0, std::memory_order_relaxed);
+	m_deadlineTotal.store(0, std::memory_order_relaxed);
+	m_deadlineLast.store(0, std::memory_order_relaxed);
+}
+
@@ -0,0 +1,156 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <etk/Stream.hpp>
+#include <atomic>
+
+namespace audio {
+	namespace drain {
+		static const size_t metricFillBucket = 8; //!< Number of bucket of the fill histogram (bucket i: fill in [i/8, (i+1)/8[ of the capacity, full in the last)
+		/**
+		 * @brief Copy of the counters of an end-point (plain values, read by the monitoring).
+		 */
+		class EndPointMetricSnapshot {
+			public:
+				uint64_t m_nbProcess; //!< Number of process call
+				uint64_t m_nbUnderflow; //!< Number of process without enough data
+				uint64_t m_underflowChunk; //!< Number of chunk missing (replaced by silence or not sent)
+				uint64_t m_nbOverflow; //!< Number of process with a full buffer
+				uint64_t m_overflowChunk; //!< Number of chunk dropped
+				uint64_t m_fillHistogram[audio::drain::metricFillBucket]; //!< Fill of the buffer at each process call
+				uint64_t m_fillLevel; //!< Number of chunk in the buffer at the last process call
+				uint64_t m_fillCapacity; //!< Capacity of the buffer at the last process call
+				int32_t m_driftPpm; //!< Correction of the drift compensation (part per million, 0 when disable)
+				EndPointMetricSnapshot();
+		};
+		etk::Stream& operator <<(etk::Stream& _os, const audio::drain::EndPointMetricSnapshot& _obj);
+		/**
+		 * @brief Live counters of an end-point: written by the audio thread with relaxed atomics, read at any time
+		 * by an other thread with getSnapshot (no lock, no wait on the audio thread).
+		 * @note The counters are independent: a snapshot is not an atomic view of all of them.
+		 */
+		class EndPointMetric {
+			protected:
+				std::atomic<uint64_t> m_nbProcess; //!< Number of process call
+				std::atomic<uint64_t> m_nbUnderflow; //!< Number of underflow
+				std::atomic<uint64_t> m_underflowChunk; //!< Chunk missing
+				std::atomic<uint64_t> m_nbOverflow; //!< Number of overflow
+				std::atomic<uint64_t> m_overflowChunk; //!< Chunk dropped
+				std::atomic<uint64_t> m_fillHistogram[audio::drain::metricFillBucket]; //!< Fill histogram
+				std::atomic<uint64_t> m_fillLevel; //!< Last fill level
+				std::atomic<uint64_t> m_fillCapacity; //!< Last capacity
+				std::atomic<int32_t> m_driftPpm; //!< Last drift correction
+			public:
+				EndPointMetric();
+				/**
+				 * @brief Add the fill of the buffer of a process call (count a process call).
+				 * @param[in] _nbChunk Number of chunk in the buffer.
+				 * @param[in] _capacity Capacity of the buffer in chunk.
+				 */
+				void addFill(size_t _nbChunk, size_t _capacity);
+				/**
+				 * @brief Add an underflow.
+				 * @param[in] _nbChunk Number of chunk missing.
+				 */
+				void addUnderflow(size_t _nbChunk) {
+					m_nbUnderflow.fetch_add(1, std::memory_order_relaxed);
+					m_underflowChunk.fetch_add(_nbChunk, std::memory_order_relaxed);
+				}
+				/**
+				 * @brief Add an overflow.
+				 * @param[in] _nbChunk Number of chunk dropped.
+				 */
+				void addOverflow(size_t _nbChunk) {
+					m_nbOverflow.fetch_add(1, std::memory_order_relaxed);
+					m_overflowChunk.fetch_add(_nbChunk, std::memory_order_relaxed);
+				}
+				/**
+				 * @brief Set the current ratio of the drift compensation.
+				 * @param[in] _ratio Input chunk by output chunk (1.0: no correction).
+				 */
+				void setDrift(double _ratio) {
+					m_driftPpm.store(int32_t((_ratio - 1.0) * 1000000.0), std::memory_order_relaxed);
+				}
+				/**
+				 * @brief Get a copy of the counters.
+				 * @param[out] _snapshot Current values.
+				 */
+				void getSnapshot(audio::drain::EndPointMetricSnapshot& _snapshot) const;
+				/**
+				 * @brief Clear all the counters.
+				 */
+				void reset();
+		};
+		/**
+		 * @brief Copy of the counters of a Process (plain values, read by the monitoring).
+		 */
+		class ProcessMetricSnapshot {
+			public:
+				uint64_t m_nbPeriod; //!< Number of process call with data
+				uint64_t m_nbDeadlineMiss; //!< Number of period processed slower than the real time
+				uint64_t m_timeTotal; //!< Total processing time (ns)
+				uint64_t m_timeLast; //!< Processing time of the last period (ns)
+				uint64_t m_timeMax; //!< Slower period (ns)
+				uint64_t m_deadlineTotal; //!< Total duration of the data processed (ns)
+				uint64_t m_deadlineLast; //!< Duration of the data of the last period (ns)
+				ProcessMetricSnapshot();
+				/**
+				 * @brief Get the average CPU load of the Process.
+				 * @return Processing time / duration of the data (1.0: real time limit).
+				 */
+				float getLoad() const {
+					if (m_deadlineTotal == 0) {
+						return 0.0f;
+					}
+					return float(double(m_timeTotal) / double(m_deadlineTotal));
+				}
+				/**
+				 * @brief Get the CPU load of the last period.
+				 * @return Processing time / duration of the data (1.0: real time limit).
+				 */
+				float getLoadLast() const {
+					if (m_deadlineLast == 0) {
+						return 0.0f;
+					}
+					return float(double(m_timeLast) / double(m_deadlineLast));
+				}
+		};
+		etk::Stream& operator <<(etk::Stream& _os, const audio::drain::ProcessMetricSnapshot& _obj);
+		/**
+		 * @brief Live counters of a Process (same access rules as audio::drain::EndPointMetric).
+		 */
+		class ProcessMetric {
+			protected:
+				std::atomic<uint64_t> m_nbPeriod; //!< Number of period
+				std::atomic<uint64_t> m_nbDeadlineMiss; //!< Number of late period
+				std::atomic<uint64_t> m_timeTotal; //!< Total processing time (ns)
+				std::atomic<uint64_t> m_timeLast; //!< Last processing time (ns)
+				std::atomic<uint64_t> m_timeMax; //!< Slower period (ns)
+				std::atomic<uint64_t> m_deadlineTotal; //!< Total duration of the data (ns)
+				std::atomic<uint64_t> m_deadlineLast; //!< Last duration of the data (ns)
+			public:
+				ProcessMetric();
+				/**
+				 * @brief Add a processed period.
+				 * @param[in] _time Processing time (ns).
+				 * @param[in] _deadline Duration of the data processed (ns, 0 if unknow).
+				 */
+				void addPeriod(uint64_t _time, uint64_t _deadline);
+				/**
+				 * @brief Get a copy of the counters.
+				 * @param[out] _snapshot Current values.
+				 */
+				void getSnapshot(audio::drain::ProcessMetricSnapshot& _snapshot) const;
+				/**
+				 * @brief Clear all the counters.
+				 */
+				void reset();
+		};
+	}
+}
+
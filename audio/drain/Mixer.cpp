@@ -0,0 +1,329 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <audio/drain/Mixer.hpp>
+#include <audio/drain/cpu.hpp>
+#include <audio/drain/debug.hpp>
+
+audio::drain::Mixer::Mixer() :
+  m_directAccumulation(false),
+  m_functionLoad(null),
+  m_functionAdd(null),
+  m_functionStore(null) {
+
+}
+
+void audio::drain::Mixer::init() {
+	audio::drain::Algo::init();
+	m_type = "Mixer";
+	m_supportedFormat.pushBack(audio::format_float);
+	m_supportedFormat.pushBack(audio::format_int16_on_int32);
+	m_supportedFormat.pushBack(audio::format_int16);
+}
+
+ememory::SharedPtr<audio::drain::Mixer> audio::drain::Mixer::create() {
+	ememory::SharedPtr<audio::drain::Mixer> tmp(ETK_NEW(audio::drain::Mixer));
+	tmp->init();
+	return tmp;
+}
+
+audio::drain::Mixer::~Mixer() {
+
+}
+
+template<typename TYPE_IN, typename TYPE_ACC>
+static void mixLoad(const void* _input, void* _accumulator, size_t _nbSample) {
+	const TYPE_IN* in = static_cast<const TYPE_IN*>(_input);
+	TYPE_ACC* acc = static_cast<TYPE_ACC*>(_accumulator);
+	for (size_t iii=0; iii<_nbSample; ++iii) {
+		acc[iii] = TYPE_ACC(in[iii]);
+	}
+}
+
+template<typename TYPE_IN, typename TYPE_ACC>
+static void mixAdd(const void* _input, void* _accumulator, size_t _nbSample) {
+	const TYPE_IN* in = static_cast<const TYPE_IN*>(_input);
+	TYPE_ACC* acc = static_cast<TYPE_ACC*>(_accumulator);
+	for (size_t iii=0; iii<_nbSample; ++iii) {
+		acc[iii] += TYPE_ACC(in[iii]);
+	}
+}
+
+static void mixStore__int32__to__int16(const void* _accumulator, void* _output, size_t _nbSample) {
+	const int32_t* acc = static_cast<const int32_t*>(_accumulator);
+	int16_t* out = static_cast<int16_t*>(_output);
+	for (size_t iii=0; iii<_nbSample; ++iii) {
+		out[iii] = int16_t(etk::min(etk::max(int32_t(INT16_MIN), acc[iii]), int32_t(INT16_MAX)));
+	}
+}
+
+#ifdef DRAIN_SIMD_X86
+DRAIN_TARGET_SSE2 static void mixAdd__int16__to__int32__sse2(const void* _input, void* _accumulator, size_t _nbSample) {
+	const int16_t* in = static_cast<const int16_t*>(_input);
+	int32_t* acc = static_cast<int32_t*>(_accumulator);
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]));
+		// sign extention in int32_t
+		__m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+		__m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16);
+		__m128i* out = reinterpret_cast<__m128i*>(&acc[iii]);
+		_mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), low));
+		_mm_storeu_si128(out+1, _mm_add_epi32(_mm_loadu_si128(out+1), high));
+	}
+	mixAdd<int16_t, int32_t>(&in[iii], &acc[iii], _nbSample-iii);
+}
+DRAIN_TARGET_SSE2 static void mixAdd__int32__to__int32__sse2(const void* _input, void* _accumulator, size_t _nbSample) {
+	const int32_t* in = static_cast<const int32_t*>(_input);
+	int32_t* acc = static_cast<int32_t*>(_accumulator);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		__m128i* out = reinterpret_cast<__m128i*>(&acc[iii]);
+		_mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]))));
+	}
+	mixAdd<int32_t, int32_t>(&in[iii], &acc[iii], _nbSample-iii);
+}
+DRAIN_TARGET_SSE2 static void mixAdd__float__to__float__sse2(const void* _input, void* _accumulator, size_t _nbSample) {
+	const float* in = static_cast<const float*>(_input);
+	float* acc = static_cast<float*>(_accumulator);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		_mm_storeu_ps(&acc[iii], _mm_add_ps(_mm_loadu_ps(&acc[iii]), _mm_loadu_ps(&in[iii])));
+	}
+	mixAdd<float, float>(&in[iii], &acc[iii], _nbSample-iii);
+}
+DRAIN_TARGET_SSE2 static void mixStore__int32__to__int16__sse2(const void* _accumulator, void* _output, size_t _nbSample) {
+	const int32_t* acc = static_cast<const int32_t*>(_accumulator);
+	int16_t* out = static_cast<int16_t*>(_output);
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		// pack with signed saturation
+		__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&acc[iii]));
+		__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&acc[iii+4]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_packs_epi32(low, high));
+	}
+	mixStore__int32__to__int16(&acc[iii], &out[iii], _nbSample-iii);
+}
+#endif
+
+void audio::drain::Mixer::configurationChange() {
+	audio::drain::Algo::configurationChange();
+	if (m_input.getMap() != m_output.getMap()) {
+		DRAIN_ERROR("Mixer map change is not supported");
+	}
+	if (m_input.getFrequency() != m_output.getFrequency()) {
+		DRAIN_ERROR("Mixer frequency change is not supported");
+	}
+	if (m_input.getFormat() != m_output.getFormat()) {
+		DRAIN_ERROR("Mixer format change is not supported");
+	}
+	m_directAccumulation = true;
+	m_functionStore = null;
+	switch (m_output.getFormat()) {
+		case audio::format_int16:
+			// accumulate in int32: saturation only at the end
+			m_directAccumulation = false;
+			m_functionLoad = &mixLoad<int16_t, int32_t>;
+			m_functionAdd = &mixAdd<int16_t, int32_t>;
+			m_functionStore = &mixStore__int32__to__int16;
+			#ifdef DRAIN_SIMD_X86
+				if (audio::drain::cpu::haveSse2() == true) {
+					m_functionAdd = &mixAdd__int16__to__int32__sse2;
+					m_functionStore = &mixStore__int32__to__int16__sse2;
+				}
+			#endif
+			break;
+		case audio::format_int16_on_int32:
+			// the format keep 16 bits of headroom
+			m_functionLoad = &mixLoad<int32_t, int32_t>;
+			m_functionAdd = &mixAdd<int32_t, int32_t>;
+			#ifdef DRAIN_SIMD_X86
+				if (audio::drain::cpu::haveSse2() == true) {
+					m_functionAdd = &mixAdd__int32__to__int32__sse2;
+				}
+			#endif
+			break;
+		case audio::format_float:
+			m_functionLoad = &mixLoad<float, float>;
+			m_functionAdd = &mixAdd<float, float>;
+			#ifdef DRAIN_SIMD_X86
+				if (audio::drain::cpu::haveSse2() == true) {
+					m_functionAdd = &mixAdd__float__to__float__sse2;
+				}
+			#endif
+			break;
+		default:
+			m_functionLoad = null;
+			m_functionAdd = null;
+			if (m_output.getFormat() != audio::format_unknow) {
+				DRAIN_ERROR("Mixer format not supported: " << m_output.getFormat());
+			}
+			break;
+	}
+	processBufferSizeChange();
+	// the inputs follow the format of the mixer
+	ethread::UniqueLock lock(m_inputLock);
+	for (size_t iii=0; iii<m_listInput.size(); ++iii) {
+		configureInput(m_listInput[iii]);
+	}
+	m_needProcess = true;
+}
+
+void audio::drain::Mixer::processBufferSizeChange() {
+	// the periods bigger than the process buffer size are mixed by blocks
+	size_t nbChunk = etk::max(getProcessBufferSize(), size_t(1));
+	m_inputBuffer.resize(nbChunk*m_input.getChunkSize());
+	if (m_directAccumulation == true) {
+		m_accumulator.clear();
+		return;
+	}
+	// int32 as the float: 4 bytes by sample
+	m_accumulator.resize(nbChunk*m_input.getMap().size()*sizeof(int32_t));
+}
+
+void audio::drain::Mixer::configureInput(const ememory::SharedPtr<audio::drain::Process>& _input) {
+	if (    _input == null
+	     || m_input.getConfigured() == false) {
+		return;
+	}
+	_input->setOutputConfig(audio::drain::IOFormatInterface(m_input.getMap(), m_input.getFormat(), m_input.getFrequency()));
+}
+
+void audio::drain::Mixer::addInput(const ememory::SharedPtr<audio::drain::Process>& _input) {
+	if (_input == null) {
+		return;
+	}
+	ethread::UniqueLock lock(m_inputLock);
+	for (size_t iii=0; iii<m_listInput.size(); ++iii) {
+		if (m_listInput[iii] == _input) {
+			return;
+		}
+	}
+	configureInput(_input);
+	m_listInput.pushBack(_input);
+	m_activeInput.set(m_listInput);
+}
+
+void audio::drain::Mixer::removeInput(const ememory::SharedPtr<audio::drain::Process>& _input) {
+	ethread::UniqueLock lock(m_inputLock);
+	for (size_t iii=0; iii<m_listInput.size(); ++iii) {
+		if (m_listInput[iii] == _input) {
+			m_listInput.erase(m_listInput.begin()+iii);
+			m_activeInput.set(m_listInput);
+			return;
+		}
+	}
+}
+
+size_t audio::drain::Mixer::getNbInput() {
+	ethread::UniqueLock lock(m_inputLock);
+	return m_listInput.size();
+}
+
+bool audio::drain::Mixer::canProcessInPlace() const {
+	// the input is the first element of the accumulation
+	return m_directAccumulation;
+}
+
+bool audio::drain::Mixer::process(audio::Time& _time,
+                                  void* _input,
+                                  size_t _inputNbChunk,
+                                  void*& _output,
+                                  size_t& _outputNbChunk) {
+	audio::drain::AutoLogInOut tmpLog("Mixer");
+	// take the inputs added by the control thread since the previous period
+	m_activeInput.update();
+	const etk::Vector<ememory::SharedPtr<audio::drain::Process> >& listInput = m_activeInput.get();
+	_output = _input;
+	_outputNbChunk = _inputNbChunk;
+	if (    listInput.size() == 0
+	     || _inputNbChunk == 0) {
+		// nothing to mix
+		return true;
+	}
+	if (    m_functionLoad == null
+	     || m_functionAdd == null) {
+		DRAIN_ERROR("null function ptr");
+		return false;
+	}
+	size_t chunkSize = m_input.getChunkSize();
+	size_t blockNbChunk = etk::max(getProcessBufferSize(), size_t(1));
+	_output = getOutputBuffer(_inputNbChunk);
+	bool silent = true;
+	for (size_t offset=0; offset<_inputNbChunk; offset+=blockNbChunk) {
+		size_t nbChunk = etk::min(blockNbChunk, _inputNbChunk - offset);
+		audio::Time time = _time;
+		if (    offset != 0
+		     && m_input.getFrequency() != 0) {
+			time += audio::Duration(0, int64_t(offset)*1000000000LL/int64_t(m_input.getFrequency()));
+		}
+		const void* input = null;
+		if (_input != null) {
+			input = static_cast<const uint8_t*>(_input) + offset*chunkSize;
+		}
+		if (mixBlock(listInput, time, input, static_cast<uint8_t*>(_output) + offset*chunkSize, nbChunk) == false) {
+			silent = false;
+		}
+	}
+	if (silent == true) {
+		// all the inputs are silent ==> the next algos see a silent stream
+		m_outputSilence = true;
+	}
+	return true;
+}
+
+bool audio::drain::Mixer::mixBlock(const etk::Vector<ememory::SharedPtr<audio::drain::Process> >& _listInput,
+                                   const audio::Time& _time,
+                                   const void* _input,
+                                   void* _output,
+                                   size_t _nbChunk) {
+	size_t nbSample = _nbChunk*m_input.getMap().size();
+	size_t chunkSize = m_input.getChunkSize();
+	void* accumulator = _output;
+	if (m_directAccumulation == false) {
+		accumulator = m_accumulator.data();
+	}
+	bool silent = true;
+	if (    _input != null
+	     && m_inputSilence == false) {
+		if (accumulator != _input) {
+			m_functionLoad(_input, accumulator, nbSample);
+		}
+		silent = false;
+	}
+	for (size_t iii=0; iii<_listInput.size(); ++iii) {
+		if (_listInput[iii] == null) {
+			continue;
+		}
+		audio::Time time = _time;
+		_listInput[iii]->pull(time, m_inputBuffer.data(), _nbChunk, chunkSize);
+		// silence of the data of this pull (the residual data of the previous pull included)
+		size_t nbChunkDone = _listInput[iii]->getPullNbChunk();
+		if (    nbChunkDone == 0
+		     || _listInput[iii]->getPullSilence() == true) {
+			// 0 does not change the sum
+			continue;
+		}
+		if (nbChunkDone < _nbChunk) {
+			// the input has no more data: the end of the block is silent
+			memset(m_inputBuffer.data() + nbChunkDone*chunkSize, 0, (_nbChunk - nbChunkDone)*chunkSize);
+		}
+		if (silent == true) {
+			m_functionLoad(m_inputBuffer.data(), accumulator, nbSample);
+			silent = false;
+		} else {
+			m_functionAdd(m_inputBuffer.data(), accumulator, nbSample);
+		}
+	}
+	if (silent == true) {
+		memset(_output, 0, _nbChunk*chunkSize);
+		return true;
+	}
+	if (m_directAccumulation == false) {
+		m_functionStore(accumulator, _output, nbSample);
+	}
+	return false;
+}
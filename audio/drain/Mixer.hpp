@@ -0,0 +1,98 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <audio/drain/Algo.hpp>
+#include <audio/drain/Process.hpp>
+#include <audio/drain/AlignedBuffer.hpp>
+#include <audio/drain/ParameterBlock.hpp>
+#include <ememory/memory.hpp>
+#include <ethread/Mutex.hpp>
+
+namespace audio {
+	namespace drain {
+		/**
+		 * @brief Mix the stream of the chain with the output of other Process (N inputs ==> 1 output).
+		 * The inputs are pulled at each period in the format of the mixer, accumulated in int32 (int16 formats) or float
+		 * and saturated only at the end. The silent inputs (Process with setSilenceDetection) are skipped.
+		 * @note The output format of an input Process is set by the mixer: add it before its first process.
+		 */
+		class Mixer : public Algo {
+			protected:
+				/**
+				 * @brief Constructor
+				 */
+				Mixer();
+				void init();
+			public:
+				static ememory::SharedPtr<audio::drain::Mixer> create();
+				/**
+				 * @brief Destructor
+				 */
+				virtual ~Mixer();
+			protected:
+				ethread::Mutex m_inputLock; //!< Protect m_listInput (control side)
+				etk::Vector<ememory::SharedPtr<audio::drain::Process> > m_listInput; //!< Inputs added by the user
+				audio::drain::ParameterBlock<etk::Vector<ememory::SharedPtr<audio::drain::Process> > > m_activeInput; //!< Inputs used by the process
+				audio::drain::AlignedBuffer m_inputBuffer; //!< Data pulled from an input (one block of the process buffer size)
+				audio::drain::AlignedBuffer m_accumulator; //!< Sum of the inputs (int32 when the format is int16, one block of the process buffer size)
+				bool m_directAccumulation; //!< The accumulator is the output buffer (same type)
+				//! Set the first input in the accumulator
+				void (*m_functionLoad)(const void* _input, void* _accumulator, size_t _nbSample);
+				//! Add an input in the accumulator
+				void (*m_functionAdd)(const void* _input, void* _accumulator, size_t _nbSample);
+				//! Convert the accumulator in the output format (saturation, when not m_directAccumulation)
+				void (*m_functionStore)(const void* _accumulator, void* _output, size_t _nbSample);
+				/**
+				 * @brief Set the output format of an input (format of the mixer).
+				 * @param[in] _input Input to configure.
+				 */
+				void configureInput(const ememory::SharedPtr<audio::drain::Process>& _input);
+				/**
+				 * @brief Mix a block of the period (the size of the process buffer at most: no allocation).
+				 * @param[in] _listInput Inputs to pull.
+				 * @param[in] _time Time of the first chunk of the block.
+				 * @param[in] _input Data of the chain (null if none).
+				 * @param[out] _output Output of the block.
+				 * @param[in] _nbChunk Number of chunk of the block.
+				 * @return true if all the inputs are silent (the output is set at 0).
+				 */
+				bool mixBlock(const etk::Vector<ememory::SharedPtr<audio::drain::Process> >& _listInput,
+				              const audio::Time& _time,
+				              const void* _input,
+				              void* _output,
+				              size_t _nbChunk);
+			public:
+				/**
+				 * @brief Add an input mixed with the stream of the chain.
+				 * @param[in] _input Process that generate the data (pulled at each period).
+				 */
+				void addInput(const ememory::SharedPtr<audio::drain::Process>& _input);
+				/**
+				 * @brief Remove an input.
+				 * @param[in] _input Process to remove.
+				 */
+				void removeInput(const ememory::SharedPtr<audio::drain::Process>& _input);
+				/**
+				 * @brief Get the number of input (without the stream of the chain).
+				 * @return Number of Process mixed.
+				 */
+				size_t getNbInput();
+			public:
+				void configurationChange();
+			protected:
+				void processBufferSizeChange();
+			public:
+				bool process(audio::Time& _time,
+				             void* _input,
+				             size_t _inputNbChunk,
+				             void*& _output,
+				             size_t& _outputNbChunk);
+				bool canProcessInPlace() const;
+		};
+	}
+}
+
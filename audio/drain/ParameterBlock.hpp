@@ -0,0 +1,78 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <atomic>
+
+namespace audio {
+	namespace drain {
+		/**
+		 * @brief Parameters prepared by a control thread and taken by the audio thread at the start of a period.
+		 * Three copies of the parameters (triple buffer): the writer fill its own copy and publish it, the
+		 * reader exchange its copy with the last published one. No lock and no allocation on the audio side,
+		 * the previous value is released by the writer when its copy is overwritten.
+		 * @note Only one writer and one reader at a time (serialize the writers with a mutex if needed).
+		 */
+		template<typename DRAIN_TYPE> class ParameterBlock {
+			protected:
+				static const uint32_t m_newFlag = 4; //!< Set on m_middle when it contain a value not taken by the reader
+				DRAIN_TYPE m_slot[3]; //!< The 3 copies of the parameters
+				std::atomic<uint32_t> m_middle; //!< Id of the last published copy (and m_newFlag)
+				uint32_t m_back; //!< Copy owned by the writer
+				uint32_t m_front; //!< Copy used by the reader
+			public:
+				ParameterBlock() :
+				  m_middle(1),
+				  m_back(2),
+				  m_front(0) {
+
+				}
+			public:
+				/**
+				 * @brief Publish new parameters (writer side).
+				 * @param[in] _value New parameters.
+				 */
+				void set(const DRAIN_TYPE& _value) {
+					m_slot[m_back] = _value;
+					m_back = m_middle.exchange(m_back | m_newFlag, std::memory_order_acq_rel) & 3;
+				}
+				/**
+				 * @brief Take the last published parameters (reader side).
+				 * @return true New parameters are available in get().
+				 */
+				bool update() {
+					if ((m_middle.load(std::memory_order_relaxed) & m_newFlag) == 0) {
+						return false;
+					}
+					m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & 3;
+					return true;
+				}
+				/**
+				 * @brief Check if some parameters are waiting for the reader.
+				 * @return true update() will change the value.
+				 */
+				bool isPending() const {
+					return (m_middle.load(std::memory_order_relaxed) & m_newFlag) != 0;
+				}
+				/**
+				 * @brief Get the parameters taken by the last update() (reader side).
+				 * @return The current parameters.
+				 */
+				const DRAIN_TYPE& get() const {
+					return m_slot[m_front];
+				}
+				/**
+				 * @brief Get the parameters taken by the last update() (reader side).
+				 * @return The current parameters.
+				 */
+				DRAIN_TYPE& get() {
+					return m_slot[m_front];
+				}
+		};
+	}
+}
+
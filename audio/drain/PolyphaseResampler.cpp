@@ -0,0 +1,503 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <audio/drain/PolyphaseResampler.hpp>
+#include <audio/drain/debug.hpp>
+#include <ethread/Mutex.hpp>
+#include <math.h>
+#include <audio/drain/cpu.hpp>
+
+//! Maximum number of phase of a filter (bigger L are rounded)
+static const uint32_t g_maxNbPhase = 1024;
+//! Maximum number of tap of a phase
+static const size_t g_maxNbTap = 1024;
+//! Maximum number of filter kept in the cache
+static const size_t g_bankCacheMaxSize = 16;
+static ethread::Mutex g_bankLock;
+static etk::Vector<ememory::SharedPtr<audio::drain::PolyphaseBank> > g_bankCache;
+
+static uint32_t gcd(uint32_t _aaa, uint32_t _bbb) {
+	while (_bbb != 0) {
+		uint32_t tmp = _aaa % _bbb;
+		_aaa = _bbb;
+		_bbb = tmp;
+	}
+	return _aaa;
+}
+
+/**
+ * @brief Inner product of a phase (_nbTap is a multiple of 8, _coefficient is aligned on 32 bytes).
+ */
+static float dotProductGeneric(const float* _coefficient, const float* _data, size_t _nbTap) {
+	float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+	for (size_t iii=0; iii<_nbTap; iii+=4) {
+		sum[0] += _coefficient[iii] * _data[iii];
+		sum[1] += _coefficient[iii+1] * _data[iii+1];
+		sum[2] += _coefficient[iii+2] * _data[iii+2];
+		sum[3] += _coefficient[iii+3] * _data[iii+3];
+	}
+	return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+#ifdef DRAIN_SIMD_X86
+DRAIN_TARGET_SSE2 static float dotProductSse2(const float* _coefficient, const float* _data, size_t _nbTap) {
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	for (size_t iii=0; iii<_nbTap; iii+=8) {
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_load_ps(_coefficient+iii), _mm_loadu_ps(_data+iii)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_load_ps(_coefficient+iii+4), _mm_loadu_ps(_data+iii+4)));
+	}
+	__m128 tmp = _mm_add_ps(sum0, sum1);
+	tmp = _mm_add_ps(tmp, _mm_movehl_ps(tmp, tmp));
+	tmp = _mm_add_ss(tmp, _mm_shuffle_ps(tmp, tmp, 1));
+	return _mm_cvtss_f32(tmp);
+}
+
+DRAIN_TARGET_AVX2 static float dotProductAvx2(const float* _coefficient, const float* _data, size_t _nbTap) {
+	__m256 sum = _mm256_setzero_ps();
+	for (size_t iii=0; iii<_nbTap; iii+=8) {
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_load_ps(_coefficient+iii), _mm256_loadu_ps(_data+iii)));
+	}
+	__m128 tmp = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+	tmp = _mm_add_ps(tmp, _mm_movehl_ps(tmp, tmp));
+	tmp = _mm_add_ss(tmp, _mm_shuffle_ps(tmp, tmp, 1));
+	return _mm_cvtss_f32(tmp);
+}
+#endif
+
+#ifdef DRAIN_SIMD_NEON
+static float dotProductNeon(const float* _coefficient, const float* _data, size_t _nbTap) {
+	float32x4_t sum0 = vdupq_n_f32(0.0f);
+	float32x4_t sum1 = vdupq_n_f32(0.0f);
+	for (size_t iii=0; iii<_nbTap; iii+=8) {
+		sum0 = vmlaq_f32(sum0, vld1q_f32(_coefficient+iii), vld1q_f32(_data+iii));
+		sum1 = vmlaq_f32(sum1, vld1q_f32(_coefficient+iii+4), vld1q_f32(_data+iii+4));
+	}
+	float32x4_t tmp = vaddq_f32(sum0, sum1);
+	float32x2_t tmp2 = vadd_f32(vget_low_f32(tmp), vget_high_f32(tmp));
+	return vget_lane_f32(vpadd_f32(tmp2, tmp2), 0);
+}
+#endif
+
+/**
+ * @brief Select the inner product kernel of the CPU.
+ */
+static audio::drain::PolyphaseResampler::dotProductFunction getDotProductFunction() {
+	#ifdef DRAIN_SIMD_X86
+		if (audio::drain::cpu::haveAvx2() == true) {
+			return &dotProductAvx2;
+		}
+		if (audio::drain::cpu::haveSse2() == true) {
+			return &dotProductSse2;
+		}
+	#endif
+	#ifdef DRAIN_SIMD_NEON
+		if (audio::drain::cpu::haveNeon() == true) {
+			return &dotProductNeon;
+		}
+	#endif
+	return &dotProductGeneric;
+}
+
+/**
+ * @brief Get the length of the filter of a configuration (a longer filter when decimating to keep the same transition band).
+ */
+static size_t getNbTap(uint32_t _interpolation, uint32_t _decimation, int32_t _quality) {
+	double ratio = double(_interpolation) / double(_decimation);
+	size_t nbTap = 8 * (_quality + 1);
+	if (ratio < 1.0) {
+		nbTap = size_t(ceil(double(nbTap) / ratio));
+	}
+	return etk::min(((nbTap + 7) / 8) * 8, g_maxNbTap);
+}
+
+/**
+ * @brief Compute a Blackman windowed sinc filter bank.
+ */
+static ememory::SharedPtr<audio::drain::PolyphaseBank> createBank(uint32_t _interpolation, uint32_t _decimation, int32_t _quality) {
+	ememory::SharedPtr<audio::drain::PolyphaseBank> bank(ETK_NEW(audio::drain::PolyphaseBank));
+	bank->m_interpolation = _interpolation;
+	bank->m_decimation = _decimation;
+	bank->m_quality = _quality;
+	bank->m_nbPhase = etk::min(_interpolation, g_maxNbPhase);
+	double ratio = double(_interpolation) / double(_decimation);
+	// the cut frequency is the lower nyquist frequency (with a transition band that decrease with the quality)
+	double cutoff = etk::min(1.0, ratio) * (0.80 + 0.015 * _quality);
+	size_t nbTap = getNbTap(_interpolation, _decimation, _quality);
+	bank->m_nbTap = nbTap;
+	bank->m_coefficient.resize(bank->m_nbPhase * nbTap * sizeof(float));
+	double halfLength = double(nbTap) / 2.0;
+	double center = halfLength - 1.0;
+	for (uint32_t ppp=0; ppp<bank->m_nbPhase; ++ppp) {
+		float* phase = reinterpret_cast<float*>(bank->m_coefficient.data()) + ppp*nbTap;
+		double fraction = double(ppp) / double(bank->m_nbPhase);
+		double sum = 0.0;
+		for (size_t iii=0; iii<nbTap; ++iii) {
+			double position = double(iii) - center - fraction;
+			double value = cutoff;
+			if (position != 0.0) {
+				value = sin(M_PI * cutoff * position) / (M_PI * position);
+			}
+			double windowPos = position / halfLength;
+			if (    windowPos <= -1.0
+			     || windowPos >= 1.0) {
+				value = 0.0;
+			} else {
+				value *= 0.42 + 0.5 * cos(M_PI * windowPos) + 0.08 * cos(2.0 * M_PI * windowPos);
+			}
+			phase[iii] = value;
+			sum += value;
+		}
+		// unity gain on each phase (no modulation of the DC)
+		if (sum != 0.0) {
+			for (size_t iii=0; iii<nbTap; ++iii) {
+				phase[iii] = double(phase[iii]) / sum;
+			}
+		}
+	}
+	DRAIN_DEBUG("Create polyphase filter L=" << _interpolation << " M=" << _decimation << " phases=" << bank->m_nbPhase << " taps=" << nbTap);
+	return bank;
+}
+
+/**
+ * @brief Get a filter bank from the cache (create it if needed).
+ */
+static ememory::SharedPtr<audio::drain::PolyphaseBank> findBank(uint32_t _interpolation, uint32_t _decimation, int32_t _quality) {
+	ethread::UniqueLock lock(g_bankLock);
+	for (size_t iii=0; iii<g_bankCache.size(); ++iii) {
+		if (    g_bankCache[iii]->m_interpolation == _interpolation
+		     && g_bankCache[iii]->m_decimation == _decimation
+		     && g_bankCache[iii]->m_quality == _quality) {
+			return g_bankCache[iii];
+		}
+	}
+	ememory::SharedPtr<audio::drain::PolyphaseBank> bank = createBank(_interpolation, _decimation, _quality);
+	if (g_bankCache.size() >= g_bankCacheMaxSize) {
+		g_bankCache.erase(g_bankCache.begin());
+	}
+	g_bankCache.pushBack(bank);
+	return bank;
+}
+
+ememory::SharedPtr<audio::drain::PolyphaseBank> audio::drain::PolyphaseResampler::getBank(uint32_t _inputFrequency, uint32_t _outputFrequency, int32_t _quality) {
+	if (    _inputFrequency == 0
+	     || _outputFrequency == 0) {
+		return null;
+	}
+	uint32_t divisor = gcd(_inputFrequency, _outputFrequency);
+	return findBank(_outputFrequency/divisor, _inputFrequency/divisor, etk::avg(0, _quality, 10));
+}
+
+audio::drain::PolyphaseResampler::PolyphaseResampler() :
+  m_dotProduct(&dotProductGeneric),
+  m_bank(null),
+  m_nbChannel(0),
+  m_inputFrequency(0),
+  m_outputFrequency(0),
+  m_bufferSize(0),
+  m_nbPast(0),
+  m_phase(0),
+  m_nbZero(0) {
+
+}
+
+audio::drain::PolyphaseResampler::~PolyphaseResampler() {
+
+}
+
+bool audio::drain::PolyphaseResampler::init(size_t _nbChannel, uint32_t _inputFrequency, uint32_t _outputFrequency, int32_t _quality) {
+	m_bankOwner.reset();
+	m_bank = null;
+	m_nbChannel = _nbChannel;
+	m_inputFrequency = _inputFrequency;
+	m_outputFrequency = _outputFrequency;
+	if (    _nbChannel == 0
+	     || _inputFrequency == 0
+	     || _outputFrequency == 0) {
+		DRAIN_ERROR("Can not configure the resampler: " << _nbChannel << " channels " << _inputFrequency << " -> " << _outputFrequency);
+		return false;
+	}
+	// the kernel is selected at the configuration
+	m_dotProduct = getDotProductFunction();
+	m_bankOwner = getBank(_inputFrequency, _outputFrequency, _quality);
+	m_buffer.resize(m_nbChannel);
+	setBank(m_bankOwner.get());
+	reset();
+	return true;
+}
+
+void audio::drain::PolyphaseResampler::reset() {
+	m_phase = 0;
+	m_bufferSize = 0;
+	m_nbZero = 0;
+	if (m_bank == null) {
+		return;
+	}
+	// history of zero: the first output is late of the filter delay
+	m_bufferSize = m_nbPast + m_bank->m_nbTap - 1;
+	for (size_t iii=0; iii<m_buffer.size(); ++iii) {
+		if (m_buffer[iii].size() < m_bufferSize) {
+			m_buffer[iii].resize(m_bufferSize);
+		}
+		for (size_t jjj=0; jjj<m_bufferSize; ++jjj) {
+			m_buffer[iii][jjj] = 0.0f;
+		}
+	}
+	m_nbZero = m_bufferSize;
+}
+
+void audio::drain::PolyphaseResampler::setBank(const audio::drain::PolyphaseBank* _bank) {
+	if (_bank == null) {
+		return;
+	}
+	if (    m_bank != null
+	     && (    m_bank->m_interpolation != _bank->m_interpolation
+	          || m_bank->m_decimation != _bank->m_decimation)) {
+		DRAIN_ERROR("Can not change the ratio of the resampler: " << m_bank->m_interpolation << "/" << m_bank->m_decimation << " -> " << _bank->m_interpolation << "/" << _bank->m_decimation);
+		return;
+	}
+	m_bank = _bank;
+	// the past samples kept before the filter center all the qualities on the same sample ==> the buffer does not change
+	m_nbPast = (getNbTap(m_bank->m_interpolation, m_bank->m_decimation, 10) - m_bank->m_nbTap) / 2;
+}
+
+void audio::drain::PolyphaseResampler::reserve(size_t _nbChunk) {
+	if (m_bank == null) {
+		return;
+	}
+	// the longest filter (quality 10)
+	size_t nbTap = getNbTap(m_bank->m_interpolation, m_bank->m_decimation, 10);
+	for (size_t iii=0; iii<m_buffer.size(); ++iii) {
+		if (m_buffer[iii].size() < nbTap + _nbChunk) {
+			m_buffer[iii].resize(nbTap + _nbChunk);
+		}
+	}
+}
+
+void audio::drain::PolyphaseResampler::getRatio(uint32_t& _num, uint32_t& _den) const {
+	if (m_bank == null) {
+		_num = 1;
+		_den = 1;
+		return;
+	}
+	_num = m_bank->m_decimation;
+	_den = m_bank->m_interpolation;
+}
+
+size_t audio::drain::PolyphaseResampler::getInputLatency() const {
+	if (m_bank == null) {
+		return 0;
+	}
+	return m_bank->m_nbTap / 2;
+}
+
+template<typename DRAIN_TYPE> void audio::drain::PolyphaseResampler::append(const DRAIN_TYPE* _input, size_t _nbChunk) {
+	for (size_t iii=0; iii<m_nbChannel; ++iii) {
+		etk::Vector<float>& buffer = m_buffer[iii];
+		if (buffer.size() < m_bufferSize + _nbChunk) {
+			buffer.resize(m_bufferSize + _nbChunk);
+		}
+		float* data = &buffer[m_bufferSize];
+		const DRAIN_TYPE* in = _input + iii;
+		for (size_t jjj=0; jjj<_nbChunk; ++jjj) {
+			data[jjj] = float(*in);
+			in += m_nbChannel;
+		}
+	}
+	m_bufferSize += _nbChunk;
+	m_nbZero = 0;
+}
+
+void audio::drain::PolyphaseResampler::appendSilence(size_t _nbChunk) {
+	for (size_t iii=0; iii<m_nbChannel; ++iii) {
+		etk::Vector<float>& buffer = m_buffer[iii];
+		if (buffer.size() < m_bufferSize + _nbChunk) {
+			buffer.resize(m_bufferSize + _nbChunk);
+		}
+		memset(&buffer[m_bufferSize], 0, _nbChunk*sizeof(float));
+	}
+	m_bufferSize += _nbChunk;
+	m_nbZero += _nbChunk;
+}
+
+static inline void storeSample(float* _output, float _value) {
+	*_output = _value;
+}
+
+static inline void storeSample(int16_t* _output, float _value) {
+	*_output = int16_t(etk::avg(-32768.0f, floorf(_value + 0.5f), 32767.0f));
+}
+
+size_t audio::drain::PolyphaseResampler::getInputNeeded(size_t _nbChunk) const {
+	if (    m_bank == null
+	     || _nbChunk == 0) {
+		return 0;
+	}
+	// position of the last output in the buffer, it use nbTap samples from here
+	uint64_t position = m_nbPast + (uint64_t(m_phase) + uint64_t(_nbChunk-1) * m_bank->m_decimation) / m_bank->m_interpolation;
+	uint64_t needed = position + m_bank->m_nbTap;
+	if (needed <= m_bufferSize) {
+		return 0;
+	}
+	return needed - m_bufferSize;
+}
+
+uint32_t audio::drain::PolyphaseResampler::getIntegerFactor() const {
+	if (m_bank == null) {
+		return 0;
+	}
+	uint32_t factor = 0;
+	if (m_bank->m_decimation == 1) {
+		factor = m_bank->m_interpolation;
+	} else if (m_bank->m_interpolation == 1) {
+		factor = m_bank->m_decimation;
+	}
+	if (    factor == 2
+	     || factor == 3
+	     || factor == 4
+	     || factor == 6) {
+		return factor;
+	}
+	return 0;
+}
+
+template<typename DRAIN_TYPE, uint32_t DRAIN_FACTOR, bool DRAIN_SILENT>
+void audio::drain::PolyphaseResampler::generateInterpolation(DRAIN_TYPE* _output, size_t _nbChunkMax, size_t& _position, size_t& _nbChunk) {
+	const audio::drain::PolyphaseBank& bank = *m_bank;
+	size_t nbTap = bank.m_nbTap;
+	while (    _nbChunk + DRAIN_FACTOR <= _nbChunkMax
+	        && _position + nbTap <= m_bufferSize) {
+		DRAIN_TYPE* out = _output + _nbChunk*m_nbChannel;
+		for (size_t iii=0; iii<m_nbChannel; ++iii) {
+			const float* data = &m_buffer[iii][_position];
+			for (uint32_t ppp=0; ppp<DRAIN_FACTOR; ++ppp) {
+				storeSample(out + ppp*m_nbChannel + iii, DRAIN_SILENT == true ? 0.0f : m_dotProduct(bank.getPhase(ppp), data, nbTap));
+			}
+		}
+		_nbChunk += DRAIN_FACTOR;
+		++_position;
+	}
+}
+
+template<typename DRAIN_TYPE, uint32_t DRAIN_FACTOR, bool DRAIN_SILENT>
+void audio::drain::PolyphaseResampler::generateDecimation(DRAIN_TYPE* _output, size_t _nbChunkMax, size_t& _position, size_t& _nbChunk) {
+	const audio::drain::PolyphaseBank& bank = *m_bank;
+	size_t nbTap = bank.m_nbTap;
+	const float* coefficient = bank.getPhase(0);
+	while (    _nbChunk < _nbChunkMax
+	        && _position + nbTap <= m_bufferSize) {
+		DRAIN_TYPE* out = _output + _nbChunk*m_nbChannel;
+		for (size_t iii=0; iii<m_nbChannel; ++iii) {
+			storeSample(out + iii, DRAIN_SILENT == true ? 0.0f : m_dotProduct(coefficient, &m_buffer[iii][_position], nbTap));
+		}
+		++_nbChunk;
+		_position += DRAIN_FACTOR;
+	}
+}
+
+template<typename DRAIN_TYPE, bool DRAIN_SILENT> size_t audio::drain::PolyphaseResampler::generate(DRAIN_TYPE* _output, size_t _nbChunkMax) {
+	const audio::drain::PolyphaseBank& bank = *m_bank;
+	size_t nbTap = bank.m_nbTap;
+	uint32_t interpolation = bank.m_interpolation;
+	uint32_t decimation = bank.m_decimation;
+	size_t position = m_nbPast;
+	size_t nbChunk = 0;
+	// integer ratio: dedicated kernel (the phase is 0 at the start of each group of output)
+	if (m_phase == 0) {
+		if (decimation == 1) {
+			switch (interpolation) {
+				case 2: generateInterpolation<DRAIN_TYPE, 2, DRAIN_SILENT>(_output, _nbChunkMax, position, nbChunk); break;
+				case 3: generateInterpolation<DRAIN_TYPE, 3, DRAIN_SILENT>(_output, _nbChunkMax, position, nbChunk); break;
+				case 4: generateInterpolation<DRAIN_TYPE, 4, DRAIN_SILENT>(_output, _nbChunkMax, position, nbChunk); break;
+				case 6: generateInterpolation<DRAIN_TYPE, 6, DRAIN_SILENT>(_output, _nbChunkMax, position, nbChunk); break;
+				default: break;
+			}
+		} else if (interpolation == 1) {
+			switch (decimation) {
+				case 2: generateDecimation<DRAIN_TYPE, 2, DRAIN_SILENT>(_output, _nbChunkMax, position, nbChunk); break;
+				case 3: generateDecimation<DRAIN_TYPE, 3, DRAIN_SILENT>(_output, _nbChunkMax, position, nbChunk); break;
+				case 4: generateDecimation<DRAIN_TYPE, 4, DRAIN_SILENT>(_output, _nbChunkMax, position, nbChunk); break;
+				case 6: generateDecimation<DRAIN_TYPE, 6, DRAIN_SILENT>(_output, _nbChunkMax, position, nbChunk); break;
+				default: break;
+			}
+		}
+	}
+	// fractional ratio (or the end of the output that can not contain a full group)
+	while (    nbChunk < _nbChunkMax
+	        && position + nbTap <= m_bufferSize) {
+		uint32_t phase = m_phase;
+		if (bank.m_nbPhase != interpolation) {
+			phase = (uint64_t(m_phase) * bank.m_nbPhase) / interpolation;
+		}
+		const float* coefficient = bank.getPhase(phase);
+		DRAIN_TYPE* out = _output + nbChunk*m_nbChannel;
+		for (size_t iii=0; iii<m_nbChannel; ++iii) {
+			storeSample(out + iii, DRAIN_SILENT == true ? 0.0f : m_dotProduct(coefficient, &m_buffer[iii][position], nbTap));
+		}
+		m_phase += decimation;
+		position += m_phase / interpolation;
+		m_phase %= interpolation;
+		++nbChunk;
+	}
+	// remove the samples that will never be used again (keep the past of the longest filter)
+	position = etk::min(position, m_bufferSize) - m_nbPast;
+	if (position != 0) {
+		for (size_t iii=0; iii<m_nbChannel; ++iii) {
+			memmove(&m_buffer[iii][0], &m_buffer[iii][position], (m_bufferSize-position)*sizeof(float));
+		}
+		m_bufferSize -= position;
+		m_nbZero = etk::min(m_nbZero, m_bufferSize);
+	}
+	return nbChunk;
+}
+
+void audio::drain::PolyphaseResampler::process(const float* _input, uint32_t& _inputNbChunk, float* _output, uint32_t& _outputNbChunk) {
+	if (m_bank == null) {
+		_inputNbChunk = 0;
+		_outputNbChunk = 0;
+		return;
+	}
+	append(_input, _inputNbChunk);
+	_outputNbChunk = generate<float, false>(_output, _outputNbChunk);
+}
+
+void audio::drain::PolyphaseResampler::process(const int16_t* _input, uint32_t& _inputNbChunk, int16_t* _output, uint32_t& _outputNbChunk) {
+	if (m_bank == null) {
+		_inputNbChunk = 0;
+		_outputNbChunk = 0;
+		return;
+	}
+	append(_input, _inputNbChunk);
+	_outputNbChunk = generate<int16_t, false>(_output, _outputNbChunk);
+}
+
+template<typename DRAIN_TYPE> bool audio::drain::PolyphaseResampler::generateSilence(DRAIN_TYPE* _output, uint32_t& _nbChunkMax) {
+	if (m_nbZero + m_nbPast >= m_bufferSize) {
+		_nbChunkMax = generate<DRAIN_TYPE, true>(_output, _nbChunkMax);
+		return true;
+	}
+	// the end of the previous signal is still in the filter
+	_nbChunkMax = generate<DRAIN_TYPE, false>(_output, _nbChunkMax);
+	return false;
+}
+
+bool audio::drain::PolyphaseResampler::processSilence(uint32_t _inputNbChunk, float* _output, uint32_t& _outputNbChunk) {
+	if (m_bank == null) {
+		_outputNbChunk = 0;
+		return true;
+	}
+	appendSilence(_inputNbChunk);
+	return generateSilence(_output, _outputNbChunk);
+}
+
+bool audio::drain::PolyphaseResampler::processSilence(uint32_t _inputNbChunk, int16_t* _output, uint32_t& _outputNbChunk) {
+	if (m_bank == null) {
+		_outputNbChunk = 0;
+		return true;
+	}
+	appendSilence(_inputNbChunk);
+	return generateSilence(_output, _outputNbChunk);
+}
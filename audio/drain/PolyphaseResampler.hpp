@@ -0,0 +1,184 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <etk/Vector.hpp>
+#include <ememory/memory.hpp>
+#include <audio/drain/AlignedBuffer.hpp>
+
+namespace audio {
+	namespace drain {
+		/**
+		 * @brief Windowed sinc filter split in phases (shared by all the resamplers with the same configuration).
+		 */
+		class PolyphaseBank {
+			public:
+				uint32_t m_nbPhase; //!< Number of phase of the filter
+				uint32_t m_interpolation; //!< Interpolation factor (L)
+				uint32_t m_decimation; //!< Decimation factor (M)
+				int32_t m_quality; //!< Quality used to compute the filter
+				size_t m_nbTap; //!< Number of tap of each phase (multiple of 8)
+				audio::drain::AlignedBuffer m_coefficient; //!< m_nbPhase*m_nbTap float aligned on 64 bytes (each phase on 32 bytes: m_nbTap is a multiple of 8)
+				/**
+				 * @brief Get the coefficients of a phase.
+				 * @param[in] _phase Id of the phase [0..m_nbPhase[.
+				 * @return The m_nbTap coefficients.
+				 */
+				const float* getPhase(uint32_t _phase) const {
+					return reinterpret_cast<const float*>(m_coefficient.data()) + _phase*m_nbTap;
+				}
+		};
+		/**
+		 * @brief Polyphase FIR resampler (no external dependency).
+		 * The ratio is reduced to L/M (out/in): the output sample k use the phase (k*M)%L of the filter on the
+		 * input starting at (k*M)/L. When L is too big (not a "simple" rate pair) the phase is rounded to 1024 steps.
+		 * The filter bank of a configuration is computed once and shared by all the instances.
+		 * The integer ratios (x2, x3, x4, x6 and /2, /3, /4, /6) use dedicated kernels without phase computation.
+		 */
+		class PolyphaseResampler {
+			public:
+				typedef float (*dotProductFunction)(const float* _coefficient, const float* _data, size_t _nbTap);
+			protected:
+				dotProductFunction m_dotProduct; //!< Inner product of a phase (kernel of the CPU)
+				ememory::SharedPtr<audio::drain::PolyphaseBank> m_bankOwner; //!< Filter created by init
+				const audio::drain::PolyphaseBank* m_bank; //!< Current filter (m_bankOwner or the filter given to setBank)
+				size_t m_nbChannel; //!< Number of channel
+				uint32_t m_inputFrequency; //!< Input frequency
+				uint32_t m_outputFrequency; //!< Output frequency
+				etk::Vector<etk::Vector<float> > m_buffer; //!< History of each channel followed by the input not used yet
+				size_t m_bufferSize; //!< Number of sample in each m_buffer
+				size_t m_nbPast; //!< Number of sample kept before the filter (the filter of quality 10 is centered on the same sample)
+				uint32_t m_phase; //!< Fractional position of the next output [0..L[
+				size_t m_nbZero; //!< Number of 0 at the end of the history of all the channels
+			public:
+				PolyphaseResampler();
+				virtual ~PolyphaseResampler();
+			public:
+				/**
+				 * @brief Configure the resampler (reset the history).
+				 * @param[in] _nbChannel Number of channel.
+				 * @param[in] _inputFrequency Input frequency.
+				 * @param[in] _outputFrequency Output frequency.
+				 * @param[in] _quality Quality [0..10] (length of the filter).
+				 * @return true The configuration is valid.
+				 */
+				bool init(size_t _nbChannel, uint32_t _inputFrequency, uint32_t _outputFrequency, int32_t _quality);
+				/**
+				 * @brief Get the filter of a configuration (shared by all the resamplers, computed at the first use).
+				 * @param[in] _inputFrequency Input frequency.
+				 * @param[in] _outputFrequency Output frequency.
+				 * @param[in] _quality Quality [0..10].
+				 * @return The filter (null if a frequency is 0).
+				 */
+				static ememory::SharedPtr<audio::drain::PolyphaseBank> getBank(uint32_t _inputFrequency, uint32_t _outputFrequency, int32_t _quality);
+				/**
+				 * @brief Change the filter with an other quality of the same ratio (no allocation, no lock).
+				 * The filters of all the qualities are centered on the same sample: the history is kept ==> no discontinuity, only the delay change.
+				 * @param[in] _bank New filter (owned by the caller while it is used).
+				 */
+				void setBank(const audio::drain::PolyphaseBank* _bank);
+				/**
+				 * @brief Allocate the buffers for the calls of process with up to _nbChunk input chunk (no allocation in the process).
+				 * @param[in] _nbChunk Number of input chunk.
+				 */
+				void reserve(size_t _nbChunk);
+				/**
+				 * @brief Clear the history (the next output start as after the init).
+				 */
+				void reset();
+				/**
+				 * @brief Get the reduced ratio of the resampler: input = output * num / den.
+				 * @param[out] _num Decimation factor (M).
+				 * @param[out] _den Interpolation factor (L).
+				 */
+				void getRatio(uint32_t& _num, uint32_t& _den) const;
+				/**
+				 * @brief Get the delay of the filter.
+				 * @return Number of input sample.
+				 */
+				size_t getInputLatency() const;
+				/**
+				 * @brief Get the integer factor of the ratio when it has a dedicated kernel.
+				 * @return The interpolation or decimation factor (2, 3, 4 or 6), 0 for the fractional ratios.
+				 */
+				uint32_t getIntegerFactor() const;
+				/**
+				 * @brief Get the exact number of input chunk needed to generate a number of output chunk.
+				 * @param[in] _nbChunk Number of output chunk.
+				 * @return Number of input chunk (can be 0 when the history is enough).
+				 */
+				size_t getInputNeeded(size_t _nbChunk) const;
+				/**
+				 * @brief Resample interleaved float data.
+				 * @param[in] _input Input data.
+				 * @param[in,out] _inputNbChunk Number of input chunk (set at the number of chunk consumed).
+				 * @param[in] _output Output data.
+				 * @param[in,out] _outputNbChunk Number of chunk available in the output (set at the number of chunk produced).
+				 */
+				void process(const float* _input, uint32_t& _inputNbChunk, float* _output, uint32_t& _outputNbChunk);
+				/**
+				 * @brief Resample interleaved int16 data (@see process).
+				 */
+				void process(const int16_t* _input, uint32_t& _inputNbChunk, int16_t* _output, uint32_t& _outputNbChunk);
+				/**
+				 * @brief Resample a silent input (all the samples are 0): the filter is not computed when all the history is 0.
+				 * @param[in] _inputNbChunk Number of input chunk.
+				 * @param[in] _output Output data.
+				 * @param[in,out] _outputNbChunk Number of chunk available in the output (set at the number of chunk produced).
+				 * @return true The output is silent.
+				 */
+				bool processSilence(uint32_t _inputNbChunk, float* _output, uint32_t& _outputNbChunk);
+				/**
+				 * @brief Resample a silent input in int16 (@see processSilence).
+				 */
+				bool processSilence(uint32_t _inputNbChunk, int16_t* _output, uint32_t& _outputNbChunk);
+			protected:
+				/**
+				 * @brief Add the input in the buffer of each channel.
+				 * @param[in] _input Interleaved data.
+				 * @param[in] _nbChunk Number of chunk.
+				 */
+				template<typename DRAIN_TYPE> void append(const DRAIN_TYPE* _input, size_t _nbChunk);
+				/**
+				 * @brief Add silent samples in the buffer of each channel.
+				 * @param[in] _nbChunk Number of chunk.
+				 */
+				void appendSilence(size_t _nbChunk);
+				/**
+				 * @brief Generate the output of a silent input.
+				 * @param[in] _output Interleaved output.
+				 * @param[in] _nbChunkMax Number of chunk available in the output.
+				 * @return true The output is silent.
+				 */
+				template<typename DRAIN_TYPE> bool generateSilence(DRAIN_TYPE* _output, uint32_t& _nbChunkMax);
+				/**
+				 * @brief Generate the output available with the current buffer (DRAIN_SILENT: the history is 0, the filter is not computed).
+				 * @param[in] _output Interleaved output.
+				 * @param[in] _nbChunkMax Number of chunk available in the output.
+				 * @return Number of chunk produced.
+				 */
+				template<typename DRAIN_TYPE, bool DRAIN_SILENT> size_t generate(DRAIN_TYPE* _output, size_t _nbChunkMax);
+				/**
+				 * @brief Interpolation by an integer factor (M = 1): each input position produce DRAIN_FACTOR outputs.
+				 * @param[in] _output Interleaved output.
+				 * @param[in] _nbChunkMax Number of chunk available in the output.
+				 * @param[in,out] _position Position in the buffer.
+				 * @param[in,out] _nbChunk Number of chunk produced.
+				 */
+				template<typename DRAIN_TYPE, uint32_t DRAIN_FACTOR, bool DRAIN_SILENT> void generateInterpolation(DRAIN_TYPE* _output, size_t _nbChunkMax, size_t& _position, size_t& _nbChunk);
+				/**
+				 * @brief Decimation by an integer factor (L = 1): a single phase, the input position move of DRAIN_FACTOR.
+				 * @param[in] _output Interleaved output.
+				 * @param[in] _nbChunkMax Number of chunk available in the output.
+				 * @param[in,out] _position Position in the buffer.
+				 * @param[in,out] _nbChunk Number of chunk produced.
+				 */
+				template<typename DRAIN_TYPE, uint32_t DRAIN_FACTOR, bool DRAIN_SILENT> void generateDecimation(DRAIN_TYPE* _output, size_t _nbChunkMax, size_t& _position, size_t& _nbChunk);
+		};
+	}
+}
+
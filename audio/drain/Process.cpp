@@ -12,14 +12,161 @@
 #include <audio/drain/ChannelReorder.hpp>
 #include <audio/drain/FormatUpdate.hpp>
 #include <audio/drain/Resampler.hpp>
+#include <audio/drain/Volume.hpp>
+#include <audio/drain/cpu.hpp>
+#include <ethread/Mutex.hpp>
+#include <ethread/tools.hpp>
 #include <audio/drain/debug.hpp>
 
+namespace audio {
+	namespace drain {
+		/**
+		 * @brief One algo of a solved configuration.
+		 */
+		class NegotiationStage {
+			public:
+				etk::String m_type; //!< Type of the algo (to create the temporary algo)
+				bool m_temporary; //!< Algo added by the negotiation
+				audio::drain::IOFormatInterface m_input; //!< Input format negotiated
+				audio::drain::IOFormatInterface m_output; //!< Output format negotiated
+		};
+		/**
+		 * @brief Solved configuration of a chain.
+		 */
+		class NegotiationCache {
+			public:
+				etk::Vector<uint32_t> m_key; //!< Description of the chain before the negotiation
+				etk::Vector<audio::drain::NegotiationStage> m_stage; //!< Algos after negotiation
+		};
+		/**
+		 * @brief Status of the queue with the name of its algo (given to the user after the release of the chain).
+		 */
+		class StatusReport {
+			public:
+				etk::String m_origin; //!< Name of the algo that generate the status
+				enum audio::drain::status m_status; //!< Status
+				uint32_t m_count; //!< Number of occurence
+				StatusReport(const etk::String& _origin, enum audio::drain::status _status, uint32_t _count) :
+				  m_origin(_origin),
+				  m_status(_status),
+				  m_count(_count) {
+					
+				}
+		};
+	}
+}
+//! Maximum number of chain configuration kept
+static const size_t g_negotiationCacheMaxSize = 32;
+static ethread::Mutex g_negotiationLock;
+static etk::Vector<audio::drain::NegotiationCache> g_negotiationCache;
+static size_t g_negotiationCacheNext = 0; //!< Next element replaced when the cache is full
+
+audio::drain::AlgoStatisticCounter::AlgoStatisticCounter() {
+	reset(0);
+}
+
+audio::drain::AlgoStatisticCounter::AlgoStatisticCounter(const audio::drain::AlgoStatisticCounter& _obj) {
+	*this = _obj;
+}
+
+audio::drain::AlgoStatisticCounter& audio::drain::AlgoStatisticCounter::operator=(const audio::drain::AlgoStatisticCounter& _obj) {
+	m_type = _obj.m_type;
+	m_name = _obj.m_name;
+	m_generation.store(_obj.m_generation.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	m_nbCall.store(_obj.m_nbCall.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	m_nbChunk.store(_obj.m_nbChunk.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	m_cycleTotal.store(_obj.m_cycleTotal.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	m_cycleMin.store(_obj.m_cycleMin.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	m_cycleMax.store(_obj.m_cycleMax.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	m_cycleLast.store(_obj.m_cycleLast.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	m_outputSizeMax.store(_obj.m_outputSizeMax.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	return *this;
+}
+
+void audio::drain::AlgoStatisticCounter::reset(uint32_t _generation) {
+	m_generation.store(_generation, std::memory_order_relaxed);
+	m_nbCall.store(0, std::memory_order_relaxed);
+	m_nbChunk.store(0, std::memory_order_relaxed);
+	m_cycleTotal.store(0, std::memory_order_relaxed);
+	m_cycleMin.store(0, std::memory_order_relaxed);
+	m_cycleMax.store(0, std::memory_order_relaxed);
+	m_cycleLast.store(0, std::memory_order_relaxed);
+	m_outputSizeMax.store(0, std::memory_order_relaxed);
+}
+
+void audio::drain::AlgoStatisticCounter::add(uint32_t _generation, uint64_t _cycle, size_t _nbChunk, size_t _outputSize) {
+	// only the audio thread write the counters: a load and a store are enough
+	if (m_generation.load(std::memory_order_relaxed) != _generation) {
+		reset(_generation);
+	}
+	uint64_t nbCall = m_nbCall.load(std::memory_order_relaxed);
+	if (    nbCall == 0
+	     || _cycle < m_cycleMin.load(std::memory_order_relaxed)) {
+		m_cycleMin.store(_cycle, std::memory_order_relaxed);
+	}
+	if (_cycle > m_cycleMax.load(std::memory_order_relaxed)) {
+		m_cycleMax.store(_cycle, std::memory_order_relaxed);
+	}
+	if (_outputSize > m_outputSizeMax.load(std::memory_order_relaxed)) {
+		m_outputSizeMax.store(_outputSize, std::memory_order_relaxed);
+	}
+	m_cycleTotal.store(m_cycleTotal.load(std::memory_order_relaxed) + _cycle, std::memory_order_relaxed);
+	m_cycleLast.store(_cycle, std::memory_order_relaxed);
+	m_nbChunk.store(m_nbChunk.load(std::memory_order_relaxed) + _nbChunk, std::memory_order_relaxed);
+	m_nbCall.store(nbCall + 1, std::memory_order_relaxed);
+}
+
+void audio::drain::AlgoStatisticCounter::getSnapshot(audio::drain::AlgoStatistic& _out, uint32_t _generation) const {
+	_out.reset();
+	if (m_generation.load(std::memory_order_relaxed) != _generation) {
+		// reset requested: not applied yet by the audio thread
+		return;
+	}
+	_out.m_nbCall = m_nbCall.load(std::memory_order_relaxed);
+	_out.m_nbChunk = m_nbChunk.load(std::memory_order_relaxed);
+	_out.m_cycleTotal = m_cycleTotal.load(std::memory_order_relaxed);
+	_out.m_cycleMin = m_cycleMin.load(std::memory_order_relaxed);
+	_out.m_cycleMax = m_cycleMax.load(std::memory_order_relaxed);
+	_out.m_cycleLast = m_cycleLast.load(std::memory_order_relaxed);
+	_out.m_outputSizeMax = m_outputSizeMax.load(std::memory_order_relaxed);
+}
+
 audio::drain::Process::Process() :
-  m_isConfigured(false) {
-	m_data.clear();
+  m_processBufferNbChunk(4096),
+  m_finalBuffer(null),
+  m_finalBufferSize(0),
+  m_dataSilence(false),
+  m_pullNbChunk(0),
+  m_pullSilence(false),
+  m_batchTileNbChunk(0),
+  m_lowLatency(false),
+  m_pipelineThread(null),
+  m_pipelineWakeUp(null),
+  m_pipelineRead(false),
+  m_pipelineEnable(false),
+  m_pipelineStop(false),
+  m_pipelineNbChunk(0),
+  m_pipelineUnderrun(0),
+  m_flushDenormal(false),
+  m_dither(audio::drain::dither_none),
+  m_silenceDetection(false),
+  m_silence(false),
+  m_statisticEnable(false),
+  m_statisticGeneration(0),
+  m_topologyKey(0),
+  m_handleNameRevision(0),
+  m_handleRevision(1),
+  m_hotPending(false),
+  m_hotTopologyKey(0),
+  m_isConfigured(false),
+  m_configurationBatch(false) {
+	
 }
 audio::drain::Process::~Process() {
+	stopPipeline();
+	hotClear();
 	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+		releaseTemporaryAlgo(m_listAlgo[iii]);
 		m_listAlgo[iii].reset();
 	}
 }
@@ -38,13 +185,64 @@ bool audio::drain::Process::pull(audio::Time& _time,
                                  void* _data,
                                  size_t _nbChunk,
                                  size_t _chunkSize) {
+	if (m_pipelineEnable.load(std::memory_order_acquire) == true) {
+		if (m_pipelineData.getChunkSize() != _chunkSize) {
+			DRAIN_ERROR("Pull with a chunk size different of the pipeline: " << _chunkSize << " != " << m_pipelineData.getChunkSize());
+			return false;
+		}
+		// only a copy in the audio callback: the periods are computed by the pipeline thread
+		audio::drain::CircularBufferReadSpan span;
+		span.m_data = _data;
+		span.m_nbChunk = _nbChunk;
+		if (m_pipelineData.readv(&span, 1) != 0) {
+			// the missing chunks are set at 0
+			m_pipelineUnderrun.fetch_add(1, std::memory_order_relaxed);
+		}
+		m_pipelineRead.store(true, std::memory_order_release);
+		m_pullNbChunk = _nbChunk;
+		m_pullSilence = false;
+		return true;
+	}
+	size_t nbChunkDone = 0;
+	bool silence = false;
+	bool ret = pullDirect(_time, _data, _nbChunk, _chunkSize, nbChunkDone, silence);
+	m_pullNbChunk = nbChunkDone;
+	m_pullSilence = silence;
+	return ret;
+}
+
+bool audio::drain::Process::pullDirect(audio::Time& _time,
+                                       void* _data,
+                                       size_t _nbChunk,
+                                       size_t _chunkSize,
+                                       size_t& _nbChunkDone,
+                                       bool& _silence) {
 	//DRAIN_DEBUG("Execute:");
-	while(m_data.size() < _nbChunk*_chunkSize) {
+	_nbChunkDone = 0;
+	_silence = false;
+	updateInterAlgo();
+	if (m_outputConfig.getLayout() != audio::drain::layout_interleaved) {
+		// the residual of a period is kept by chunk: the planes can not be cut
+		DRAIN_ERROR("Pull is not supported with a planar output: use push/process");
+		return false;
+	}
+	if (m_data.getChunkSize() != _chunkSize) {
+		m_data.setCapacity(m_processBufferNbChunk, _chunkSize, m_outputConfig.getFrequency());
+	}
+	// copy the residual data of the previous call
+	size_t nbChunkDone = etk::min(m_data.getSize(), _nbChunk);
+	bool silence = true;
+	if (nbChunkDone != 0) {
+		m_data.read(_data, nbChunkDone);
+		silence = m_dataSilence;
+	}
+	while(nbChunkDone < _nbChunk) {
 		void* in = null;
-		size_t nbChunkIn = _nbChunk - m_data.size()/_chunkSize;
+		size_t nbChunkIn = _nbChunk - nbChunkDone;
 		void* out = null;
 		size_t nbChunkOut;
-		if (nbChunkIn < 128) {
+		if (    m_lowLatency == false
+		     && nbChunkIn < 128) {
 			nbChunkIn = 128;
 		}
 		// TODO : maybe remove this for input data ...
@@ -53,30 +251,193 @@ bool audio::drain::Process::pull(audio::Time& _time,
 				nbChunkIn = m_listAlgo[iii]->needInputData(nbChunkIn);
 			}
 		}
-		if (nbChunkIn < 32) {
+		if (    m_lowLatency == false
+		     && nbChunkIn < 32) {
 			nbChunkIn = 32;
 		}
 		//DRAIN_DEBUG("    process:" << _time << " in=" << in << " nbChunkIn=" << nbChunkIn << " out=" << out << " nbChunkOut=" << nbChunkOut);
+		// the last algo can write directly in the user buffer (when its output fit in it)
+		uint8_t* userData = static_cast<uint8_t*>(_data) + nbChunkDone*_chunkSize;
+		m_finalBuffer = userData;
+		m_finalBufferSize = (_nbChunk - nbChunkDone)*_chunkSize;
 		// get data from the upstream
 		process(_time, in, nbChunkIn, out, nbChunkOut);
-		if (nbChunkOut > 0) {
-			size_t position = m_data.size();
-			m_data.resize(m_data.size() + nbChunkOut*_chunkSize);
-			memcpy(&m_data[position], out, nbChunkOut*_chunkSize);
-		} else {
+		m_finalBuffer = null;
+		m_finalBufferSize = 0;
+		if (nbChunkOut == 0) {
 			// No more data in the process stream (0 input data might have flush data)
 			break;
 		}
+		if (m_silence == false) {
+			silence = false;
+		}
+		size_t nbChunkUsed = etk::min(nbChunkOut, _nbChunk - nbChunkDone);
+		if (out != userData) {
+			// copy in the user buffer
+			memcpy(userData, out, nbChunkUsed*_chunkSize);
+		}
+		nbChunkDone += nbChunkUsed;
+		if (nbChunkUsed != nbChunkOut) {
+			// keep the rest for the next call (the residual buffer is empty here)
+			size_t nbResidual = nbChunkOut - nbChunkUsed;
+			if (m_data.getCapacity() < nbResidual) {
+				DRAIN_WARNING("Residual buffer too small: " << m_data.getCapacity() << " < " << nbResidual << " chunks (realloc)");
+				m_data.setCapacity(nbResidual, _chunkSize, m_outputConfig.getFrequency());
+			}
+			m_data.write(static_cast<uint8_t*>(out) + nbChunkUsed*_chunkSize, nbResidual, m_data.getReadTimeStamp());
+			m_dataSilence = m_silence;
+		}
 	}
-	// copy only data availlable :
-	int32_t minByTeSize = etk::min(m_data.size(), _nbChunk*_chunkSize);
-	if (minByTeSize >= 0) {
-		memcpy(_data, &m_data[0], minByTeSize);
-		m_data.erase(m_data.begin(), m_data.begin()+minByTeSize);
+	_nbChunkDone = nbChunkDone;
+	_silence = silence;
+	return true;
+}
+
+bool audio::drain::Process::startPipeline(size_t _depth, size_t _nbChunk, const audio::Time& _time) {
+	stopPipeline();
+	if (    _depth == 0
+	     || _nbChunk == 0) {
+		DRAIN_ERROR("Can not start a pipeline of " << _depth << " period(s) of " << _nbChunk << " chunk(s)");
+		return false;
+	}
+	updateInterAlgo();
+	if (m_outputConfig.getLayout() != audio::drain::layout_interleaved) {
+		DRAIN_ERROR("Pipeline is not supported with a planar output");
+		return false;
 	}
+	size_t chunkSize = m_outputConfig.getChunkSize();
+	// all the allocations are done here: the pull and the pipeline thread only copy
+	m_pipelineData.setLockFree(true);
+	m_pipelineData.setCapacity(_depth*_nbChunk, chunkSize, m_outputConfig.getFrequency());
+	m_pipelineBuffer.resize(_nbChunk*chunkSize);
+	m_data.setCapacity(m_processBufferNbChunk, chunkSize, m_outputConfig.getFrequency());
+	m_pipelineNbChunk = _nbChunk;
+	m_pipelineTime = _time;
+	m_pipelineUnderrun = 0;
+	m_pipelineStop = false;
+	m_pipelineRead = false;
+	m_pipelineWakeUp = ETK_NEW(ethread::Semaphore);
+	m_pipelineThread = ETK_NEW(ethread::Thread, [=](){ pipelineCallback();}, "audio-drain-pipeline");
+	m_pipelineEnable.store(true, std::memory_order_release);
+	DRAIN_INFO("Start pipeline of " << _depth << " period(s) of " << _nbChunk << " chunk(s)");
 	return true;
 }
 
+void audio::drain::Process::stopPipeline() {
+	if (m_pipelineThread == null) {
+		return;
+	}
+	m_pipelineEnable.store(false, std::memory_order_release);
+	m_pipelineStop = true;
+	m_pipelineWakeUp->post();
+	m_pipelineThread->join();
+	ETK_DELETE(ethread::Thread, m_pipelineThread);
+	m_pipelineThread = null;
+	ETK_DELETE(ethread::Semaphore, m_pipelineWakeUp);
+	m_pipelineWakeUp = null;
+	m_pipelineData.clear();
+}
+
+void audio::drain::Process::pipelineCallback() {
+	ethread::setName("audio-drain-pipeline");
+	size_t chunkSize = m_pipelineData.getChunkSize();
+	float frequency = m_outputConfig.getFrequency();
+	// retry of a dry chain: one period
+	uint64_t timeOutUs = 1000;
+	if (frequency > 0.0f) {
+		timeOutUs = etk::max(uint64_t(m_pipelineNbChunk*1000000/size_t(frequency)), uint64_t(1));
+	}
+	// poll of the read of a period: a quarter of period
+	uint64_t pollUs = etk::max(timeOutUs/4, uint64_t(1));
+	size_t nbChunkTotal = 0;
+	while (m_pipelineStop == false) {
+		if (m_pipelineData.getFreeSize() < m_pipelineNbChunk) {
+			// full: poll the read of a period (the pull does not wake up the thread)
+			if (m_pipelineRead.exchange(false, std::memory_order_acquire) == false) {
+				m_pipelineWakeUp->wait(pollUs);
+			}
+			continue;
+		}
+		// computed from the start of the pipeline: no accumulation of the rounding
+		audio::Time time = m_pipelineTime;
+		if (frequency > 0.0f) {
+			time += audio::Duration(0, int64_t(nbChunkTotal)*1000000000LL/int64_t(frequency));
+		}
+		size_t nbChunkDone = 0;
+		bool silence = false;
+		void* data = null;
+		if (m_pipelineData.peekContiguousWrite(data, m_pipelineNbChunk) >= m_pipelineNbChunk) {
+			// compute directly in the queue
+			pullDirect(time, data, m_pipelineNbChunk, chunkSize, nbChunkDone, silence);
+			m_pipelineData.commitWrite(nbChunkDone);
+		} else {
+			pullDirect(time, m_pipelineBuffer.data(), m_pipelineNbChunk, chunkSize, nbChunkDone, silence);
+			m_pipelineData.write(m_pipelineBuffer.data(), nbChunkDone, time);
+		}
+		if (nbChunkDone == 0) {
+			// no data in the chain: retry later
+			m_pipelineWakeUp->wait(timeOutUs);
+			continue;
+		}
+		nbChunkTotal += nbChunkDone;
+	}
+}
+
+//! Size of the data of a tile of processBatch: the tile and the 2 ping-pong buffers stay in a 256kB L2 cache
+static const size_t g_batchTileByte = 64*1024;
+
+size_t audio::drain::Process::getBatchTileSize() const {
+	if (m_batchTileNbChunk != 0) {
+		return m_batchTileNbChunk;
+	}
+	// the biggest chunk of the chain (input, or the output of an algo) limit the tile
+	size_t chunkSize = m_inputConfig.getChunkSize();
+	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+		if (m_listAlgo[iii] != null) {
+			chunkSize = etk::max(chunkSize, size_t(m_listAlgo[iii]->getOutputFormat().getChunkSize()));
+		}
+	}
+	size_t out = g_batchTileByte / etk::max(chunkSize, size_t(1));
+	// a bigger tile than the process buffer allocate in the algos
+	return etk::avg(size_t(64), out, etk::max(m_processBufferNbChunk, size_t(64)));
+}
+
+bool audio::drain::Process::processBatch(const audio::Time& _time,
+                                         const void* _data,
+                                         size_t _nbChunk,
+                                         const etk::Function<void (const audio::Time& _time, const void* _data, size_t _nbChunk)>& _output) {
+	if (    _data == null
+	     && _nbChunk != 0) {
+		DRAIN_ERROR("Batch process without input data");
+		return false;
+	}
+	size_t tileNbChunk = getBatchTileSize();
+	size_t chunkSize = m_inputConfig.getChunkSize();
+	float frequency = m_inputConfig.getFrequency();
+	const uint8_t* input = static_cast<const uint8_t*>(_data);
+	size_t nbChunkDone = 0;
+	while (nbChunkDone < _nbChunk) {
+		size_t nbChunk = etk::min(tileNbChunk, _nbChunk - nbChunkDone);
+		// computed from the start of the block: no accumulation of the rounding
+		audio::Time time = _time;
+		if (frequency > 0.0f) {
+			time += audio::Duration(0, int64_t(nbChunkDone)*1000000000LL/int64_t(frequency));
+		}
+		void* out = null;
+		size_t nbChunkOut = 0;
+		// a Process never write in its input buffer
+		if (process(time, const_cast<uint8_t*>(input + nbChunkDone*chunkSize), nbChunk, out, nbChunkOut) == false) {
+			DRAIN_ERROR("Batch process failed at the chunk " << nbChunkDone << "/" << _nbChunk);
+			return false;
+		}
+		if (    nbChunkOut != 0
+		     && _output != null) {
+			_output(time, out, nbChunkOut);
+		}
+		nbChunkDone += nbChunk;
+	}
+	return true;
+}
 
 bool audio::drain::Process::process(audio::Time& _time,
                                     void* _inData,
@@ -84,33 +445,470 @@ bool audio::drain::Process::process(audio::Time& _time,
                                     void*& _outData,
                                     size_t& _outNbChunk) {
 	updateInterAlgo();
-	if (m_listAlgo.size() == 0) {
+	// period boundary: use the chain prepared by a hot change
+	hotApply();
+	if (m_activeAlgo.size() == 0) {
+		// no algo or only pass-through algos
+		m_silence = false;
 		_outData = _inData;
 		_outNbChunk = _inNbChunk;
 		return true;
 	}
-	DRAIN_VERBOSE(" process : " << m_listAlgo.size() << " algos nbChunk=" << _inNbChunk);
+	DRAIN_VERBOSE(" process : " << m_activeAlgo.size() << "/" << m_listAlgo.size() << " algos nbChunk=" << _inNbChunk);
+	audio::drain::cpu::FlushDenormal flush(m_flushDenormal);
+	size_t nbChunk = _inNbChunk;
+	bool ret = true;
+	echrono::Steady startTime = echrono::Steady::now();
+	for (size_t iii=0; iii<m_activeAlgo.size(); ++iii) {
+		if (processStage(iii, _time, _inData, _inNbChunk) == false) {
+			// the next algos can not use the output
+			ret = false;
+			break;
+		}
+	}
+	addMetricPeriod(uint64_t((echrono::Steady::now() - startTime).get()), nbChunk);
+	if (ret == false) {
+		_outData = null;
+		_outNbChunk = 0;
+		return false;
+	}
+	_outData = _inData;
+	_outNbChunk = _inNbChunk;
+	return true;
+}
+
+void audio::drain::Process::addMetricPeriod(uint64_t _duration, size_t _nbChunk) {
+	// the data of the period must be processed faster than their duration
+	uint64_t deadline = 0;
+	if (m_inputConfig.getFrequency() > 0.0f) {
+		deadline = uint64_t(_nbChunk)*1000000000ULL/uint64_t(m_inputConfig.getFrequency());
+	}
+	m_metric.addPeriod(_duration, deadline);
+}
+
+bool audio::drain::Process::processStage(size_t _activeId,
+                                         audio::Time& _time,
+                                         void*& _data,
+                                         size_t& _nbChunk) {
+	size_t id = m_activeAlgo[_activeId];
+	audio::drain::Algo* algo = m_listAlgo[id].get();
+	int8_t* buffer[2] = {null, null};
+	size_t bufferSize = m_processBuffer[0].size();
+	if (bufferSize != 0) {
+		buffer[0] = reinterpret_cast<int8_t*>(m_processBuffer[0].data());
+		buffer[1] = reinterpret_cast<int8_t*>(m_processBuffer[1].data());
+	}
+	// select the ping-pong buffer that is not used by the input
+	if (    m_finalBuffer != null
+	     && _activeId+1 == m_activeAlgo.size()
+	     && _data != m_finalBuffer) {
+		// last algo ==> write in the final buffer of the pull
+		algo->setOutputBuffer(m_finalBuffer, m_finalBufferSize);
+	} else if (_data == buffer[0]) {
+		if (algo->canProcessInPlace() == true) {
+			algo->setOutputBuffer(buffer[0], bufferSize);
+		} else {
+			algo->setOutputBuffer(buffer[1], bufferSize);
+		}
+	} else if (_data == buffer[1]) {
+		if (algo->canProcessInPlace() == true) {
+			algo->setOutputBuffer(buffer[1], bufferSize);
+		} else {
+			algo->setOutputBuffer(buffer[0], bufferSize);
+		}
+	} else {
+		// user buffer ==> never write on it
+		algo->setOutputBuffer(buffer[0], bufferSize);
+	}
+	if (_activeId == 0) {
+		m_silence = false;
+		if (    m_silenceDetection == true
+		     && _data != null) {
+			m_silence = audio::drain::isSilence(_data, _nbChunk*algo->getInputFormat().getChunkSize());
+		}
+	}
+	algo->setInputSilence(m_silence);
+	uint64_t startCycle = 0;
+	bool statisticEnable = m_statisticEnable.load(std::memory_order_relaxed);
+	if (statisticEnable == true) {
+		startCycle = audio::drain::cpu::getCycle();
+	}
+	void* outData = null;
+	size_t outNbChunk = 0;
+	bool ret = algo->process(_time, _data, _nbChunk, outData, outNbChunk);
+	m_silence = algo->getOutputSilence();
+	if (    m_silenceDetection == true
+	     && m_silence == false
+	     && _activeId == 0
+	     && _data == null
+	     && outData != null) {
+		// the first algo generate the data (endpoint)
+		m_silence = audio::drain::isSilence(outData, outNbChunk*algo->getOutputFormat().getChunkSize());
+	}
+	if (    statisticEnable == true
+	     && id < m_statistic.size()) {
+		m_statistic[id].add(m_statisticGeneration.load(std::memory_order_relaxed),
+		                    audio::drain::cpu::getCycle() - startCycle,
+		                    _nbChunk,
+		                    outNbChunk*algo->getOutputFormat().getChunkSize());
+	}
+	// the buffer is only valid during this call
+	algo->setOutputBuffer(null, 0);
+	_data = outData;
+	_nbChunk = outNbChunk;
+	return ret;
+}
+
+audio::Duration audio::drain::Process::getLatency() {
+	audio::Duration latency(0);
 	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
-		DRAIN_VERBOSE("            Algo " << iii+1 << "/" << m_listAlgo.size());
 		if (m_listAlgo[iii] != null) {
-			m_listAlgo[iii]->process(_time, _inData, _inNbChunk, _outData, _outNbChunk);
-			_inData = _outData;
-			_inNbChunk = _outNbChunk;
+			latency += m_listAlgo[iii]->getLatency();
 		}
 	}
-	return true;
+	// residual data of the previous pull
+	if (m_outputConfig.getFrequency() > 0.0f) {
+		latency += audio::Duration(0, int64_t(m_data.getSize() + m_pipelineData.getSize())*1000000000LL/int64_t(m_outputConfig.getFrequency()));
+	}
+	return latency;
 }
 
-void audio::drain::Process::pushBack(ememory::SharedPtr<audio::drain::Algo> _algo) {
-	removeAlgoDynamic();
-	_algo->setStatusFunction([=](const etk::String& _origin, const etk::String& _status) { generateStatus(_origin, _status);});
-	m_listAlgo.pushBack(_algo);
+void audio::drain::Process::setInputConfig(const audio::drain::IOFormatInterface& _interface) {
+	if (m_inputConfig != _interface) {
+		resetNegotiation();
+	}
+	m_inputConfig = _interface;
+}
+
+void audio::drain::Process::setOutputConfig(const audio::drain::IOFormatInterface& _interface) {
+	if (m_outputConfig != _interface) {
+		resetNegotiation();
+	}
+	m_outputConfig = _interface;
+}
+
+void audio::drain::Process::resetNegotiation() {
+	if (m_isConfigured == false) {
+		// nothing negotiated
+		return;
+	}
+	hotClear();
+	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+		if (    m_listAlgo[iii] != null
+		     && m_listAlgo[iii]->getTemporary() == true) {
+			releaseTemporaryAlgo(m_listAlgo[iii]);
+			m_listAlgo.erase(m_listAlgo.begin()+iii);
+			--iii;
+		}
+	}
+	m_activeAlgo.clear();
+	m_topologyKey = 0;
+	m_isConfigured = false;
+}
+
+void audio::drain::Process::setProcessBufferSize(size_t _nbChunk) {
+	m_processBufferNbChunk = _nbChunk;
+	if (m_isConfigured == true) {
+		updateProcessBuffer();
+	}
+}
+
+size_t audio::drain::Process::getProcessNbChunk(float _frequency) const {
+	float inputFrequency = m_inputConfig.getFrequency();
+	float nbChunk = m_processBufferNbChunk;
+	if (    inputFrequency > 0.0f
+	     && _frequency > 0.0f) {
+		// the resampler request 50% more space than the theoric output
+		nbChunk *= _frequency / inputFrequency * 1.5f;
+	}
+	return size_t(nbChunk) + 1;
+}
+
+void audio::drain::Process::updateProcessBuffer() {
+	// get the biggest output of the chain (the frequency change increase the number of chunk)
+	size_t maxSize = 0;
+	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+		if (m_listAlgo[iii] == null) {
+			continue;
+		}
+		const audio::drain::IOFormatInterface& output = m_listAlgo[iii]->getOutputFormat();
+		maxSize = etk::max(maxSize, getProcessNbChunk(output.getFrequency()) * output.getChunkSize());
+		// the internal buffers of the algo are allocated now
+		m_listAlgo[iii]->setProcessBufferSize(getProcessNbChunk(m_listAlgo[iii]->getInputFormat().getFrequency()));
+	}
+	DRAIN_VERBOSE("Process buffer size : 2*" << maxSize << " bytes");
+	m_processBuffer[0].resize(maxSize);
+	m_processBuffer[1].resize(maxSize);
+	// residual of the pull: less than one process output
+	if (m_outputConfig.getChunkSize() != 0) {
+		m_data.setCapacity(m_processBufferNbChunk,
+		                   m_outputConfig.getChunkSize(),
+		                   m_outputConfig.getFrequency());
+	}
 }
 
-void audio::drain::Process::pushFront(ememory::SharedPtr<audio::drain::Algo> _algo) {
+void audio::drain::Process::updateProcessBuffer(const ememory::SharedPtr<audio::drain::Algo>& _algo) {
+	_algo->setProcessBufferSize(getProcessNbChunk(_algo->getInputFormat().getFrequency()));
+	// the ping-pong buffers are used by the audio thread: a bigger output use the internal buffer of the algo
+	const audio::drain::IOFormatInterface& output = _algo->getOutputFormat();
+	size_t nbChunk = getProcessNbChunk(output.getFrequency());
+	if (nbChunk * output.getChunkSize() > m_processBuffer[0].size()) {
+		_algo->reserveOutputBuffer(nbChunk);
+	}
+}
+
+int32_t audio::drain::Process::addAlgo(ememory::SharedPtr<audio::drain::Algo> _algo, const void* _typeId, bool _front) {
+	if (_algo == null) {
+		DRAIN_ERROR("Can not add a null algo");
+		return -1;
+	}
 	removeAlgoDynamic();
 	_algo->setStatusFunction([=](const etk::String& _origin, const etk::String& _status) { generateStatus(_origin, _status);});
-	m_listAlgo.pushFront(_algo);
+	_algo->setStatusQueue(&m_statusQueue);
+	if (_front == true) {
+		m_listAlgo.pushFront(_algo);
+	} else {
+		m_listAlgo.pushBack(_algo);
+	}
+	return addHandle(_algo, _typeId);
+}
+
+int32_t audio::drain::Process::addHandle(const ememory::SharedPtr<audio::drain::Algo>& _algo, const void* _typeId) {
+	int32_t id = m_handleAlgo.size();
+	m_handleAlgo.pushBack(_algo);
+	m_handleType.pushBack(_typeId);
+	if (    _algo->getName() != ""
+	     && m_handleName.find(_algo->getName()) == m_handleName.end()) {
+		m_handleName.set(_algo->getName(), id);
+	}
+	m_handleRevision.fetch_add(1, std::memory_order_release);
+	return id;
+}
+
+void audio::drain::Process::removeHandle(const ememory::SharedPtr<audio::drain::Algo>& _algo) {
+	for (size_t iii=0; iii<m_handleAlgo.size(); ++iii) {
+		if (m_handleAlgo[iii] != _algo) {
+			continue;
+		}
+		// the id is not reused: the other handles stay valid
+		m_handleAlgo[iii].reset();
+		m_handleType[iii] = null;
+		// an other algo with the same name (replaced algo) is found with this name now
+		updateHandleName();
+		m_handleRevision.fetch_add(1, std::memory_order_release);
+		return;
+	}
+}
+
+void audio::drain::Process::updateHandleName() const {
+	m_handleNameRevision = audio::drain::Algo::getNameRevision();
+	m_handleName.clear();
+	for (size_t iii=0; iii<m_handleAlgo.size(); ++iii) {
+		if (    m_handleAlgo[iii] == null
+		     || m_handleAlgo[iii]->getName() == "") {
+			continue;
+		}
+		if (m_handleName.find(m_handleAlgo[iii]->getName()) == m_handleName.end()) {
+			m_handleName.set(m_handleAlgo[iii]->getName(), int32_t(iii));
+		}
+	}
+}
+
+int32_t audio::drain::Process::findHandle(const etk::String& _name) const {
+	if (m_handleNameRevision != audio::drain::Algo::getNameRevision()) {
+		// an algo has been renamed
+		updateHandleName();
+	}
+	auto it = m_handleName.find(_name);
+	if (it == m_handleName.end()) {
+		return -1;
+	}
+	return it->second;
+}
+
+bool audio::drain::Process::hotPrepare() {
+	if (m_hotPending.load(std::memory_order_acquire) == true) {
+		DRAIN_WARNING("The previous hot change is not applied (no process since)");
+		return false;
+	}
+	// the previous chain is not used anymore by the audio thread (the removed algos are freed here)
+	m_hotListAlgo = m_listAlgo;
+	return true;
+}
+
+bool audio::drain::Process::hotBridge(size_t _position, const ememory::SharedPtr<audio::drain::Algo>& _algo) {
+	// formats already used at this position: the neighbours are not modified
+	const audio::drain::IOFormatInterface& input = _position == 0 ? m_inputConfig : m_hotListAlgo[_position-1]->getOutputFormat();
+	const audio::drain::IOFormatInterface& output = _position == m_hotListAlgo.size() ? m_outputConfig : m_hotListAlgo[_position]->getInputFormat();
+	audio::drain::Process bridge;
+	bridge.setAlgoPool(m_algoPool);
+	bridge.setDither(m_dither);
+	// only used by the negotiation: the buffers of the new algos are allocated by hotCommit
+	bridge.setProcessBufferSize(1);
+	bridge.setInputConfig(audio::drain::IOFormatInterface(input.getMap(), input.getFormat(), input.getFrequency(), input.getLayout()));
+	bridge.setOutputConfig(audio::drain::IOFormatInterface(output.getMap(), output.getFormat(), output.getFrequency(), output.getLayout()));
+	if (_algo != null) {
+		bridge.m_listAlgo.pushBack(_algo);
+	}
+	bridge.updateInterAlgo();
+	for (size_t iii=0; iii<bridge.m_listAlgo.size(); ++iii) {
+		if (    bridge.m_listAlgo[iii]->getInputFormat().getConfigured() == false
+		     || bridge.m_listAlgo[iii]->getOutputFormat().getConfigured() == false) {
+			DRAIN_ERROR("Can not negotiate the hot change: " << input << " -> " << output);
+			// the algo of the user is not given to the pool (the failed algo can be a temporary one)
+			for (size_t jjj=0; jjj<bridge.m_listAlgo.size(); ++jjj) {
+				if (bridge.m_listAlgo[jjj] == _algo) {
+					bridge.m_listAlgo.erase(bridge.m_listAlgo.begin()+jjj);
+					break;
+				}
+			}
+			// only the temporary algos of the negotiation stay
+			for (size_t jjj=0; jjj<bridge.m_listAlgo.size(); ++jjj) {
+				bridge.releaseTemporaryAlgo(bridge.m_listAlgo[jjj]);
+			}
+			bridge.m_listAlgo.clear();
+			return false;
+		}
+	}
+	for (size_t iii=0; iii<bridge.m_listAlgo.size(); ++iii) {
+		const ememory::SharedPtr<audio::drain::Algo>& algo = bridge.m_listAlgo[iii];
+		algo->setStatusFunction([=](const etk::String& _origin, const etk::String& _status) { generateStatus(_origin, _status);});
+		algo->setStatusQueue(&m_statusQueue);
+		m_hotListAlgo.insert(m_hotListAlgo.begin()+_position+iii, algo);
+	}
+	// the algos are now in the chain
+	bridge.m_listAlgo.clear();
+	return true;
+}
+
+void audio::drain::Process::hotCommit() {
+	getActiveAlgo(m_hotListAlgo, m_hotActiveAlgo, m_hotTopologyKey);
+	// keep the profiling of the algos already in the chain
+	m_hotStatistic.resize(m_hotListAlgo.size());
+	uint32_t generation = m_statisticGeneration.load(std::memory_order_relaxed);
+	for (size_t iii=0; iii<m_hotListAlgo.size(); ++iii) {
+		m_hotStatistic[iii].reset(generation);
+		bool used = false;
+		for (size_t jjj=0; jjj<m_listAlgo.size(); ++jjj) {
+			if (m_listAlgo[jjj] == m_hotListAlgo[iii]) {
+				if (jjj < m_statistic.size()) {
+					m_hotStatistic[iii] = m_statistic[jjj];
+				}
+				used = true;
+				break;
+			}
+		}
+		if (used == false) {
+			// new algo (or conversion of the bridge): allocated here instead of at its first process
+			updateProcessBuffer(m_hotListAlgo[iii]);
+		}
+		m_hotStatistic[iii].m_type = m_hotListAlgo[iii]->getType();
+		m_hotStatistic[iii].m_name = m_hotListAlgo[iii]->getName();
+	}
+	m_hotPending.store(true, std::memory_order_release);
+}
+
+void audio::drain::Process::hotClear() {
+	if (m_hotPending.load(std::memory_order_acquire) == true) {
+		// the prepared chain is never used: give back its new temporary algos
+		for (size_t iii=0; iii<m_hotListAlgo.size(); ++iii) {
+			bool used = false;
+			for (size_t jjj=0; jjj<m_listAlgo.size(); ++jjj) {
+				if (m_listAlgo[jjj] == m_hotListAlgo[iii]) {
+					used = true;
+					break;
+				}
+			}
+			if (used == false) {
+				releaseTemporaryAlgo(m_hotListAlgo[iii]);
+			}
+		}
+		m_hotPending.store(false, std::memory_order_release);
+	}
+	m_hotListAlgo.clear();
+}
+
+int32_t audio::drain::Process::hotInsert(const ememory::SharedPtr<audio::drain::Algo>& _algo, const void* _typeId, int32_t _next) {
+	if (_algo == null) {
+		DRAIN_ERROR("Can not add a null algo");
+		return -1;
+	}
+	if (m_isConfigured == false) {
+		// not running: the full negotiation is done at the first process
+		if (_next < 0) {
+			return addAlgo(_algo, _typeId, false);
+		}
+		DRAIN_ERROR("Can not insert an algo in a chain not configured");
+		return -1;
+	}
+	ethread::UniqueLock lock(m_hotLock);
+	if (hotPrepare() == false) {
+		return -1;
+	}
+	size_t position = m_hotListAlgo.size();
+	if (_next >= 0) {
+		if (    _next >= int32_t(m_handleAlgo.size())
+		     || m_handleAlgo[_next] == null) {
+			DRAIN_ERROR("Invalid handle: " << _next);
+			return -1;
+		}
+		for (position=0; position<m_hotListAlgo.size(); ++position) {
+			if (m_hotListAlgo[position] == m_handleAlgo[_next]) {
+				break;
+			}
+		}
+		if (position == m_hotListAlgo.size()) {
+			DRAIN_ERROR("The algo of the handle " << _next << " is not in the chain");
+			return -1;
+		}
+	}
+	if (hotBridge(position, _algo) == false) {
+		return -1;
+	}
+	int32_t id = addHandle(_algo, _typeId);
+	hotCommit();
+	return id;
+}
+
+bool audio::drain::Process::hotRemove(int32_t _handle) {
+	if (    _handle < 0
+	     || _handle >= int32_t(m_handleAlgo.size())
+	     || m_handleAlgo[_handle] == null) {
+		DRAIN_ERROR("Invalid handle: " << _handle);
+		return false;
+	}
+	if (m_isConfigured == false) {
+		for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+			if (m_listAlgo[iii] == m_handleAlgo[_handle]) {
+				m_listAlgo.erase(m_listAlgo.begin()+iii);
+				break;
+			}
+		}
+		removeHandle(m_handleAlgo[_handle]);
+		return true;
+	}
+	ethread::UniqueLock lock(m_hotLock);
+	if (hotPrepare() == false) {
+		return false;
+	}
+	size_t position = 0;
+	for (position=0; position<m_hotListAlgo.size(); ++position) {
+		if (m_hotListAlgo[position] == m_handleAlgo[_handle]) {
+			break;
+		}
+	}
+	if (position == m_hotListAlgo.size()) {
+		DRAIN_ERROR("The algo of the handle " << _handle << " is not in the chain");
+		return false;
+	}
+	// the conversions around the algo are kept: they are also used by the other algos (their state is kept)
+	m_hotListAlgo.erase(m_hotListAlgo.begin()+position);
+	if (hotBridge(position, null) == false) {
+		return false;
+	}
+	removeHandle(m_handleAlgo[_handle]);
+	hotCommit();
+	return true;
 }
 
 template<typename DRAIN_TYPE>
@@ -136,6 +934,15 @@ etk::Vector<DRAIN_TYPE> getUnion(const etk::Vector<DRAIN_TYPE>& _out, const etk:
 }
 
 
+static bool haveFormat(const etk::Vector<audio::format>& _list, enum audio::format _format) {
+	for (size_t iii=0; iii<_list.size(); ++iii) {
+		if (_list[iii] == _format) {
+			return true;
+		}
+	}
+	return false;
+}
+
 void audio::drain::Process::displayAlgo() {
 	DRAIN_DEBUG("    Input : " << m_inputConfig);
 	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
@@ -147,6 +954,7 @@ void audio::drain::Process::displayAlgo() {
 			DRAIN_DEBUG("            format : " << m_listAlgo[iii]->getFormatSupportedInput());
 			DRAIN_DEBUG("            frequency : " << m_listAlgo[iii]->getFrequencySupportedInput());
 			DRAIN_DEBUG("            map : " << m_listAlgo[iii]->getMapSupportedInput());
+			DRAIN_DEBUG("            layout : " << m_listAlgo[iii]->getLayoutSupportedInput());
 		}
 		if (m_listAlgo[iii]->getOutputFormat().getConfigured() == true) {
 			DRAIN_DEBUG("        Output: " << m_listAlgo[iii]->getOutputFormat());
@@ -155,6 +963,7 @@ void audio::drain::Process::displayAlgo() {
 			DRAIN_DEBUG("            format : " << m_listAlgo[iii]->getFormatSupportedOutput());
 			DRAIN_DEBUG("            frequency : " << m_listAlgo[iii]->getFrequencySupportedOutput());
 			DRAIN_DEBUG("            map : " << m_listAlgo[iii]->getMapSupportedOutput());
+			DRAIN_DEBUG("            layout : " << m_listAlgo[iii]->getLayoutSupportedOutput());
 		}
 	}
 	DRAIN_DEBUG("    Output : " << m_outputConfig);
@@ -225,12 +1034,30 @@ void audio::drain::Process::updateAlgo(size_t _position) {
 		DRAIN_VERBOSE("        format out   :" << formatOut);
 		DRAIN_VERBOSE("        format in    :" << formatIn);
 		DRAIN_VERBOSE("        format union :" << format);
+		// step 4 : Check layout:
+		etk::Vector<enum audio::drain::layout> layoutOut;
+		etk::Vector<enum audio::drain::layout> layoutIn;
+		if (_position == 0) {
+			layoutOut.pushBack(m_inputConfig.getLayout());
+		} else {
+			layoutOut = m_listAlgo[_position-1]->getLayoutSupportedOutput();
+		}
+		if (_position == m_listAlgo.size()) {
+			layoutIn.pushBack(m_outputConfig.getLayout());
+		} else {
+			layoutIn = m_listAlgo[_position]->getLayoutSupportedInput();
+		}
+		etk::Vector<enum audio::drain::layout> layout = getUnion<enum audio::drain::layout>(layoutOut, layoutIn);
+		DRAIN_VERBOSE("        layout out   :" << layoutOut);
+		DRAIN_VERBOSE("        layout in    :" << layoutIn);
+		DRAIN_VERBOSE("        layout union :" << layout);
 		
 		if (    freq.size() >= 1
 		     && map.size() >= 1
-		     && format.size() >= 1) {
-			DRAIN_VERBOSE("        find 1 compatibility :{format=" << format << ",frequency=" << freq << ",map=" << map << "}");
-			drain::IOFormatInterface tmp(map[0], format[0], freq[0]);
+		     && format.size() >= 1
+		     && layout.size() >= 1) {
+			DRAIN_VERBOSE("        find 1 compatibility :{format=" << format << ",frequency=" << freq << ",map=" << map << ",layout=" << layout << "}");
+			drain::IOFormatInterface tmp(map[0], format[0], freq[0], layout[0]);
 			if (_position > 0) {
 				m_listAlgo[_position-1]->setOutputFormat(tmp);
 			}
@@ -320,6 +1147,32 @@ void audio::drain::Process::updateAlgo(size_t _position) {
 				}
 			}
 		}
+		if (layout.size() > 0) {
+			out.setLayout(layout[0]);
+			in.setLayout(layout[0]);
+		} else {
+			if (layoutOut.size() == 0) {
+				if (layoutIn.size() == 0) {
+					if (_position == 0) {
+						DRAIN_ERROR("IMPOSSIBLE CASE");
+					} else {
+						out.setLayout(m_listAlgo[_position-1]->getInputFormat().getLayout());
+						in.setLayout(m_listAlgo[_position-1]->getInputFormat().getLayout());
+					}
+				} else {
+					out.setLayout(layoutIn[0]);
+					in.setLayout(layoutIn[0]);
+				}
+			} else {
+				if (layoutIn.size() == 0) {
+					out.setLayout(layoutOut[0]);
+					in.setLayout(layoutOut[0]);
+				} else {
+					out.setLayout(layoutOut[0]);
+					in.setLayout(layoutIn[0]);
+				}
+			}
+		}
 		DRAIN_VERBOSE("        update: out=" << out);
 		DRAIN_VERBOSE("                in=" << in);
 		if (_position > 0) {
@@ -329,54 +1182,62 @@ void audio::drain::Process::updateAlgo(size_t _position) {
 			m_listAlgo[_position]->setInputFormat(in);
 		}
 		// TODO : Add updater with an optimisation of CPU
+		if (    out.getFrequency() != in.getFrequency()
+		     && out.getLayout() != audio::drain::layout_interleaved) {
+			// the resampler work only on interleaved chunks
+			ememory::SharedPtr<audio::drain::Algo> algo = createTemporaryAlgo("ChannelReorder");
+			algo->setInputFormat(out);
+			out.setLayout(audio::drain::layout_interleaved);
+			algo->setOutputFormat(out);
+			m_listAlgo.insert(m_listAlgo.begin()+_position, algo);
+			DRAIN_VERBOSE("convert " << out.getLayout() << " -> " << in.getLayout());
+			_position++;
+		}
 		if (out.getFrequency() != in.getFrequency()) {
-			
-			// TODO : Do it better: special check for resampler : only support int16_t
-			if (    out.getFormat() != audio::format_int16
-			     /* && out.getFormat() != format_float */) {
-				// need add a format Updater
-				ememory::SharedPtr<audio::drain::FormatUpdate> algo = audio::drain::FormatUpdate::create();
-				algo->setTemporary();
+			ememory::SharedPtr<audio::drain::Algo> algoResampler = createTemporaryAlgo("Resampler");
+			// the resampler does not support all the formats
+			if (haveFormat(algoResampler->getFormatSupportedInput(), out.getFormat()) == false) {
+				// need add a format Updater (keep the precision of the 32 bits formats)
+				ememory::SharedPtr<audio::drain::Algo> algo = createTemporaryAlgo("FormatUpdate");
 				algo->setInputFormat(out);
-				out.setFormat(audio::format_int16);
+				if (out.getFormat() == audio::format_int32) {
+					out.setFormat(audio::format_float);
+				} else {
+					out.setFormat(audio::format_int16);
+				}
 				algo->setOutputFormat(out);
-				algo->setStatusFunction([=](const etk::String& _origin, const etk::String& _status) { generateStatus(_origin, _status);});
 				m_listAlgo.insert(m_listAlgo.begin()+_position, algo);
 				DRAIN_VERBOSE("convert " << out.getFormat() << " -> " << in.getFormat());
 				_position++;
 			}
 			// need add a resampler
-			ememory::SharedPtr<audio::drain::Resampler> algo = audio::drain::Resampler::create();
-			algo->setTemporary();
+			ememory::SharedPtr<audio::drain::Algo> algo = algoResampler;
 			algo->setInputFormat(out);
 			out.setFrequency(in.getFrequency());
 			algo->setOutputFormat(out);
-			algo->setStatusFunction([=](const etk::String& _origin, const etk::String& _status) { generateStatus(_origin, _status);});
 			m_listAlgo.insert(m_listAlgo.begin()+_position, algo);
 			DRAIN_VERBOSE("convert " << out.getFrequency() << " -> " << in.getFrequency());
 			out.setFrequency(in.getFrequency());
 			_position++;
 		}
-		if (out.getMap() != in.getMap()) {
-			// need add a channel Reorder
-			ememory::SharedPtr<audio::drain::ChannelReorder> algo = audio::drain::ChannelReorder::create();
-			algo->setTemporary();
+		if (    out.getMap() != in.getMap()
+		     || out.getLayout() != in.getLayout()) {
+			// need add a channel Reorder (it convert the layout too)
+			ememory::SharedPtr<audio::drain::Algo> algo = createTemporaryAlgo("ChannelReorder");
 			algo->setInputFormat(out);
 			out.setMap(in.getMap());
+			out.setLayout(in.getLayout());
 			algo->setOutputFormat(out);
-			algo->setStatusFunction([=](const etk::String& _origin, const etk::String& _status) { generateStatus(_origin, _status);});
 			m_listAlgo.insert(m_listAlgo.begin()+_position, algo);
 			DRAIN_VERBOSE("convert " << out.getMap() << " -> " << in.getMap());
 			_position++;
 		}
 		if (out.getFormat() != in.getFormat()) {
 			// need add a format Updater
-			ememory::SharedPtr<audio::drain::FormatUpdate> algo = audio::drain::FormatUpdate::create();
-			algo->setTemporary();
+			ememory::SharedPtr<audio::drain::Algo> algo = createTemporaryAlgo("FormatUpdate");
 			algo->setInputFormat(out);
 			out.setFormat(in.getFormat());
 			algo->setOutputFormat(out);
-			algo->setStatusFunction([=](const etk::String& _origin, const etk::String& _status) { generateStatus(_origin, _status);});
 			m_listAlgo.insert(m_listAlgo.begin()+_position, algo);
 			DRAIN_VERBOSE("convert " << out.getFormat() << " -> " << in.getFormat());
 			_position++;
@@ -398,22 +1259,448 @@ void audio::drain::Process::updateInterAlgo() {
 		// cahin is already configured
 		return ;
 	}
-	DRAIN_VERBOSE("Display properties : nbAlgo : " << m_listAlgo.size());
-	displayAlgo();
-	DRAIN_VERBOSE("********* configuration START *************");
-	// configure first the endpoint ...
-	if (m_listAlgo.size() >= 1) {
-		updateAlgo(m_listAlgo.size());
+	// the negotiation change the formats many times: each algo compute its configuration once, at the end
+	m_configurationBatch = true;
+	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+		if (m_listAlgo[iii] != null) {
+			m_listAlgo[iii]->beginConfiguration();
+		}
 	}
-	for (size_t iii=0; iii<=m_listAlgo.size(); ++iii) {
-		updateAlgo(iii);
+	etk::Vector<uint32_t> key;
+	bool cacheable = getNegotiationKey(key);
+	if (    cacheable == true
+	     && applyNegotiationCache(key) == true) {
+		DRAIN_VERBOSE("********* configuration from cache (nbAlgo=" << m_listAlgo.size() << ") *************");
+	} else {
+		DRAIN_VERBOSE("********* configuration START (nbAlgo=" << m_listAlgo.size() << ") *************");
+		// configure first the endpoint ...
+		if (m_listAlgo.size() >= 1) {
+			updateAlgo(m_listAlgo.size());
+		}
+		for (size_t iii=0; iii<=m_listAlgo.size(); ++iii) {
+			updateAlgo(iii);
+		}
+		fuseAlgo();
+		insertDither();
+		DRAIN_VERBOSE("********* configuration will be done *************");
+		#ifdef DEBUG
+			// the supported lists are copied for the log: only when it is displayed
+			if (elog::getLevel(audio::drain::getLogId()) >= elog::level_debug) {
+				displayAlgo();
+			}
+		#endif
+		if (cacheable == true) {
+			storeNegotiationCache(key);
+		}
+	}
+	m_configurationBatch = false;
+	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+		if (m_listAlgo[iii] != null) {
+			m_listAlgo[iii]->endConfiguration();
+		}
+	}
+	updateProcessBuffer();
+	updateActiveAlgo();
+	// profiling: one element for each algo (no allocation in the process)
+	m_statistic.resize(m_listAlgo.size());
+	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+		m_statistic[iii].reset(m_statisticGeneration.load(std::memory_order_relaxed));
+		if (m_listAlgo[iii] != null) {
+			m_statistic[iii].m_type = m_listAlgo[iii]->getType();
+			m_statistic[iii].m_name = m_listAlgo[iii]->getName();
+		}
 	}
-	DRAIN_VERBOSE("********* configuration will be done *************");
-	displayAlgo();
 	m_isConfigured = true;
 	//exit(-1);
 }
 
+void audio::drain::Process::getActiveAlgo(const etk::Vector<ememory::SharedPtr<audio::drain::Algo>>& _listAlgo,
+                                          etk::Vector<size_t>& _activeAlgo,
+                                          uint64_t& _topologyKey) {
+	_activeAlgo.clear();
+	_activeAlgo.reserve(_listAlgo.size());
+	for (size_t iii=0; iii<_listAlgo.size(); ++iii) {
+		if (    _listAlgo[iii] == null
+		     || _listAlgo[iii]->isPassThrough() == true) {
+			continue;
+		}
+		_activeAlgo.pushBack(iii);
+	}
+	// FNV-1a of the active algos and their formats
+	_topologyKey = 14695981039346656037ULL;
+	for (size_t iii=0; iii<_activeAlgo.size(); ++iii) {
+		const ememory::SharedPtr<audio::drain::Algo>& algo = _listAlgo[_activeAlgo[iii]];
+		const etk::String& type = algo->getType();
+		for (size_t jjj=0; jjj<type.size(); ++jjj) {
+			_topologyKey = (_topologyKey ^ uint8_t(type[jjj])) * 1099511628211ULL;
+		}
+		const audio::drain::IOFormatInterface* format[2] = {&algo->getInputFormat(), &algo->getOutputFormat()};
+		for (size_t jjj=0; jjj<2; ++jjj) {
+			_topologyKey = (_topologyKey ^ uint64_t(format[jjj]->getFormat())) * 1099511628211ULL;
+			_topologyKey = (_topologyKey ^ uint64_t(format[jjj]->getFrequency())) * 1099511628211ULL;
+			_topologyKey = (_topologyKey ^ uint64_t(format[jjj]->getMap().size())) * 1099511628211ULL;
+		}
+	}
+	DRAIN_VERBOSE("Active algo : " << _activeAlgo.size() << "/" << _listAlgo.size());
+}
+
+void audio::drain::Process::fuseAlgo() {
+	size_t iii = 0;
+	while (iii+1 < m_listAlgo.size()) {
+		ememory::SharedPtr<audio::drain::Algo> first = m_listAlgo[iii];
+		ememory::SharedPtr<audio::drain::Algo> second = m_listAlgo[iii+1];
+		if (    first == null
+		     || second == null) {
+			++iii;
+			continue;
+		}
+		ememory::SharedPtr<audio::drain::FormatUpdate> firstFormat = ememory::dynamicPointerCast<audio::drain::FormatUpdate>(first);
+		ememory::SharedPtr<audio::drain::FormatUpdate> secondFormat = ememory::dynamicPointerCast<audio::drain::FormatUpdate>(second);
+		if (    secondFormat != null
+		     && secondFormat->getTemporary() == true) {
+			if (    firstFormat != null
+			     && firstFormat->getTemporary() == true) {
+				// FormatUpdate -> FormatUpdate ==> a single conversion
+				DRAIN_VERBOSE("fuse [" << iii << "] FormatUpdate + FormatUpdate");
+				first->setOutputFormat(second->getOutputFormat());
+				m_listAlgo.erase(m_listAlgo.begin()+iii+1);
+				releaseTemporaryAlgo(second);
+				if (first->getInputFormat().getFormat() == first->getOutputFormat().getFormat()) {
+					m_listAlgo.erase(m_listAlgo.begin()+iii);
+					releaseTemporaryAlgo(first);
+					if (iii > 0) {
+						// the previous algo can now be fused with the next one
+						--iii;
+					}
+				}
+				continue;
+			}
+			if (    ememory::dynamicPointerCast<audio::drain::Volume>(first) != null
+			     && secondFormat->needDither() == false
+			     && haveFormat(first->getFormatSupportedOutput(), second->getOutputFormat().getFormat()) == true) {
+				// Volume -> FormatUpdate ==> the volume convert the format
+				DRAIN_VERBOSE("fuse [" << iii << "] Volume + FormatUpdate");
+				first->setOutputFormat(second->getOutputFormat());
+				m_listAlgo.erase(m_listAlgo.begin()+iii+1);
+				releaseTemporaryAlgo(second);
+				continue;
+			}
+		}
+		if (    firstFormat != null
+		     && firstFormat->getTemporary() == true
+		     && ememory::dynamicPointerCast<audio::drain::Volume>(second) != null
+		     && haveFormat(second->getFormatSupportedInput(), first->getInputFormat().getFormat()) == true) {
+			// FormatUpdate -> Volume ==> the volume convert the format
+			DRAIN_VERBOSE("fuse [" << iii << "] FormatUpdate + Volume");
+			second->setInputFormat(first->getInputFormat());
+			m_listAlgo.erase(m_listAlgo.begin()+iii);
+			releaseTemporaryAlgo(first);
+			if (iii > 0) {
+				--iii;
+			}
+			continue;
+		}
+		++iii;
+	}
+}
+
+void audio::drain::Process::insertDither() {
+	if (m_dither == audio::drain::dither_none) {
+		return;
+	}
+	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+		if (ememory::dynamicPointerCast<audio::drain::Volume>(m_listAlgo[iii]) == null) {
+			continue;
+		}
+		audio::drain::IOFormatInterface out = m_listAlgo[iii]->getOutputFormat();
+		enum audio::format inputFormat = m_listAlgo[iii]->getInputFormat().getFormat();
+		if (    out.getFormat() != audio::format_int16
+		     || (    inputFormat != audio::format_float
+		          && inputFormat != audio::format_int32)
+		     || haveFormat(m_listAlgo[iii]->getFormatSupportedOutput(), inputFormat) == false) {
+			continue;
+		}
+		// the volume keep the resolution, the FormatUpdate requantize with the dither
+		ememory::SharedPtr<audio::drain::Algo> algo = createTemporaryAlgo("FormatUpdate");
+		if (algo == null) {
+			continue;
+		}
+		audio::drain::IOFormatInterface wide = out;
+		wide.setFormat(inputFormat);
+		m_listAlgo[iii]->setOutputFormat(wide);
+		algo->setInputFormat(wide);
+		algo->setOutputFormat(out);
+		m_listAlgo.insert(m_listAlgo.begin()+iii+1, algo);
+		DRAIN_VERBOSE("dither [" << iii << "] Volume + FormatUpdate " << inputFormat << " -> " << out.getFormat());
+		++iii;
+	}
+}
+
+static void appendKey(etk::Vector<uint32_t>& _key, const audio::drain::IOFormatInterface& _format) {
+	if (_format.getConfigured() == false) {
+		_key.pushBack(0);
+		return;
+	}
+	_key.pushBack(1);
+	_key.pushBack(uint32_t(_format.getFormat()));
+	float frequency = _format.getFrequency();
+	uint32_t frequencyBit = 0;
+	memcpy(&frequencyBit, &frequency, sizeof(uint32_t));
+	_key.pushBack(frequencyBit);
+	_key.pushBack(_format.getMap().size());
+	for (size_t iii=0; iii<_format.getMap().size(); ++iii) {
+		_key.pushBack(uint32_t(_format.getMap()[iii]));
+	}
+	_key.pushBack(uint32_t(_format.getLayout()));
+}
+
+static void appendKey(etk::Vector<uint32_t>& _key, const etk::String& _value) {
+	// FNV-1a
+	uint32_t hash = 2166136261U;
+	for (size_t iii=0; iii<_value.size(); ++iii) {
+		hash ^= uint8_t(_value[iii]);
+		hash *= 16777619U;
+	}
+	_key.pushBack(hash);
+}
+
+bool audio::drain::Process::getNegotiationKey(etk::Vector<uint32_t>& _key) {
+	_key.clear();
+	_key.reserve(32 + m_listAlgo.size()*8);
+	appendKey(_key, m_inputConfig);
+	appendKey(_key, m_outputConfig);
+	// the dither change the fusion of the algos
+	_key.pushBack(uint32_t(m_dither));
+	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+		if (    m_listAlgo[iii] == null
+		     || m_listAlgo[iii]->getTemporary() == true) {
+			// already negotiated chain ==> can not be matched with a cache element
+			return false;
+		}
+		appendKey(_key, m_listAlgo[iii]->getType());
+		appendKey(_key, m_listAlgo[iii]->getInputFormat());
+		appendKey(_key, m_listAlgo[iii]->getOutputFormat());
+		// the supported lists depend on the parameters of the algo (and are used by the negotiation): hashed without copy
+		audio::drain::NegotiationHash hash;
+		m_listAlgo[iii]->appendSupportedKey(hash);
+		_key.pushBack(uint32_t(hash.m_value));
+		_key.pushBack(uint32_t(hash.m_value >> 32));
+	}
+	return true;
+}
+
+bool audio::drain::Process::applyNegotiationCache(const etk::Vector<uint32_t>& _key) {
+	// copy the solved configuration: the algos are created without the lock (the pool has its own lock)
+	etk::Vector<audio::drain::NegotiationStage> stages;
+	{
+		ethread::UniqueLock lock(g_negotiationLock);
+		for (size_t iii=0; iii<g_negotiationCache.size(); ++iii) {
+			if (g_negotiationCache[iii].m_key == _key) {
+				stages = g_negotiationCache[iii].m_stage;
+				break;
+			}
+		}
+	}
+	if (stages.size() == 0) {
+		return false;
+	}
+	etk::Vector<ememory::SharedPtr<audio::drain::Algo> > newList;
+	size_t userId = 0;
+	for (size_t iii=0; iii<stages.size(); ++iii) {
+		ememory::SharedPtr<audio::drain::Algo> algo;
+		if (stages[iii].m_temporary == false) {
+			if (userId >= m_listAlgo.size()) {
+				DRAIN_ERROR("Negotiation cache corrupted");
+				break;
+			}
+			algo = m_listAlgo[userId++];
+		} else {
+			algo = createTemporaryAlgo(stages[iii].m_type);
+			if (algo == null) {
+				DRAIN_ERROR("Negotiation cache: can not create temporary algo '" << stages[iii].m_type << "'");
+				break;
+			}
+		}
+		newList.pushBack(algo);
+	}
+	if (    newList.size() != stages.size()
+	     || userId != m_listAlgo.size()) {
+		if (userId != m_listAlgo.size()) {
+			DRAIN_ERROR("Negotiation cache corrupted");
+		}
+		for (size_t iii=0; iii<newList.size(); ++iii) {
+			if (newList[iii]->getTemporary() == true) {
+				releaseTemporaryAlgo(newList[iii]);
+			}
+		}
+		return false;
+	}
+	for (size_t iii=0; iii<stages.size(); ++iii) {
+		newList[iii]->setFormat(stages[iii].m_input, stages[iii].m_output);
+	}
+	m_listAlgo = newList;
+	return true;
+}
+
+void audio::drain::Process::storeNegotiationCache(const etk::Vector<uint32_t>& _key) {
+	audio::drain::NegotiationCache element;
+	element.m_key = _key;
+	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+		if (m_listAlgo[iii] == null) {
+			return;
+		}
+		audio::drain::NegotiationStage stage;
+		stage.m_type = m_listAlgo[iii]->getType();
+		stage.m_temporary = m_listAlgo[iii]->getTemporary();
+		const audio::drain::IOFormatInterface& input = m_listAlgo[iii]->getInputFormat();
+		const audio::drain::IOFormatInterface& output = m_listAlgo[iii]->getOutputFormat();
+		stage.m_input.set(input.getMap(), input.getFormat(), input.getFrequency(), input.getLayout());
+		stage.m_output.set(output.getMap(), output.getFormat(), output.getFrequency(), output.getLayout());
+		element.m_stage.pushBack(stage);
+	}
+	ethread::UniqueLock lock(g_negotiationLock);
+	if (g_negotiationCache.size() < g_negotiationCacheMaxSize) {
+		g_negotiationCache.pushBack(element);
+		return;
+	}
+	g_negotiationCache[g_negotiationCacheNext] = element;
+	g_negotiationCacheNext = (g_negotiationCacheNext + 1) % g_negotiationCacheMaxSize;
+}
+
+ememory::SharedPtr<audio::drain::Algo> audio::drain::Process::createTemporaryAlgo(const etk::String& _type) {
+	ememory::SharedPtr<audio::drain::Algo> algo;
+	if (m_algoPool != null) {
+		algo = m_algoPool->get(_type);
+	} else {
+		algo = audio::drain::AlgoPool::createAlgo(_type);
+	}
+	if (algo != null) {
+		algo->setStatusFunction([=](const etk::String& _origin, const etk::String& _status) { generateStatus(_origin, _status);});
+		algo->setStatusQueue(&m_statusQueue);
+		ememory::SharedPtr<audio::drain::FormatUpdate> format = ememory::dynamicPointerCast<audio::drain::FormatUpdate>(algo);
+		if (format != null) {
+			format->setDither(m_dither);
+		}
+		if (m_configurationBatch == true) {
+			algo->beginConfiguration();
+		}
+	}
+	return algo;
+}
+
+void audio::drain::Process::releaseTemporaryAlgo(const ememory::SharedPtr<audio::drain::Algo>& _algo) {
+	if (m_algoPool == null) {
+		return;
+	}
+	if (    m_configurationBatch == true
+	     && _algo != null) {
+		// removed by the negotiation: close its configuration before giving it back to the pool
+		_algo->endConfiguration();
+	}
+	if (_algo != null) {
+		// the pool can give it to an other Process
+		_algo->setStatusQueue(null);
+	}
+	m_algoPool->release(_algo);
+}
+
+void audio::drain::Process::clearNegotiationCache() {
+	ethread::UniqueLock lock(g_negotiationLock);
+	g_negotiationCache.clear();
+	g_negotiationCacheNext = 0;
+}
+
+void audio::drain::Process::setDither(enum audio::drain::dither _value) {
+	m_dither = _value;
+	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+		ememory::SharedPtr<audio::drain::FormatUpdate> format = ememory::dynamicPointerCast<audio::drain::FormatUpdate>(m_listAlgo[iii]);
+		if (    format != null
+		     && format->getTemporary() == true) {
+			format->setDither(m_dither);
+		}
+	}
+}
+
+etk::Vector<audio::drain::AlgoStatistic> audio::drain::Process::getStatistics() const {
+	// the audio thread does not swap the chain during the copy
+	ethread::UniqueLock lock(m_hotLock);
+	uint32_t generation = m_statisticGeneration.load(std::memory_order_relaxed);
+	etk::Vector<audio::drain::AlgoStatistic> out;
+	out.resize(m_statistic.size());
+	for (size_t iii=0; iii<m_statistic.size(); ++iii) {
+		out[iii].m_type = m_statistic[iii].m_type;
+		out[iii].m_name = m_statistic[iii].m_name;
+		m_statistic[iii].getSnapshot(out[iii], generation);
+	}
+	return out;
+}
+
+void audio::drain::Process::resetStatistics() {
+	// the counters are only written by the audio thread: it clears them at the next call of each algo
+	m_statisticGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t audio::drain::Process::getDotCycle(size_t& _hotId) const {
+	_hotId = m_listAlgo.size();
+	if (m_statisticEnable.load(std::memory_order_relaxed) == false) {
+		return 0;
+	}
+	uint32_t generation = m_statisticGeneration.load(std::memory_order_relaxed);
+	audio::drain::AlgoStatistic stat;
+	uint64_t out = 0;
+	uint64_t cycleMax = 0;
+	for (size_t iii=0; iii<m_statistic.size() && iii<m_listAlgo.size(); ++iii) {
+		m_statistic[iii].getSnapshot(stat, generation);
+		out += stat.m_cycleTotal;
+		if (stat.m_cycleTotal > cycleMax) {
+			cycleMax = stat.m_cycleTotal;
+			_hotId = iii;
+		}
+	}
+	return out;
+}
+
+void audio::drain::Process::generateDotStatistic(ememory::SharedPtr<etk::io::Interface>& _io, size_t _id, uint64_t _cycleTotal) {
+	if (    m_statisticEnable.load(std::memory_order_relaxed) == false
+	     || _id >= m_statistic.size()) {
+		return;
+	}
+	audio::drain::AlgoStatistic stat;
+	m_statistic[_id].getSnapshot(stat, m_statisticGeneration.load(std::memory_order_relaxed));
+	if (stat.m_nbCall == 0) {
+		return;
+	}
+	// written directly in the output: no string is built at each poll
+	double usByCycle = audio::drain::cpu::getCycleDuration() / 1000.0;
+	*_io << "\\ncall=" << stat.m_nbCall;
+	*_io << "\\ncycle/call=" << stat.m_cycleTotal / stat.m_nbCall;
+	*_io << " [" << stat.m_cycleMin << ".." << stat.m_cycleMax << "]";
+	if (stat.m_nbChunk != 0) {
+		*_io << "\\ncycle/chunk=" << float(stat.m_cycleTotal) / float(stat.m_nbChunk);
+	}
+	*_io << "\\ntime/period=" << float(double(stat.m_cycleLast) * usByCycle) << "us";
+	*_io << " [" << float(double(stat.m_cycleMin) * usByCycle) << ".." << float(double(stat.m_cycleMax) * usByCycle) << "]";
+	if (_cycleTotal != 0) {
+		*_io << "\\nload=" << float(double(stat.m_cycleTotal) * 100.0 / double(_cycleTotal)) << "%";
+	}
+	if (m_processBuffer[0].size() != 0) {
+		*_io << "\\nfill=" << float(double(stat.m_outputSizeMax) * 100.0 / double(m_processBuffer[0].size())) << "%";
+	}
+}
+
+etk::String audio::drain::Process::generateDotAlgo(ememory::SharedPtr<etk::io::Interface>& _io, int32_t _basicID, size_t _id, uint64_t _cycleTotal, size_t _hotId) {
+	etk::String out = "ALGO_" + etk::toString(_basicID) + "__" + etk::toString(_id);
+	*_io << "				" << out << " [label=\"" << m_listAlgo[_id]->getDotLabel();
+	generateDotStatistic(_io, _id, _cycleTotal);
+	*_io << "\"";
+	if (_id == _hotId) {
+		// the stage to look at first
+		*_io << ", color=red";
+	}
+	*_io << " ];\n";
+	return out;
+}
+
 void audio::drain::Process::removeAlgoDynamic() {
 	if (m_isConfigured == true) {
 		// chain is already unconfigured.
@@ -463,6 +1750,10 @@ void audio::drain::Process::generateDot(ememory::SharedPtr<etk::io::Interface>&
                                         etk::String& _nameIn,
                                         etk::String& _nameOut,
                                         bool _reserseGraph) {
+	// the audio thread does not swap the chain during the dump
+	ethread::UniqueLock lock(m_hotLock);
+	size_t hotId = 0;
+	uint64_t cycleTotal = getDotCycle(hotId);
 	*_io << "			subgraph clusterNode_" << _basicID << "_process {\n";
 	*_io << "				label=\"Drain::Process" << (_reserseGraph?"_R":"_N") << "\";\n";
 	*_io << "				node [shape=ellipse];\n";
@@ -487,16 +1778,7 @@ void audio::drain::Process::generateDot(ememory::SharedPtr<etk::io::Interface>&
 			if (m_listAlgo[iii] == null) {
 				continue;
 			}
-			etk::String connectStringSecond = "ALGO_" + etk::toString(_basicID) + "__" + etk::toString(iii);
-			*_io << "				" << connectStringSecond << " [label=\"ALGO\\ntype='" << m_listAlgo[iii]->getType() << "'";
-			if (m_listAlgo[iii]->getName() != "") {
-				*_io << "\\nname='" << m_listAlgo[iii]->getName() << "'";
-			}
-			etk::String tmpDesc = m_listAlgo[iii]->getDotDesc();
-			if (tmpDesc.size() != 0) {
-				*_io << tmpDesc;
-			}
-			*_io << "\" ];\n";
+			etk::String connectStringSecond = generateDotAlgo(_io, _basicID, iii, cycleTotal, hotId);
 			link(_io, connectString, "->", connectStringSecond);
 			connectString = connectStringSecond;
 		}
@@ -536,16 +1818,7 @@ void audio::drain::Process::generateDot(ememory::SharedPtr<etk::io::Interface>&
 			if (m_listAlgo[iii] == null) {
 				continue;
 			}
-			etk::String connectStringSecond = "ALGO_" + etk::toString(_basicID) + "__" + etk::toString(iii);
-			*_io << "				" << connectStringSecond << " [label=\"ALGO\\ntype='" << m_listAlgo[iii]->getType() << "'";
-			if (m_listAlgo[iii]->getName() != "") {
-				*_io << "\\nname='" << m_listAlgo[iii]->getName() << "'";
-			}
-			etk::String tmpDesc = m_listAlgo[iii]->getDotDesc();
-			if (tmpDesc.size() != 0) {
-				*_io << tmpDesc;
-			}
-			*_io << "\" ];\n";
+			etk::String connectStringSecond = generateDotAlgo(_io, _basicID, iii, cycleTotal, hotId);
 			//link(_io, connectStringSecond, "<-", connectString);
 			link(_io, connectString, "<-", connectStringSecond);
 			//link(_io, connectStringSecond, "->", connectString);
@@ -571,6 +1844,9 @@ void audio::drain::Process::generateDot(ememory::SharedPtr<etk::io::Interface>&
 }
 
 void audio::drain::Process::generateDotProcess(ememory::SharedPtr<etk::io::Interface>& _io, int32_t _offset, int32_t _basicID, etk::String& _nameIn, etk::String& _nameOut, bool _reserseGraph) {
+	ethread::UniqueLock lock(m_hotLock);
+	size_t hotId = 0;
+	uint64_t cycleTotal = getDotCycle(hotId);
 	*_io << "			subgraph clusterNode_" << _basicID << "_process {\n";
 	*_io << "				label=\"Drain::Process" << (_reserseGraph?"_R":"_N") << "\";\n";
 	*_io << "				node [shape=ellipse];\n";
@@ -593,16 +1869,7 @@ void audio::drain::Process::generateDotProcess(ememory::SharedPtr<etk::io::Inter
 			if (m_listAlgo[iii] == null) {
 				continue;
 			}
-			etk::String connectStringSecond = "ALGO_" + etk::toString(_basicID) + "__" + etk::toString(iii);
-			*_io << "				" << connectStringSecond << " [label=\"ALGO\\ntype='" << m_listAlgo[iii]->getType() << "'";
-			if (m_listAlgo[iii]->getName() != "") {
-				*_io << "\\nname='" << m_listAlgo[iii]->getName() << "'";
-			}
-			etk::String tmpDesc = m_listAlgo[iii]->getDotDesc();
-			if (tmpDesc.size() != 0) {
-				*_io << tmpDesc;
-			}
-			*_io << "\" ];\n";
+			etk::String connectStringSecond = generateDotAlgo(_io, _basicID, iii, cycleTotal, hotId);
 			link(_io, connectString, "->", connectStringSecond);
 			connectString = connectStringSecond;
 		}
@@ -612,16 +1879,7 @@ void audio::drain::Process::generateDotProcess(ememory::SharedPtr<etk::io::Inter
 			if (m_listAlgo[iii] == null) {
 				continue;
 			}
-			etk::String connectStringSecond = "ALGO_" + etk::toString(_basicID) + "__" + etk::toString(iii);
-			*_io << "				" << connectStringSecond << " [label=\"ALGO\\ntype='" << m_listAlgo[iii]->getType() << "'";
-			if (m_listAlgo[iii]->getName() != "") {
-				*_io << "\\nname='" << m_listAlgo[iii]->getName() << "'";
-			}
-			etk::String tmpDesc = m_listAlgo[iii]->getDotDesc();
-			if (tmpDesc.size() != 0) {
-				*_io << tmpDesc;
-			}
-			*_io << "\" ];\n";
+			etk::String connectStringSecond = generateDotAlgo(_io, _basicID, iii, cycleTotal, hotId);
 			link(_io, connectStringSecond, "<-", connectString);
 			connectString = connectStringSecond;
 		}
@@ -656,3 +1914,65 @@ void audio::drain::Process::generateStatus(const etk::String& _origin, const etk
 void audio::drain::Process::setStatusFunction(statusFunction _newFunction) {
 	m_statusFunction = _newFunction;
 }
+
+void audio::drain::Process::setStatusEventFunction(statusEventFunction _newFunction) {
+	m_statusEventFunction = _newFunction;
+}
+
+void audio::drain::Process::setStatusQueue(bool _value, const audio::Duration& _minInterval) {
+	m_statusQueue.setMinInterval(_minInterval);
+	m_statusQueue.setEnable(_value);
+}
+
+etk::String audio::drain::Process::getStatusOrigin(const audio::drain::Algo* _origin) const {
+	for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+		if (m_listAlgo[iii].get() != _origin) {
+			continue;
+		}
+		if (m_listAlgo[iii]->getName().size() == 0) {
+			return m_listAlgo[iii]->getType();
+		}
+		return m_listAlgo[iii]->getName();
+	}
+	return "unknow";
+}
+
+void audio::drain::Process::reportStatus(const etk::String& _origin, enum audio::drain::status _status, uint32_t _count) {
+	if (m_statusEventFunction != null) {
+		m_statusEventFunction(_origin, _status, _count);
+	} else {
+		generateStatus(_origin, audio::drain::getStatusName(_status));
+	}
+}
+
+size_t audio::drain::Process::flushStatus() {
+	etk::Vector<audio::drain::StatusReport> listReport;
+	{
+		// the audio thread does not swap the chain while the origins are searched (the user functions are called after: they can read the chain)
+		ethread::UniqueLock lock(m_hotLock);
+		audio::drain::StatusEvent event;
+		while (m_statusQueue.pop(event) == true) {
+			listReport.pushBack(audio::drain::StatusReport(getStatusOrigin(event.m_origin), event.m_status, event.m_count));
+		}
+		// occurences coalesced and not posted in the min interval
+		for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+			if (m_listAlgo[iii] == null) {
+				continue;
+			}
+			for (size_t jjj=0; jjj<audio::drain::status_count; ++jjj) {
+				uint32_t count = m_listAlgo[iii]->takeStatusPending(static_cast<enum audio::drain::status>(jjj));
+				if (count != 0) {
+					listReport.pushBack(audio::drain::StatusReport(getStatusOrigin(m_listAlgo[iii].get()), static_cast<enum audio::drain::status>(jjj), count));
+				}
+			}
+		}
+	}
+	for (size_t iii=0; iii<listReport.size(); ++iii) {
+		reportStatus(listReport[iii].m_origin, listReport[iii].m_status, listReport[iii].m_count);
+	}
+	uint32_t nbDrop = m_statusQueue.takeNbDrop();
+	if (nbDrop != 0) {
+		DRAIN_WARNING("Status queue full: " << nbDrop << " events lost");
+	}
+	return listReport.size();
+}
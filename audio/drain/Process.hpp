@@ -11,15 +11,147 @@
 #include <audio/format.hpp>
 #include <audio/channel.hpp>
 #include <audio/drain/Algo.hpp>
+#include <audio/drain/CircularBuffer.hpp>
+#include <audio/drain/AlgoPool.hpp>
+#include <audio/drain/Metric.hpp>
+#include <audio/drain/FormatUpdate.hpp>
 #include <echrono/Steady.hpp>
 #include <ememory/memory.hpp>
+#include <etk/Map.hpp>
+#include <ethread/Mutex.hpp>
+#include <ethread/Semaphore.hpp>
+#include <ethread/Thread.hpp>
+#include <atomic>
 
 namespace audio {
 	namespace drain{
 		typedef etk::Function<void (const etk::String& _origin, const etk::String& _status)> statusFunction;
+		typedef etk::Function<void (const etk::String& _origin, enum audio::drain::status _status, uint32_t _count)> statusEventFunction;
+		/**
+		 * @brief Get a unique id of a type (compared without RTTI).
+		 * @return Address unique for the type.
+		 */
+		template<typename T> const void* getTypeId() {
+			static const char id = 0;
+			return &id;
+		}
+		/**
+		 * @brief Stable reference on an algo pushed in a Process (@see Process::pushBack).
+		 * It is not changed by the negotiation: the lookup is a direct access in a table, no string compare and no cast.
+		 */
+		template<typename T> class AlgoHandle {
+			public:
+				int32_t m_id; //!< Id in the handle table of the Process (-1: invalid)
+				AlgoHandle(int32_t _id=-1) :
+				  m_id(_id) {
+					
+				}
+				/**
+				 * @brief Check if the handle reference an algo.
+				 * @return true if the handle is valid.
+				 */
+				bool isValid() const {
+					return m_id >= 0;
+				}
+		};
+		/**
+		 * @brief Handle of an algo found by its name, kept by the caller between the calls of Process::get (@see Process::get).
+		 * The name is resolved again only when the handles or the names changed since the last call (push, remove, hot change, setName).
+		 */
+		template<typename T> class AlgoNameCache {
+			public:
+				etk::String m_name; //!< Name of the algo
+				audio::drain::AlgoHandle<T> m_handle; //!< Handle of the algo (invalid: not found or temporary algo)
+				uint32_t m_revision; //!< Revision of the handles of the Process at the resolution (0: never resolved)
+				uint32_t m_nameRevision; //!< Revision of the names of the algos at the resolution
+				AlgoNameCache(const etk::String& _name) :
+				  m_name(_name),
+				  m_revision(0),
+				  m_nameRevision(0) {
+					
+				}
+		};
+		/**
+		 * @brief Profiling of one algo of a Process (@see audio::drain::cpu::getCycle for the cycle unit).
+		 * @note Copy of the counters (plain values, read by the monitoring).
+		 */
+		class AlgoStatistic {
+			public:
+				etk::String m_type; //!< Type of the algo
+				etk::String m_name; //!< Name of the algo
+				uint64_t m_nbCall; //!< Number of process call
+				uint64_t m_nbChunk; //!< Number of input chunk processed
+				uint64_t m_cycleTotal; //!< Total cycle used in the process call
+				uint64_t m_cycleMin; //!< Faster process call
+				uint64_t m_cycleMax; //!< Slower process call
+				uint64_t m_cycleLast; //!< Cycle used by the last process call
+				size_t m_outputSizeMax; //!< Biggest output of a process call in byte (fill of the buffers of the chain)
+				AlgoStatistic() {
+					reset();
+				}
+				/**
+				 * @brief Clear all the counters.
+				 */
+				void reset() {
+					m_nbCall = 0;
+					m_nbChunk = 0;
+					m_cycleTotal = 0;
+					m_cycleMin = 0;
+					m_cycleMax = 0;
+					m_cycleLast = 0;
+					m_outputSizeMax = 0;
+				}
+		};
+		/**
+		 * @brief Live profiling of one algo: written by the audio thread with relaxed atomics, read at any time
+		 * by a control thread with getSnapshot (no lock, no wait on the audio thread).
+		 * A reset is only requested by the control thread (new generation): the audio thread clears the counters at the next call.
+		 * @note The counters are independent: a snapshot is not an atomic view of all of them.
+		 */
+		class AlgoStatisticCounter {
+			public:
+				etk::String m_type; //!< Type of the algo (set at the configuration, not changed by the audio thread)
+				etk::String m_name; //!< Name of the algo (set at the configuration, not changed by the audio thread)
+			protected:
+				std::atomic<uint32_t> m_generation; //!< Reset generation of the counters
+				std::atomic<uint64_t> m_nbCall; //!< Number of process call
+				std::atomic<uint64_t> m_nbChunk; //!< Number of input chunk processed
+				std::atomic<uint64_t> m_cycleTotal; //!< Total cycle
+				std::atomic<uint64_t> m_cycleMin; //!< Faster process call
+				std::atomic<uint64_t> m_cycleMax; //!< Slower process call
+				std::atomic<uint64_t> m_cycleLast; //!< Last process call
+				std::atomic<uint64_t> m_outputSizeMax; //!< Biggest output in byte
+			public:
+				AlgoStatisticCounter();
+				AlgoStatisticCounter(const AlgoStatisticCounter& _obj);
+				AlgoStatisticCounter& operator=(const AlgoStatisticCounter& _obj);
+				/**
+				 * @brief Clear all the counters (only when the audio thread does not use them: configuration).
+				 * @param[in] _generation Current reset generation of the Process.
+				 */
+				void reset(uint32_t _generation);
+				/**
+				 * @brief Add a process call (audio thread only).
+				 * @param[in] _generation Current reset generation of the Process (the counters are cleared when it changed).
+				 * @param[in] _cycle Cycle used by the call.
+				 * @param[in] _nbChunk Number of input chunk processed.
+				 * @param[in] _outputSize Size of the output in byte.
+				 */
+				void add(uint32_t _generation, uint64_t _cycle, size_t _nbChunk, size_t _outputSize);
+				/**
+				 * @brief Get a copy of the counters (the type and the name are not copied: no allocation).
+				 * @param[out] _out Counters.
+				 * @param[in] _generation Current reset generation of the Process (cleared counters when it changed).
+				 */
+				void getSnapshot(audio::drain::AlgoStatistic& _out, uint32_t _generation) const;
+		};
 		class Process {
 			protected:
-				etk::Vector<int8_t> m_data; //!< temporary overlap output buffer (change size of the output data)
+				audio::drain::CircularBuffer m_data; //!< residual output data of the previous pull (change size of the output data)
+				audio::drain::AlignedBuffer m_processBuffer[2]; //!< ping-pong buffers shared by all the algos of the chain (aligned on 64 bytes)
+				size_t m_processBufferNbChunk; //!< Number of input chunk that the ping-pong buffers can manage in one process call
+				void* m_finalBuffer; //!< Buffer where the last algo can write its output (set during a pull)
+				size_t m_finalBufferSize; //!< Size in byte of m_finalBuffer
 			public:
 				Process();
 				virtual ~Process();
@@ -41,6 +173,8 @@ namespace audio {
 				 * @param[in] _data Pointer on the data pushed.
 				 * @param[in,out] _nbChunk Number of chunk present in the pointer (set at the number of chunk requested(hope)).
 				 * @param[out] _chunkSize size of a single chunk. TODO : Not needed ... Remove it ...
+				 * @note Does not allocate memory when the residual data fit in the process buffer size (@see setProcessBufferSize).
+				 * @note With the pipeline (@see startPipeline), only copy the periods computed in advance (the missing chunks are set at 0).
 				 * @return true The procress is done corectly.
 				 * @return false An error occured.
 				 */
@@ -48,6 +182,43 @@ namespace audio {
 				          void* _data,
 				          size_t _nbChunk,
 				          size_t _chunkSize);
+			protected:
+				/**
+				 * @brief Compute the data of a pull in the calling thread.
+				 * @param[in] _time Time of the first sample requested.
+				 * @param[in] _data Pointer on the output data.
+				 * @param[in] _nbChunk Number of chunk requested.
+				 * @param[in] _chunkSize size of a single chunk.
+				 * @param[out] _nbChunkDone Number of chunk written in _data (less than _nbChunk when the chain has no more data).
+				 * @param[out] _silence All the chunks written are 0 (residual data included).
+				 * @return true The procress is done corectly.
+				 * @return false An error occured.
+				 */
+				bool pullDirect(audio::Time& _time,
+				                void* _data,
+				                size_t _nbChunk,
+				                size_t _chunkSize,
+				                size_t& _nbChunkDone,
+				                bool& _silence);
+				bool m_dataSilence; //!< The residual data of m_data contain only 0
+				size_t m_pullNbChunk; //!< Number of chunk written by the last pull
+				bool m_pullSilence; //!< All the chunks written by the last pull are 0
+			public:
+				/**
+				 * @brief Get the number of chunk written by the last pull (the end of the buffer is not set when the chain has no more data).
+				 * @return Number of chunk.
+				 */
+				size_t getPullNbChunk() const {
+					return m_pullNbChunk;
+				}
+				/**
+				 * @brief Check if the data of the last pull are silent (residual data of the previous pull included).
+				 * @return true All the chunks written by the last pull are 0.
+				 */
+				bool getPullSilence() const {
+					return m_pullSilence;
+				}
+			public:
 				/**
 				 * @brief Push data in the algo stream.
 				 * @param[in] _time Time of the first sample pushed.
@@ -74,32 +245,402 @@ namespace audio {
 				               size_t _inNbChunk,
 				               void* _outData,
 				               size_t _outNbChunk);
+			protected:
+				size_t m_batchTileNbChunk; //!< Number of input chunk of a tile of processBatch (0: sized on the cache)
+			public:
+				/**
+				 * @brief Process a big block of data (offline transcode, memory mapped file ...) by tiles.
+				 * Each tile is processed in the whole chain before the next one: its data stay in the cache between the algos
+				 * and the per-call overhead is paid once by tile instead of once by period.
+				 * @param[in] _time Time of the first sample of the block (the time of each tile is deduced from the input frequency).
+				 * @param[in] _data Input data (read-only, never modified).
+				 * @param[in] _nbChunk Number of chunk of the block (no limit).
+				 * @param[in] _output Function called with the output of each tile (data valid only during the call).
+				 * @return true The procress is done corectly.
+				 * @return false An error occured (the next tiles are not processed).
+				 */
+				bool processBatch(const audio::Time& _time,
+				                  const void* _data,
+				                  size_t _nbChunk,
+				                  const etk::Function<void (const audio::Time& _time, const void* _data, size_t _nbChunk)>& _output);
+				/**
+				 * @brief Set the number of input chunk of a tile of processBatch.
+				 * @param[in] _nbChunk Number of chunk (0: the tile and the ping-pong buffers fit in a 256kB cache, limited by the process buffer size).
+				 */
+				void setBatchTileSize(size_t _nbChunk) {
+					m_batchTileNbChunk = _nbChunk;
+				}
+				/**
+				 * @brief Get the number of input chunk of a tile of processBatch (resolved with the current configuration).
+				 * @return Number of chunk.
+				 */
+				size_t getBatchTileSize() const;
+				/**
+				 * @brief Set the maximum number of input chunk processed in one call without allocation (default 4096).
+				 * @note Bigger process call are done with the internal buffer of each algo.
+				 * @param[in] _nbChunk Number of chunk.
+				 */
+				void setProcessBufferSize(size_t _nbChunk);
+				/**
+				 * @brief Get the maximum number of input chunk processed in one call without allocation.
+				 * @return Number of chunk.
+				 */
+				size_t getProcessBufferSize() const {
+					return m_processBufferNbChunk;
+				}
+			protected:
+				bool m_lowLatency; //!< The pull request only the data needed by the output (no minimum size of process)
+			public:
+				/**
+				 * @brief Set the low latency mode: a pull process exactly the requested period (no minimum of 128 and 32 chunks).
+				 * @note The native resampler request the exact input needed ==> the delay of the chain stay constant.
+				 * @param[in] _value New state (disable by default).
+				 */
+				void setLowLatency(bool _value) {
+					m_lowLatency = _value;
+				}
+				/**
+				 * @brief Get the low latency mode.
+				 * @return true if the low latency mode is enable.
+				 */
+				bool getLowLatency() const {
+					return m_lowLatency;
+				}
+				/**
+				 * @brief Get the total delay of the chain: delay of each algo (@see audio::drain::Algo::getLatency),
+				 * data waiting in the endpoint buffers, data kept for the next pull and periods computed in advance by the pipeline.
+				 * @return Delay between the input and the output of the chain.
+				 */
+				audio::Duration getLatency();
+			protected:
+				ethread::Thread* m_pipelineThread; //!< Thread that compute the next periods (null when the pipeline is stopped)
+				ethread::Semaphore* m_pipelineWakeUp; //!< Timed wait of the pipeline thread (posted only by stopPipeline)
+				std::atomic<bool> m_pipelineRead; //!< A period is read (set by the pull, polled by the pipeline thread: no mutex in the audio thread)
+				std::atomic<bool> m_pipelineEnable; //!< The pull only read the periods computed by the pipeline thread
+				std::atomic<bool> m_pipelineStop; //!< Request the pipeline thread to stop
+				audio::drain::CircularBuffer m_pipelineData; //!< Periods ready to be read (single producer / single consumer)
+				audio::drain::AlignedBuffer m_pipelineBuffer; //!< Period computed when the free space of m_pipelineData is not contiguous
+				size_t m_pipelineNbChunk; //!< Number of chunk of a period computed by the pipeline thread
+				audio::Time m_pipelineTime; //!< Time of the first period computed by the pipeline thread
+				std::atomic<uint64_t> m_pipelineUnderrun; //!< Number of pull that do not find all their data ready
+			public:
+				/**
+				 * @brief Start the pipelined pull: a thread compute the next periods in advance, and the pull only copy them.
+				 * The chain process leave the critical path of the audio callback, for a latency of _depth periods.
+				 * @note Call it from the control thread when the stream is stopped. The chain is then processed only by the pipeline
+				 * thread: the modifications while it run must use the parameters of the algos or the hot update (@see hotPrepare).
+				 * @param[in] _depth Number of period computed in advance (at least 1).
+				 * @param[in] _nbChunk Number of chunk of a period.
+				 * @param[in] _time Time of the first period.
+				 * @return true The pipeline is started.
+				 * @return false An error occured (the pull stay direct).
+				 */
+				bool startPipeline(size_t _depth, size_t _nbChunk, const audio::Time& _time);
+				/**
+				 * @brief Stop the pipelined pull (the periods computed in advance are dropped).
+				 * @note Call it from the control thread when the stream is stopped.
+				 */
+				void stopPipeline();
+				/**
+				 * @brief Get the state of the pipelined pull.
+				 * @return true if the pull read the periods computed by the pipeline thread.
+				 */
+				bool getPipelineEnable() const {
+					return m_pipelineEnable.load(std::memory_order_acquire);
+				}
+				/**
+				 * @brief Get the number of chunk computed in advance and not read.
+				 * @return Number of chunk.
+				 */
+				size_t getPipelineSize() const {
+					return m_pipelineData.getSize();
+				}
+				/**
+				 * @brief Get the number of pull that do not find all their data ready (the missing chunks are set at 0).
+				 * @return Number of underrun since the start of the pipeline.
+				 */
+				uint64_t getPipelineUnderrun() const {
+					return m_pipelineUnderrun.load(std::memory_order_relaxed);
+				}
+			protected:
+				/**
+				 * @brief Main loop of the pipeline thread.
+				 */
+				void pipelineCallback();
+			protected:
+				bool m_flushDenormal; //!< The denormal floats are flushed to zero during the process
+			public:
+				/**
+				 * @brief Flush the denormal floats to zero on the calling thread during the process (FTZ/DAZ on x86, FZ on ARM).
+				 * The previous state of the float unit is restored at the end of each process call.
+				 * @note Prevent the CPU spikes of the IIR filters and the ramps when the stream become silent (disable by default).
+				 * @param[in] _value New state.
+				 */
+				void setFlushDenormal(bool _value) {
+					m_flushDenormal = _value;
+				}
+				/**
+				 * @brief Get the denormal flush mode.
+				 * @return true if the denormal floats are flushed during the process.
+				 */
+				bool getFlushDenormal() const {
+					return m_flushDenormal;
+				}
+			protected:
+				enum audio::drain::dither m_dither; //!< Dither of the FormatUpdate added by the negotiation
+			public:
+				/**
+				 * @brief Set the dither used when the chain requantize in int16_t (float or int32_t to int16_t).
+				 * The FormatUpdate applied it in the conversion, and a Volume is no more fused with such a FormatUpdate.
+				 * @note Set it before the configuration of the chain: a configured chain only update the dither of its FormatUpdate.
+				 * @param[in] _value New dither (disable by default).
+				 */
+				void setDither(enum audio::drain::dither _value);
+				/**
+				 * @brief Get the dither used when the chain requantize in int16_t.
+				 * @return Current dither.
+				 */
+				enum audio::drain::dither getDither() const {
+					return m_dither;
+				}
+			protected:
+				bool m_silenceDetection; //!< Scan the input of the chain to detect the silence
+				bool m_silence; //!< The data of the current stage contain only 0
+			public:
+				/**
+				 * @brief Enable the detection of the silent input (scan of the input of the chain, or of the output of the endpoint).
+				 * The silent buffers are marked along the chain: the stateless algos generate the silence without
+				 * processing and the algos with a memory skip their kernels when their tail is finished.
+				 * @param[in] _value New state (disable by default).
+				 */
+				void setSilenceDetection(bool _value) {
+					m_silenceDetection = _value;
+				}
+				/**
+				 * @brief Get the state of the silence detection.
+				 * @return true if the input of the chain is scanned.
+				 */
+				bool getSilenceDetection() const {
+					return m_silenceDetection;
+				}
+				/**
+				 * @brief Check if the output of the last process call is silent.
+				 * @return true All the output samples are 0.
+				 */
+				bool getOutputSilence() const {
+					return m_silence;
+				}
+			protected:
+				std::atomic<bool> m_statisticEnable; //!< Profiling of the algos is enable
+				std::atomic<uint32_t> m_statisticGeneration; //!< Reset generation of the profiling (@see resetStatistics)
+				etk::Vector<audio::drain::AlgoStatisticCounter> m_statistic; //!< Profiling of each algo (same order as m_listAlgo)
+			public:
+				/**
+				 * @brief Enable the profiling of each algo of the chain (disable by default).
+				 * @param[in] _value New state.
+				 */
+				void setStatisticEnable(bool _value) {
+					m_statisticEnable.store(_value, std::memory_order_relaxed);
+				}
+				/**
+				 * @brief Get the state of the profiling.
+				 * @return true if the profiling is enable.
+				 */
+				bool getStatisticEnable() const {
+					return m_statisticEnable.load(std::memory_order_relaxed);
+				}
+				/**
+				 * @brief Get a copy of the profiling of each algo of the chain (in the order of the chain).
+				 * @return List of the statistics.
+				 */
+				etk::Vector<audio::drain::AlgoStatistic> getStatistics() const;
+				/**
+				 * @brief Clear the profiling counters (applied by the audio thread at the next call of each algo).
+				 */
+				void resetStatistics();
+			protected:
+				audio::drain::ProcessMetric m_metric; //!< Live counters of the process calls (always updated)
+			public:
+				/**
+				 * @brief Get the live counters of the chain: processing time of each period vs duration of its data (can be called from any thread).
+				 * @note The counters of the buffers are in the end-points (@see audio::drain::EndPoint::getMetric).
+				 * @param[out] _snapshot Copy of the counters.
+				 */
+				void getMetric(audio::drain::ProcessMetricSnapshot& _snapshot) const {
+					m_metric.getSnapshot(_snapshot);
+				}
+				/**
+				 * @brief Clear the live counters of the chain.
+				 */
+				void resetMetric() {
+					m_metric.reset();
+				}
+				/**
+				 * @brief Add a period in the live counters (a scheduler that calls processStage directly call it at the end of the period).
+				 * @param[in] _duration Processing time of the period (ns).
+				 * @param[in] _nbChunk Number of input chunk of the period (its duration is the deadline).
+				 */
+				void addMetricPeriod(uint64_t _duration, size_t _nbChunk);
 			protected:
 				IOFormatInterface m_inputConfig;
 			public:
 				const IOFormatInterface& getInputConfig() const {
 					return m_inputConfig;
 				}
-				void setInputConfig(const IOFormatInterface& _interface) {
-					m_inputConfig = _interface;
-				}
+				/**
+				 * @brief Set the format of the input of the chain.
+				 * @param[in] _interface New format (a change remove the algos of the negotiation: the chain is negotiated again at the next updateInterAlgo).
+				 */
+				void setInputConfig(const IOFormatInterface& _interface);
 			protected:
 				IOFormatInterface m_outputConfig;
 			public:
 				const IOFormatInterface& getOutputConfig() const {
 					return m_outputConfig;
 				}
-				void setOutputConfig(const IOFormatInterface& _interface) {
-					m_outputConfig = _interface;
-				}
+				/**
+				 * @brief Set the format of the output of the chain.
+				 * @param[in] _interface New format (a change remove the algos of the negotiation: the chain is negotiated again at the next updateInterAlgo).
+				 */
+				void setOutputConfig(const IOFormatInterface& _interface);
+			protected:
+				/**
+				 * @brief Remove the algos added by the negotiation (the algos of the user are kept).
+				 */
+				void resetNegotiation();
 			protected:
 				etk::Vector<ememory::SharedPtr<drain::Algo> > m_listAlgo;
+				ememory::SharedPtr<audio::drain::AlgoPool> m_algoPool; //!< Pool of the temporary algos (null: always allocate them)
+			public:
+				/**
+				 * @brief Set the pool where the temporary algos are taken and given back (none by default).
+				 * @param[in] _pool Pool to use (can be shared with other Process, null to disable).
+				 */
+				void setAlgoPool(const ememory::SharedPtr<audio::drain::AlgoPool>& _pool) {
+					m_algoPool = _pool;
+				}
+				/**
+				 * @brief Get the pool of the temporary algos.
+				 * @return The pool (null if none).
+				 */
+				const ememory::SharedPtr<audio::drain::AlgoPool>& getAlgoPool() const {
+					return m_algoPool;
+				}
+			protected:
+				/**
+				 * @brief Get a temporary algo (from the pool if any) connected to the status of this Process.
+				 * @param[in] _type Type of the algo.
+				 * @return The algo (null if the type is unknown).
+				 */
+				ememory::SharedPtr<audio::drain::Algo> createTemporaryAlgo(const etk::String& _type);
+				/**
+				 * @brief Give back a temporary algo removed of the chain.
+				 * @param[in] _algo Algo removed (ignored if it is not a temporary algo).
+				 */
+				void releaseTemporaryAlgo(const ememory::SharedPtr<audio::drain::Algo>& _algo);
+				etk::Vector<size_t> m_activeAlgo; //!< Id (in m_listAlgo) of the algos called by the process (the pass-through algos are removed)
+				uint64_t m_topologyKey; //!< Hash of the active algos and their formats
+			public:
+				/**
+				 * @brief Get the hash of the configured chain (two chains with the same key execute the same kernels).
+				 * @return Key of the chain (valid after updateInterAlgo).
+				 */
+				uint64_t getTopologyKey() const {
+					return m_topologyKey;
+				}
+				/**
+				 * @brief Get the number of algos really called by the process.
+				 * @return Number of active algo (valid after updateInterAlgo).
+				 */
+				size_t getActiveAlgoCount() const {
+					return m_activeAlgo.size();
+				}
+				/**
+				 * @brief Execute a single active algo of the chain (used to interleave the execution of several chains).
+				 * @param[in] _activeId Id of the algo in the active algos (< getActiveAlgoCount()).
+				 * @param[in] _time Time of the first sample.
+				 * @param[in,out] _data Input data, set at the output data.
+				 * @param[in,out] _nbChunk Input number of chunk, set at the output number of chunk.
+				 * @return true The procress is done corectly.
+				 * @return false An error occured.
+				 */
+				bool processStage(size_t _activeId,
+				                  audio::Time& _time,
+				                  void*& _data,
+				                  size_t& _nbChunk);
+			protected:
+				etk::Vector<ememory::SharedPtr<drain::Algo>> m_handleAlgo; //!< Algos pushed by the user (id: handle, null when removed)
+				etk::Vector<const void*> m_handleType; //!< Static type of each handle (@see getTypeId)
+				mutable etk::Map<etk::String, int32_t> m_handleName; //!< Handle of the first algo pushed with each name
+				mutable uint32_t m_handleNameRevision; //!< Revision of the names of the algos (@see Algo::getNameRevision) used to build m_handleName
+				std::atomic<uint32_t> m_handleRevision; //!< Incremented at each change of the handle table (invalidate the AlgoNameCache, start at 1)
+				/**
+				 * @brief Add an algo in the chain and in the handle table.
+				 * @param[in] _algo Algo to add.
+				 * @param[in] _typeId Static type of the algo.
+				 * @param[in] _front Add at the start of the chain.
+				 * @return Id of the handle.
+				 */
+				int32_t addAlgo(ememory::SharedPtr<drain::Algo> _algo, const void* _typeId, bool _front);
+				/**
+				 * @brief Add an algo in the handle table.
+				 * @param[in] _algo Algo added in the chain.
+				 * @param[in] _typeId Static type of the algo.
+				 * @return Id of the handle.
+				 */
+				int32_t addHandle(const ememory::SharedPtr<drain::Algo>& _algo, const void* _typeId);
+				/**
+				 * @brief Remove an algo of the handle table (its handle stay invalid).
+				 * @param[in] _algo Algo removed of the chain.
+				 */
+				void removeHandle(const ememory::SharedPtr<drain::Algo>& _algo);
+				/**
+				 * @brief Build m_handleName from the current names of the algos of the handle table.
+				 */
+				void updateHandleName() const;
+				/**
+				 * @brief Get the handle of the first algo pushed with a name (the index is rebuilt after a setName on an algo).
+				 * @param[in] _name Name of the algo.
+				 * @return Id of the handle (-1 if not found).
+				 */
+				int32_t findHandle(const etk::String& _name) const;
 			public:
-				void pushBack(ememory::SharedPtr<drain::Algo> _algo);
-				void pushFront(ememory::SharedPtr<drain::Algo> _algo);
+				void pushBack(ememory::SharedPtr<drain::Algo> _algo) {
+					addAlgo(_algo, audio::drain::getTypeId<drain::Algo>(), false);
+				}
+				void pushFront(ememory::SharedPtr<drain::Algo> _algo) {
+					addAlgo(_algo, audio::drain::getTypeId<drain::Algo>(), true);
+				}
+				/**
+				 * @brief Add an algo at the end of the chain.
+				 * @param[in] _algo Algo to add.
+				 * @return Handle of the algo (valid until clear, for any modification of the chain).
+				 */
+				template<typename T> audio::drain::AlgoHandle<T> pushBack(const ememory::SharedPtr<T>& _algo) {
+					return audio::drain::AlgoHandle<T>(addAlgo(_algo, audio::drain::getTypeId<T>(), false));
+				}
+				/**
+				 * @brief Add an algo at the start of the chain.
+				 * @param[in] _algo Algo to add.
+				 * @return Handle of the algo (valid until clear, for any modification of the chain).
+				 */
+				template<typename T> audio::drain::AlgoHandle<T> pushFront(const ememory::SharedPtr<T>& _algo) {
+					return audio::drain::AlgoHandle<T>(addAlgo(_algo, audio::drain::getTypeId<T>(), true));
+				}
 				void clear() {
+					stopPipeline();
+					hotClear();
 					m_isConfigured = false;
+					for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
+						releaseTemporaryAlgo(m_listAlgo[iii]);
+					}
 					m_listAlgo.clear();
+					m_activeAlgo.clear();
+					m_topologyKey = 0;
+					m_handleAlgo.clear();
+					m_handleType.clear();
+					m_handleName.clear();
+					m_handleRevision.fetch_add(1, std::memory_order_release);
 				}
 				size_t size() {
 					return m_listAlgo.size();
@@ -113,8 +654,67 @@ namespace audio {
 				ememory::SharedPtr<drain::Algo> operator[](int32_t _id) {
 					return m_listAlgo[_id];
 				}
-				
+				/**
+				 * @brief Get the handle of an algo pushed in the chain (resolve it once, then use get with the handle).
+				 * @param[in] _name Name of the algo (the first algo pushed with this name).
+				 * @return Handle of the algo (invalid if not found or not a T).
+				 */
+				template<typename T> audio::drain::AlgoHandle<T> getHandle(const etk::String& _name) {
+					int32_t id = findHandle(_name);
+					if (id < 0) {
+						return audio::drain::AlgoHandle<T>();
+					}
+					if (    m_handleType[id] != audio::drain::getTypeId<T>()
+					     && ememory::dynamicPointerCast<T>(m_handleAlgo[id]) == null) {
+						return audio::drain::AlgoHandle<T>();
+					}
+					return audio::drain::AlgoHandle<T>(id);
+				}
+				/**
+				 * @brief Get an algo with its handle (no string compare, no cast).
+				 * @param[in] _handle Handle given by this Process.
+				 * @return The algo (null if the handle is invalid or the algo is removed).
+				 */
+				template<typename T> ememory::SharedPtr<T> get(const audio::drain::AlgoHandle<T>& _handle) {
+					if (    _handle.m_id < 0
+					     || _handle.m_id >= int32_t(m_handleAlgo.size())) {
+						return ememory::SharedPtr<T>();
+					}
+					// the type is checked at the creation of the handle
+					return ememory::staticPointerCast<T>(m_handleAlgo[_handle.m_id]);
+				}
+				/**
+				 * @brief Get an algo with its name, resolved once in the cache of the caller (no lock and no string compare while the chain does not change).
+				 * @param[in,out] _cache Name of the algo and its handle found at the previous call.
+				 * @return The algo (null if not found or not a T).
+				 */
+				template<typename T> ememory::SharedPtr<T> get(audio::drain::AlgoNameCache<T>& _cache) {
+					uint32_t revision = m_handleRevision.load(std::memory_order_acquire);
+					uint32_t nameRevision = audio::drain::Algo::getNameRevision();
+					if (    _cache.m_revision != revision
+					     || _cache.m_nameRevision != nameRevision) {
+						ethread::UniqueLock lock(m_hotLock);
+						_cache.m_handle = getHandle<T>(_cache.m_name);
+						_cache.m_revision = revision;
+						_cache.m_nameRevision = nameRevision;
+					}
+					if (_cache.m_handle.isValid() == false) {
+						// temporary algos added by the negotiation are not in the handle table
+						return get<T>(_cache.m_name);
+					}
+					return get(_cache.m_handle);
+				}
 				template<typename T> ememory::SharedPtr<T> get(const etk::String& _name) {
+					// the audio thread does not swap the chain during the search
+					ethread::UniqueLock lock(m_hotLock);
+					int32_t id = findHandle(_name);
+					if (id >= 0) {
+						if (m_handleType[id] == audio::drain::getTypeId<T>()) {
+							return ememory::staticPointerCast<T>(m_handleAlgo[id]);
+						}
+						return ememory::dynamicPointerCast<T>(m_handleAlgo[id]);
+					}
+					// temporary algos added by the negotiation
 					for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
 						if (m_listAlgo[iii] == null) {
 							continue;
@@ -126,6 +726,14 @@ namespace audio {
 					return ememory::SharedPtr<T>();
 				}
 				template<typename T> ememory::SharedPtr<const T> get(const etk::String& _name) const {
+					ethread::UniqueLock lock(m_hotLock);
+					int32_t id = findHandle(_name);
+					if (id >= 0) {
+						if (m_handleType[id] == audio::drain::getTypeId<T>()) {
+							return ememory::staticPointerCast<const T>(m_handleAlgo[id]);
+						}
+						return ememory::dynamicPointerCast<const T>(m_handleAlgo[id]);
+					}
 					for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
 						if (m_listAlgo[iii] == null) {
 							continue;
@@ -143,6 +751,7 @@ namespace audio {
 					if (m_listAlgo.size() > 0) {
 						ememory::SharedPtr<T> algoEP = get<T>(0);
 						if (algoEP != null) {
+							removeHandle(m_listAlgo[0]);
 							m_listAlgo.erase(m_listAlgo.begin());
 						}
 					}
@@ -151,11 +760,21 @@ namespace audio {
 					if (m_listAlgo.size() > 0) {
 						ememory::SharedPtr<T> algoEP = get<T>(m_listAlgo.size()-1);
 						if (algoEP != null) {
+							removeHandle(m_listAlgo[m_listAlgo.size()-1]);
 							m_listAlgo.erase(m_listAlgo.begin()+m_listAlgo.size()-1);
 						}
 					}
 				}
 				template<typename T> bool hasType() {
+					ethread::UniqueLock lock(m_hotLock);
+					// algos pushed with their type: no cast
+					const void* typeId = audio::drain::getTypeId<T>();
+					for (size_t iii=0; iii<m_handleType.size(); ++iii) {
+						if (    m_handleType[iii] == typeId
+						     && m_handleAlgo[iii] != null) {
+							return true;
+						}
+					}
 					for (size_t iii=0; iii<m_listAlgo.size(); ++iii) {
 						ememory::SharedPtr<T> tmp = ememory::dynamicPointerCast<T>(m_listAlgo[iii]);
 						if (tmp != null) {
@@ -164,19 +783,234 @@ namespace audio {
 					}
 					return false;
 				}
+			protected:
+				mutable ethread::Mutex m_hotLock; //!< Serialize the hot changes and the readers of the chain of the control threads (only tried by the audio thread)
+				std::atomic<bool> m_hotPending; //!< The chain m_hotListAlgo is ready: swapped at the start of the next period
+				etk::Vector<ememory::SharedPtr<drain::Algo>> m_hotListAlgo; //!< Chain prepared by the control thread (the previous chain after the swap)
+				etk::Vector<size_t> m_hotActiveAlgo; //!< Active algos of m_hotListAlgo
+				etk::Vector<audio::drain::AlgoStatisticCounter> m_hotStatistic; //!< Profiling of m_hotListAlgo
+				uint64_t m_hotTopologyKey; //!< Topology key of m_hotListAlgo
+				/**
+				 * @brief Start a hot change: copy the current chain in m_hotListAlgo (m_hotLock locked).
+				 * @return false if the previous change is not applied by the audio thread.
+				 */
+				bool hotPrepare();
+				/**
+				 * @brief Insert an algo and the conversions needed around it in the prepared chain (only the new algos are configured).
+				 * @param[in] _position Position in m_hotListAlgo.
+				 * @param[in] _algo Algo to insert (null: only convert the output of the previous algo to the input of the next one).
+				 * @return true if the negotiation succeed.
+				 */
+				bool hotBridge(size_t _position, const ememory::SharedPtr<drain::Algo>& _algo);
+				/**
+				 * @brief Publish the prepared chain to the audio thread.
+				 */
+				void hotCommit();
+				/**
+				 * @brief Drop the prepared chain and give back its new temporary algos (the audio thread is stopped).
+				 */
+				void hotClear();
+				/**
+				 * @brief Insert an algo in a running chain.
+				 * @param[in] _algo Algo to insert.
+				 * @param[in] _typeId Static type of the algo.
+				 * @param[in] _next Handle of the algo before which the algo is inserted (-1: end of the chain).
+				 * @return Id of the handle (-1 on error).
+				 */
+				int32_t hotInsert(const ememory::SharedPtr<drain::Algo>& _algo, const void* _typeId, int32_t _next);
+				/**
+				 * @brief Remove an algo of a running chain.
+				 * @param[in] _handle Id of the handle of the algo.
+				 * @return true if the change is prepared.
+				 */
+				bool hotRemove(int32_t _handle);
+			public:
+				/**
+				 * @brief Swap the prepared chain at the period boundary (audio thread, no allocation, no wait).
+				 * When a control thread read the chain (get, hasType, flushStatus, generateDot ...), the swap is done at the next period.
+				 * @note Called by process: a scheduler that calls processStage directly call it before the first stage of a period.
+				 */
+				void hotApply() {
+					if (m_hotPending.load(std::memory_order_acquire) == false) {
+						return;
+					}
+					if (m_hotLock.tryLock() == false) {
+						return;
+					}
+					m_listAlgo.swap(m_hotListAlgo);
+					m_activeAlgo.swap(m_hotActiveAlgo);
+					m_statistic.swap(m_hotStatistic);
+					m_topologyKey = m_hotTopologyKey;
+					m_hotPending.store(false, std::memory_order_release);
+					m_hotLock.unLock();
+				}
+				/**
+				 * @brief Add an algo at the end of a running chain without a new negotiation of the chain.
+				 * The algo is configured with the formats already used at this position (a conversion is added around it if needed):
+				 * the other algos keep their configuration and their state (no glitch). The negotiation is done in the calling
+				 * thread, the new chain is used at the start of the next period.
+				 * @note The chain is not optimized as with a full negotiation (a conversion can stay around the new algo).
+				 * @param[in] _algo Algo to add.
+				 * @return Handle of the algo (invalid if the change is impossible or the previous one is not applied yet).
+				 */
+				template<typename T> audio::drain::AlgoHandle<T> hotPushBack(const ememory::SharedPtr<T>& _algo) {
+					return audio::drain::AlgoHandle<T>(hotInsert(_algo, audio::drain::getTypeId<T>(), -1));
+				}
+				/**
+				 * @brief Insert an algo before an other one in a running chain (@see hotPushBack).
+				 * @param[in] _next Handle of the algo before which the algo is inserted.
+				 * @param[in] _algo Algo to insert.
+				 * @return Handle of the algo (invalid if the change is impossible or the previous one is not applied yet).
+				 */
+				template<typename T, typename U> audio::drain::AlgoHandle<T> hotInsertBefore(const audio::drain::AlgoHandle<U>& _next, const ememory::SharedPtr<T>& _algo) {
+					if (_next.isValid() == false) {
+						return audio::drain::AlgoHandle<T>();
+					}
+					return audio::drain::AlgoHandle<T>(hotInsert(_algo, audio::drain::getTypeId<T>(), _next.m_id));
+				}
+				/**
+				 * @brief Remove an algo of a running chain: only the junction between its neighbours is negotiated (@see hotPushBack).
+				 * @param[in] _handle Handle of the algo.
+				 * @return true if the change is prepared (used at the start of the next period).
+				 */
+				template<typename T> bool hotRemove(const audio::drain::AlgoHandle<T>& _handle) {
+					return hotRemove(_handle.m_id);
+				}
+				/**
+				 * @brief Check if a hot change wait the next period.
+				 * @return true if the prepared chain is not used yet.
+				 */
+				bool getHotPending() const {
+					return m_hotPending.load(std::memory_order_acquire);
+				}
 			private:
 				statusFunction m_statusFunction;
+				statusEventFunction m_statusEventFunction; //!< Receive the events of the queue with their number of occurence
+				audio::drain::StatusQueue m_statusQueue; //!< Status posted by the audio thread (when enable)
+				/**
+				 * @brief Get the name of an algo of the chain for its status (m_hotLock locked).
+				 * @param[in] _origin Algo that generate the status.
+				 * @return Name of the algo (its type if it has no name).
+				 */
+				etk::String getStatusOrigin(const audio::drain::Algo* _origin) const;
+				/**
+				 * @brief Give a status of the queue to the user function.
+				 * @param[in] _origin Name of the algo that generate the status.
+				 * @param[in] _status Status.
+				 * @param[in] _count Number of occurence.
+				 */
+				void reportStatus(const etk::String& _origin, enum audio::drain::status _status, uint32_t _count);
 			public:
 				void generateStatus(const etk::String& _origin, const etk::String& _status);
 				void setStatusFunction(statusFunction _newFunction);
+				/**
+				 * @brief Set the function that receive the status of the queue (called instead of the status function by flushStatus).
+				 * @param[in] _newFunction Function (origin, status, number of occurence).
+				 */
+				void setStatusEventFunction(statusEventFunction _newFunction);
+				/**
+				 * @brief Post the status of the algos in a lock-free queue instead of calling the status function in the audio thread.
+				 * @note The status are given to the user only by flushStatus (call it from a control thread).
+				 * @param[in] _value New state.
+				 * @param[in] _minInterval Minimum delay between 2 events of the same status of an algo (the occurences between are coalesced).
+				 */
+				void setStatusQueue(bool _value, const audio::Duration& _minInterval=audio::Duration(0, 100000000LL));
+				/**
+				 * @brief Give the status posted in the queue to the status functions (control thread).
+				 * @return Number of event given.
+				 */
+				size_t flushStatus();
 			private:
 				bool m_isConfigured;
+				bool m_configurationBatch; //!< The negotiation is running: the algos apply their new formats at its end
 			public:
 				void updateInterAlgo();
 				void removeAlgoDynamic();
+				/**
+				 * @brief Remove all the solved configurations of the negotiation cache (shared by all the Process).
+				 */
+				static void clearNegotiationCache();
 			private:
 				void displayAlgo();
 				void updateAlgo(size_t _position);
+				/**
+				 * @brief Merge the adjacent algos that can be done in a single pass (remove the temporary FormatUpdate when possible).
+				 */
+				void fuseAlgo();
+				/**
+				 * @brief Move the requantization in int16_t of the Volume in a dithered FormatUpdate (when a dither is set).
+				 */
+				void insertDither();
+				/**
+				 * @brief Create the key of the negotiation cache for the current chain.
+				 * @param[out] _key Key of the chain (input/output config, algo types, preset formats and supported lists).
+				 * @return false if the chain can not be cached.
+				 */
+				bool getNegotiationKey(etk::Vector<uint32_t>& _key);
+				/**
+				 * @brief Configure the chain with a configuration already solved.
+				 * @param[in] _key Key of the chain.
+				 * @return true if the configuration is applied.
+				 */
+				bool applyNegotiationCache(const etk::Vector<uint32_t>& _key);
+				/**
+				 * @brief Store the configuration of the chain in the negotiation cache.
+				 * @param[in] _key Key of the chain (before the negotiation).
+				 */
+				void storeNegotiationCache(const etk::Vector<uint32_t>& _key);
+				/**
+				 * @brief Resize the ping-pong buffers and give the maximum size of a process call to each algo.
+				 */
+				void updateProcessBuffer();
+				/**
+				 * @brief Get the maximum number of chunk of a process call at a frequency of the chain.
+				 * @param[in] _frequency Frequency of the data (input or output of an algo).
+				 * @return Number of chunk.
+				 */
+				size_t getProcessNbChunk(float _frequency) const;
+				/**
+				 * @brief Allocate the buffers of an algo added by a hot change (control thread: the first process does not allocate).
+				 * @param[in] _algo New algo of m_hotListAlgo.
+				 */
+				void updateProcessBuffer(const ememory::SharedPtr<drain::Algo>& _algo);
+				/**
+				 * @brief Create the list of the algos that need to be called (@see audio::drain::Algo::isPassThrough).
+				 */
+				void updateActiveAlgo() {
+					getActiveAlgo(m_listAlgo, m_activeAlgo, m_topologyKey);
+				}
+				/**
+				 * @brief Create the list of the active algos of a chain and its topology key.
+				 * @param[in] _listAlgo Chain.
+				 * @param[out] _activeAlgo Id of the active algos.
+				 * @param[out] _topologyKey Key of the chain.
+				 */
+				static void getActiveAlgo(const etk::Vector<ememory::SharedPtr<drain::Algo>>& _listAlgo,
+				                          etk::Vector<size_t>& _activeAlgo,
+				                          uint64_t& _topologyKey);
+				/**
+				 * @brief Write the profiling of an algo in the label of its node (nothing when the profiling is disable).
+				 * @param[in] _io Output of the graph.
+				 * @param[in] _id Id of the algo in the chain.
+				 * @param[in] _cycleTotal Cycles used by all the algos of the chain (load of the algo).
+				 */
+				void generateDotStatistic(ememory::SharedPtr<etk::io::Interface>& _io, size_t _id, uint64_t _cycleTotal);
+				/**
+				 * @brief Write the node of an algo: cached static label and live profiling.
+				 * @param[in] _io Output of the graph.
+				 * @param[in] _basicID Id of the graph of the Process.
+				 * @param[in] _id Id of the algo in the chain.
+				 * @param[in] _cycleTotal Cycles used by all the algos of the chain.
+				 * @param[in] _hotId Id of the algo that use the most cycles (highlighted).
+				 * @return Name of the node.
+				 */
+				etk::String generateDotAlgo(ememory::SharedPtr<etk::io::Interface>& _io, int32_t _basicID, size_t _id, uint64_t _cycleTotal, size_t _hotId);
+				/**
+				 * @brief Get the cycles used by the chain and the algo that use the most (the hot stage).
+				 * @param[out] _hotId Id of the hot algo (m_listAlgo.size() when not available).
+				 * @return Cycles used by all the algos.
+				 */
+				uint64_t getDotCycle(size_t& _hotId) const;
 			public:
 				void generateDot(ememory::SharedPtr<etk::io::Interface>& _io, int32_t _offset, int32_t _basicID, etk::String& _nameIn, etk::String& _nameOut, bool _reserseGraph);
 				// TODO : Remove this one when we find a good way to do it ...
@@ -0,0 +1,107 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <audio/drain/ProcessGraph.hpp>
+#include <audio/drain/debug.hpp>
+
+audio::drain::ProcessGraph::ProcessGraph() {
+
+}
+
+audio::drain::ProcessGraph::~ProcessGraph() {
+
+}
+
+int32_t audio::drain::ProcessGraph::addNode(const ememory::SharedPtr<audio::drain::Process>& _process, int32_t _parent) {
+	if (_process == null) {
+		DRAIN_ERROR("Can not add a null Process");
+		return -1;
+	}
+	if (    _parent < -1
+	     || _parent >= int32_t(m_listNode.size())) {
+		DRAIN_ERROR("Can not add a Process on the node " << _parent << " (only " << m_listNode.size() << " nodes)");
+		return -1;
+	}
+	for (size_t iii=0; iii<m_listNode.size(); ++iii) {
+		if (m_listNode[iii].m_process == _process) {
+			DRAIN_ERROR("Process already in the graph");
+			return -1;
+		}
+	}
+	if (_parent >= 0) {
+		// the node read the output of its parent
+		_process->setInputConfig(m_listNode[_parent].m_process->getOutputConfig());
+	}
+	audio::drain::ProcessGraphNode node;
+	node.m_process = _process;
+	node.m_parent = _parent;
+	node.m_data = null;
+	node.m_nbChunk = 0;
+	m_listNode.pushBack(node);
+	return int32_t(m_listNode.size()) - 1;
+}
+
+void audio::drain::ProcessGraph::clear() {
+	m_listNode.clear();
+}
+
+size_t audio::drain::ProcessGraph::getNbChild(int32_t _id) const {
+	size_t out = 0;
+	for (size_t iii=0; iii<m_listNode.size(); ++iii) {
+		if (m_listNode[iii].m_parent == _id) {
+			out++;
+		}
+	}
+	return out;
+}
+
+void audio::drain::ProcessGraph::updateInputConfig(size_t _id) {
+	audio::drain::ProcessGraphNode& node = m_listNode[_id];
+	if (node.m_parent < 0) {
+		return;
+	}
+	const audio::drain::IOFormatInterface& output = m_listNode[node.m_parent].m_process->getOutputConfig();
+	if (node.m_process->getInputConfig() != output) {
+		DRAIN_VERBOSE("Node " << _id << ": the parent output change " << node.m_process->getInputConfig() << " -> " << output);
+		// the chain is negotiated again with the new format
+		node.m_process->setInputConfig(output);
+	}
+}
+
+void audio::drain::ProcessGraph::updateInterAlgo() {
+	// the parents are always before their children: a single sweep
+	for (size_t iii=0; iii<m_listNode.size(); ++iii) {
+		updateInputConfig(iii);
+		m_listNode[iii].m_process->updateInterAlgo();
+	}
+}
+
+bool audio::drain::ProcessGraph::process(audio::Time& _time, void* _inData, size_t _inNbChunk) {
+	bool ret = true;
+	// the parents are always before their children: a single sweep
+	for (size_t iii=0; iii<m_listNode.size(); ++iii) {
+		audio::drain::ProcessGraphNode& node = m_listNode[iii];
+		void* inData = _inData;
+		size_t inNbChunk = _inNbChunk;
+		node.m_time = _time;
+		if (node.m_parent >= 0) {
+			const audio::drain::ProcessGraphNode& parent = m_listNode[node.m_parent];
+			// shared buffer: the Process of the children never write in it
+			inData = parent.m_data;
+			inNbChunk = parent.m_nbChunk;
+			node.m_time = parent.m_time;
+			// parent reconfigured without updateInterAlgo: the negotiation is done by the process of the node
+			updateInputConfig(iii);
+		}
+		node.m_data = null;
+		node.m_nbChunk = 0;
+		if (node.m_process->process(node.m_time, inData, inNbChunk, node.m_data, node.m_nbChunk) == false) {
+			DRAIN_ERROR("Process of the node " << iii << " failed");
+			ret = false;
+		}
+	}
+	return ret;
+}
@@ -0,0 +1,129 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/Vector.hpp>
+#include <ememory/memory.hpp>
+#include <audio/Time.hpp>
+#include <audio/drain/Process.hpp>
+
+namespace audio {
+	namespace drain{
+		/**
+		 * @brief Element of a ProcessGraph.
+		 */
+		class ProcessGraphNode {
+			public:
+				ememory::SharedPtr<audio::drain::Process> m_process; //!< Chain of the node
+				int32_t m_parent; //!< Id of the node that feed this one (-1: input of the graph)
+				audio::Time m_time; //!< Time of the output during the process
+				void* m_data; //!< Output data of the last process (read-only, valid until the next process)
+				size_t m_nbChunk; //!< Number of chunk in m_data
+		};
+		/**
+		 * @brief Tree of Process: the output of a node feed all its children (fan-out).
+		 * The common part of the streams (capture, echo canceller ...) is a node computed once by period and the
+		 * branches (recorder at 48kHz, speech engine at 16kHz ...) read its output buffer directly: a Process never
+		 * write in its input buffer, so the buffer is shared without copy for all the children.
+		 * @note Use a audio::drain::Mixer for the fan-in.
+		 * @code
+		 * audio::drain::ProcessGraph graph;
+		 * int32_t capture = graph.addNode(captureProcess); // input config: format of the device
+		 * int32_t record = graph.addNode(recordProcess, capture); // input config set by the graph
+		 * int32_t speech = graph.addNode(speechProcess, capture);
+		 * graph.updateInterAlgo();
+		 * graph.process(time, deviceData, nbChunk);
+		 * void* speechData = graph.getOutputData(speech);
+		 * @endcode
+		 */
+		class ProcessGraph {
+			protected:
+				etk::Vector<audio::drain::ProcessGraphNode> m_listNode; //!< All the nodes (a parent is always before its children)
+			public:
+				ProcessGraph();
+				virtual ~ProcessGraph();
+			public:
+				/**
+				 * @brief Add a node in the graph.
+				 * @param[in] _process Chain of the node.
+				 * @param[in] _parent Id of the node that feed it (-1: input of the graph), its input config is set at the output config of the parent.
+				 * @return Id of the node (-1 on error).
+				 */
+				int32_t addNode(const ememory::SharedPtr<audio::drain::Process>& _process, int32_t _parent=-1);
+				/**
+				 * @brief Remove all the nodes.
+				 */
+				void clear();
+				/**
+				 * @brief Get the number of node in the graph.
+				 * @return Number of node.
+				 */
+				size_t size() const {
+					return m_listNode.size();
+				}
+				/**
+				 * @brief Get the chain of a node.
+				 * @param[in] _id Id of the node.
+				 * @return The chain.
+				 */
+				ememory::SharedPtr<audio::drain::Process> operator[](size_t _id) {
+					return m_listNode[_id].m_process;
+				}
+				/**
+				 * @brief Get the number of child of a node.
+				 * @param[in] _id Id of the node (-1: input of the graph).
+				 * @return Number of node fed by this one.
+				 */
+				size_t getNbChild(int32_t _id) const;
+				/**
+				 * @brief Negotiate all the nodes, the parents before the children (to call after a change of the config of a node).
+				 * @note The output config of a parent is given to its children: a reconfigured node update all its branches.
+				 */
+				void updateInterAlgo();
+			protected:
+				/**
+				 * @brief Set the input config of a node at the output config of its parent (when it changed).
+				 * @param[in] _id Id of the node.
+				 */
+				void updateInputConfig(size_t _id);
+			public:
+				/**
+				 * @brief Process a period in all the nodes (each node once, the parents before the children).
+				 * @param[in] _time Time of the first sample of the period.
+				 * @param[in] _inData Input data of the nodes without parent.
+				 * @param[in] _inNbChunk Number of chunk of the period.
+				 * @return true The procress is done corectly.
+				 * @return false An error occured.
+				 */
+				bool process(audio::Time& _time, void* _inData, size_t _inNbChunk);
+				/**
+				 * @brief Get the output of a node of the last process (read-only).
+				 * @param[in] _id Id of the node.
+				 * @return Pointer on the data (valid until the next process).
+				 */
+				void* getOutputData(size_t _id) const {
+					return m_listNode[_id].m_data;
+				}
+				/**
+				 * @brief Get the number of output chunk of a node of the last process.
+				 * @param[in] _id Id of the node.
+				 * @return Number of chunk.
+				 */
+				size_t getOutputNbChunk(size_t _id) const {
+					return m_listNode[_id].m_nbChunk;
+				}
+				/**
+				 * @brief Get the time of the output of a node of the last process.
+				 * @param[in] _id Id of the node.
+				 * @return Time of the first output sample.
+				 */
+				const audio::Time& getOutputTime(size_t _id) const {
+					return m_listNode[_id].m_time;
+				}
+		};
+	}
+}
+
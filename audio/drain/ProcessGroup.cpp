@@ -0,0 +1,198 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <audio/drain/ProcessGroup.hpp>
+#include <audio/drain/cpu.hpp>
+#include <audio/drain/debug.hpp>
+#include <echrono/Steady.hpp>
+
+audio::drain::ProcessGroup::ProcessGroup() {
+
+}
+
+audio::drain::ProcessGroup::~ProcessGroup() {
+
+}
+
+void audio::drain::ProcessGroup::add(const ememory::SharedPtr<audio::drain::Process>& _process) {
+	if (_process == null) {
+		DRAIN_ERROR("Can not add a null Process");
+		return;
+	}
+	m_listProcess.pushBack(_process);
+	// force the update of the batches
+	m_topology.clear();
+}
+
+void audio::drain::ProcessGroup::remove(const ememory::SharedPtr<audio::drain::Process>& _process) {
+	for (size_t iii=0; iii<m_listProcess.size(); ++iii) {
+		if (m_listProcess[iii] == _process) {
+			m_listProcess.erase(m_listProcess.begin()+iii);
+			m_topology.clear();
+			return;
+		}
+	}
+	DRAIN_WARNING("Process not in the group");
+}
+
+void audio::drain::ProcessGroup::clear() {
+	m_listProcess.clear();
+	m_topology.clear();
+}
+
+void audio::drain::ProcessGroup::updateBatch() {
+	bool change = m_topology.size() != m_listProcess.size();
+	if (change == false) {
+		for (size_t iii=0; iii<m_listProcess.size(); ++iii) {
+			if (m_topology[iii] != m_listProcess[iii]->getTopologyKey()) {
+				change = true;
+				break;
+			}
+		}
+	}
+	if (change == false) {
+		return;
+	}
+	m_topology.resize(m_listProcess.size());
+	for (size_t iii=0; iii<m_listProcess.size(); ++iii) {
+		m_topology[iii] = m_listProcess[iii]->getTopologyKey();
+	}
+	m_batchList.clear();
+	m_batchStart.clear();
+	// group the chains with the same topology (keep the order of the first chain of each batch)
+	etk::Vector<bool> used;
+	used.resize(m_listProcess.size(), false);
+	for (size_t iii=0; iii<m_listProcess.size(); ++iii) {
+		if (used[iii] == true) {
+			continue;
+		}
+		m_batchStart.pushBack(m_batchList.size());
+		for (size_t jjj=iii; jjj<m_listProcess.size(); ++jjj) {
+			if (    used[jjj] == false
+			     && m_topology[jjj] == m_topology[iii]) {
+				used[jjj] = true;
+				m_batchList.pushBack(jjj);
+			}
+		}
+	}
+	m_batchStart.pushBack(m_batchList.size());
+	DRAIN_DEBUG("Process group: " << m_listProcess.size() << " chains in " << m_batchStart.size()-1 << " batches");
+}
+
+void audio::drain::ProcessGroup::processBatch(size_t _batchId) {
+	size_t start = m_batchStart[_batchId];
+	size_t stop = m_batchStart[_batchId+1];
+	// all the chains of the batch have the same number of active algo
+	size_t nbStage = m_listProcess[m_batchList[start]]->getActiveAlgoCount();
+	// the batch can run on a worker thread: set the float unit here
+	bool flushDenormal = false;
+	for (size_t jjj=start; jjj<stop; ++jjj) {
+		if (m_listProcess[m_batchList[jjj]]->getFlushDenormal() == true) {
+			flushDenormal = true;
+		}
+	}
+	audio::drain::cpu::FlushDenormal flush(flushDenormal);
+	for (size_t iii=0; iii<nbStage; ++iii) {
+		for (size_t jjj=start; jjj<stop; ++jjj) {
+			size_t id = m_batchList[jjj];
+			if (m_error[id] != 0) {
+				// the next algos can not use the output
+				continue;
+			}
+			echrono::Steady startTime = echrono::Steady::now();
+			if (m_listProcess[id]->processStage(iii, m_time[id], m_data[id], m_nbChunk[id]) == false) {
+				m_error[id] = 1;
+			}
+			m_duration[id] += uint64_t((echrono::Steady::now() - startTime).get());
+		}
+	}
+}
+
+bool audio::drain::ProcessGroup::process(audio::Time& _time,
+                                         const etk::Vector<void*>& _inData,
+                                         size_t _inNbChunk,
+                                         etk::Vector<void*>& _outData,
+                                         etk::Vector<size_t>& _outNbChunk) {
+	if (_inData.size() != m_listProcess.size()) {
+		DRAIN_ERROR("Wrong number of input: " << _inData.size() << " != " << m_listProcess.size() << " chains");
+		return false;
+	}
+	if (m_listProcess.size() == 0) {
+		_outData.clear();
+		_outNbChunk.clear();
+		return true;
+	}
+	for (size_t iii=0; iii<m_listProcess.size(); ++iii) {
+		// period boundary: use the chain prepared by a hot change (as Process::process)
+		m_listProcess[iii]->hotApply();
+		m_listProcess[iii]->updateInterAlgo();
+	}
+	updateBatch();
+	m_time.resize(m_listProcess.size());
+	m_data.resize(m_listProcess.size());
+	m_nbChunk.resize(m_listProcess.size());
+	m_duration.resize(m_listProcess.size());
+	m_error.resize(m_listProcess.size());
+	for (size_t iii=0; iii<m_listProcess.size(); ++iii) {
+		m_time[iii] = _time;
+		m_data[iii] = _inData[iii];
+		m_nbChunk[iii] = _inNbChunk;
+		m_duration[iii] = 0;
+		m_error[iii] = 0;
+	}
+	size_t nbBatch = m_batchStart.size() - 1;
+	if (    m_dispatch != null
+	     && nbBatch > 1) {
+		m_dispatch(nbBatch, [&](size_t _taskId) {
+		                        processBatch(_taskId);
+		                    });
+	} else {
+		for (size_t iii=0; iii<nbBatch; ++iii) {
+			processBatch(iii);
+		}
+	}
+	bool ret = true;
+	_outData.resize(m_listProcess.size());
+	_outNbChunk.resize(m_listProcess.size());
+	for (size_t iii=0; iii<m_listProcess.size(); ++iii) {
+		m_listProcess[iii]->addMetricPeriod(m_duration[iii], _inNbChunk);
+		if (m_error[iii] != 0) {
+			DRAIN_ERROR("Process of the chain " << iii << " failed");
+			_outData[iii] = null;
+			_outNbChunk[iii] = 0;
+			ret = false;
+			continue;
+		}
+		_outData[iii] = m_data[iii];
+		_outNbChunk[iii] = m_nbChunk[iii];
+	}
+	return ret;
+}
+
+bool audio::drain::ProcessGroup::pull(audio::Time& _time,
+                                      const etk::Vector<void*>& _data,
+                                      size_t _nbChunk,
+                                      size_t _chunkSize) {
+	if (_data.size() != m_listProcess.size()) {
+		DRAIN_ERROR("Wrong number of output: " << _data.size() << " != " << m_listProcess.size() << " chains");
+		return false;
+	}
+	m_time.resize(m_listProcess.size());
+	for (size_t iii=0; iii<m_listProcess.size(); ++iii) {
+		m_time[iii] = _time;
+	}
+	if (m_dispatch != null) {
+		m_dispatch(m_listProcess.size(), [&](size_t _taskId) {
+		                                     m_listProcess[_taskId]->pull(m_time[_taskId], _data[_taskId], _nbChunk, _chunkSize);
+		                                 });
+	} else {
+		for (size_t iii=0; iii<m_listProcess.size(); ++iii) {
+			m_listProcess[iii]->pull(m_time[iii], _data[iii], _nbChunk, _chunkSize);
+		}
+	}
+	return true;
+}
+
@@ -0,0 +1,122 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/Vector.hpp>
+#include <etk/Function.hpp>
+#include <ememory/memory.hpp>
+#include <audio/Time.hpp>
+#include <audio/drain/Process.hpp>
+
+namespace audio {
+	namespace drain{
+		/**
+		 * @brief Function that execute _nbTask tasks (_task(0) ... _task(_nbTask-1)) and return when all are done.
+		 */
+		typedef etk::Function<void (size_t _nbTask, const etk::Function<void (size_t _taskId)>& _task)> dispatchFunction;
+		/**
+		 * @brief Execute many Process on the same period.
+		 * The Process with the same topology (@see audio::drain::Process::getTopologyKey) are executed algo by algo:
+		 * the first algo of all the chains, then the second ... the same kernel sweep all the streams back to back.
+		 */
+		class ProcessGroup {
+			protected:
+				etk::Vector<ememory::SharedPtr<audio::drain::Process> > m_listProcess; //!< All the managed chains
+			public:
+				ProcessGroup();
+				virtual ~ProcessGroup();
+			public:
+				/**
+				 * @brief Add a chain in the group.
+				 * @param[in] _process Chain to add.
+				 */
+				void add(const ememory::SharedPtr<audio::drain::Process>& _process);
+				/**
+				 * @brief Remove a chain of the group.
+				 * @param[in] _process Chain to remove.
+				 */
+				void remove(const ememory::SharedPtr<audio::drain::Process>& _process);
+				/**
+				 * @brief Remove all the chains.
+				 */
+				void clear();
+				/**
+				 * @brief Get the number of chain in the group.
+				 * @return Number of chain.
+				 */
+				size_t size() const {
+					return m_listProcess.size();
+				}
+				/**
+				 * @brief Get a chain of the group.
+				 * @param[in] _id Id of the chain.
+				 * @return The chain.
+				 */
+				ememory::SharedPtr<audio::drain::Process> operator[](size_t _id) {
+					return m_listProcess[_id];
+				}
+			protected:
+				dispatchFunction m_dispatch; //!< Execution of the batches (null: in the caller thread)
+			public:
+				/**
+				 * @brief Set the function that execute the batches of chains (one task for each batch).
+				 * @param[in] _function Dispatch function (null to execute in the caller thread).
+				 */
+				void setDispatchFunction(dispatchFunction _function) {
+					m_dispatch = _function;
+				}
+			protected:
+				etk::Vector<uint64_t> m_topology; //!< Topology of each chain when the batches have been created
+				etk::Vector<size_t> m_batchList; //!< Id of the chains, sorted by batch
+				etk::Vector<size_t> m_batchStart; //!< Start of each batch in m_batchList (and the end of the last one)
+				etk::Vector<audio::Time> m_time; //!< Time of each chain during the process
+				etk::Vector<void*> m_data; //!< Current data of each chain during the process
+				etk::Vector<size_t> m_nbChunk; //!< Current number of chunk of each chain during the process
+				etk::Vector<uint64_t> m_duration; //!< Processing time of each chain during the process (ns)
+				etk::Vector<uint8_t> m_error; //!< A stage of the chain failed during the process (not a bool: written by the thread of its batch)
+				/**
+				 * @brief Update the batches when the topology of a chain change.
+				 */
+				void updateBatch();
+				/**
+				 * @brief Execute all the algos of a batch.
+				 * @param[in] _batchId Id of the batch.
+				 */
+				void processBatch(size_t _batchId);
+			public:
+				/**
+				 * @brief Process the same period on all the chains.
+				 * @param[in] _time Time of the first sample of the period.
+				 * @param[in] _inData Input data of each chain (same order as the chains).
+				 * @param[in] _inNbChunk Number of chunk of the period.
+				 * @param[out] _outData Output data of each chain.
+				 * @param[out] _outNbChunk Number of output chunk of each chain.
+				 * @return true The procress is done corectly.
+				 * @return false An error occured.
+				 */
+				bool process(audio::Time& _time,
+				             const etk::Vector<void*>& _inData,
+				             size_t _inNbChunk,
+				             etk::Vector<void*>& _outData,
+				             etk::Vector<size_t>& _outNbChunk);
+				/**
+				 * @brief Pull the same period on all the chains (@see audio::drain::Process::pull).
+				 * @note Each chain is a task of the dispatch function (the chains must be independent).
+				 * @param[in] _time Time of the first sample requested.
+				 * @param[in] _data Output buffer of each chain (same order as the chains).
+				 * @param[in] _nbChunk Number of chunk requested.
+				 * @param[in] _chunkSize Size of a single chunk.
+				 * @return true The procress is done corectly.
+				 * @return false An error occured.
+				 */
+				bool pull(audio::Time& _time,
+				          const etk::Vector<void*>& _data,
+				          size_t _nbChunk,
+				          size_t _chunkSize);
+		};
+	}
+}
+
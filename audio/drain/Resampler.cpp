@@ -6,13 +6,165 @@
 
 #include <audio/drain/Resampler.hpp>
 #include <audio/drain/debug.hpp>
+#include <ethread/Mutex.hpp>
 
-audio::drain::Resampler::Resampler() :
+#ifdef HAVE_SPEEX_DSP_RESAMPLE
+	namespace audio {
+		namespace drain {
+			/**
+			 * @brief Speex state released by a Resampler (the filter memory is reset before the reuse).
+			 */
+			class ResamplerPoolElement {
+				public:
+					uint32_t m_nbChannel;
+					uint32_t m_inputFrequency;
+					uint32_t m_outputFrequency;
+					int32_t m_quality;
+					SpeexResamplerState* m_state;
+			};
+			/**
+			 * @brief Global pool of speex state (free the states at the end of the application).
+			 */
+			class ResamplerPool {
+				public:
+					ethread::Mutex m_lock;
+					etk::Vector<audio::drain::ResamplerPoolElement> m_list;
+					size_t m_maxSize;
+					ResamplerPool() :
+					  m_maxSize(16) {
+						
+					}
+					~ResamplerPool() {
+						clear();
+					}
+					void clear() {
+						for (size_t iii=0; iii<m_list.size(); ++iii) {
+							speex_resampler_destroy(m_list[iii].m_state);
+						}
+						m_list.clear();
+					}
+			};
+		}
+	}
+	static audio::drain::ResamplerPool& getPool() {
+		static audio::drain::ResamplerPool pool;
+		return pool;
+	}
+#endif
+
+void audio::drain::Resampler::setPoolSize(size_t _nbState) {
+	#ifdef HAVE_SPEEX_DSP_RESAMPLE
+		audio::drain::ResamplerPool& pool = getPool();
+		ethread::UniqueLock lock(pool.m_lock);
+		pool.m_maxSize = _nbState;
+		while (pool.m_list.size() > pool.m_maxSize) {
+			speex_resampler_destroy(pool.m_list[0].m_state);
+			pool.m_list.erase(pool.m_list.begin());
+		}
+	#else
+		// no state to keep
+		(void)_nbState;
+	#endif
+}
+
+size_t audio::drain::Resampler::getPoolCount() {
+	#ifdef HAVE_SPEEX_DSP_RESAMPLE
+		audio::drain::ResamplerPool& pool = getPool();
+		ethread::UniqueLock lock(pool.m_lock);
+		return pool.m_list.size();
+	#else
+		return 0;
+	#endif
+}
+
+void audio::drain::Resampler::clearPool() {
+	#ifdef HAVE_SPEEX_DSP_RESAMPLE
+		audio::drain::ResamplerPool& pool = getPool();
+		ethread::UniqueLock lock(pool.m_lock);
+		pool.clear();
+	#endif
+}
+
+audio::drain::ResamplerEngine::ResamplerEngine() :
   #ifdef HAVE_SPEEX_DSP_RESAMPLE
-    m_speexResampler(null),
+    m_speex(null),
+    m_speexNbChannel(0),
+    m_speexInputFrequency(0),
+    m_speexOutputFrequency(0),
   #endif
+  m_quality(10),
+  m_native(true) {
+	
+}
+
+audio::drain::ResamplerEngine::~ResamplerEngine() {
+	#ifdef HAVE_SPEEX_DSP_RESAMPLE
+		if (m_speex == null) {
+			return;
+		}
+		audio::drain::ResamplerPool& pool = getPool();
+		{
+			ethread::UniqueLock lock(pool.m_lock);
+			if (pool.m_list.size() < pool.m_maxSize) {
+				audio::drain::ResamplerPoolElement element;
+				element.m_nbChannel = m_speexNbChannel;
+				element.m_inputFrequency = m_speexInputFrequency;
+				element.m_outputFrequency = m_speexOutputFrequency;
+				element.m_quality = m_quality;
+				element.m_state = m_speex;
+				pool.m_list.pushBack(element);
+				m_speex = null;
+				return;
+			}
+		}
+		speex_resampler_destroy(m_speex);
+		m_speex = null;
+	#endif
+}
+
+size_t audio::drain::ResamplerEngine::getInputLatency() const {
+	if (m_native == true) {
+		if (m_bank == null) {
+			return 0;
+		}
+		return m_bank->m_nbTap / 2;
+	}
+	#ifdef HAVE_SPEEX_DSP_RESAMPLE
+		if (m_speex != null) {
+			return speex_resampler_get_input_latency(m_speex);
+		}
+	#endif
+	return 0;
+}
+
+void audio::drain::ResamplerEngine::getRatio(uint32_t& _num, uint32_t& _den) const {
+	_num = 1;
+	_den = 1;
+	if (m_native == true) {
+		if (m_bank != null) {
+			_num = m_bank->m_decimation;
+			_den = m_bank->m_interpolation;
+		}
+		return;
+	}
+	#ifdef HAVE_SPEEX_DSP_RESAMPLE
+		if (m_speex != null) {
+			spx_uint32_t ratioNum = 1;
+			spx_uint32_t ratioDen = 1;
+			speex_resampler_get_ratio(m_speex, &ratioNum, &ratioDen);
+			_num = ratioNum;
+			_den = ratioDen;
+		}
+	#endif
+}
+
+audio::drain::Resampler::Resampler() :
+  m_engine(null),
   m_positionRead(0),
-  m_positionWrite(0) {
+  m_positionWrite(0),
+  m_inputResidualNbChunk(0),
+  m_historyNbChunk(0),
+  m_historyMaxChunk(0) {
 	
 }
 
@@ -20,7 +172,15 @@ void audio::drain::Resampler::init() {
 	audio::drain::Algo::init();
 	m_type = "Resampler";
 	m_supportedFormat.pushBack(audio::format_int16);
+	m_supportedFormat.pushBack(audio::format_int16_on_int32);
+	m_supportedFormat.pushBack(audio::format_float);
 	m_residualTimeInResampler = audio::Duration(0);
+	m_request.m_quality = 10;
+	#ifdef HAVE_SPEEX_DSP_RESAMPLE
+		m_request.m_nativeEngine = false;
+	#else
+		m_request.m_nativeEngine = true;
+	#endif
 }
 
 ememory::SharedPtr<audio::drain::Resampler> audio::drain::Resampler::create() {
@@ -30,12 +190,106 @@ ememory::SharedPtr<audio::drain::Resampler> audio::drain::Resampler::create() {
 }
 
 audio::drain::Resampler::~Resampler() {
+	
+}
+
+/**
+ * @brief Check if a rate pair has a dedicated kernel in the native resampler (x2, x3, x4, x6 or /2, /3, /4, /6).
+ */
+static bool isIntegerRatio(uint32_t _inputFrequency, uint32_t _outputFrequency) {
+	uint32_t low = etk::min(_inputFrequency, _outputFrequency);
+	uint32_t high = etk::max(_inputFrequency, _outputFrequency);
+	if (    low == 0
+	     || high % low != 0) {
+		return false;
+	}
+	uint32_t factor = high / low;
+	return    factor == 2
+	       || factor == 3
+	       || factor == 4
+	       || factor == 6;
+}
+
+ememory::SharedPtr<audio::drain::ResamplerEngine> audio::drain::Resampler::createEngine(int32_t _quality, bool _nativeEngine) {
+	if (    m_needProcess == false
+	     || m_input.getFrequency() == 0
+	     || m_output.getFrequency() == 0) {
+		return null;
+	}
+	ememory::SharedPtr<audio::drain::ResamplerEngine> engine(ETK_NEW(audio::drain::ResamplerEngine));
+	engine->m_quality = _quality;
+	engine->m_native = _nativeEngine;
+	if (isIntegerRatio(m_input.getFrequency(), m_output.getFrequency()) == true) {
+		// dedicated kernel: cheaper than the fractional path and a constant delay
+		engine->m_native = true;
+	}
+	if (engine->m_native == true) {
+		DRAIN_DEBUG("Create native resampler for : " << m_input << " to " << m_output);
+		engine->m_bank = audio::drain::PolyphaseResampler::getBank(m_input.getFrequency(), m_output.getFrequency(), _quality);
+		return engine;
+	}
 	#ifdef HAVE_SPEEX_DSP_RESAMPLE
-		if (m_speexResampler != null) {
-			speex_resampler_destroy(m_speexResampler);
-			m_speexResampler = null;
+		engine->m_speexNbChannel = m_output.getMap().size();
+		engine->m_speexInputFrequency = m_input.getFrequency();
+		engine->m_speexOutputFrequency = m_output.getFrequency();
+		{
+			// reuse a state with the same configuration: only the filter memory need to be reset
+			audio::drain::ResamplerPool& pool = getPool();
+			ethread::UniqueLock lock(pool.m_lock);
+			for (size_t iii=pool.m_list.size(); iii>0; --iii) {
+				const audio::drain::ResamplerPoolElement& element = pool.m_list[iii-1];
+				if (    element.m_nbChannel == engine->m_speexNbChannel
+				     && element.m_inputFrequency == engine->m_speexInputFrequency
+				     && element.m_outputFrequency == engine->m_speexOutputFrequency
+				     && element.m_quality == _quality) {
+					engine->m_speex = element.m_state;
+					pool.m_list.erase(pool.m_list.begin()+iii-1);
+					break;
+				}
+			}
+		}
+		if (engine->m_speex != null) {
+			DRAIN_DEBUG("Reuse resampler for : " << m_input << " to " << m_output);
+			speex_resampler_reset_mem(engine->m_speex);
+		} else {
+			int err = 0;
+			DRAIN_WARNING("Create resampler for : " << m_input << " to " << m_output);
+			engine->m_speex = speex_resampler_init(engine->m_speexNbChannel,
+			                                       engine->m_speexInputFrequency,
+			                                       engine->m_speexOutputFrequency,
+			                                       _quality, &err);
 		}
 	#endif
+	return engine;
+}
+
+void audio::drain::Resampler::publishRequest() {
+	m_request.m_engine = createEngine(m_request.m_quality, m_request.m_nativeEngine);
+	m_parameter.set(m_request);
+}
+
+void audio::drain::Resampler::updateBuffer() {
+	if (    m_input.getFrequency() == 0
+	     || m_output.getFrequency() == 0) {
+		return;
+	}
+	size_t chunkSize = m_input.getChunkSize();
+	// the longest filter is the speex one in quality 10: 256 taps, longer when decimating
+	m_historyMaxChunk = 256 * ((m_input.getFrequency() + m_output.getFrequency() - 1) / m_output.getFrequency());
+	m_history.resize(m_historyMaxChunk*chunkSize);
+	m_historyNbChunk = etk::min(m_historyNbChunk, m_historyMaxChunk);
+	// the residual is a part of the previous input (with the new input when the engine does not consume all)
+	if (m_inputResidual.size() < 2*getProcessBufferSize()*chunkSize) {
+		m_inputResidual.resize(2*getProcessBufferSize()*chunkSize);
+	}
+	m_native.reserve(etk::max(getProcessBufferSize(), m_historyMaxChunk));
+	if (m_input.getFormat() == audio::format_int16_on_int32) {
+		// a process call (its output can contain 1 more chunk for the fractional position of the filter)
+		size_t nbChannel = m_input.getMap().size();
+		size_t nbChunkOutput = (uint64_t(getProcessBufferSize()) * m_output.getFrequency() + m_input.getFrequency() - 1) / m_input.getFrequency() + 2;
+		m_floatInput.resize(getProcessBufferSize()*nbChannel);
+		m_floatOutput.resize(nbChunkOutput*nbChannel);
+	}
 }
 
 void audio::drain::Resampler::configurationChange() {
@@ -44,8 +298,10 @@ void audio::drain::Resampler::configurationChange() {
 		DRAIN_ERROR("can not support Format Change ...");
 		m_needProcess = false;
 	}
-	if (m_input.getFormat() != audio::format_int16) {
-		DRAIN_ERROR("can not support Format other than int16_t ...");
+	if (    m_input.getFormat() != audio::format_int16
+	     && m_input.getFormat() != audio::format_int16_on_int32
+	     && m_input.getFormat() != audio::format_float) {
+		DRAIN_ERROR("can not support Format other than int16_t, int16_on_int32_t and float ...");
 		m_needProcess = false;
 		return;
 	}
@@ -63,30 +319,326 @@ void audio::drain::Resampler::configurationChange() {
 		DRAIN_WARNING("Configure IO with 0 frequency ... " << m_input << " to " << m_output);
 		return;
 	}
+	m_inputResidualNbChunk = 0;
+	m_historyNbChunk = 0;
+	// the engine is created now ==> use directly the last parameters
+	{
+		ethread::UniqueLock lock(m_parameterLock);
+		m_native.init(m_output.getMap().size(), m_input.getFrequency(), m_output.getFrequency(), m_request.m_quality);
+		publishRequest();
+	}
+	updateBuffer();
+	m_parameter.update();
+	m_engine = m_parameter.get().m_engine.get();
+	if (    m_engine != null
+	     && m_engine->m_native == true) {
+		m_native.setBank(m_engine->m_bank.get());
+	}
+	// the first output sample is late of the filter delay
+	m_residualTimeInResampler = getFilterDelay();
+}
+
+void audio::drain::Resampler::processBufferSizeChange() {
+	if (m_needProcess == false) {
+		return;
+	}
+	updateBuffer();
+}
+
+void audio::drain::Resampler::setNativeEngine(bool _value) {
+	#ifndef HAVE_SPEEX_DSP_RESAMPLE
+		if (_value == false) {
+			DRAIN_WARNING("SPEEX DSP lib not accessible ==> keep the native resampler");
+		}
+		_value = true;
+	#endif
+	ethread::UniqueLock lock(m_parameterLock);
+	if (_value == m_request.m_nativeEngine) {
+		return;
+	}
+	m_request.m_nativeEngine = _value;
+	publishRequest();
+}
+
+audio::Duration audio::drain::Resampler::getFilterDelay() {
+	if (    m_engine == null
+	     || m_input.getFrequency() == 0) {
+		return audio::Duration(0);
+	}
+	int64_t latency = m_engine->getInputLatency();
+	return audio::Duration(0, (latency*1000000000LL) / int64_t(m_input.getFrequency()));
+}
+
+void audio::drain::Resampler::setQuality(int32_t _quality) {
+	_quality = etk::avg(0, _quality, 10);
+	ethread::UniqueLock lock(m_parameterLock);
+	if (_quality == m_request.m_quality) {
+		return;
+	}
+	m_request.m_quality = _quality;
+	publishRequest();
+	DRAIN_DEBUG("Set resampler quality : " << _quality);
+}
+
+void audio::drain::Resampler::applyParameter() {
+	if (m_parameter.isPending() == false) {
+		return;
+	}
+	// the previous engine can be released by the control thread as soon as the new one is taken
+	audio::Duration previousDelay = getFilterDelay();
+	bool previousNative =    m_engine != null
+	                      && m_engine->m_native == true;
+	m_parameter.update();
+	m_engine = m_parameter.get().m_engine.get();
+	if (m_engine == null) {
+		return;
+	}
+	if (m_engine->m_native == true) {
+		// same ratio: the history of the filter is kept ==> no discontinuity in the stream, only the delay change
+		m_native.setBank(m_engine->m_bank.get());
+		if (previousNative == false) {
+			m_native.reset();
+			fillEngine();
+		}
+	} else {
+		fillEngine();
+	}
+	m_residualTimeInResampler += getFilterDelay() - previousDelay;
+}
+
+void audio::drain::Resampler::fillEngine() {
+	size_t chunkSize = m_input.getChunkSize();
+	size_t nbChunk = etk::min(m_historyNbChunk, 2*m_engine->getInputLatency());
+	const int8_t* input = &m_history[(m_historyNbChunk-nbChunk)*chunkSize];
+	while (nbChunk > 0) {
+		uint32_t nbChunkInput = etk::min(nbChunk, size_t(64));
+		uint32_t nbChunkOutput = (uint64_t(nbChunkInput) * m_output.getFrequency() + m_input.getFrequency() - 1) / m_input.getFrequency() + 2;
+		processEngine(input, nbChunkInput, getOutputBuffer(nbChunkOutput), nbChunkOutput);
+		if (nbChunkInput == 0) {
+			break;
+		}
+		nbChunk -= nbChunkInput;
+		input += nbChunkInput*chunkSize;
+	}
+}
+
+void audio::drain::Resampler::storeHistory(const void* _input, size_t _nbChunk) {
+	if (    _nbChunk == 0
+	     || m_historyMaxChunk == 0) {
+		return;
+	}
+	size_t chunkSize = m_input.getChunkSize();
+	const int8_t* input = static_cast<const int8_t*>(_input);
+	if (_nbChunk >= m_historyMaxChunk) {
+		memcpy(&m_history[0], input + (_nbChunk-m_historyMaxChunk)*chunkSize, m_historyMaxChunk*chunkSize);
+		m_historyNbChunk = m_historyMaxChunk;
+		return;
+	}
+	size_t nbKeep = etk::min(m_historyNbChunk, m_historyMaxChunk - _nbChunk);
+	if (nbKeep != m_historyNbChunk) {
+		memmove(&m_history[0], &m_history[(m_historyNbChunk-nbKeep)*chunkSize], nbKeep*chunkSize);
+	}
+	memcpy(&m_history[nbKeep*chunkSize], input, _nbChunk*chunkSize);
+	m_historyNbChunk = nbKeep + _nbChunk;
+}
+
+audio::Duration audio::drain::Resampler::getLatency() const {
+	if (m_needProcess == false) {
+		return audio::Duration(0);
+	}
+	return m_residualTimeInResampler;
+}
+
+bool audio::drain::Resampler::getRatio(uint32_t& _num, uint32_t& _den) {
+	_num = 1;
+	_den = 1;
+	if (m_engine == null) {
+		return false;
+	}
+	m_engine->getRatio(_num, _den);
+	return true;
+}
+
+size_t audio::drain::Resampler::needInputData(size_t _output) {
+	if (    m_needProcess == true
+	     && m_engine != null
+	     && m_engine->m_native == true) {
+		// exact number (the native engine consume all its input ==> no residual)
+		return etk::max(size_t(1), m_native.getInputNeeded(_output));
+	}
+	uint32_t ratioNum = 1;
+	uint32_t ratioDen = 1;
+	if (    m_needProcess == true
+	     && getRatio(ratioNum, ratioDen) == true
+	     && ratioDen != 0) {
+		// exact ratio of the resampler: input = output * num / den (+1 for the fractional position of the filter)
+		return (uint64_t(_output) * ratioNum + ratioDen - 1) / ratioDen + 1;
+	}
+	return audio::drain::Algo::needInputData(_output);
+}
+
+bool audio::drain::Resampler::setParameter(const etk::String& _parameter, const etk::String& _value) {
+	if (_parameter == "quality") {
+		if (_value == "fast") {
+			setQuality(3);
+		} else if (_value == "balanced") {
+			setQuality(5);
+		} else if (_value == "hq") {
+			setQuality(10);
+		} else {
+			int32_t value = 0;
+			if (    sscanf(_value.c_str(), "%d", &value) != 1
+			     || value < 0
+			     || value > 10) {
+				DRAIN_ERROR("Can not set quality ... : '" << _value << "' not in [fast,balanced,hq,0..10]");
+				return false;
+			}
+			setQuality(value);
+		}
+		return true;
+	}
+	if (_parameter == "engine") {
+		if (_value == "native") {
+			setNativeEngine(true);
+		} else if (_value == "speex") {
+			#ifndef HAVE_SPEEX_DSP_RESAMPLE
+				DRAIN_ERROR("Can not set engine ... : 'speex' not available");
+				return false;
+			#endif
+			setNativeEngine(false);
+		} else {
+			DRAIN_ERROR("Can not set engine ... : '" << _value << "' not in [native,speex]");
+			return false;
+		}
+		return true;
+	}
+	DRAIN_ERROR("unknow set Parameter : '" << _parameter << "' with Value: '" << _value << "'");
+	return false;
+}
+
+etk::String audio::drain::Resampler::getParameter(const etk::String& _parameter) const {
+	if (_parameter == "quality") {
+		return etk::toString(getQuality());
+	}
+	if (_parameter == "engine") {
+		bool native = m_request.m_nativeEngine;
+		if (m_request.m_engine != null) {
+			// the integer ratios always use the native engine
+			native = m_request.m_engine->m_native;
+		}
+		if (native == true) {
+			return "native";
+		}
+		return "speex";
+	}
+	DRAIN_ERROR("unknow get Parameter : '" << _parameter << "'");
+	return "[ERROR]";
+}
+
+etk::String audio::drain::Resampler::getParameterProperty(const etk::String& _parameter) const {
+	if (_parameter == "quality") {
+		return "[fast,balanced,hq,0..10]";
+	}
+	if (_parameter == "engine") {
+		return "[native,speex]";
+	}
+	DRAIN_ERROR("unknow Parameter property for: '" << _parameter << "'");
+	return "[ERROR]";
+}
+
+void audio::drain::Resampler::processEngineFloat(const float* _input, uint32_t& _inputNbChunk, float* _output, uint32_t& _outputNbChunk) {
+	if (m_engine->m_native == true) {
+		m_native.process(_input, _inputNbChunk, _output, _outputNbChunk);
+		return;
+	}
 	#ifdef HAVE_SPEEX_DSP_RESAMPLE
-		if (m_speexResampler != null) {
-			speex_resampler_destroy(m_speexResampler);
-			m_speexResampler = null;
-		}
-		int err = 0;
-		DRAIN_WARNING("Create resampler for : " << m_input << " to " << m_output);
-		m_speexResampler = speex_resampler_init(m_output.getMap().size(),
-		                                        m_input.getFrequency(),
-		                                        m_output.getFrequency(),
-		                                        10, &err);
-		m_residualTimeInResampler = audio::Duration(0);
-	#else
-		DRAIN_WARNING("SPEEX DSP lib not accessible ==> can not resample");
-		m_needProcess = false;
+		int ret = speex_resampler_process_interleaved_float(m_engine->m_speex,
+		                                                    _input,
+		                                                    &_inputNbChunk,
+		                                                    _output,
+		                                                    &_outputNbChunk);
+		if (ret != 0) {
+			DRAIN_ERROR("                               speex error=" << ret);
+		}
 	#endif
 }
 
+void audio::drain::Resampler::processEngine(const void* _input, uint32_t& _inputNbChunk, void* _output, uint32_t& _outputNbChunk) {
+	switch (m_input.getFormat()) {
+		default:
+		case audio::format_int16:
+			if (m_engine->m_native == true) {
+				m_native.process(static_cast<const int16_t*>(_input),
+				                              _inputNbChunk,
+				                              static_cast<int16_t*>(_output),
+				                              _outputNbChunk);
+			} else {
+				#ifdef HAVE_SPEEX_DSP_RESAMPLE
+					int ret = speex_resampler_process_interleaved_int(m_engine->m_speex,
+					                                                  static_cast<const int16_t*>(_input),
+					                                                  &_inputNbChunk,
+					                                                  static_cast<int16_t*>(_output),
+					                                                  &_outputNbChunk);
+					if (ret != 0) {
+						DRAIN_ERROR("                               speex error=" << ret);
+					}
+				#endif
+			}
+			break;
+		case audio::format_float:
+			processEngineFloat(static_cast<const float*>(_input),
+			                   _inputNbChunk,
+			                   static_cast<float*>(_output),
+			                   _outputNbChunk);
+			break;
+		case audio::format_int16_on_int32:
+			{
+				// No 32 bits integer interface: the value (with the headroom) are resample in float
+				// by blocks of the buffers sized in updateBuffer (no allocation in the process)
+				size_t nbChannel = m_input.getMap().size();
+				DRAIN_ASSERT(m_floatInput.size() >= nbChannel && m_floatOutput.size() >= nbChannel, "Resampler float buffers not allocated");
+				const int32_t* in = static_cast<const int32_t*>(_input);
+				int32_t* out = static_cast<int32_t*>(_output);
+				uint32_t nbChunkInputDone = 0;
+				uint32_t nbChunkOutputDone = 0;
+				while (    nbChunkInputDone < _inputNbChunk
+				        && nbChunkOutputDone < _outputNbChunk) {
+					uint32_t nbChunkInput = etk::min(size_t(_inputNbChunk - nbChunkInputDone), m_floatInput.size()/nbChannel);
+					uint32_t nbChunkOutput = etk::min(size_t(_outputNbChunk - nbChunkOutputDone), m_floatOutput.size()/nbChannel);
+					for (size_t iii=0; iii<nbChunkInput*nbChannel; ++iii) {
+						m_floatInput[iii] = float(in[iii]);
+					}
+					processEngineFloat(&m_floatInput[0],
+					                   nbChunkInput,
+					                   &m_floatOutput[0],
+					                   nbChunkOutput);
+					for (size_t iii=0; iii<nbChunkOutput*nbChannel; ++iii) {
+						out[iii] = int32_t(etk::min(etk::max(-2147483648.0f, m_floatOutput[iii]), 2147483520.0f));
+					}
+					if (    nbChunkInput == 0
+					     && nbChunkOutput == 0) {
+						break;
+					}
+					in += nbChunkInput*nbChannel;
+					out += nbChunkOutput*nbChannel;
+					nbChunkInputDone += nbChunkInput;
+					nbChunkOutputDone += nbChunkOutput;
+				}
+				_inputNbChunk = nbChunkInputDone;
+				_outputNbChunk = nbChunkOutputDone;
+			}
+			break;
+	}
+}
+
 bool audio::drain::Resampler::process(audio::Time& _time,
                                       void* _input,
                                       size_t _inputNbChunk,
                                       void*& _output,
                                       size_t& _outputNbChunk) {
 	drain::AutoLogInOut tmpLog("Resampler");
+	// take the parameters published by the control thread since the previous period
+	applyParameter();
 	_outputNbChunk = 2048;
 	// chack if we need to process:
 	if (m_needProcess == false) {
@@ -96,7 +648,7 @@ bool audio::drain::Resampler::process(audio::Time& _time,
 		return true;
 	}
 	if (_input == null) {
-		_output = &(m_outputData[0]);
+		_output = m_outputData.data();
 		_outputNbChunk = 0;
 		DRAIN_ERROR("null pointer input ... ");
 		return false;
@@ -107,56 +659,81 @@ bool audio::drain::Resampler::process(audio::Time& _time,
 	
 	audio::Duration inTime(0, (int64_t(_inputNbChunk)*1000000000LL) / int64_t(m_input.getFrequency()));
 	m_residualTimeInResampler += inTime;
-	#ifdef HAVE_SPEEX_DSP_RESAMPLE
-		float nbInputTime = float(_inputNbChunk)/m_input.getFrequency();
-		float nbOutputSample = nbInputTime*m_output.getFrequency();
-		// we add 10% of the buffer size to have all the time enought data in the output to proceed all the input data...
-		_outputNbChunk = size_t(nbOutputSample*1.5f);
-		DRAIN_VERBOSE("                               freq in=" << m_input.getFrequency() << " out=" << m_output.getFrequency());
-		DRAIN_VERBOSE("                               Frame duration=" << nbInputTime);
-		DRAIN_VERBOSE("                               nbInput chunk=" << _inputNbChunk << " nbOutputChunk=" << nbOutputSample);
-		
-		m_outputData.resize(_outputNbChunk*m_output.getMap().size()*m_formatSize*16);
-		_output = &(m_outputData[0]);
-		if (m_speexResampler == null) {
-			DRAIN_ERROR("                               No speex resampler");
-			return false;
-		}
-		uint32_t nbChunkInput = _inputNbChunk;
-		uint32_t nbChunkOutput = _outputNbChunk;
-		DRAIN_VERBOSE("                               >> input=" << nbChunkInput << " output=" << nbChunkOutput);
-		int ret = speex_resampler_process_interleaved_int(m_speexResampler,
-		                                                  static_cast<int16_t*>(_input),
-		                                                  &nbChunkInput,
-		                                                  static_cast<int16_t*>(_output),
-		                                                  &nbChunkOutput);
-		DRAIN_VERBOSE("                               << input=" << nbChunkInput << " output=" << nbChunkOutput);
-		// update position of data:
-		m_positionWrite += nbChunkOutput;
-		// Check all input and output ...
-		if (nbChunkInput != _inputNbChunk) {
-			DRAIN_ERROR("                               inputSize (not all read ...) proceed=" << nbChunkInput << " requested=" << _inputNbChunk);
-			// TODO : manage this case ...
-		}
-		if (nbChunkOutput == _outputNbChunk) {
-			DRAIN_ERROR("                               Might have not enought data in output... output size=" << _outputNbChunk);
-			// TODO : manage this case ...
-		}
-		_outputNbChunk = nbChunkOutput;
-		DRAIN_VERBOSE("                               process chunk=" << nbChunkInput << " out=" << nbChunkOutput);
-		audio::Duration outTime(0, (int64_t(_outputNbChunk)*1000000000LL) / int64_t(m_output.getFrequency()));
-		DRAIN_VERBOSE("convert " << _inputNbChunk << " ==> " << _outputNbChunk << "    " << inTime << " => " << outTime);
-		// correct time :
-		m_residualTimeInResampler -= outTime;
-		/*
-		if (m_residualTimeInResampler.get() < 0) {
-			DRAIN_TODO("manage this case ... residual time in resampler : " << m_residualTimeInResampler << "ns");
-		}
-		*/
-		return true;
-	#else
+	// exact number of output chunk (ratio in/out = num/den), +1 for the fractional position of the filter
+	uint32_t ratioNum = 1;
+	uint32_t ratioDen = 1;
+	if (getRatio(ratioNum, ratioDen) == false) {
+		DRAIN_ERROR("                               No resampler engine");
 		_output = _input;
-		_outputNbChunk = _inputNbChunk;
+		_outputNbChunk = 0;
 		return false;
-	#endif
+	}
+	size_t nbInputTotal = _inputNbChunk + m_inputResidualNbChunk;
+	_outputNbChunk = (uint64_t(nbInputTotal) * ratioDen + ratioNum - 1) / ratioNum + 1;
+	DRAIN_VERBOSE("                               freq in=" << m_input.getFrequency() << " out=" << m_output.getFrequency());
+	DRAIN_VERBOSE("                               nbInput chunk=" << _inputNbChunk << " (+" << m_inputResidualNbChunk << " residual) nbOutputChunk=" << _outputNbChunk);
+	_output = getOutputBuffer(_outputNbChunk);
+	size_t chunkSize = m_input.getMap().size() * m_formatSize;
+	uint32_t nbChunkOutput = 0;
+	bool residual = m_inputResidualNbChunk > 0;
+	// first: the input not consumed by the previous call
+	if (m_inputResidualNbChunk > 0) {
+		uint32_t nbChunkInput = m_inputResidualNbChunk;
+		nbChunkOutput = _outputNbChunk;
+		processEngine(&m_inputResidual[0], nbChunkInput, _output, nbChunkOutput);
+		storeHistory(&m_inputResidual[0], nbChunkInput);
+		m_inputResidualNbChunk -= nbChunkInput;
+		if (m_inputResidualNbChunk > 0) {
+			memmove(&m_inputResidual[0], &m_inputResidual[nbChunkInput*chunkSize], m_inputResidualNbChunk*chunkSize);
+		}
+	}
+	// second: the new input
+	uint32_t nbChunkInput = 0;
+	if (m_inputResidualNbChunk == 0) {
+		nbChunkInput = _inputNbChunk;
+		uint32_t nbChunkOutputNew = _outputNbChunk - nbChunkOutput;
+		void* output = static_cast<int8_t*>(_output) + nbChunkOutput*chunkSize;
+		if (    m_inputSilence == true
+		     && m_engine->m_native == true
+		     && m_input.getFormat() == audio::format_float) {
+			// the filter is not computed when its history is 0
+			m_outputSilence =    m_native.processSilence(nbChunkInput, static_cast<float*>(output), nbChunkOutputNew) == true
+			                  && residual == false;
+		} else if (    m_inputSilence == true
+		            && m_engine->m_native == true
+		            && m_input.getFormat() == audio::format_int16) {
+			m_outputSilence =    m_native.processSilence(nbChunkInput, static_cast<int16_t*>(output), nbChunkOutputNew) == true
+			                  && residual == false;
+		} else {
+			processEngine(_input, nbChunkInput, output, nbChunkOutputNew);
+		}
+		storeHistory(_input, nbChunkInput);
+		nbChunkOutput += nbChunkOutputNew;
+	}
+	// keep the input not consumed for the next call
+	if (nbChunkInput < _inputNbChunk) {
+		size_t nbLeft = _inputNbChunk - nbChunkInput;
+		DRAIN_VERBOSE("                               keep " << nbLeft << " input chunk for the next call");
+		if (m_inputResidual.size() < (m_inputResidualNbChunk + nbLeft) * chunkSize) {
+			m_inputResidual.resize((m_inputResidualNbChunk + nbLeft) * chunkSize);
+		}
+		memcpy(&m_inputResidual[m_inputResidualNbChunk*chunkSize],
+		       static_cast<int8_t*>(_input) + nbChunkInput*chunkSize,
+		       nbLeft*chunkSize);
+		m_inputResidualNbChunk += nbLeft;
+	}
+	// update position of data:
+	m_positionWrite += nbChunkOutput;
+	_outputNbChunk = nbChunkOutput;
+	DRAIN_VERBOSE("                               process chunk=" << _inputNbChunk << " out=" << nbChunkOutput);
+	audio::Duration outTime(0, (int64_t(_outputNbChunk)*1000000000LL) / int64_t(m_output.getFrequency()));
+	DRAIN_VERBOSE("convert " << _inputNbChunk << " ==> " << _outputNbChunk << "    " << inTime << " => " << outTime);
+	// correct time :
+	m_residualTimeInResampler -= outTime;
+	/*
+	if (m_residualTimeInResampler.get() < 0) {
+		DRAIN_TODO("manage this case ... residual time in resampler : " << m_residualTimeInResampler << "ns");
+	}
+	*/
+	return true;
 }
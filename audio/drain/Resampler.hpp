@@ -6,22 +6,105 @@
 #pragma once
 
 #include <audio/drain/Algo.hpp>
+#include <audio/drain/PolyphaseResampler.hpp>
 #ifdef HAVE_SPEEX_DSP_RESAMPLE
 	#include <speex/speex_resampler.h>
 #endif
 #include <ememory/memory.hpp>
+#include <ethread/Mutex.hpp>
+#include <audio/drain/ParameterBlock.hpp>
 
 namespace audio {
 	namespace drain {
+		/**
+		 * @brief Resampler engine: created by the control thread, used by the audio thread.
+		 */
+		class ResamplerEngine {
+			public:
+				ResamplerEngine();
+				~ResamplerEngine();
+				#ifdef HAVE_SPEEX_DSP_RESAMPLE
+					SpeexResamplerState* m_speex; //!< Speex state (given back to the pool by the destructor)
+					uint32_t m_speexNbChannel; //!< Number of channel of m_speex (key of the pool)
+					uint32_t m_speexInputFrequency; //!< Input frequency of m_speex (key of the pool)
+					uint32_t m_speexOutputFrequency; //!< Output frequency of m_speex (key of the pool)
+				#endif
+				int32_t m_quality; //!< Quality of the filter [0..10]
+				bool m_native; //!< The native resampler is used (selected or integer ratio), speex otherwise
+				ememory::SharedPtr<audio::drain::PolyphaseBank> m_bank; //!< Filter of the native resampler
+				/**
+				 * @brief Get the delay of the filter.
+				 * @return Number of input chunk.
+				 */
+				size_t getInputLatency() const;
+				/**
+				 * @brief Get the exact ratio of the engine: input = output * num / den.
+				 * @param[out] _num Numerator.
+				 * @param[out] _den Denominator.
+				 */
+				void getRatio(uint32_t& _num, uint32_t& _den) const;
+		};
+		/**
+		 * @brief Parameters set by the control thread and applied by the audio thread at the next period.
+		 */
+		class ResamplerParameter {
+			public:
+				ResamplerParameter() :
+				  m_quality(10),
+				  m_nativeEngine(false) {
+					
+				}
+				int32_t m_quality; //!< Quality of the resampler [0..10]
+				bool m_nativeEngine; //!< Use the native engine instead of speex
+				ememory::SharedPtr<audio::drain::ResamplerEngine> m_engine; //!< Engine ready for these parameters (null when the IO are not configured)
+		};
 		// TODO: Manage change timestamp when pull mode
 		// TODO: drain ...
 		class Resampler : public audio::drain::Algo {
 			private:
-				#ifdef HAVE_SPEEX_DSP_RESAMPLE
-					SpeexResamplerState* m_speexResampler;
-				#endif
+				audio::drain::ResamplerEngine* m_engine; //!< Engine used by the process (owned by the current slot of m_parameter)
+				audio::drain::PolyphaseResampler m_native; //!< Resampler of audio-drain (its filter is the one of the native engines)
 				size_t m_positionRead; //!< For residual data in the buffer last read number of chunk
 				size_t m_positionWrite; //!< Current pointer of writing new output data of resampler
+				etk::Vector<float> m_floatInput; //!< Temporary input buffer for the int16_on_int32 format (resample in float)
+				etk::Vector<float> m_floatOutput; //!< Temporary output buffer for the int16_on_int32 format (resample in float)
+				etk::Vector<int8_t> m_inputResidual; //!< Input data not consumed by the previous process call
+				size_t m_inputResidualNbChunk; //!< Number of chunk in m_inputResidual
+				etk::Vector<int8_t> m_history; //!< Last input chunks consumed by the engine (fill the filter of a new engine)
+				size_t m_historyNbChunk; //!< Number of chunk in m_history
+				size_t m_historyMaxChunk; //!< Capacity of m_history (length of the longest filter)
+				ethread::Mutex m_parameterLock; //!< Serialize the control threads (never taken by the process)
+				audio::drain::ResamplerParameter m_request; //!< Last parameters requested by the control thread
+				audio::drain::ParameterBlock<audio::drain::ResamplerParameter> m_parameter; //!< Parameters published for the process
+				/**
+				 * @brief Create the engine of a configuration (control thread: compute the filter or initialize a speex state).
+				 * @param[in] _quality Quality [0..10].
+				 * @param[in] _nativeEngine Use the native engine instead of speex.
+				 * @return The engine (null when the IO are not configured).
+				 */
+				ememory::SharedPtr<audio::drain::ResamplerEngine> createEngine(int32_t _quality, bool _nativeEngine);
+				/**
+				 * @brief Publish m_request with the engine of its parameters (control thread, m_parameterLock locked).
+				 */
+				void publishRequest();
+				/**
+				 * @brief Take the engine published since the previous period (audio thread: no allocation, no lock).
+				 */
+				void applyParameter();
+				/**
+				 * @brief Fill the filter memory of a new engine with the last input chunks (the output is dropped).
+				 */
+				void fillEngine();
+				/**
+				 * @brief Keep the last input chunks consumed by the engine.
+				 * @param[in] _input Input data.
+				 * @param[in] _nbChunk Number of chunk.
+				 */
+				void storeHistory(const void* _input, size_t _nbChunk);
+				/**
+				 * @brief Size the buffers used by the process with the maximum size of a process call.
+				 */
+				void updateBuffer();
 			protected:
 				/**
 				 * @brief Constructor
@@ -36,14 +119,90 @@ namespace audio {
 				virtual ~Resampler();
 			protected:
 				virtual void configurationChange();
+				virtual void processBufferSizeChange();
 			public:
+				virtual bool isPassThrough() const {
+					return m_needProcess == false;
+				}
 				virtual bool process(audio::Time& _time,
 				                     void* _input,
 				                     size_t _inputNbChunk,
 				                     void*& _output,
 				                     size_t& _outputNbChunk);
+				virtual size_t needInputData(size_t _output);
+				virtual audio::Duration getLatency() const;
+			public:
+				/**
+				 * @brief Set the quality of the resampler (can be change during the stream without losing data).
+				 * @note Can be called from any thread: the new filter is computed here and used at the start of the next period.
+				 * @param[in] _quality Speex quality [0..10] (3 for VoIP, 5 for desktop, 10 for high quality).
+				 */
+				void setQuality(int32_t _quality);
+				/**
+				 * @brief Get the quality of the resampler.
+				 * @return Speex quality [0..10].
+				 */
+				int32_t getQuality() const {
+					return m_request.m_quality;
+				}
+				/**
+				 * @brief Select the resampler engine (the new engine is filled with the last input and used at the next period).
+				 * @note Without speex-dsp the native engine is always used, the integer ratios (2, 3, 4, 6) always use its dedicated kernels.
+				 * @param[in] _value true: polyphase resampler of audio-drain, false: speex.
+				 */
+				void setNativeEngine(bool _value);
+				/**
+				 * @brief Get the resampler engine.
+				 * @return true if the native polyphase resampler is used.
+				 */
+				bool getNativeEngine() const {
+					return m_request.m_nativeEngine;
+				}
+				virtual bool setParameter(const etk::String& _parameter, const etk::String& _value);
+				virtual etk::String getParameter(const etk::String& _parameter) const;
+				virtual etk::String getParameterProperty(const etk::String& _parameter) const;
+			public:
+				/**
+				 * @brief Set the maximum number of speex state kept by the global pool (default 16, 0 to disable).
+				 * @note A new resampler with the same (channels, frequencies, quality) as a released one only reset the filter memory instead of computing the sinc tables.
+				 * @param[in] _nbState Number of state.
+				 */
+				static void setPoolSize(size_t _nbState);
+				/**
+				 * @brief Get the number of speex state ready to be reused.
+				 * @return Number of state.
+				 */
+				static size_t getPoolCount();
+				/**
+				 * @brief Free all the speex states of the pool.
+				 */
+				static void clearPool();
 			private:
 				audio::Duration m_residualTimeInResampler; //!< the time of data locked in the resampler ...
+				/**
+				 * @brief Get the delay of the resampler filter.
+				 * @return Duration of the input data locked in the filter.
+				 */
+				audio::Duration getFilterDelay();
+				/**
+				 * @brief Get the exact ratio of the current engine: input = output * num / den.
+				 * @param[out] _num Numerator.
+				 * @param[out] _den Denominator.
+				 * @return false if no engine is configured.
+				 */
+				bool getRatio(uint32_t& _num, uint32_t& _den);
+				/**
+				 * @brief Resample a buffer with the current engine (in the current format).
+				 * @param[in] _input Input data.
+				 * @param[in,out] _inputNbChunk Number of input chunk (set at the number of chunk consumed).
+				 * @param[in] _output Output data.
+				 * @param[in,out] _outputNbChunk Number of chunk available in the output (set at the number of chunk produced).
+				 */
+				void processEngine(const void* _input, uint32_t& _inputNbChunk, void* _output, uint32_t& _outputNbChunk);
+				/**
+				 * @brief Resample a float buffer with the current engine (@see processEngine).
+				 */
+				void processEngineFloat(const float* _input, uint32_t& _inputNbChunk, float* _output, uint32_t& _outputNbChunk);
 		};
 	}
 }
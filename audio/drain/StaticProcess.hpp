@@ -0,0 +1,252 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <etk/Vector.hpp>
+#include <audio/drain/Algo.hpp>
+#include <audio/drain/AlignedBuffer.hpp>
+#include <audio/drain/IOFormatInterface.hpp>
+#include <type_traits>
+#include <audio/drain/debug.hpp>
+
+namespace audio {
+	namespace drain {
+		/**
+		 * @brief Algo stored by value in a StaticProcess (give access to the protected constructor and init of the algo).
+		 */
+		template<typename DRAIN_TYPE> class StaticStage : public DRAIN_TYPE {
+			public:
+				StaticStage() {
+					DRAIN_TYPE::init();
+				}
+		};
+		/**
+		 * @brief Check a value in a list of supported values.
+		 * @param[in] _list List of supported values (empty: all the values are supported).
+		 * @param[in] _value Value to check.
+		 * @return true The value is supported.
+		 */
+		template<typename DRAIN_TYPE> bool staticIsSupported(const etk::Vector<DRAIN_TYPE>& _list, const DRAIN_TYPE& _value) {
+			if (_list.size() == 0) {
+				return true;
+			}
+			for (size_t iii=0; iii<_list.size(); ++iii) {
+				if (_list[iii] == _value) {
+					return true;
+				}
+			}
+			return false;
+		}
+		/**
+		 * @brief Recursive list of the stages of a StaticProcess (end of the list).
+		 */
+		template<typename... DRAIN_STAGE> class StaticChain {
+			public:
+				bool configure(const audio::drain::IOFormatInterface* /*_format*/) {
+					return true;
+				}
+				void process(audio::Time& /*_time*/, void*& /*_data*/, size_t& /*_nbChunk*/, int8_t** /*_buffer*/, size_t /*_bufferSize*/) {
+					// no more stage: the data stay in place
+				}
+				audio::Duration getLatency() const {
+					return audio::Duration(0);
+				}
+		};
+		/**
+		 * @brief Recursive list of the stages of a StaticProcess: the first stage and the others.
+		 */
+		template<typename DRAIN_FIRST, typename... DRAIN_OTHER> class StaticChain<DRAIN_FIRST, DRAIN_OTHER...> {
+			static_assert(std::is_base_of<audio::drain::Algo, DRAIN_FIRST>::value == true, "A stage of a StaticProcess must be an audio::drain::Algo");
+			protected:
+				audio::drain::StaticStage<DRAIN_FIRST> m_stage; //!< Algo of this stage
+				audio::drain::StaticChain<DRAIN_OTHER...> m_next; //!< Next stages
+			public:
+				/**
+				 * @brief Set the formats of this stage and the next ones.
+				 * @param[in] _format Input format of this stage, followed by the output format of each stage.
+				 * @return true The algos support the formats.
+				 */
+				bool configure(const audio::drain::IOFormatInterface* _format) {
+					if (    audio::drain::staticIsSupported(m_stage.getFormatSupportedInput(), _format[0].getFormat()) == false
+					     || audio::drain::staticIsSupported(m_stage.getFormatSupportedOutput(), _format[1].getFormat()) == false
+					     || audio::drain::staticIsSupported(m_stage.getMapSupportedInput(), _format[0].getMap()) == false
+					     || audio::drain::staticIsSupported(m_stage.getMapSupportedOutput(), _format[1].getMap()) == false
+					     || audio::drain::staticIsSupported(m_stage.getFrequencySupportedInput(), _format[0].getFrequency()) == false
+					     || audio::drain::staticIsSupported(m_stage.getFrequencySupportedOutput(), _format[1].getFrequency()) == false
+					     || audio::drain::staticIsSupported(m_stage.getLayoutSupportedInput(), _format[0].getLayout()) == false
+					     || audio::drain::staticIsSupported(m_stage.getLayoutSupportedOutput(), _format[1].getLayout()) == false) {
+						DRAIN_ERROR("Static process: " << m_stage.getType() << " does not support " << _format[0] << " ==> " << _format[1]);
+						return false;
+					}
+					m_stage.setFormat(_format[0], _format[1]);
+					return m_next.configure(&_format[1]);
+				}
+				/**
+				 * @brief Process the data in this stage and the next ones (direct call of the algos: no virtual dispatch).
+				 * @param[in] _time Time of the first sample.
+				 * @param[in,out] _data Input data, set at the output data.
+				 * @param[in,out] _nbChunk Input number of chunk, set at the output number of chunk.
+				 * @param[in] _buffer Ping-pong buffers of the process.
+				 * @param[in] _bufferSize Size in byte of each ping-pong buffer.
+				 */
+				void process(audio::Time& _time, void*& _data, size_t& _nbChunk, int8_t** _buffer, size_t _bufferSize) {
+					if (m_stage.DRAIN_FIRST::isPassThrough() == false) {
+						// same selection of the ping-pong buffer as the dynamic process
+						bool inPlace = m_stage.DRAIN_FIRST::canProcessInPlace();
+						if (_data == _buffer[0]) {
+							m_stage.setOutputBuffer(inPlace == true ? _buffer[0] : _buffer[1], _bufferSize);
+						} else if (_data == _buffer[1]) {
+							m_stage.setOutputBuffer(inPlace == true ? _buffer[1] : _buffer[0], _bufferSize);
+						} else {
+							// user buffer ==> never write on it
+							m_stage.setOutputBuffer(_buffer[0], _bufferSize);
+						}
+						void* outData = null;
+						size_t outNbChunk = 0;
+						m_stage.DRAIN_FIRST::process(_time, _data, _nbChunk, outData, outNbChunk);
+						m_stage.setOutputBuffer(null, 0);
+						_data = outData;
+						_nbChunk = outNbChunk;
+					}
+					m_next.process(_time, _data, _nbChunk, _buffer, _bufferSize);
+				}
+				/**
+				 * @brief Get the delay of this stage and the next ones.
+				 * @return Duration of the data kept inside the algos.
+				 */
+				audio::Duration getLatency() const {
+					return m_stage.DRAIN_FIRST::getLatency() + m_next.getLatency();
+				}
+				/**
+				 * @brief Get the algo of a stage.
+				 * @return The algo of the stage DRAIN_ID.
+				 */
+				template<size_t DRAIN_ID> typename std::enable_if<DRAIN_ID == 0, DRAIN_FIRST&>::type get() {
+					return m_stage;
+				}
+				template<size_t DRAIN_ID> typename std::enable_if<DRAIN_ID != 0, decltype(m_next.template get<DRAIN_ID-1>())>::type get() {
+					return m_next.template get<DRAIN_ID-1>();
+				}
+		};
+		/**
+		 * @brief Processing chain fixed at the compilation: the algos are members of the process (no allocation of the
+		 * algos, no shared pointer) and are called directly by their type (no virtual dispatch: the compiler can inline
+		 * the kernels when their definitions are visible, LTO build).
+		 * The formats are given by the user at the configuration: no negotiation and no temporary algo (add the
+		 * ChannelReorder, FormatUpdate or Resampler stages needed in the list).
+		 * @code
+		 * audio::drain::StaticProcess<audio::drain::Volume, audio::drain::Equalizer, audio::drain::FormatUpdate> process;
+		 * audio::drain::IOFormatInterface format[4] = {stereoFloat, stereoFloat, stereoFloat, stereoInt16};
+		 * process.configure(format);
+		 * process.get<0>().setParameter("volume", "-3dB");
+		 * @endcode
+		 * @note The algos keep a pointer on themselves (format callbacks): the process can not be copied.
+		 */
+		template<typename... DRAIN_STAGE> class StaticProcess {
+			public:
+				static const size_t m_nbStage = sizeof...(DRAIN_STAGE); //!< Number of stage of the chain
+			protected:
+				audio::drain::StaticChain<DRAIN_STAGE...> m_chain; //!< Algos of the chain
+				audio::drain::IOFormatInterface m_format[m_nbStage+1]; //!< Input format then output format of each stage
+				audio::drain::AlignedBuffer m_processBuffer[2]; //!< ping-pong buffers shared by all the stages
+				size_t m_processBufferNbChunk; //!< Number of input chunk that the ping-pong buffers can manage in one process call
+				bool m_isConfigured; //!< All the stages accept their formats
+			public:
+				StaticProcess() :
+				  m_processBufferNbChunk(4096),
+				  m_isConfigured(false) {
+
+				}
+				StaticProcess(const StaticProcess&) = delete;
+				StaticProcess& operator=(const StaticProcess&) = delete;
+			public:
+				/**
+				 * @brief Configure all the stages (the only moment where the process allocate memory).
+				 * @param[in] _format Input format of the first stage, followed by the output format of each stage.
+				 * @param[in] _nbChunk Maximum number of input chunk of a process call without allocation.
+				 * @return true The algos support the formats.
+				 */
+				bool configure(const audio::drain::IOFormatInterface (&_format)[m_nbStage+1], size_t _nbChunk=4096) {
+					for (size_t iii=0; iii<m_nbStage+1; ++iii) {
+						m_format[iii] = _format[iii];
+					}
+					m_processBufferNbChunk = _nbChunk;
+					m_isConfigured = m_chain.configure(m_format);
+					// get the biggest output of the chain (same rule as the dynamic process)
+					size_t maxSize = 0;
+					float inputFrequency = m_format[0].getFrequency();
+					for (size_t iii=1; iii<m_nbStage+1; ++iii) {
+						float nbChunk = m_processBufferNbChunk;
+						if (    inputFrequency > 0.0f
+						     && m_format[iii].getFrequency() > 0.0f) {
+							nbChunk *= m_format[iii].getFrequency() / inputFrequency * 1.5f;
+						}
+						maxSize = etk::max(maxSize, (size_t(nbChunk) + 1) * m_format[iii].getChunkSize());
+					}
+					m_processBuffer[0].resize(maxSize);
+					m_processBuffer[1].resize(maxSize);
+					return m_isConfigured;
+				}
+				/**
+				 * @brief Process data in the chain.
+				 * @param[in] _time Time of the first sample.
+				 * @param[in] _inData Pointer on the input data.
+				 * @param[in] _inNbChunk Number of chunk in the input.
+				 * @param[out] _outData Pointer on the output data (the input, a buffer of the process or of an algo).
+				 * @param[out] _outNbChunk Number of chunk in the output.
+				 * @return true The process is done corectly.
+				 * @return false The process is not configured.
+				 */
+				bool process(audio::Time& _time,
+				             void* _inData,
+				             size_t _inNbChunk,
+				             void*& _outData,
+				             size_t& _outNbChunk) {
+					_outData = _inData;
+					_outNbChunk = _inNbChunk;
+					if (m_isConfigured == false) {
+						return false;
+					}
+					int8_t* buffer[2] = {reinterpret_cast<int8_t*>(m_processBuffer[0].data()),
+					                     reinterpret_cast<int8_t*>(m_processBuffer[1].data())};
+					m_chain.process(_time, _outData, _outNbChunk, buffer, m_processBuffer[0].size());
+					return true;
+				}
+				/**
+				 * @brief Get the algo of a stage (to set its parameters).
+				 * @return The algo of the stage DRAIN_ID.
+				 */
+				template<size_t DRAIN_ID> auto get() -> decltype(m_chain.template get<DRAIN_ID>()) {
+					static_assert(DRAIN_ID < m_nbStage, "Stage id out of the chain");
+					return m_chain.template get<DRAIN_ID>();
+				}
+				/**
+				 * @brief Get the input format of the chain.
+				 * @return Format of the input of the first stage.
+				 */
+				const audio::drain::IOFormatInterface& getInputConfig() const {
+					return m_format[0];
+				}
+				/**
+				 * @brief Get the output format of the chain.
+				 * @return Format of the output of the last stage.
+				 */
+				const audio::drain::IOFormatInterface& getOutputConfig() const {
+					return m_format[m_nbStage];
+				}
+				/**
+				 * @brief Get the delay of the chain.
+				 * @return Delay between the input and the output of the chain.
+				 */
+				audio::Duration getLatency() const {
+					return m_chain.getLatency();
+				}
+		};
+	}
+}
+#include "debugRemove.hpp"
+
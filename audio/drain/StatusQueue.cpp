@@ -0,0 +1,64 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <audio/drain/StatusQueue.hpp>
+#include <audio/drain/debug.hpp>
+
+const char* audio::drain::getStatusName(enum audio::drain::status _status) {
+	switch (_status) {
+		case audio::drain::status_endPointWriteUnderflow:
+			return "EPW_UNDERFLOW";
+		case audio::drain::status_endPointReadOverflow:
+			return "EPR_OVERFLOW";
+		case audio::drain::status_count:
+			break;
+	}
+	return "UNKNOW";
+}
+
+etk::Stream& audio::drain::operator <<(etk::Stream& _os, enum audio::drain::status _obj) {
+	_os << audio::drain::getStatusName(_obj);
+	return _os;
+}
+
+audio::drain::StatusQueue::StatusQueue(size_t _capacity) :
+  m_mask(0),
+  m_write(0),
+  m_read(0),
+  m_nbDrop(0),
+  m_enable(false),
+  m_minInterval(0, 100000000LL) {
+	size_t capacity = 1;
+	while (capacity < _capacity) {
+		capacity <<= 1;
+	}
+	m_event.resize(capacity);
+	m_mask = capacity - 1;
+}
+
+bool audio::drain::StatusQueue::post(const audio::drain::StatusEvent& _event) {
+	// Only the writer update the write position
+	uint64_t positionWrite = m_write.load(std::memory_order_relaxed);
+	if (positionWrite - m_read.load(std::memory_order_acquire) >= m_event.size()) {
+		m_nbDrop.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	m_event[positionWrite & m_mask] = _event;
+	m_write.store(positionWrite + 1, std::memory_order_release);
+	return true;
+}
+
+bool audio::drain::StatusQueue::pop(audio::drain::StatusEvent& _event) {
+	// Only the reader update the read position
+	uint64_t positionRead = m_read.load(std::memory_order_relaxed);
+	if (positionRead == m_write.load(std::memory_order_acquire)) {
+		return false;
+	}
+	_event = m_event[positionRead & m_mask];
+	m_read.store(positionRead + 1, std::memory_order_release);
+	return true;
+}
+
@@ -0,0 +1,113 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <etk/Vector.hpp>
+#include <audio/Time.hpp>
+#include <audio/Duration.hpp>
+#include <atomic>
+
+namespace audio {
+	namespace drain {
+		class Algo;
+		/**
+		 * @brief Status generated by the algos during the process.
+		 */
+		enum status {
+			status_endPointWriteUnderflow, //!< "EPW_UNDERFLOW": no enough data written by the user
+			status_endPointReadOverflow, //!< "EPR_OVERFLOW": the user does not read the data fast enough
+			status_count, //!< Number of status (not a status)
+		};
+		/**
+		 * @brief Get the name of a status (string given to the status callbacks).
+		 * @param[in] _status Status.
+		 * @return Static string of the status.
+		 */
+		const char* getStatusName(enum audio::drain::status _status);
+		etk::Stream& operator <<(etk::Stream& _os, enum audio::drain::status _obj);
+		/**
+		 * @brief Status posted by the audio thread (no allocation: only ids and counters).
+		 */
+		class StatusEvent {
+			public:
+				enum audio::drain::status m_status; //!< Status
+				const audio::drain::Algo* m_origin; //!< Algo that generate the status (only compared, never dereferenced)
+				uint32_t m_count; //!< Number of occurence coalesced in this event
+				audio::Time m_time; //!< Time of the post
+		};
+		/**
+		 * @brief Lock-free queue of StatusEvent: the audio thread post, a control thread drain.
+		 * The events are preallocated at the construction: a post never allocate and never wait, a full queue
+		 * drop the event (counted).
+		 * @note Only one writer and one reader at a time.
+		 */
+		class StatusQueue {
+			protected:
+				etk::Vector<audio::drain::StatusEvent> m_event; //!< Ring of events (size: power of 2)
+				size_t m_mask; //!< m_event.size()-1
+				std::atomic<uint64_t> m_write; //!< Number of event posted (updated by the writer)
+				std::atomic<uint64_t> m_read; //!< Number of event read (updated by the reader)
+				std::atomic<uint32_t> m_nbDrop; //!< Number of event dropped on a full queue
+				std::atomic<bool> m_enable; //!< The algos post in the queue instead of calling the status callback
+				audio::Duration m_minInterval; //!< Minimum delay between 2 events of a status of an algo (coalescing)
+			public:
+				/**
+				 * @brief Constructor.
+				 * @param[in] _capacity Number of event (rounded up to a power of 2).
+				 */
+				StatusQueue(size_t _capacity=64);
+				/**
+				 * @brief Post an event (writer side).
+				 * @param[in] _event Event to post.
+				 * @return false The queue is full (event dropped).
+				 */
+				bool post(const audio::drain::StatusEvent& _event);
+				/**
+				 * @brief Get the oldest event (reader side).
+				 * @param[out] _event Event read.
+				 * @return false No event in the queue.
+				 */
+				bool pop(audio::drain::StatusEvent& _event);
+				/**
+				 * @brief Get and reset the number of dropped events.
+				 * @return Number of event lost since the previous call.
+				 */
+				uint32_t takeNbDrop() {
+					return m_nbDrop.exchange(0, std::memory_order_acq_rel);
+				}
+				/**
+				 * @brief Enable the queue (the status callback is no more called by the audio thread).
+				 * @param[in] _value New state.
+				 */
+				void setEnable(bool _value) {
+					m_enable.store(_value, std::memory_order_release);
+				}
+				/**
+				 * @brief Check if the queue is enable.
+				 * @return true The status are posted in the queue.
+				 */
+				bool getEnable() const {
+					return m_enable.load(std::memory_order_acquire);
+				}
+				/**
+				 * @brief Set the minimum delay between 2 events of the same status and algo (the occurences between are coalesced).
+				 * @param[in] _value Delay (0: one event by occurence).
+				 */
+				void setMinInterval(const audio::Duration& _value) {
+					m_minInterval = _value;
+				}
+				/**
+				 * @brief Get the minimum delay between 2 events of the same status and algo.
+				 * @return Delay.
+				 */
+				const audio::Duration& getMinInterval() const {
+					return m_minInterval;
+				}
+		};
+	}
+}
+
@@ -8,11 +8,29 @@
 extern "C" {
 	#include <math.h>
 }
+#include <type_traits>
+#include <audio/drain/cpu.hpp>
 #include <audio/drain/debug.hpp>
 
+//! Number of frame processed in one step of a ramp (size of the gain table)
+static const size_t g_rampBlockSize = 256;
+//! Lower gain used as start/stop of an exponential ramp (-120dB)
+static const float g_rampMinGain = 0.000001f;
+static const float g_floatInt32Max = 2147483520.0f;
+
 audio::drain::Volume::Volume() :
   m_volumeAppli(1.0f),
-  m_functionConvert(null) {
+  m_volumeDecalage(0),
+  m_volumeCoef(1<<16),
+  m_functionConvert(null),
+  m_rampType(audio::drain::volumeRamp_linear),
+  m_rampDuration(10.0f),
+  m_volumeCurrent(1.0f),
+  m_rampStep(0.0f),
+  m_rampNbFrame(0),
+  m_rampScale(1.0f),
+  m_functionRamp(null),
+  m_functionExpandGain(null) {
 	
 }
 
@@ -21,6 +39,8 @@ void audio::drain::Volume::init() {
 	m_type = "Volume";
 	m_supportedFormat.pushBack(audio::format_int16);
 	m_supportedFormat.pushBack(audio::format_int16_on_int32);
+	// gain by sample: the ramp is managed for the 2 layouts
+	m_supportedLayout.pushBack(audio::drain::layout_planar);
 }
 
 ememory::SharedPtr<audio::drain::Volume> audio::drain::Volume::create() {
@@ -33,55 +53,151 @@ audio::drain::Volume::~Volume() {
 	
 }
 
-static int32_t neareastsss(float _val) {
-	int32_t out = 0;
-	while (_val > float(1<<out)) {
-		out++;
+//! Number of step by dB of the gain table
+static const int32_t g_gainTableStep = 256;
+//! Limit of the gain table (the total volume of the stages is clamped on it)
+static const int32_t g_gainTableRange = 400;
+/**
+ * @brief Table of the dB to linear gain: 10^(dB/20) = decade * unit * fraction (computed once).
+ */
+class gainTable {
+	public:
+		double m_decade[2*g_gainTableRange/20+1]; //!< 10^k for k in [-20..20] (step of 20dB)
+		double m_unit[20]; //!< Gain of [0..19] dB
+		double m_fraction[g_gainTableStep+1]; //!< Gain of [0..1] dB by step of 1/g_gainTableStep dB
+		gainTable() {
+			for (int32_t iii=0; iii<=2*g_gainTableRange/20; ++iii) {
+				m_decade[iii] = pow(10.0, double(iii - g_gainTableRange/20));
+			}
+			for (int32_t iii=0; iii<20; ++iii) {
+				m_unit[iii] = pow(10.0, double(iii)/20.0);
+			}
+			for (int32_t iii=0; iii<=g_gainTableStep; ++iii) {
+				m_fraction[iii] = pow(10.0, double(iii)/double(g_gainTableStep)/20.0);
+			}
+		}
+};
+
+/**
+ * @brief Get the linear gain of a volume (no pow: 3 products and a linear interpolation, relative error < 1e-7).
+ * @param[in] _volumedB Volume in dB.
+ * @return Linear gain.
+ */
+static double getGain(double _volumedB) {
+	static const gainTable table;
+	double volumedB = etk::min(etk::max(_volumedB, -double(g_gainTableRange)), double(g_gainTableRange) - 0.000001);
+	double position = volumedB + double(g_gainTableRange);
+	int32_t decade = int32_t(position / 20.0);
+	position -= double(decade) * 20.0;
+	int32_t unit = etk::min(int32_t(position), 19);
+	position = (position - double(unit)) * double(g_gainTableStep);
+	int32_t fraction = etk::min(int32_t(position), g_gainTableStep - 1);
+	double ratio = position - double(fraction);
+	double gainFraction = table.m_fraction[fraction] + (table.m_fraction[fraction+1] - table.m_fraction[fraction]) * ratio;
+	return table.m_decade[decade] * table.m_unit[unit] * gainFraction;
+}
+
+/**
+ * @brief Get the scale of a format in the fixed point kernels (bit shift of the full scale from the int16).
+ * @return Shift (-1: the format does not use the fixed point kernels).
+ */
+static int32_t getFixedScale(enum audio::format _format) {
+	switch (_format) {
+		case audio::format_int16:
+		case audio::format_int16_on_int32:
+			return 0;
+		case audio::format_int32:
+			return 16;
+		default:
+			return -1;
+	}
+}
+
+/**
+ * @brief Get the fixed point gain of a couple of formats: out = (in * coef + (1<<(decalage-1))) >> decalage.
+ * @param[in] _gain Linear gain.
+ * @param[in] _precision Number of bit of the fractional part of the coef (16: product on 32 bits, 30: product on 64 bits).
+ * @param[in] _scale Shift of the input full scale less the shift of the output full scale (getFixedScale).
+ * @param[out] _coef Multiplier (< 2^(_precision+1)).
+ * @param[out] _decalage Shift of the product.
+ */
+static void getFixedGain(double _gain, int32_t _precision, int32_t _scale, int32_t& _coef, int32_t& _decalage) {
+	// smallest integer part (power of 2) that contain the gain: the fractional bits are removed from it
+	int32_t exponent = 0;
+	frexp(_gain, &exponent);
+	if (_gain <= ldexp(1.0, exponent - 1)) {
+		exponent--;
+	}
+	int32_t exponentMax = etk::min(_precision, _precision + _scale);
+	if (exponent > exponentMax) {
+		// the output saturate in all case
+		exponent = exponentMax;
+		_gain = ldexp(1.0, exponent);
 	}
-	return etk::min(16,out);
+	exponent = etk::max(exponent, int32_t(0));
+	_coef = int32_t(ldexp(_gain, _precision - exponent) + 0.5);
+	_decalage = _precision - exponent + _scale;
 }
 
+static inline int16_t saturateInt16(int32_t _value) {
+	return int16_t(etk::min(etk::max(_value, int32_t(INT16_MIN)), int32_t(INT16_MAX)));
+}
+static inline int32_t saturateInt32(int64_t _value) {
+	return int32_t(etk::min(etk::max(_value, int64_t(INT32_MIN)), int64_t(INT32_MAX)));
+}
+static inline int64_t getRound(int32_t _decalage) {
+	return _decalage > 0 ? int64_t(1) << (_decalage-1) : 0;
+}
 
+/**
+ * @brief Q16 gain: the product stay on 32 bits (coef <= 2^16).
+ */
 static void convert__int16__to__int16(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli) {
 	int16_t* in = static_cast<int16_t*>(_input);
 	int16_t* out = static_cast<int16_t*>(_output);
+	const int32_t round = int32_t(getRound(_volumeDecalage));
 	for (size_t iii=0; iii<_nbSample; ++iii) {
-		out[iii] = int16_t((int32_t(in[iii]) * int32_t(_volumeCoef)) >> _volumeDecalage);
+		out[iii] = saturateInt16((int32_t(in[iii]) * _volumeCoef + round) >> _volumeDecalage);
 	}
 }
-static void convert__int16__to__float(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli) {
+static void convert__int16__to__float(void* _input, void* _output, size_t _nbSample, int32_t /*_volumeCoef*/, int32_t /*_volumeDecalage*/, float _volumeAppli) {
 	int16_t* in = static_cast<int16_t*>(_input);
 	float* out = static_cast<float*>(_output);
+	// exact in float: no fixed point
+	const float coef = _volumeAppli * (1.0f/audio::drain::int16FullScale);
 	for (size_t iii=0; iii<_nbSample; ++iii) {
-		out[iii] = double((int32_t(in[iii]) * int32_t(_volumeCoef)) >> _volumeDecalage) * 0.00003051757;
+		out[iii] = float(in[iii]) * coef;
 	}
 }
 
+/**
+ * @brief Q30 gain: the product is on 64 bits (precision of the int32 formats).
+ */
 static void convert__int16__to__int32(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli) {
 	int16_t* in = static_cast<int16_t*>(_input);
 	int32_t* out = static_cast<int32_t*>(_output);
+	const int64_t round = getRound(_volumeDecalage);
 	for (size_t iii=0; iii<_nbSample; ++iii) {
-		out[iii] = (int32_t(in[iii]) * int32_t(_volumeCoef)) >> _volumeDecalage;
+		out[iii] = saturateInt32((int64_t(in[iii]) * int64_t(_volumeCoef) + round) >> _volumeDecalage);
 	}
-	//DRAIN_INFO("plop " << in[0] << " >> " << out[0]);
 }
 
 static void convert__int32__to__int16(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli) {
 	int32_t* in = static_cast<int32_t*>(_input);
 	int16_t* out = static_cast<int16_t*>(_output);
+	const int64_t round = getRound(_volumeDecalage);
 	for (size_t iii=0; iii<_nbSample; ++iii) {
-		int32_t value = in[iii] >> 16;
-		out[iii] = int16_t((int64_t(in[iii]) * int64_t(_volumeCoef)) >> _volumeDecalage);
+		out[iii] = saturateInt16(saturateInt32((int64_t(in[iii]) * int64_t(_volumeCoef) + round) >> _volumeDecalage));
 	}
 }
 
 static void convert__int32__to__int32(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli) {
 	int32_t* in = static_cast<int32_t*>(_input);
 	int32_t* out = static_cast<int32_t*>(_output);
+	const int64_t round = getRound(_volumeDecalage);
 	for (size_t iii=0; iii<_nbSample; ++iii) {
-		out[iii] = int32_t((int64_t(in[iii]) * int64_t(_volumeCoef)) >> _volumeDecalage);
+		out[iii] = saturateInt32((int64_t(in[iii]) * int64_t(_volumeCoef) + round) >> _volumeDecalage);
 	}
-	//DRAIN_INFO("plop " << in[0] << " >> " << out[0]);
 }
 
 static void convert__float__to__float(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli) {
@@ -92,58 +208,527 @@ static void convert__float__to__float(void* _input, void* _output, size_t _nbSam
 	}
 }
 
-void audio::drain::Volume::configurationChange() {
-	audio::drain::Algo::configurationChange();
-	switch (m_input.getFormat()) {
+static inline void rampStore(float _value, int16_t& _output) {
+	_output = static_cast<int16_t>(etk::min(etk::max(static_cast<float>(INT16_MIN), _value), static_cast<float>(INT16_MAX)));
+}
+static inline void rampStore(float _value, int32_t& _output) {
+	_output = static_cast<int32_t>(etk::min(etk::max(static_cast<float>(INT32_MIN), _value), g_floatInt32Max));
+}
+static inline void rampStore(float _value, float& _output) {
+	_output = _value;
+}
+
+/**
+ * @brief Apply a gain for each sample (the gain include the scale between the 2 formats).
+ */
+template<typename TYPE_IN, typename TYPE_OUT>
+static void ramp(const void* _input, void* _output, size_t _nbSample, const float* _gain) {
+	const TYPE_IN* in = static_cast<const TYPE_IN*>(_input);
+	TYPE_OUT* out = static_cast<TYPE_OUT*>(_output);
+	for (size_t iii=0; iii<_nbSample; ++iii) {
+		rampStore(static_cast<float>(in[iii]) * _gain[iii], out[iii]);
+	}
+}
+
+/**
+ * @brief Expand in place the gain of each frame (_gain[0.._nbFrame[) on all the channels of the frame.
+ * @note Done from the end: a gain is read before its position is written.
+ */
+template<size_t NB_CHANNEL>
+static void expandGain(float* _gain, size_t _nbFrame, size_t /*_nbChannel*/) {
+	for (size_t iii=_nbFrame; iii>0; --iii) {
+		float gain = _gain[iii-1];
+		for (size_t jjj=0; jjj<NB_CHANNEL; ++jjj) {
+			_gain[(iii-1)*NB_CHANNEL + jjj] = gain;
+		}
+	}
+}
+
+static void expandGainGeneric(float* _gain, size_t _nbFrame, size_t _nbChannel) {
+	for (size_t iii=_nbFrame; iii>0; --iii) {
+		float gain = _gain[iii-1];
+		for (size_t jjj=0; jjj<_nbChannel; ++jjj) {
+			_gain[(iii-1)*_nbChannel + jjj] = gain;
+		}
+	}
+}
+
+/**
+ * @brief Mono: the gain of the frames is already the gain of the samples.
+ */
+static void expandGainMono(float* /*_gain*/, size_t /*_nbFrame*/, size_t /*_nbChannel*/) {
+	
+}
+
+/**
+ * @brief Properties of the samples of a format for the generic kernels.
+ * getFullScale(): value of a full scale signal, getMin()/getMax(): saturation of the storage (exact in a float).
+ */
+template<enum audio::format DRAIN_FORMAT> class volumeSample;
+template<> class volumeSample<audio::format_int8> {
+	public:
+		typedef int8_t type;
+		static constexpr double getFullScale() { return 128.0; }
+		static constexpr double getMin() { return -128.0; }
+		static constexpr double getMax() { return 127.0; }
+		static constexpr bool isInteger() { return true; }
+};
+template<> class volumeSample<audio::format_int8_on_int16> {
+	public:
+		typedef int16_t type;
+		static constexpr double getFullScale() { return 128.0; }
+		static constexpr double getMin() { return -32768.0; }
+		static constexpr double getMax() { return 32767.0; }
+		static constexpr bool isInteger() { return true; }
+};
+template<> class volumeSample<audio::format_int16> {
+	public:
+		typedef int16_t type;
+		static constexpr double getFullScale() { return audio::drain::int16FullScale; }
+		static constexpr double getMin() { return -32768.0; }
+		static constexpr double getMax() { return 32767.0; }
+		static constexpr bool isInteger() { return true; }
+};
+template<> class volumeSample<audio::format_int16_on_int32> {
+	public:
+		typedef int32_t type;
+		static constexpr double getFullScale() { return audio::drain::int16FullScale; }
+		static constexpr double getMin() { return -2147483648.0; }
+		static constexpr double getMax() { return 2147483520.0; }
+		static constexpr bool isInteger() { return true; }
+};
+template<> class volumeSample<audio::format_int24> {
+	public:
+		typedef int32_t type;
+		static constexpr double getFullScale() { return 8388608.0; }
+		static constexpr double getMin() { return -8388608.0; }
+		static constexpr double getMax() { return 8388607.0; }
+		static constexpr bool isInteger() { return true; }
+};
+template<> class volumeSample<audio::format_int32> {
+	public:
+		typedef int32_t type;
+		static constexpr double getFullScale() { return 2147483648.0; }
+		static constexpr double getMin() { return -2147483648.0; }
+		static constexpr double getMax() { return 2147483520.0; }
+		static constexpr bool isInteger() { return true; }
+};
+template<> class volumeSample<audio::format_int32_on_int64> {
+	public:
+		typedef int64_t type;
+		static constexpr double getFullScale() { return 2147483648.0; }
+		static constexpr double getMin() { return -9223372036854775808.0; }
+		static constexpr double getMax() { return 9223371487098961920.0; }
+		static constexpr bool isInteger() { return true; }
+};
+template<> class volumeSample<audio::format_int64> {
+	public:
+		typedef int64_t type;
+		static constexpr double getFullScale() { return 9223372036854775808.0; }
+		static constexpr double getMin() { return -9223372036854775808.0; }
+		static constexpr double getMax() { return 9223371487098961920.0; }
+		static constexpr bool isInteger() { return true; }
+};
+template<> class volumeSample<audio::format_float> {
+	public:
+		typedef float type;
+		static constexpr double getFullScale() { return 1.0; }
+		static constexpr double getMin() { return -1.0; }
+		static constexpr double getMax() { return 1.0; }
+		static constexpr bool isInteger() { return false; }
+};
+template<> class volumeSample<audio::format_double> {
+	public:
+		typedef double type;
+		static constexpr double getFullScale() { return 1.0; }
+		static constexpr double getMin() { return -1.0; }
+		static constexpr double getMax() { return 1.0; }
+		static constexpr bool isInteger() { return false; }
+};
+/**
+ * @brief Type of the computation of a couple of formats: float, double when a side is on 64 bits.
+ */
+template<enum audio::format DRAIN_IN, enum audio::format DRAIN_OUT> class volumeCalc {
+	public:
+		typedef typename std::conditional<    sizeof(typename volumeSample<DRAIN_IN>::type) == 8
+		                                   || sizeof(typename volumeSample<DRAIN_OUT>::type) == 8, double, float>::type type;
+};
+/**
+ * @brief Store a sample (saturation of the integer formats, truncation as the other kernels).
+ */
+template<enum audio::format DRAIN_FORMAT, typename TYPE_CALC>
+static inline typename volumeSample<DRAIN_FORMAT>::type volumeStore(TYPE_CALC _value) {
+	if (volumeSample<DRAIN_FORMAT>::isInteger() == true) {
+		_value = etk::min(etk::max(TYPE_CALC(volumeSample<DRAIN_FORMAT>::getMin()), _value), TYPE_CALC(volumeSample<DRAIN_FORMAT>::getMax()));
+	}
+	return static_cast<typename volumeSample<DRAIN_FORMAT>::type>(_value);
+}
+/**
+ * @brief Apply a constant gain and convert the format in one pass (simple loop: vectorized by the compiler).
+ */
+template<enum audio::format DRAIN_IN, enum audio::format DRAIN_OUT>
+static void gain(void* _input, void* _output, size_t _nbSample, int32_t /*_volumeCoef*/, int32_t /*_volumeDecalage*/, float _volumeAppli) {
+	typedef typename volumeCalc<DRAIN_IN, DRAIN_OUT>::type calc;
+	const typename volumeSample<DRAIN_IN>::type* in = static_cast<const typename volumeSample<DRAIN_IN>::type*>(_input);
+	typename volumeSample<DRAIN_OUT>::type* out = static_cast<typename volumeSample<DRAIN_OUT>::type*>(_output);
+	const calc coef = calc(_volumeAppli) * calc(volumeSample<DRAIN_OUT>::getFullScale() / volumeSample<DRAIN_IN>::getFullScale());
+	for (size_t iii=0; iii<_nbSample; ++iii) {
+		out[iii] = volumeStore<DRAIN_OUT>(calc(in[iii]) * coef);
+	}
+}
+/**
+ * @brief Apply a gain for each sample and convert the format (the gain include the scale between the 2 formats).
+ */
+template<enum audio::format DRAIN_IN, enum audio::format DRAIN_OUT>
+static void rampFormat(const void* _input, void* _output, size_t _nbSample, const float* _gain) {
+	typedef typename volumeCalc<DRAIN_IN, DRAIN_OUT>::type calc;
+	const typename volumeSample<DRAIN_IN>::type* in = static_cast<const typename volumeSample<DRAIN_IN>::type*>(_input);
+	typename volumeSample<DRAIN_OUT>::type* out = static_cast<typename volumeSample<DRAIN_OUT>::type*>(_output);
+	for (size_t iii=0; iii<_nbSample; ++iii) {
+		out[iii] = volumeStore<DRAIN_OUT>(calc(in[iii]) * calc(_gain[iii]));
+	}
+}
+
+// ---------------------------------------------------------------------------------
+//   SIMD kernels: process the main part of the buffer and the generic kernel end it.
+// ---------------------------------------------------------------------------------
+#ifdef DRAIN_SIMD_X86
+// (x*coef+round)>>decalage with coef in [0..65536[: 32 bits product from the low and high part of the signed product,
+// corrected when coef does not fit in a int16_t (the pack saturate the result)
+DRAIN_TARGET_SSE2 static void convert__int16__to__int16__sse2(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli) {
+	if (    _volumeDecalage > 16
+	     || _volumeCoef < 0
+	     || _volumeCoef >= 65536) {
+		convert__int16__to__int16(_input, _output, _nbSample, _volumeCoef, _volumeDecalage, _volumeAppli);
+		return;
+	}
+	int16_t* in = static_cast<int16_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	const __m128i coef = _mm_set1_epi16(int16_t(_volumeCoef));
+	const __m128i correction = _mm_set1_epi16(_volumeCoef >= 32768 ? -1 : 0);
+	const __m128i round = _mm_set1_epi32(int32_t(getRound(_volumeDecalage)));
+	const __m128i decalage = _mm_cvtsi32_si128(_volumeDecalage);
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]));
+		__m128i low = _mm_mullo_epi16(value, coef);
+		__m128i high = _mm_add_epi16(_mm_mulhi_epi16(value, coef), _mm_and_si128(value, correction));
+		__m128i result0 = _mm_sra_epi32(_mm_add_epi32(_mm_unpacklo_epi16(low, high), round), decalage);
+		__m128i result1 = _mm_sra_epi32(_mm_add_epi32(_mm_unpackhi_epi16(low, high), round), decalage);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_packs_epi32(result0, result1));
+	}
+	convert__int16__to__int16(&in[iii], &out[iii], _nbSample-iii, _volumeCoef, _volumeDecalage, _volumeAppli);
+}
+DRAIN_TARGET_SSE2 static void convert__float__to__float__sse2(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli) {
+	float* in = static_cast<float*>(_input);
+	float* out = static_cast<float*>(_output);
+	const __m128 coef = _mm_set1_ps(_volumeAppli);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		_mm_storeu_ps(&out[iii], _mm_mul_ps(_mm_loadu_ps(&in[iii]), coef));
+	}
+	convert__float__to__float(&in[iii], &out[iii], _nbSample-iii, _volumeCoef, _volumeDecalage, _volumeAppli);
+}
+DRAIN_TARGET_SSE2 static void ramp__int16__to__int16__sse2(const void* _input, void* _output, size_t _nbSample, const float* _gain) {
+	const int16_t* in = static_cast<const int16_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	const __m128 minValue = _mm_set1_ps(static_cast<float>(INT16_MIN));
+	const __m128 maxValue = _mm_set1_ps(static_cast<float>(INT16_MAX));
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii]));
+		// sign extention in int32_t
+		__m128 low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16));
+		__m128 high = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16));
+		low = _mm_mul_ps(low, _mm_loadu_ps(&_gain[iii]));
+		high = _mm_mul_ps(high, _mm_loadu_ps(&_gain[iii+4]));
+		low = _mm_min_ps(_mm_max_ps(low, minValue), maxValue);
+		high = _mm_min_ps(_mm_max_ps(high, minValue), maxValue);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_packs_epi32(_mm_cvttps_epi32(low), _mm_cvttps_epi32(high)));
+	}
+	ramp<int16_t, int16_t>(&in[iii], &out[iii], _nbSample-iii, &_gain[iii]);
+}
+DRAIN_TARGET_SSE2 static void ramp__int32__to__int32__sse2(const void* _input, void* _output, size_t _nbSample, const float* _gain) {
+	const int32_t* in = static_cast<const int32_t*>(_input);
+	int32_t* out = static_cast<int32_t*>(_output);
+	const __m128 minValue = _mm_set1_ps(static_cast<float>(INT32_MIN));
+	const __m128 maxValue = _mm_set1_ps(g_floatInt32Max);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		__m128 value = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[iii])));
+		value = _mm_mul_ps(value, _mm_loadu_ps(&_gain[iii]));
+		value = _mm_min_ps(_mm_max_ps(value, minValue), maxValue);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_cvttps_epi32(value));
+	}
+	ramp<int32_t, int32_t>(&in[iii], &out[iii], _nbSample-iii, &_gain[iii]);
+}
+DRAIN_TARGET_SSE2 static void ramp__float__to__float__sse2(const void* _input, void* _output, size_t _nbSample, const float* _gain) {
+	const float* in = static_cast<const float*>(_input);
+	float* out = static_cast<float*>(_output);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		_mm_storeu_ps(&out[iii], _mm_mul_ps(_mm_loadu_ps(&in[iii]), _mm_loadu_ps(&_gain[iii])));
+	}
+	ramp<float, float>(&in[iii], &out[iii], _nbSample-iii, &_gain[iii]);
+}
+DRAIN_TARGET_SSE2 static void gain__float__to__int16__sse2(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli) {
+	float* in = static_cast<float*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	// same operations as the generic kernel (bit exact)
+	const __m128 coef = _mm_set1_ps(_volumeAppli * audio::drain::int16FullScale);
+	const __m128 minValue = _mm_set1_ps(static_cast<float>(INT16_MIN));
+	const __m128 maxValue = _mm_set1_ps(static_cast<float>(INT16_MAX));
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		__m128 low = _mm_mul_ps(_mm_loadu_ps(&in[iii]), coef);
+		__m128 high = _mm_mul_ps(_mm_loadu_ps(&in[iii+4]), coef);
+		low = _mm_min_ps(_mm_max_ps(low, minValue), maxValue);
+		high = _mm_min_ps(_mm_max_ps(high, minValue), maxValue);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_packs_epi32(_mm_cvttps_epi32(low), _mm_cvttps_epi32(high)));
+	}
+	gain<audio::format_float, audio::format_int16>(&in[iii], &out[iii], _nbSample-iii, _volumeCoef, _volumeDecalage, _volumeAppli);
+}
+DRAIN_TARGET_SSE2 static void gain__float__to__int32__sse2(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli) {
+	float* in = static_cast<float*>(_input);
+	int32_t* out = static_cast<int32_t*>(_output);
+	const __m128 coef = _mm_set1_ps(_volumeAppli * 2147483648.0f);
+	const __m128 minValue = _mm_set1_ps(static_cast<float>(INT32_MIN));
+	const __m128 maxValue = _mm_set1_ps(g_floatInt32Max);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		__m128 value = _mm_mul_ps(_mm_loadu_ps(&in[iii]), coef);
+		value = _mm_min_ps(_mm_max_ps(value, minValue), maxValue);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[iii]), _mm_cvttps_epi32(value));
+	}
+	gain<audio::format_float, audio::format_int32>(&in[iii], &out[iii], _nbSample-iii, _volumeCoef, _volumeDecalage, _volumeAppli);
+}
+#endif
+
+#ifdef DRAIN_SIMD_NEON
+static void convert__float__to__float__neon(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli) {
+	float* in = static_cast<float*>(_input);
+	float* out = static_cast<float*>(_output);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		vst1q_f32(&out[iii], vmulq_n_f32(vld1q_f32(&in[iii]), _volumeAppli));
+	}
+	convert__float__to__float(&in[iii], &out[iii], _nbSample-iii, _volumeCoef, _volumeDecalage, _volumeAppli);
+}
+static void ramp__int16__to__int16__neon(const void* _input, void* _output, size_t _nbSample, const float* _gain) {
+	const int16_t* in = static_cast<const int16_t*>(_input);
+	int16_t* out = static_cast<int16_t*>(_output);
+	size_t iii = 0;
+	for (; iii+8 <= _nbSample; iii+=8) {
+		int16x8_t value = vld1q_s16(&in[iii]);
+		float32x4_t low = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(value))), vld1q_f32(&_gain[iii]));
+		float32x4_t high = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(value))), vld1q_f32(&_gain[iii+4]));
+		vst1q_s16(&out[iii], vcombine_s16(vqmovn_s32(vcvtq_s32_f32(low)), vqmovn_s32(vcvtq_s32_f32(high))));
+	}
+	ramp<int16_t, int16_t>(&in[iii], &out[iii], _nbSample-iii, &_gain[iii]);
+}
+static void ramp__float__to__float__neon(const void* _input, void* _output, size_t _nbSample, const float* _gain) {
+	const float* in = static_cast<const float*>(_input);
+	float* out = static_cast<float*>(_output);
+	size_t iii = 0;
+	for (; iii+4 <= _nbSample; iii+=4) {
+		vst1q_f32(&out[iii], vmulq_f32(vld1q_f32(&in[iii]), vld1q_f32(&_gain[iii])));
+	}
+	ramp<float, float>(&in[iii], &out[iii], _nbSample-iii, &_gain[iii]);
+}
+#endif
+
+#ifdef DRAIN_SIMD_X86
+	#define DRAIN_VOLUME_X86(name) &name
+#else
+	#define DRAIN_VOLUME_X86(name) null
+#endif
+#ifdef DRAIN_SIMD_NEON
+	#define DRAIN_VOLUME_NEON(name) &name
+#else
+	#define DRAIN_VOLUME_NEON(name) null
+#endif
+typedef void (*volumeConvertFunction)(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli);
+typedef void (*volumeRampFunction)(const void* _input, void* _output, size_t _nbSample, const float* _gain);
+//! Kernels of a couple of formats (generic and the optimized versions)
+struct volumeKernel {
+	volumeConvertFunction convert; //!< Apply a constant volume (null: the couple of format is not supported)
+	volumeConvertFunction convertSse2;
+	volumeConvertFunction convertNeon;
+	volumeRampFunction ramp; //!< Apply a gain table
+	volumeRampFunction rampSse2;
+	volumeRampFunction rampNeon;
+	float rampScale; //!< Scale between the input and output range of the ramp
+};
+//! Number of format managed by the volume
+static const size_t g_volumeNbFormat = 10;
+/**
+ * @brief Get the id of a format in the generic kernel table.
+ * @param[in] _format Format of the data.
+ * @return Id in [0..g_volumeNbFormat[ (g_volumeNbFormat: unknow format).
+ */
+static size_t getVolumeFormatId(enum audio::format _format) {
+	switch (_format) {
+		case audio::format_int8:
+			return 0;
+		case audio::format_int8_on_int16:
+			return 1;
+		case audio::format_int16:
+			return 2;
+		case audio::format_int16_on_int32:
+			return 3;
+		case audio::format_int24:
+			return 4;
+		case audio::format_int32:
+			return 5;
+		case audio::format_int32_on_int64:
+			return 6;
+		case audio::format_int64:
+			return 7;
+		case audio::format_float:
+			return 8;
+		case audio::format_double:
+			return 9;
 		default:
+			return g_volumeNbFormat;
+	}
+}
+#define DRAIN_VOLUME_GENERIC(in, out) \
+	{ &gain<in, out>, null, null, &rampFormat<in, out>, null, null, float(volumeSample<out>::getFullScale() / volumeSample<in>::getFullScale()) }
+#define DRAIN_VOLUME_GENERIC_LINE(in) { \
+	DRAIN_VOLUME_GENERIC(in, audio::format_int8), \
+	DRAIN_VOLUME_GENERIC(in, audio::format_int8_on_int16), \
+	DRAIN_VOLUME_GENERIC(in, audio::format_int16), \
+	DRAIN_VOLUME_GENERIC(in, audio::format_int16_on_int32), \
+	DRAIN_VOLUME_GENERIC(in, audio::format_int24), \
+	DRAIN_VOLUME_GENERIC(in, audio::format_int32), \
+	DRAIN_VOLUME_GENERIC(in, audio::format_int32_on_int64), \
+	DRAIN_VOLUME_GENERIC(in, audio::format_int64), \
+	DRAIN_VOLUME_GENERIC(in, audio::format_float), \
+	DRAIN_VOLUME_GENERIC(in, audio::format_double) }
+//! Generic kernels of each couple [input][output] (order of the id of getVolumeFormatId)
+static constexpr volumeKernel g_volumeGenericKernel[g_volumeNbFormat][g_volumeNbFormat] = {
+	DRAIN_VOLUME_GENERIC_LINE(audio::format_int8),
+	DRAIN_VOLUME_GENERIC_LINE(audio::format_int8_on_int16),
+	DRAIN_VOLUME_GENERIC_LINE(audio::format_int16),
+	DRAIN_VOLUME_GENERIC_LINE(audio::format_int16_on_int32),
+	DRAIN_VOLUME_GENERIC_LINE(audio::format_int24),
+	DRAIN_VOLUME_GENERIC_LINE(audio::format_int32),
+	DRAIN_VOLUME_GENERIC_LINE(audio::format_int32_on_int64),
+	DRAIN_VOLUME_GENERIC_LINE(audio::format_int64),
+	DRAIN_VOLUME_GENERIC_LINE(audio::format_float),
+	DRAIN_VOLUME_GENERIC_LINE(audio::format_double)
+};
+#undef DRAIN_VOLUME_GENERIC_LINE
+/**
+ * @brief Get the id of a format in the optimized kernel table.
+ * @param[in] _format Format of the data.
+ * @return Id in [0..3] (4: no optimized kernels).
+ */
+static size_t getVolumeOptimizedId(enum audio::format _format) {
+	switch (_format) {
 		case audio::format_int16:
-			switch (m_output.getFormat()) {
-				default:
-				case audio::format_int16:
-					m_functionConvert = &convert__int16__to__int16;
-					DRAIN_DEBUG("Use converter : 'convert__int16__to__int16' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_int16_on_int32:
-				case audio::format_int32:
-					m_functionConvert = &convert__int16__to__int32;
-					DRAIN_DEBUG("Use converter : 'convert__int16__to__int32' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_float:
-					m_functionConvert = &convert__int16__to__float;
-					break;
-			}
-			break;
+			return 0;
 		case audio::format_int16_on_int32:
+			return 1;
 		case audio::format_int32:
-			switch (m_output.getFormat()) {
-				default:
-				case audio::format_int16:
-					m_functionConvert = &convert__int32__to__int16;
-					DRAIN_DEBUG("Use converter : 'convert__int32__to__int16' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_int16_on_int32:
-				case audio::format_int32:
-					m_functionConvert = &convert__int32__to__int32;
-					DRAIN_DEBUG("Use converter : 'convert__int32__to__int32' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
-				case audio::format_float:
-					DRAIN_ERROR("Impossible case 2");
-					break;
-			}
-			break;
+			return 2;
 		case audio::format_float:
-			switch (m_output.getFormat()) {
-				default:
-				case audio::format_int16:
-				case audio::format_int16_on_int32:
-				case audio::format_int32:
-					DRAIN_ERROR("Impossible case 4");
-					break;
-				case audio::format_float:
-					m_functionConvert = &convert__float__to__float;
-					DRAIN_DEBUG("Use converter : 'convert__float__to__float' for " << m_input.getFormat() << " to " << m_output.getFormat());
-					break;
+			return 3;
+		default:
+			return 4;
+	}
+}
+//! Optimized kernels (fixed point and SIMD) of the common formats [input][output], order of the id of getVolumeOptimizedId
+static constexpr volumeKernel g_volumeKernel[4][4] = {
+	{ // from int16
+		{ &convert__int16__to__int16, DRAIN_VOLUME_X86(convert__int16__to__int16__sse2), null,
+		  &ramp<int16_t, int16_t>, DRAIN_VOLUME_X86(ramp__int16__to__int16__sse2), DRAIN_VOLUME_NEON(ramp__int16__to__int16__neon), 1.0f },
+		{ &convert__int16__to__int32, null, null, &ramp<int16_t, int32_t>, null, null, 1.0f },
+		{ &convert__int16__to__int32, null, null, &ramp<int16_t, int32_t>, null, null, 65536.0f },
+		{ &convert__int16__to__float, null, null, &ramp<int16_t, float>, null, null, 1.0f/audio::drain::int16FullScale }
+	}, { // from int16 on int32
+		{ &convert__int32__to__int16, null, null, &ramp<int32_t, int16_t>, null, null, 1.0f },
+		{ &convert__int32__to__int32, null, null, &ramp<int32_t, int32_t>, DRAIN_VOLUME_X86(ramp__int32__to__int32__sse2), null, 1.0f },
+		{ &convert__int32__to__int32, null, null, &ramp<int32_t, int32_t>, DRAIN_VOLUME_X86(ramp__int32__to__int32__sse2), null, 65536.0f },
+		DRAIN_VOLUME_GENERIC(audio::format_int16_on_int32, audio::format_float)
+	}, { // from int32
+		{ &convert__int32__to__int16, null, null, &ramp<int32_t, int16_t>, null, null, 1.0f/65536.0f },
+		{ &convert__int32__to__int32, null, null, &ramp<int32_t, int32_t>, DRAIN_VOLUME_X86(ramp__int32__to__int32__sse2), null, 1.0f/65536.0f },
+		{ &convert__int32__to__int32, null, null, &ramp<int32_t, int32_t>, DRAIN_VOLUME_X86(ramp__int32__to__int32__sse2), null, 1.0f },
+		DRAIN_VOLUME_GENERIC(audio::format_int32, audio::format_float)
+	}, { // from float
+		{ &gain<audio::format_float, audio::format_int16>, DRAIN_VOLUME_X86(gain__float__to__int16__sse2), null,
+		  &rampFormat<audio::format_float, audio::format_int16>, null, null, audio::drain::int16FullScale },
+		DRAIN_VOLUME_GENERIC(audio::format_float, audio::format_int16_on_int32),
+		{ &gain<audio::format_float, audio::format_int32>, DRAIN_VOLUME_X86(gain__float__to__int32__sse2), null,
+		  &rampFormat<audio::format_float, audio::format_int32>, null, null, 2147483648.0f },
+		{ &convert__float__to__float, DRAIN_VOLUME_X86(convert__float__to__float__sse2), DRAIN_VOLUME_NEON(convert__float__to__float__neon),
+		  &ramp<float, float>, DRAIN_VOLUME_X86(ramp__float__to__float__sse2), DRAIN_VOLUME_NEON(ramp__float__to__float__neon), 1.0f }
+	}
+};
+#undef DRAIN_VOLUME_GENERIC
+
+void audio::drain::Volume::configurationChange() {
+	audio::drain::Algo::configurationChange();
+	m_functionConvert = null;
+	m_functionRamp = null;
+	m_rampScale = 1.0f;
+	// direct access to the kernels of the couple of formats (optimized version of the common formats)
+	const volumeKernel* kernel = null;
+	size_t inputId = getVolumeFormatId(m_input.getFormat());
+	size_t outputId = getVolumeFormatId(m_output.getFormat());
+	if (    inputId < g_volumeNbFormat
+	     && outputId < g_volumeNbFormat) {
+		kernel = &g_volumeGenericKernel[inputId][outputId];
+		size_t inputOptimizedId = getVolumeOptimizedId(m_input.getFormat());
+		size_t outputOptimizedId = getVolumeOptimizedId(m_output.getFormat());
+		if (    inputOptimizedId < 4
+		     && outputOptimizedId < 4) {
+			kernel = &g_volumeKernel[inputOptimizedId][outputOptimizedId];
+		}
+	}
+	if (kernel != null) {
+		m_functionConvert = kernel->convert;
+		m_functionRamp = kernel->ramp;
+		m_rampScale = kernel->rampScale;
+		// Select the optimized kernels:
+		if (audio::drain::cpu::haveSse2() == true) {
+			if (kernel->convertSse2 != null) {
+				m_functionConvert = kernel->convertSse2;
+			}
+			if (kernel->rampSse2 != null) {
+				m_functionRamp = kernel->rampSse2;
+			}
+		}
+		if (audio::drain::cpu::haveNeon() == true) {
+			if (kernel->convertNeon != null) {
+				m_functionConvert = kernel->convertNeon;
+			}
+			if (kernel->rampNeon != null) {
+				m_functionRamp = kernel->rampNeon;
 			}
+		}
+		DRAIN_DEBUG("Use volume kernels for " << m_input.getFormat() << " to " << m_output.getFormat());
+	} else if (    m_input.getFormat() != audio::format_unknow
+	            && m_output.getFormat() != audio::format_unknow) {
+		DRAIN_ERROR("Volume can not convert " << m_input.getFormat() << " to " << m_output.getFormat());
+	}
+	m_rampGain.resize(g_rampBlockSize * m_input.getMap().size());
+	switch (m_input.getMap().size()) {
+		case 1:
+			m_functionExpandGain = &expandGainMono;
+			break;
+		case 2:
+			m_functionExpandGain = &expandGain<2>;
+			break;
+		case 6:
+			m_functionExpandGain = &expandGain<6>;
+			break;
+		case 8:
+			m_functionExpandGain = &expandGain<8>;
+			break;
+		default:
+			m_functionExpandGain = &expandGainGeneric;
 			break;
 	}
 	if (m_input.getMap() != m_output.getMap()) {
@@ -152,14 +737,32 @@ void audio::drain::Volume::configurationChange() {
 	if (m_input.getFrequency() != m_output.getFrequency()) {
 		DRAIN_ERROR("Volume frequency change is not supported");
 	}
+	if (m_input.getLayout() != m_output.getLayout()) {
+		DRAIN_ERROR("Volume layout change is not supported");
+	}
 	// nee to process all time (the format not change (just a simple filter))
 	m_needProcess = true;
 	volumeChange();
+	m_parameter.update();
+	applyParameter();
+	// no ramp at the configuration: start directly with the good volume
+	m_rampNbFrame = 0;
+	m_volumeCurrent = m_volumeAppli;
 }
 
 void audio::drain::Volume::volumeChange() {
-	//m_volumeAppli = 20 * log(m_volumedB);
-	float volumedB = 0.0f;
+	ethread::UniqueLock lock(m_parameterLock);
+	publishParameter();
+}
+
+void audio::drain::Volume::publishParameter() {
+	// the label of the graph show the volumes
+	invalidateDotLabel();
+	audio::drain::VolumeParameter parameter;
+	parameter.m_rampType = m_rampType;
+	parameter.m_rampDuration = m_rampDuration;
+	// accumulated in double: the stacked stages do not add rounding errors
+	double volumedB = 0.0;
 	bool mute = false;
 	for (size_t iii=0; iii<m_volumeList.size(); ++iii) {
 		if (m_volumeList[iii] == null) {
@@ -173,158 +776,192 @@ void audio::drain::Volume::volumeChange() {
 	}
 	DRAIN_DEBUG(" Total volume : " << volumedB << "dB nbVolume=" << m_volumeList.size());
 	if (mute == true) {
-		m_volumeAppli = 0.0f;
-		m_volumeCoef = 0;
-		m_volumeDecalage = 0;
+		parameter.m_volume = 0.0f;
+		parameter.m_coef = 0;
+		parameter.m_decalage = 0;
+		m_parameter.set(parameter);
 		return;
 	}
-	#if (defined(__STDCPP_LLVM__) || __cplusplus < 201103L)
-		m_volumeAppli = pow(10.0f, volumedB/20.0f);
-	#else
-		m_volumeAppli = etk::pow(10.0f, volumedB/20.0f);
-	#endif
-	switch (m_input.getFormat()) {
-		default:
-		case audio::format_int16:
-			switch (m_output.getFormat()) {
-				default:
-				case audio::format_int16:
-					if (m_volumeAppli <= 1.0f) {
-						m_volumeCoef = m_volumeAppli*float(1<<16);
-						m_volumeDecalage = 16;
-					} else {
-						int32_t neareast = neareastsss(m_volumeAppli);
-						m_volumeCoef = m_volumeAppli*float(1<<(16-neareast));
-						m_volumeDecalage = 16-neareast;
-					}
-					break;
-				case audio::format_int16_on_int32:
-					if (m_volumeAppli <= 1.0f) {
-						m_volumeCoef = m_volumeAppli*float(1<<16);
-						m_volumeDecalage = 16;
-					} else {
-						int32_t neareast = neareastsss(m_volumeAppli);
-						m_volumeCoef = m_volumeAppli*float(1<<(16-neareast));
-						m_volumeDecalage = 16-neareast;
-					}
-					break;
-				case audio::format_int32:
-					m_volumeCoef = m_volumeAppli*float(1<<16);
-					m_volumeDecalage = 0;
-					break;
-				case audio::format_float:
-					if (m_volumeAppli <= 1.0f) {
-						m_volumeCoef = m_volumeAppli*float(1<<16);
-						m_volumeDecalage = 16;
-					} else {
-						int32_t neareast = neareastsss(m_volumeAppli);
-						m_volumeCoef = m_volumeAppli*float(1<<(16-neareast));
-						m_volumeDecalage = 16-neareast;
-					}
-					break;
-			}
-			break;
-		case audio::format_int16_on_int32:
-			switch (m_output.getFormat()) {
-				default:
-				case audio::format_int16:
-					if (m_volumeAppli <= 1.0f) {
-						m_volumeCoef = m_volumeAppli*float(1<<16);
-						m_volumeDecalage = 16;
-					} else {
-						int32_t neareast = neareastsss(m_volumeAppli);
-						m_volumeCoef = m_volumeAppli*float(1<<(16-neareast));
-						m_volumeDecalage = 16-neareast;
-					}
-					break;
-				case audio::format_int16_on_int32:
-					if (m_volumeAppli <= 1.0f) {
-						m_volumeCoef = m_volumeAppli*float(1<<16);
-						m_volumeDecalage = 16;
-					} else {
-						int32_t neareast = neareastsss(m_volumeAppli);
-						m_volumeCoef = m_volumeAppli*float(1<<(16-neareast));
-						m_volumeDecalage = 16-neareast;
-					}
-					break;
-				case audio::format_int32:
-					m_volumeCoef = m_volumeAppli*float(1<<16);
-					m_volumeDecalage = 0;
-					break;
-				case audio::format_float:
-					DRAIN_ERROR("Impossible case 2");
-					break;
+	double gain = getGain(volumedB);
+	parameter.m_volume = float(gain);
+	// fixed point kernels: Q16 for int16 to int16 (product on 32 bits), Q30 for the others
+	int32_t inputScale = getFixedScale(m_input.getFormat());
+	int32_t outputScale = getFixedScale(m_output.getFormat());
+	if (    inputScale >= 0
+	     && outputScale >= 0) {
+		int32_t precision = 30;
+		if (    m_input.getFormat() == audio::format_int16
+		     && m_output.getFormat() == audio::format_int16) {
+			precision = 16;
+		}
+		getFixedGain(gain, precision, inputScale - outputScale, parameter.m_coef, parameter.m_decalage);
+	}
+	m_parameter.set(parameter);
+}
+
+void audio::drain::Volume::applyParameter() {
+	const audio::drain::VolumeParameter& parameter = m_parameter.get();
+	m_volumeAppli = parameter.m_volume;
+	m_volumeCoef = parameter.m_coef;
+	m_volumeDecalage = parameter.m_decalage;
+	startRamp();
+}
+
+void audio::drain::Volume::setRamp(enum audio::drain::volumeRamp _type, float _durationMs) {
+	ethread::UniqueLock lock(m_parameterLock);
+	m_rampType = _type;
+	m_rampDuration = etk::max(0.0f, _durationMs);
+	publishParameter();
+}
+
+void audio::drain::Volume::startRamp() {
+	const audio::drain::VolumeParameter& parameter = m_parameter.get();
+	size_t nbFrame = 0;
+	if (parameter.m_rampType != audio::drain::volumeRamp_none) {
+		nbFrame = size_t(parameter.m_rampDuration * m_input.getFrequency() / 1000.0f);
+	}
+	if (    nbFrame == 0
+	     || m_volumeCurrent == m_volumeAppli) {
+		m_volumeCurrent = m_volumeAppli;
+		m_rampNbFrame = 0;
+		return;
+	}
+	if (parameter.m_rampType == audio::drain::volumeRamp_exponential) {
+		// an exponential can not start or stop at 0 ==> use the minimum gain and jump at the end
+		float start = etk::max(m_volumeCurrent, g_rampMinGain);
+		float stop = etk::max(m_volumeAppli, g_rampMinGain);
+		m_volumeCurrent = start;
+		#if (defined(__STDCPP_LLVM__) || __cplusplus < 201103L)
+			m_rampStep = pow(stop/start, 1.0f/float(nbFrame));
+		#else
+			m_rampStep = etk::pow(stop/start, 1.0f/float(nbFrame));
+		#endif
+	} else {
+		m_rampStep = (m_volumeAppli - m_volumeCurrent) / float(nbFrame);
+	}
+	m_rampNbFrame = nbFrame;
+	DRAIN_VERBOSE("Start volume ramp: " << m_volumeCurrent << " ==> " << m_volumeAppli << " in " << nbFrame << " frames");
+}
+
+void audio::drain::Volume::processRamp(void* _input, void* _output, size_t _nbChunk) {
+	size_t nbChannel = m_input.getMap().size();
+	size_t inputSampleSize = audio::getFormatBytes(m_input.getFormat());
+	const int8_t* in = static_cast<const int8_t*>(_input);
+	int8_t* out = static_cast<int8_t*>(_output);
+	enum audio::drain::volumeRamp rampType = m_parameter.get().m_rampType;
+	bool planar = m_input.getLayout() == audio::drain::layout_planar;
+	size_t nbChunkTotal = _nbChunk;
+	size_t frameId = 0;
+	while (_nbChunk > 0) {
+		size_t nbFrame = etk::min(_nbChunk, g_rampBlockSize);
+		for (size_t iii=0; iii<nbFrame; ++iii) {
+			m_rampGain[iii] = m_volumeCurrent * m_rampScale;
+			if (m_rampNbFrame > 0) {
+				if (rampType == audio::drain::volumeRamp_exponential) {
+					m_volumeCurrent *= m_rampStep;
+				} else {
+					m_volumeCurrent += m_rampStep;
+				}
+				m_rampNbFrame--;
+				if (m_rampNbFrame == 0) {
+					// remove the accumulated error
+					m_volumeCurrent = m_volumeAppli;
+				}
 			}
-			break;
-		case audio::format_int32:
-			switch (m_output.getFormat()) {
-				default:
-				case audio::format_int16:
-					if (m_volumeAppli <= 1.0f) {
-						m_volumeCoef = m_volumeAppli*float(1<<16);
-						m_volumeDecalage = 32;
-					} else {
-						int32_t neareast = neareastsss(m_volumeAppli);
-						m_volumeCoef = m_volumeAppli*float(1<<(16-neareast));
-						m_volumeDecalage = 32-neareast;
-					}
-					break;
-				case audio::format_int16_on_int32:
-					if (m_volumeAppli <= 1.0f) {
-						m_volumeCoef = m_volumeAppli*float(1<<16);
-						m_volumeDecalage = 32;
-					} else {
-						int32_t neareast = neareastsss(m_volumeAppli);
-						m_volumeCoef = m_volumeAppli*float(1<<(16-neareast));
-						m_volumeDecalage = 32-neareast;
-					}
-					break;
-				case audio::format_int32:
-					m_volumeCoef = m_volumeAppli*float(1<<16);
-					m_volumeDecalage = 16;
-					break;
-				case audio::format_float:
-					DRAIN_ERROR("Impossible case 3");
-					break;
+		}
+		if (planar == true) {
+			for (size_t jjj=0; jjj<nbChannel; ++jjj) {
+				size_t offset = jjj*nbChunkTotal + frameId;
+				m_functionRamp(&in[offset*inputSampleSize], &out[offset*m_formatSize], nbFrame, &m_rampGain[0]);
 			}
-			break;
-		case audio::format_float:
-			// nothing to do (use m_volumeAppli)
-			break;
+			frameId += nbFrame;
+			_nbChunk -= nbFrame;
+			continue;
+		}
+		// one gain by frame is used for all the planes, the interleaved buffer need it on each sample
+		m_functionExpandGain(&m_rampGain[0], nbFrame, nbChannel);
+		size_t sampleId = nbFrame * nbChannel;
+		m_functionRamp(in, out, sampleId, &m_rampGain[0]);
+		in += sampleId * inputSampleSize;
+		out += sampleId * m_formatSize;
+		_nbChunk -= nbFrame;
 	}
 }
 
+void audio::drain::Volume::skipRamp(size_t _nbChunk) {
+	if (m_rampNbFrame == 0) {
+		return;
+	}
+	size_t nbFrame = etk::min(_nbChunk, m_rampNbFrame);
+	if (m_parameter.get().m_rampType == audio::drain::volumeRamp_exponential) {
+		#if (defined(__STDCPP_LLVM__) || __cplusplus < 201103L)
+			m_volumeCurrent *= pow(m_rampStep, float(nbFrame));
+		#else
+			m_volumeCurrent *= etk::pow(m_rampStep, float(nbFrame));
+		#endif
+	} else {
+		m_volumeCurrent += m_rampStep * float(nbFrame);
+	}
+	m_rampNbFrame -= nbFrame;
+	if (m_rampNbFrame == 0) {
+		m_volumeCurrent = m_volumeAppli;
+	}
+}
 
-etk::Vector<audio::format> audio::drain::Volume::getFormatSupportedInput() {
+/**
+ * @brief Get the formats that the volume can convert in the same pass.
+ * @param[in] _format Format of the other side of the volume (first of the list: no conversion).
+ * @return List of the formats (empty: all the formats when the other side is not configured).
+ */
+static etk::Vector<audio::format> getVolumeFormatList(enum audio::format _format) {
 	etk::Vector<audio::format> tmp;
-	if (m_output.getFormat() == audio::format_float) {
-		tmp.pushBack(audio::format_float);
+	if (getVolumeFormatId(_format) == g_volumeNbFormat) {
+		return tmp;
 	}
-	if (    m_output.getFormat() == audio::format_int16
-	     || m_output.getFormat() == audio::format_int16_on_int32
-	     || m_output.getFormat() == audio::format_int32) {
-		tmp.pushBack(audio::format_int16);
-		tmp.pushBack(audio::format_int16_on_int32);
-		tmp.pushBack(audio::format_int32);
+	static const enum audio::format list[] = {
+		audio::format_int16,
+		audio::format_int16_on_int32,
+		audio::format_int32,
+		audio::format_float,
+		audio::format_int8,
+		audio::format_int8_on_int16,
+		audio::format_int24,
+		audio::format_int32_on_int64,
+		audio::format_int64,
+		audio::format_double
+	};
+	tmp.pushBack(_format);
+	for (size_t iii=0; iii<sizeof(list)/sizeof(list[0]); ++iii) {
+		if (list[iii] != _format) {
+			tmp.pushBack(list[iii]);
+		}
 	}
 	return tmp;
+}
+
+etk::Vector<audio::format> audio::drain::Volume::getFormatSupportedInput() {
+	// all the couples of formats are converted with the gain
+	return getVolumeFormatList(m_output.getFormat());
 };
 
 etk::Vector<audio::format> audio::drain::Volume::getFormatSupportedOutput() {
-	etk::Vector<audio::format> tmp;
-	if (m_input.getFormat() == audio::format_float) {
-		tmp.pushBack(audio::format_float);
-	}
-	if (    m_input.getFormat() == audio::format_int16
-	     || m_input.getFormat() == audio::format_int16_on_int32
-	     || m_input.getFormat() == audio::format_int32) {
-		tmp.pushBack(audio::format_int16);
-		tmp.pushBack(audio::format_int16_on_int32);
-		tmp.pushBack(audio::format_int32);
-	}
-	return tmp;
+	return getVolumeFormatList(m_input.getFormat());
 };
 
+void audio::drain::Volume::appendSupportedKey(audio::drain::NegotiationHash& _hash) const {
+	// the supported formats only depend on the formats of the 2 sides (@see getVolumeFormatList)
+	_hash.add(uint32_t(m_output.getFormat()));
+	_hash.add(uint32_t(m_input.getFormat()));
+	appendFrequencySupportedKey(_hash);
+	appendMapSupportedKey(_hash);
+	appendLayoutSupportedKey(_hash);
+}
+
+
+bool audio::drain::Volume::canProcessInPlace() const {
+	// convertion functions work sample per sample ==> only possible when the sample size does not change
+	return m_input.getFormat() == m_output.getFormat();
+}
 
 bool audio::drain::Volume::process(audio::Time& _time,
                                    void* _input,
@@ -332,6 +969,10 @@ bool audio::drain::Volume::process(audio::Time& _time,
                                    void*& _output,
                                    size_t& _outputNbChunk) {
 	audio::drain::AutoLogInOut tmpLog("Volume");
+	// take the parameters published by the control thread since the previous period
+	if (m_parameter.update() == true) {
+		applyParameter();
+	}
 	// chack if we need to process:
 	if (m_needProcess == false) {
 		_output = _input;
@@ -339,14 +980,41 @@ bool audio::drain::Volume::process(audio::Time& _time,
 		return true;
 	}
 	if (_input == null) {
-		_output = &(m_outputData[0]);
+		_output = m_outputData.data();
 		_outputNbChunk = 0;
 		DRAIN_ERROR("null pointer input ... ");
 		return false;
 	}
 	_outputNbChunk = _inputNbChunk;
-	m_outputData.resize(_outputNbChunk*m_input.getMap().size()*m_formatSize);
-	_output = &(m_outputData[0]);
+	if (m_inputSilence == true) {
+		// the gain of 0 is 0, only the ramp continue
+		skipRamp(_outputNbChunk);
+		_output = getSilenceBuffer(_input, _outputNbChunk);
+		return true;
+	}
+	if (    m_rampNbFrame == 0
+	     && m_volumeAppli == 1.0f
+	     && m_input.getFormat() == m_output.getFormat()) {
+		// unity gain ==> nothing to do
+		_output = _input;
+		return true;
+	}
+	_output = getOutputBuffer(_outputNbChunk);
+	if (    m_rampNbFrame == 0
+	     && m_volumeAppli == 0.0f) {
+		// mute ==> the next algos see a silent stream
+		memset(_output, 0, _outputNbChunk*m_output.getChunkSize());
+		m_outputSilence = true;
+		return true;
+	}
+	if (m_rampNbFrame > 0) {
+		if (m_functionRamp == null) {
+			DRAIN_ERROR("null ramp function ptr");
+			return false;
+		}
+		processRamp(_input, _output, _outputNbChunk);
+		return true;
+	}
 	if (m_functionConvert == null) {
 		DRAIN_ERROR("null function ptr");
 		return false;
@@ -360,6 +1028,7 @@ void audio::drain::Volume::addVolumeStage(const ememory::SharedPtr<audio::drain:
 	if (_volume == null) {
 		return;
 	}
+	ethread::UniqueLock lock(m_parameterLock);
 	for (size_t iii=0; iii<m_volumeList.size(); ++iii) {
 		if (m_volumeList[iii] == null) {
 			continue;
@@ -373,12 +1042,13 @@ void audio::drain::Volume::addVolumeStage(const ememory::SharedPtr<audio::drain:
 		}
 	}
 	m_volumeList.pushBack(_volume);
-	volumeChange();
+	publishParameter();
 }
 
 bool audio::drain::Volume::setParameter(const etk::String& _parameter, const etk::String& _value) {
 	if (_parameter == "FLOW") {
 		// set Volume ...
+		ethread::UniqueLock lock(m_parameterLock);
 		for (auto &it : m_volumeList) {
 			if (it == null) {
 				continue;
@@ -395,11 +1065,37 @@ bool audio::drain::Volume::setParameter(const etk::String& _parameter, const etk
 				}
 				it->setVolume(value);
 				DRAIN_DEBUG("Set volume : FLOW = " << value << " dB (from:" << _value << ")");
-				volumeChange();
+				publishParameter();
 				return true;
 			}
 		}
 	}
+	if (_parameter == "RAMP") {
+		if (_value == "none") {
+			setRamp(audio::drain::volumeRamp_none, m_rampDuration);
+		} else if (_value == "linear") {
+			setRamp(audio::drain::volumeRamp_linear, m_rampDuration);
+		} else if (_value == "exponential") {
+			setRamp(audio::drain::volumeRamp_exponential, m_rampDuration);
+		} else {
+			DRAIN_ERROR("Can not set ramp ... : '" << _value << "' not in [none,linear,exponential]");
+			return false;
+		}
+		return true;
+	}
+	if (_parameter == "RAMP_DURATION") {
+		float value = 0;
+		if (sscanf(_value.c_str(), "%fms", &value) != 1) {
+			return false;
+		}
+		if (    value < 0
+		     || value > 10000) {
+			DRAIN_ERROR("Can not set ramp duration ... : '" << _value << "' out of range : [0..10000]");
+			return false;
+		}
+		setRamp(m_rampType, value);
+		return true;
+	}
 	DRAIN_ERROR("unknow set Parameter : '" << _parameter << "' with Value: '" << _value << "'");
 	return false;
 }
@@ -416,6 +1112,19 @@ etk::String audio::drain::Volume::getParameter(const etk::String& _parameter) co
 			}
 		}
 	}
+	if (_parameter == "RAMP") {
+		switch (m_rampType) {
+			case audio::drain::volumeRamp_none:
+				return "none";
+			case audio::drain::volumeRamp_linear:
+				return "linear";
+			case audio::drain::volumeRamp_exponential:
+				return "exponential";
+		}
+	}
+	if (_parameter == "RAMP_DURATION") {
+		return etk::toString(m_rampDuration) + "ms";
+	}
 	DRAIN_ERROR("unknow get Parameter : '" << _parameter << "'");
 	return "[ERROR]";
 }
@@ -432,6 +1141,12 @@ etk::String audio::drain::Volume::getParameterProperty(const etk::String& _param
 			}
 		}
 	}
+	if (_parameter == "RAMP") {
+		return "[none,linear,exponential]";
+	}
+	if (_parameter == "RAMP_DURATION") {
+		return "[0..10000]ms";
+	}
 	DRAIN_ERROR("unknow Parameter property for: '" << _parameter << "'");
 	return "[ERROR]";
 }
@@ -10,6 +10,8 @@
 	#include <speex/speex_resampler.h>
 #endif
 #include <ememory/memory.hpp>
+#include <ethread/Mutex.hpp>
+#include <audio/drain/ParameterBlock.hpp>
 
 namespace audio {
 	namespace drain {
@@ -47,9 +49,35 @@ namespace audio {
 					m_mute = _mute;
 				}
 		};
+		/**
+		 * @brief Shape of the gain transition when the volume change.
+		 */
+		enum volumeRamp {
+			volumeRamp_none, //!< Instant change of the gain
+			volumeRamp_linear, //!< Linear gain interpolation
+			volumeRamp_exponential, //!< Exponential gain interpolation (linear in dB)
+		};
+		/**
+		 * @brief Gain computed by the control thread and applied by the audio thread at the next period.
+		 */
+		class VolumeParameter {
+			public:
+				VolumeParameter() :
+				  m_volume(1.0f),
+				  m_coef(1<<16),
+				  m_decalage(16),
+				  m_rampType(volumeRamp_linear),
+				  m_rampDuration(10.0f) {
+					
+				}
+				float m_volume; //!< Gain for the float format
+				int32_t m_coef; //!< Gain for the integer formats: (X * m_coef + round) >> m_decalage
+				int32_t m_decalage; //!< Shift of the integer gain
+				enum volumeRamp m_rampType; //!< Shape of the ramp
+				float m_rampDuration; //!< Duration of the ramp in milli-second
+		};
 		// TODO: Optimisation
 		// TODO: Zero crossing
-		// TODO: Continuous update volume
 		// TODO: Manage multiple volume
 		// TODO: Manage set volume
 		class Volume : public audio::drain::Algo {
@@ -58,10 +86,25 @@ namespace audio {
 				// for float input :
 				float m_volumeAppli;
 				// for integer input :
-				int32_t m_volumeDecalage; // Volume to apply is simple as : X * m_coef >> m_coef
+				int32_t m_volumeDecalage; // Volume to apply is simple as : (X * m_coef + round) >> m_volumeDecalage
 				int32_t m_volumeCoef;
 				// convertion function:
 				void (*m_functionConvert)(void* _input, void* _output, size_t _nbSample, int32_t _volumeCoef, int32_t _volumeDecalage, float _volumeAppli);
+				// parameters set by the control thread:
+				ethread::Mutex m_parameterLock; //!< Serialize the control threads (never taken by the process)
+				enum volumeRamp m_rampType; //!< Shape of the ramp requested
+				float m_rampDuration; //!< Duration of the ramp requested in milli-second
+				audio::drain::ParameterBlock<audio::drain::VolumeParameter> m_parameter; //!< Parameters published for the process
+				// ramp of the gain when the volume change:
+				float m_volumeCurrent; //!< Gain applied on the last processed frame (== m_volumeAppli when no ramp is active)
+				float m_rampStep; //!< Gain increment (linear) or factor (exponential) for each frame
+				size_t m_rampNbFrame; //!< Number of frame remaining in the current ramp
+				float m_rampScale; //!< Scale between the input and output format range
+				etk::Vector<float> m_rampGain; //!< Gain for each sample of a block (avoid allocation in process)
+				// convertion function with a gain for each sample:
+				void (*m_functionRamp)(const void* _input, void* _output, size_t _nbSample, const float* _gain);
+				// copy the gain of each frame on all its channels (specialized on the number of channel):
+				void (*m_functionExpandGain)(float* _gain, size_t _nbFrame, size_t _nbChannel);
 			protected:
 				/**
 				 * @brief Constructor
@@ -77,6 +120,7 @@ namespace audio {
 			protected:
 				virtual void configurationChange();
 			public:
+				virtual bool canProcessInPlace() const;
 				virtual bool process(audio::Time& _time,
 				                     void* _input,
 				                     size_t _inputNbChunk,
@@ -85,13 +129,48 @@ namespace audio {
 			public:
 				virtual etk::Vector<audio::format> getFormatSupportedInput();
 				virtual etk::Vector<audio::format> getFormatSupportedOutput();
+				virtual void appendSupportedKey(audio::drain::NegotiationHash& _hash) const;
 			public:
 				virtual void addVolumeStage(const ememory::SharedPtr<drain::VolumeElement>& _volume);
 				virtual bool setParameter(const etk::String& _parameter, const etk::String& _value);
 				virtual etk::String getParameter(const etk::String& _parameter) const;
 				virtual etk::String getParameterProperty(const etk::String& _parameter) const;
 			public:
+				/**
+				 * @brief Compute the gain of the volume stages and publish it for the next period (can be called from any thread).
+				 */
 				void volumeChange();
+				/**
+				 * @brief Set the ramp used when the volume change (avoid clicks).
+				 * @param[in] _type Shape of the ramp.
+				 * @param[in] _durationMs Duration of the ramp in milli-second.
+				 */
+				void setRamp(enum volumeRamp _type, float _durationMs);
+			private:
+				/**
+				 * @brief Compute the gain and publish it (m_parameterLock must be locked).
+				 */
+				void publishParameter();
+				/**
+				 * @brief Use the last parameters taken in m_parameter (audio thread).
+				 */
+				void applyParameter();
+				/**
+				 * @brief Start a ramp from the current gain to the new volume (or jump to it when no ramp is set).
+				 */
+				void startRamp();
+				/**
+				 * @brief Apply the gain ramp on a buffer.
+				 * @param[in] _input Input data.
+				 * @param[in] _output Output data.
+				 * @param[in] _nbChunk Number of chunk to process.
+				 */
+				void processRamp(void* _input, void* _output, size_t _nbChunk);
+				/**
+				 * @brief Move the gain ramp without processing (silent input).
+				 * @param[in] _nbChunk Number of chunk of the input.
+				 */
+				void skipRamp(size_t _nbChunk);
 			public:
 				virtual etk::String getDotDesc();
 		};
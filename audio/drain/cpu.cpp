@@ -0,0 +1,132 @@
+/** @file
+ * @author Edouard DUPIN 
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <audio/drain/cpu.hpp>
+#include <audio/drain/debug.hpp>
+
+static bool g_simdEnable = true;
+
+#ifdef DRAIN_SIMD_X86
+	static bool checkCpu(int32_t _id) {
+		__builtin_cpu_init();
+		switch (_id) {
+			case 0:
+				return __builtin_cpu_supports("sse2");
+			case 1:
+				return __builtin_cpu_supports("avx2");
+		}
+		return false;
+	}
+#endif
+
+bool audio::drain::cpu::haveSse2() {
+	#ifdef DRAIN_SIMD_X86
+		static bool value = checkCpu(0);
+		return g_simdEnable && value;
+	#else
+		return false;
+	#endif
+}
+
+bool audio::drain::cpu::haveAvx2() {
+	#ifdef DRAIN_SIMD_X86
+		static bool value = checkCpu(1);
+		return g_simdEnable && value;
+	#else
+		return false;
+	#endif
+}
+
+bool audio::drain::cpu::haveNeon() {
+	#ifdef DRAIN_SIMD_NEON
+		return g_simdEnable;
+	#else
+		return false;
+	#endif
+}
+
+void audio::drain::cpu::setSimdEnable(bool _value) {
+	DRAIN_INFO("Set SIMD kernels: " << (_value==true?"enable":"disable"));
+	g_simdEnable = _value;
+}
+
+bool audio::drain::cpu::getSimdEnable() {
+	return g_simdEnable;
+}
+
+#ifdef DRAIN_SIMD_X86
+	//! Flush To Zero (bit 15) and Denormals Are Zero (bit 6) of the MXCSR
+	static const uint32_t g_flushMask = 0x8040;
+	DRAIN_TARGET_SSE2 static uint32_t getMxcsr() {
+		return _mm_getcsr();
+	}
+	DRAIN_TARGET_SSE2 static void setMxcsr(uint32_t _value) {
+		_mm_setcsr(_value);
+	}
+#elif    defined(__GNUC__) \
+      && defined(__aarch64__)
+	//! Flush to zero bit of the FPCR
+	static const uint64_t g_flushMask = 1 << 24;
+#endif
+
+uint32_t audio::drain::cpu::enableFlushDenormal() {
+	#ifdef DRAIN_SIMD_X86
+		static bool value = checkCpu(0);
+		if (value == false) {
+			return 0;
+		}
+		uint32_t mode = getMxcsr();
+		setMxcsr(mode | g_flushMask);
+		return mode;
+	#elif    defined(__GNUC__) \
+	      && defined(__aarch64__)
+		uint64_t mode = 0;
+		__asm__ __volatile__("mrs %0, fpcr" : "=r"(mode));
+		__asm__ __volatile__("msr fpcr, %0" : : "r"(mode | g_flushMask));
+		return uint32_t(mode);
+	#else
+		return 0;
+	#endif
+}
+
+void audio::drain::cpu::restoreFloatMode(uint32_t _mode) {
+	#ifdef DRAIN_SIMD_X86
+		static bool value = checkCpu(0);
+		if (value == false) {
+			return;
+		}
+		setMxcsr(_mode);
+	#elif    defined(__GNUC__) \
+	      && defined(__aarch64__)
+		uint64_t mode = _mode;
+		__asm__ __volatile__("msr fpcr, %0" : : "r"(mode));
+	#endif
+}
+
+#ifdef DRAIN_SIMD_X86
+	static double calibrateCycle() {
+		echrono::Steady start = echrono::Steady::now();
+		uint64_t startCycle = audio::drain::cpu::getCycle();
+		int64_t delta = 0;
+		while (delta < 2000000) {
+			delta = (echrono::Steady::now() - start).get();
+		}
+		uint64_t nbCycle = audio::drain::cpu::getCycle() - startCycle;
+		if (nbCycle == 0) {
+			return 1.0;
+		}
+		return double(delta) / double(nbCycle);
+	}
+#endif
+
+double audio::drain::cpu::getCycleDuration() {
+	#ifdef DRAIN_SIMD_X86
+		static double value = calibrateCycle();
+		return value;
+	#else
+		return 1.0;
+	#endif
+}
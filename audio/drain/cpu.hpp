@@ -0,0 +1,113 @@
+/** @file
+ * @author Edouard DUPIN 
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <echrono/Steady.hpp>
+
+#if    defined(__GNUC__) \
+    && (    defined(__x86_64__) \
+         || defined(__i386__))
+	#define DRAIN_SIMD_X86
+	#include <immintrin.h>
+	//! Compile a function with the SSE2 instruction set (must only be called when audio::drain::cpu::haveSse2() == true)
+	#define DRAIN_TARGET_SSE2 __attribute__((target("sse2")))
+	//! Compile a function with the AVX2 instruction set (must only be called when audio::drain::cpu::haveAvx2() == true)
+	#define DRAIN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#if    defined(__ARM_NEON) \
+    || defined(__ARM_NEON__)
+	#define DRAIN_SIMD_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace audio {
+	namespace drain {
+		/**
+		 * @brief Run-time detection of the CPU instruction set used by the optimized kernels.
+		 */
+		namespace cpu {
+			/**
+			 * @brief Check if the SSE2 kernels can be used.
+			 * @return true if the CPU support SSE2 and the SIMD is enable.
+			 */
+			bool haveSse2();
+			/**
+			 * @brief Check if the AVX2 kernels can be used.
+			 * @return true if the CPU support AVX2 and the SIMD is enable.
+			 */
+			bool haveAvx2();
+			/**
+			 * @brief Check if the NEON kernels can be used.
+			 * @return true if the CPU support NEON and the SIMD is enable.
+			 */
+			bool haveNeon();
+			/**
+			 * @brief Enable or disable all the SIMD kernels (the generic C kernels are used when disable).
+			 * @note Only used at the configuration of the algos (not change the algos already configured).
+			 * @param[in] _value New state.
+			 */
+			void setSimdEnable(bool _value);
+			/**
+			 * @brief Get the SIMD kernels state.
+			 * @return true if the SIMD kernels can be used.
+			 */
+			bool getSimdEnable();
+			/**
+			 * @brief Enable the flush of the denormal floats of the calling thread (FTZ and DAZ on x86, FZ on ARM).
+			 * @return Previous state of the float unit (to give to restoreFloatMode).
+			 */
+			uint32_t enableFlushDenormal();
+			/**
+			 * @brief Restore the state of the float unit of the calling thread.
+			 * @param[in] _mode State returned by enableFlushDenormal.
+			 */
+			void restoreFloatMode(uint32_t _mode);
+			/**
+			 * @brief Flush the denormal floats on the calling thread during the life of the object.
+			 */
+			class FlushDenormal {
+				private:
+					bool m_enable; //!< The float unit has been changed
+					uint32_t m_mode; //!< State of the float unit before the change
+				public:
+					/**
+					 * @brief Constructor.
+					 * @param[in] _enable Change the float unit (nothing is done if false).
+					 */
+					FlushDenormal(bool _enable) :
+					  m_enable(_enable),
+					  m_mode(0) {
+						if (m_enable == true) {
+							m_mode = enableFlushDenormal();
+						}
+					}
+					~FlushDenormal() {
+						if (m_enable == true) {
+							restoreFloatMode(m_mode);
+						}
+					}
+			};
+			/**
+			 * @brief Get a low cost time counter (for profiling).
+			 * @return Number of CPU cycle on x86 (time stamp counter), number of nano-second otherwise.
+			 */
+			inline uint64_t getCycle() {
+				#ifdef DRAIN_SIMD_X86
+					return __rdtsc();
+				#else
+					return echrono::Steady::now().get();
+				#endif
+			}
+			/**
+			 * @brief Get the duration of a unit of getCycle() (calibrated at the first call on x86: about 2ms).
+			 * @return Duration in nano-second.
+			 */
+			double getCycleDuration();
+		}
+	}
+}
+
@@ -0,0 +1,357 @@
+/** @file
+ * @author Edouard DUPIN 
+ * @copyright 2015, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <etk/etk.hpp>
+#include <test-debug/debug.hpp>
+#include <echrono/Steady.hpp>
+#include <audio/drain/Process.hpp>
+#include <audio/drain/Volume.hpp>
+#include <audio/drain/Equalizer.hpp>
+#include <audio/drain/cpu.hpp>
+extern "C" {
+	#include <stdio.h>
+	#include <string.h>
+	#include <math.h>
+}
+
+static etk::String formatName(enum audio::format _format) {
+	switch (_format) {
+		case audio::format_int16:
+			return "int16";
+		case audio::format_int16_on_int32:
+			return "int16-on-int32";
+		case audio::format_int32:
+			return "int32";
+		case audio::format_float:
+			return "float";
+		default:
+			break;
+	}
+	return "unknow";
+}
+
+static etk::Vector<audio::channel> getMap(int32_t _nbChannel) {
+	etk::Vector<audio::channel> out;
+	if (_nbChannel == 1) {
+		out.pushBack(audio::channel_frontCenter);
+	} else if (_nbChannel == 2) {
+		out.pushBack(audio::channel_frontLeft);
+		out.pushBack(audio::channel_frontRight);
+	} else {
+		out.pushBack(audio::channel_frontLeft);
+		out.pushBack(audio::channel_frontRight);
+		out.pushBack(audio::channel_frontCenter);
+		out.pushBack(audio::channel_lfe);
+		out.pushBack(audio::channel_rearLeft);
+		out.pushBack(audio::channel_rearRight);
+	}
+	return out;
+}
+
+/**
+ * @brief Description of one benchmark chain.
+ */
+class BenchConfig {
+	public:
+		etk::String m_name; //!< Type of the chain (format, volume, resampler, channel, equalizer)
+		enum audio::format m_inputFormat;
+		enum audio::format m_outputFormat;
+		int32_t m_inputNbChannel;
+		int32_t m_outputNbChannel;
+		float m_inputFrequency;
+		float m_outputFrequency;
+		bool m_volume; //!< Add a volume stage
+		bool m_equalizer; //!< Add an equalizer stage
+		BenchConfig(const etk::String& _name,
+		            enum audio::format _inputFormat,
+		            enum audio::format _outputFormat,
+		            int32_t _inputNbChannel,
+		            int32_t _outputNbChannel,
+		            float _inputFrequency=48000,
+		            float _outputFrequency=48000,
+		            bool _volume=false,
+		            bool _equalizer=false) :
+		  m_name(_name),
+		  m_inputFormat(_inputFormat),
+		  m_outputFormat(_outputFormat),
+		  m_inputNbChannel(_inputNbChannel),
+		  m_outputNbChannel(_outputNbChannel),
+		  m_inputFrequency(_inputFrequency),
+		  m_outputFrequency(_outputFrequency),
+		  m_volume(_volume),
+		  m_equalizer(_equalizer) {
+
+		}
+};
+
+/**
+ * @brief Result of one benchmark chain.
+ */
+class BenchResult {
+	public:
+		etk::String m_chain; //!< List of the algo of the chain (after negotiation)
+		double m_nsPerSample; //!< Mean time to process one input sample (one channel)
+		double m_samplePerSecond; //!< Number of input sample processed in one second
+		int64_t m_periodMean; //!< Mean time of a period in ns
+		int64_t m_periodP99; //!< 99 percentile of the period time in ns
+		int64_t m_periodMax; //!< Worst period time in ns
+};
+
+static void sortDuration(etk::Vector<int64_t>& _list) {
+	// shell sort: no allocation
+	for (size_t gap=_list.size()/2; gap>0; gap/=2) {
+		for (size_t iii=gap; iii<_list.size(); ++iii) {
+			int64_t value = _list[iii];
+			size_t jjj = iii;
+			for (; jjj>=gap && _list[jjj-gap] > value; jjj-=gap) {
+				_list[jjj] = _list[jjj-gap];
+			}
+			_list[jjj] = value;
+		}
+	}
+}
+
+static BenchResult runBench(const BenchConfig& _config, size_t _period, size_t _nbIteration) {
+	BenchResult out;
+	audio::drain::Process process;
+	process.setInputConfig(audio::drain::IOFormatInterface(getMap(_config.m_inputNbChannel), _config.m_inputFormat, _config.m_inputFrequency));
+	process.setOutputConfig(audio::drain::IOFormatInterface(getMap(_config.m_outputNbChannel), _config.m_outputFormat, _config.m_outputFrequency));
+	if (_config.m_volume == true) {
+		ememory::SharedPtr<audio::drain::Volume> algo = audio::drain::Volume::create();
+		algo->addVolumeStage(ememory::makeShared<audio::drain::VolumeElement>("FLOW"));
+		algo->setParameter("FLOW", "-6dB");
+		process.pushBack(algo);
+	}
+	if (_config.m_equalizer == true) {
+		ememory::SharedPtr<audio::drain::Equalizer> algo = audio::drain::Equalizer::create();
+		etk::String conf = "{\n\tglobal:[\n";
+		for (int32_t iii=0; iii<10; ++iii) {
+			if (iii != 0) {
+				conf += "\t\t,\n";
+			}
+			conf += "\t\t{ type:'peak', quality:2, cut-frequency:" + etk::toString(31.25f * float(1<<iii)) + ", gain:3 }\n";
+		}
+		conf += "\t]\n}\n";
+		algo->setParameter("config", conf);
+		process.pushBack(algo);
+	}
+	process.updateInterAlgo();
+	for (size_t iii=0; iii<process.size(); ++iii) {
+		if (iii != 0) {
+			out.m_chain += ",";
+		}
+		out.m_chain += process[iii]->getType();
+	}
+	// input data: a sinus (not silence, some algo can optimize it)
+	size_t nbSample = _period * _config.m_inputNbChannel;
+	etk::Vector<int8_t> input;
+	input.resize(nbSample * audio::getFormatBytes(_config.m_inputFormat));
+	for (size_t iii=0; iii<nbSample; ++iii) {
+		float value = 0.5f * sin(float(iii) * 0.05f);
+		switch (_config.m_inputFormat) {
+			case audio::format_int16:
+				reinterpret_cast<int16_t*>(&input[0])[iii] = int16_t(value * 32767.0f);
+				break;
+			case audio::format_int16_on_int32:
+				reinterpret_cast<int32_t*>(&input[0])[iii] = int32_t(value * 32767.0f);
+				break;
+			case audio::format_int32:
+				reinterpret_cast<int32_t*>(&input[0])[iii] = int32_t(value * 2147483520.0f);
+				break;
+			case audio::format_float:
+				reinterpret_cast<float*>(&input[0])[iii] = value;
+				break;
+			default:
+				break;
+		}
+	}
+	etk::Vector<int64_t> periodTime;
+	periodTime.resize(_nbIteration);
+	audio::Time time;
+	// warm-up (first allocations, cache)
+	for (size_t iii=0; iii<16; ++iii) {
+		void* output = null;
+		size_t outputNbChunk = 0;
+		process.process(time, &input[0], _period, output, outputNbChunk);
+	}
+	int64_t totalTime = 0;
+	for (size_t iii=0; iii<_nbIteration; ++iii) {
+		void* output = null;
+		size_t outputNbChunk = 0;
+		echrono::Steady start = echrono::Steady::now();
+		process.process(time, &input[0], _period, output, outputNbChunk);
+		int64_t delta = (echrono::Steady::now() - start).get();
+		periodTime[iii] = delta;
+		totalTime += delta;
+	}
+	sortDuration(periodTime);
+	double nbSampleTotal = double(nbSample) * double(_nbIteration);
+	out.m_nsPerSample = 0.0;
+	if (nbSampleTotal != 0.0) {
+		out.m_nsPerSample = double(totalTime) / nbSampleTotal;
+	}
+	out.m_samplePerSecond = 0.0;
+	if (totalTime != 0) {
+		out.m_samplePerSecond = nbSampleTotal * 1000000000.0 / double(totalTime);
+	}
+	out.m_periodMean = 0;
+	out.m_periodP99 = 0;
+	out.m_periodMax = 0;
+	if (_nbIteration != 0) {
+		out.m_periodMean = totalTime / int64_t(_nbIteration);
+		out.m_periodP99 = periodTime[(_nbIteration * 99) / 100];
+		out.m_periodMax = periodTime[_nbIteration - 1];
+	}
+	return out;
+}
+
+/**
+ * @brief Measure a volume change on the control side (automation of a ducking).
+ * @param[in] _nbIteration Number of change measured.
+ * @return Mean time of a change in ns.
+ */
+static double runVolumeChange(size_t _nbIteration) {
+	ememory::SharedPtr<audio::drain::Volume> algo = audio::drain::Volume::create();
+	algo->addVolumeStage(ememory::makeShared<audio::drain::VolumeElement>("FLOW"));
+	algo->setFormat(audio::drain::IOFormatInterface(getMap(2), audio::format_int16, 48000),
+	                audio::drain::IOFormatInterface(getMap(2), audio::format_int16, 48000));
+	echrono::Steady start = echrono::Steady::now();
+	for (size_t iii=0; iii<_nbIteration; ++iii) {
+		algo->setParameter("FLOW", etk::toString(-float(iii%200)/10.0f) + "dB");
+	}
+	if (_nbIteration == 0) {
+		return 0.0;
+	}
+	return double((echrono::Steady::now() - start).get()) / double(_nbIteration);
+}
+
+static etk::Vector<BenchConfig> createConfigList() {
+	etk::Vector<BenchConfig> out;
+	enum audio::format formatList[] = {
+		audio::format_int16,
+		audio::format_int16_on_int32,
+		audio::format_int32,
+		audio::format_float
+	};
+	int32_t channelList[] = {1, 2, 6};
+	for (size_t fff=0; fff<4; ++fff) {
+		for (size_t ccc=0; ccc<3; ++ccc) {
+			int32_t nbChannel = channelList[ccc];
+			// format conversion
+			for (size_t ggg=0; ggg<4; ++ggg) {
+				if (ggg == fff) {
+					continue;
+				}
+				out.pushBack(BenchConfig("format", formatList[fff], formatList[ggg], nbChannel, nbChannel));
+			}
+			// volume
+			out.pushBack(BenchConfig("volume", formatList[fff], formatList[fff], nbChannel, nbChannel, 48000, 48000, true));
+			// Resampler
+			out.pushBack(BenchConfig("resampler", formatList[fff], formatList[fff], nbChannel, nbChannel, 44100, 48000));
+			// channel reorder
+			for (size_t ddd=0; ddd<3; ++ddd) {
+				if (ddd == ccc) {
+					continue;
+				}
+				out.pushBack(BenchConfig("channel", formatList[fff], formatList[fff], nbChannel, channelList[ddd]));
+			}
+			// equalizer
+			out.pushBack(BenchConfig("equalizer", formatList[fff], formatList[fff], nbChannel, nbChannel, 48000, 48000, false, true));
+		}
+	}
+	// conversion done by the volume (mono int16 -> stereo float)
+	out.pushBack(BenchConfig("volume", audio::format_int16, audio::format_float, 1, 2, 48000, 48000, true));
+	// full chain of a playback stream
+	out.pushBack(BenchConfig("playback", audio::format_int16, audio::format_float, 2, 6, 44100, 48000, true, true));
+	return out;
+}
+
+int main(int _argc, const char** _argv) {
+	etk::init(_argc, _argv);
+	size_t period = 256;
+	size_t nbIteration = 1000;
+	etk::String filter;
+	etk::String outputFile;
+	for (int32_t iii=0; iii<_argc ; ++iii) {
+		etk::String data = _argv[iii];
+		if (    data == "-h"
+		     || data == "--help") {
+			TEST_INFO("Help : ");
+			TEST_INFO("    ./xxx [options]");
+			TEST_INFO("        --period=XXX     Number of chunk in a process call (default 256)");
+			TEST_INFO("        --iteration=XXX  Number of process call measured (default 1000)");
+			TEST_INFO("        --filter=XXX     Only run the chain of this type (format, volume, resampler, channel, equalizer, playback, volume-change)");
+			TEST_INFO("        --no-simd        Disable the SIMD kernels");
+			TEST_INFO("        --output=XXX     Write the JSON result in a file (default: stdout)");
+			return 0;
+		} else if (data.startWith("--period=") == true) {
+			period = etk::string_to_int32_t(etk::String(data.begin()+9, data.end()));
+		} else if (data.startWith("--iteration=") == true) {
+			nbIteration = etk::string_to_int32_t(etk::String(data.begin()+12, data.end()));
+		} else if (data.startWith("--filter=") == true) {
+			filter = etk::String(data.begin()+9, data.end());
+		} else if (data == "--no-simd") {
+			audio::drain::cpu::setSimdEnable(false);
+		} else if (data.startWith("--output=") == true) {
+			outputFile = etk::String(data.begin()+9, data.end());
+		}
+	}
+	etk::Vector<BenchConfig> list = createConfigList();
+	etk::String json = "{\n";
+	json += "\t\"period\":" + etk::toString(period) + ",\n";
+	json += "\t\"iteration\":" + etk::toString(nbIteration) + ",\n";
+	json += "\t\"simd\":{\"sse2\":" + etk::toString(audio::drain::cpu::haveSse2())
+	      + ",\"avx2\":" + etk::toString(audio::drain::cpu::haveAvx2())
+	      + ",\"neon\":" + etk::toString(audio::drain::cpu::haveNeon()) + "},\n";
+	json += "\t\"results\":[\n";
+	bool first = true;
+	for (size_t iii=0; iii<list.size(); ++iii) {
+		const BenchConfig& config = list[iii];
+		if (    filter.size() != 0
+		     && filter != config.m_name) {
+			continue;
+		}
+		BenchResult result = runBench(config, period, nbIteration);
+		TEST_INFO(config.m_name << " " << formatName(config.m_inputFormat) << "/" << config.m_inputNbChannel << "ch/" << config.m_inputFrequency
+		          << " ==> " << formatName(config.m_outputFormat) << "/" << config.m_outputNbChannel << "ch/" << config.m_outputFrequency
+		          << " : " << result.m_nsPerSample << " ns/sample p99=" << result.m_periodP99 << " ns [" << result.m_chain << "]");
+		if (first == false) {
+			json += ",\n";
+		}
+		first = false;
+		json += "\t\t{";
+		json += "\"name\":\"" + config.m_name + "\"";
+		json += ",\"input\":{\"format\":\"" + formatName(config.m_inputFormat) + "\",\"channel\":" + etk::toString(config.m_inputNbChannel) + ",\"frequency\":" + etk::toString(int32_t(config.m_inputFrequency)) + "}";
+		json += ",\"output\":{\"format\":\"" + formatName(config.m_outputFormat) + "\",\"channel\":" + etk::toString(config.m_outputNbChannel) + ",\"frequency\":" + etk::toString(int32_t(config.m_outputFrequency)) + "}";
+		json += ",\"chain\":\"" + result.m_chain + "\"";
+		json += ",\"ns-per-sample\":" + etk::toString(result.m_nsPerSample);
+		json += ",\"sample-per-second\":" + etk::toString(int64_t(result.m_samplePerSecond));
+		json += ",\"period-mean-ns\":" + etk::toString(result.m_periodMean);
+		json += ",\"period-p99-ns\":" + etk::toString(result.m_periodP99);
+		json += ",\"period-max-ns\":" + etk::toString(result.m_periodMax);
+		json += "}";
+	}
+	json += "\n\t]";
+	if (    filter.size() == 0
+	     || filter == "volume-change") {
+		double nsByChange = runVolumeChange(nbIteration);
+		TEST_INFO("volume-change : " << nsByChange << " ns");
+		json += ",\n\t\"volume-change-ns\":" + etk::toString(nsByChange);
+	}
+	json += "\n}\n";
+	if (outputFile.size() == 0) {
+		printf("%s", json.c_str());
+		return 0;
+	}
+	FILE* file = fopen(outputFile.c_str(), "w");
+	if (file == null) {
+		TEST_ERROR("Can not open the output file: '" << outputFile << "'");
+		return -1;
+	}
+	fwrite(json.c_str(), 1, json.size(), file);
+	fclose(file);
+	return 0;
+}
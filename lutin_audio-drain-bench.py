@@ -0,0 +1,37 @@
+#!/usr/bin/python
+import realog.debug as debug
+import lutin.tools as tools
+
+
+def get_type():
+	return "BINARY"
+
+def get_sub_type():
+	return "TOOLS"
+
+def get_desc():
+	return "headless benchmark of the audio flow"
+
+def get_licence():
+	return "MPL-2"
+
+def get_compagny_type():
+	return "com"
+
+def get_compagny_name():
+	return "atria-soft"
+
+def get_maintainer():
+	return "authors.txt"
+
+def configure(target, my_module):
+	my_module.add_src_file([
+		'bench/main.cpp'
+		])
+	my_module.add_depend([
+	    'audio-drain',
+	    'etk',
+	    'test-debug'
+	    ])
+	return True
+
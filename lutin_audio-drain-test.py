@@ -31,7 +31,16 @@ def configure(target, my_module):
 		'test/resampling.cpp',
 		'test/format.cpp',
 		'test/channelOrder.cpp',
-		'test/equalizer.cpp'
+		'test/equalizer.cpp',
+		'test/volume.cpp',
+		'test/processGraph.cpp',
+		'test/processGroup.cpp',
+		'test/circularBuffer.cpp',
+		'test/mixer.cpp',
+		'test/executor.cpp',
+		'test/staticProcess.cpp',
+		'test/statusQueue.cpp',
+		'test/metric.cpp'
 		])
 	my_module.add_depend([
 	    'audio-drain',
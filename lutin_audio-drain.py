@@ -28,8 +28,12 @@ def configure(target, my_module):
 	
 	my_module.add_src_file([
 	    'audio/drain/debug.cpp',
+	    'audio/drain/cpu.cpp',
 	    'audio/drain/airtalgo.cpp',
+	    'audio/drain/AlignedBuffer.cpp',
+	    'audio/drain/BiquadCascade.cpp',
 	    'audio/drain/Algo.cpp',
+	    'audio/drain/AlgoPool.cpp',
 	    'audio/drain/ChannelReorder.cpp',
 	    'audio/drain/CircularBuffer.cpp',
 	    'audio/drain/EndPointCallback.cpp',
@@ -37,8 +41,15 @@ def configure(target, my_module):
 	    'audio/drain/EndPointRead.cpp',
 	    'audio/drain/EndPointWrite.cpp',
 	    'audio/drain/FormatUpdate.cpp',
+	    'audio/drain/Mixer.cpp',
 	    'audio/drain/Process.cpp',
+	    'audio/drain/ProcessGroup.cpp',
+	    'audio/drain/ProcessGraph.cpp',
+	    'audio/drain/StatusQueue.cpp',
+	    'audio/drain/Metric.cpp',
+	    'audio/drain/Executor.cpp',
 	    'audio/drain/Resampler.cpp',
+	    'audio/drain/PolyphaseResampler.cpp',
 	    'audio/drain/Volume.cpp',
 	    'audio/drain/IOFormatInterface.cpp',
 	    'audio/drain/AutoLogInOut.cpp',
@@ -48,8 +59,13 @@ def configure(target, my_module):
 	my_module.add_header_file([
 	    'audio/drain/debug.hpp',
 	    'audio/drain/debugRemove.hpp',
+	    'audio/drain/cpu.hpp',
 	    'audio/drain/airtalgo.hpp',
+	    'audio/drain/AlignedBuffer.hpp',
+	    'audio/drain/BiquadCascade.hpp',
 	    'audio/drain/Algo.hpp',
+	    'audio/drain/AlgoPool.hpp',
+	    'audio/drain/ParameterBlock.hpp',
 	    'audio/drain/ChannelReorder.hpp',
 	    'audio/drain/CircularBuffer.hpp',
 	    'audio/drain/EndPointCallback.hpp',
@@ -57,8 +73,16 @@ def configure(target, my_module):
 	    'audio/drain/EndPointRead.hpp',
 	    'audio/drain/EndPointWrite.hpp',
 	    'audio/drain/FormatUpdate.hpp',
+	    'audio/drain/Mixer.hpp',
 	    'audio/drain/Process.hpp',
+	    'audio/drain/ProcessGroup.hpp',
+	    'audio/drain/ProcessGraph.hpp',
+	    'audio/drain/StatusQueue.hpp',
+	    'audio/drain/Metric.hpp',
+	    'audio/drain/StaticProcess.hpp',
+	    'audio/drain/Executor.hpp',
 	    'audio/drain/Resampler.hpp',
+	    'audio/drain/PolyphaseResampler.hpp',
 	    'audio/drain/Volume.hpp',
 	    'audio/drain/IOFormatInterface.hpp',
 	    'audio/drain/AutoLogInOut.hpp',
@@ -69,6 +93,7 @@ def configure(target, my_module):
 	my_module.add_flag('c++', "-DHAVE_SPEEX_DSP_RESAMPLE")
 	my_module.add_depend([
 	    'etk',
+	    'ethread-core',
 	    'audio',
 	    'ejson',
 	    'speex-dsp',
@@ -1,5 +1,5 @@
 /** @file
- * @author Edouard DUPIN 
+ * @author Edouard DUPIN
  * @copyright 2015, Edouard DUPIN, all right reserved
  * @license MPL v2.0 (see license file)
  */
@@ -7,4 +7,199 @@
 #include <test-debug/debug.hpp>
 #include <etest/etest.hpp>
 #include <audio/drain/Process.hpp>
+#include <audio/drain/ChannelReorder.hpp>
+#include <audio/drain/cpu.hpp>
+#include "common.hpp"
+extern "C" {
+	#include <math.h>
+}
 
+static const enum audio::format g_listFormat[] = {
+	audio::format_int16,
+	audio::format_int32,
+	audio::format_float
+};
+static const size_t g_nbFormat = sizeof(g_listFormat)/sizeof(enum audio::format);
+
+static etk::Vector<audio::channel> getMapSwap() {
+	etk::Vector<audio::channel> out;
+	out.pushBack(audio::channel_frontRight);
+	out.pushBack(audio::channel_frontLeft);
+	return out;
+}
+
+/**
+ * @brief Couple of map of a test (input, output).
+ */
+class MapCouple {
+	public:
+		etk::Vector<audio::channel> m_input;
+		etk::Vector<audio::channel> m_output;
+		MapCouple(const etk::Vector<audio::channel>& _input, const etk::Vector<audio::channel>& _output) :
+		  m_input(_input),
+		  m_output(_output) {
+
+		}
+};
+
+static etk::Vector<MapCouple> getListMap() {
+	etk::Vector<MapCouple> out;
+	// every specialized kernel and the generic one
+	out.pushBack(MapCouple(test::getMap(1), test::getMap(2)));
+	out.pushBack(MapCouple(test::getMap(2), test::getMap(1)));
+	out.pushBack(MapCouple(test::getMap(6), test::getMap(1)));
+	out.pushBack(MapCouple(test::getMap(2), getMapSwap()));
+	out.pushBack(MapCouple(test::getMap(2), test::getMap(6)));
+	out.pushBack(MapCouple(test::getMap(6), test::getMap(2)));
+	out.pushBack(MapCouple(test::getMap(8), test::getMap(2)));
+	out.pushBack(MapCouple(test::getMap(3), test::getMap(4)));
+	out.pushBack(MapCouple(test::getMap(4), test::getMap(3)));
+	return out;
+}
+
+/**
+ * @brief Scalar reference of a sample of the output.
+ * @param[in] _planar The input is planar.
+ */
+static double referenceReorder(enum audio::format _format,
+                               const void* _data,
+                               size_t _nbChunk,
+                               const MapCouple& _map,
+                               bool _planar,
+                               size_t _chunk,
+                               size_t _channel) {
+	size_t nbChannelIn = _map.m_input.size();
+	if (    _map.m_output.size() == 1
+	     && nbChannelIn > 1) {
+		// down-mix: mean of all the channels (integer division rounded toward 0)
+		double sum = 0.0;
+		for (size_t iii=0; iii<nbChannelIn; ++iii) {
+			sum += test::getValue(_format, _data, _planar == true ? iii*_nbChunk + _chunk : _chunk*nbChannelIn + iii);
+		}
+		if (_format == audio::format_float) {
+			return sum / double(nbChannelIn);
+		}
+		return trunc(sum / double(nbChannelIn));
+	}
+	int32_t id = -1;
+	if (    nbChannelIn == 1
+	     && _map.m_input[0] == audio::channel_frontCenter) {
+		// a mono stream is sent on all the channels
+		id = 0;
+	} else {
+		for (size_t iii=0; iii<nbChannelIn; ++iii) {
+			if (_map.m_input[iii] == _map.m_output[_channel]) {
+				id = iii;
+				break;
+			}
+		}
+	}
+	if (id < 0) {
+		return 0.0;
+	}
+	return test::getValue(_format, _data, _planar == true ? id*_nbChunk + _chunk : _chunk*nbChannelIn + id);
+}
+
+static ememory::SharedPtr<audio::drain::ChannelReorder> createReorder(enum audio::format _format,
+                                                                      const MapCouple& _map,
+                                                                      enum audio::drain::layout _inputLayout=audio::drain::layout_interleaved,
+                                                                      enum audio::drain::layout _outputLayout=audio::drain::layout_interleaved) {
+	return test::createAlgo<audio::drain::ChannelReorder>(audio::drain::IOFormatInterface(_map.m_input, _format, 48000, _inputLayout),
+	                                                      audio::drain::IOFormatInterface(_map.m_output, _format, 48000, _outputLayout));
+}
+
+/**
+ * @brief Check all the samples of a reorder against the reference.
+ * @return Number of wrong sample.
+ */
+static size_t checkReorder(enum audio::format _format,
+                           const MapCouple& _map,
+                           enum audio::drain::layout _inputLayout,
+                           enum audio::drain::layout _outputLayout,
+                           size_t _nbChunk) {
+	ememory::SharedPtr<audio::drain::ChannelReorder> algo = createReorder(_format, _map, _inputLayout, _outputLayout);
+	etk::Vector<uint8_t> data;
+	test::fillRandom(data, _format, _nbChunk*_map.m_input.size(), 1234+_nbChunk, 1.0);
+	audio::Time time;
+	void* outputData = null;
+	size_t outputNbChunk = 0;
+	algo->process(time, &data[0], _nbChunk, outputData, outputNbChunk);
+	if (outputNbChunk != _nbChunk) {
+		return _nbChunk;
+	}
+	bool inputPlanar = _inputLayout == audio::drain::layout_planar;
+	bool outputPlanar = _outputLayout == audio::drain::layout_planar;
+	size_t nbChannelOut = _map.m_output.size();
+	size_t nbError = 0;
+	for (size_t iii=0; iii<_nbChunk; ++iii) {
+		for (size_t jjj=0; jjj<nbChannelOut; ++jjj) {
+			double reference = referenceReorder(_format, &data[0], _nbChunk, _map, inputPlanar, iii, jjj);
+			double value = test::getValue(_format, outputData, outputPlanar == true ? jjj*_nbChunk + iii : iii*nbChannelOut + jjj);
+			if (fabs(value - reference) > fabs(reference)*0.000001) {
+				if (nbError == 0) {
+					TEST_ERROR(_format << " " << _map.m_input << " -> " << _map.m_output << " [" << iii << "," << jjj << "] " << value << " != " << reference);
+				}
+				nbError++;
+			}
+		}
+	}
+	return nbError;
+}
+
+TEST(TestChannelOrder, interleaved) {
+	etk::Vector<MapCouple> listMap = getListMap();
+	// the sizes check the end of the SIMD kernels
+	static const size_t listSize[] = {1, 5, 8, 33, 1000};
+	for (size_t fff=0; fff<g_nbFormat; ++fff) {
+		for (size_t iii=0; iii<listMap.size(); ++iii) {
+			for (size_t jjj=0; jjj<sizeof(listSize)/sizeof(size_t); ++jjj) {
+				EXPECT_EQ(checkReorder(g_listFormat[fff], listMap[iii], audio::drain::layout_interleaved, audio::drain::layout_interleaved, listSize[jjj]), 0);
+			}
+		}
+	}
+}
+
+TEST(TestChannelOrder, planar) {
+	etk::Vector<MapCouple> listMap = getListMap();
+	// same map in the 2 layouts
+	listMap.pushBack(MapCouple(test::getMap(2), test::getMap(2)));
+	listMap.pushBack(MapCouple(test::getMap(6), test::getMap(6)));
+	for (size_t fff=0; fff<g_nbFormat; ++fff) {
+		for (size_t iii=0; iii<listMap.size(); ++iii) {
+			EXPECT_EQ(checkReorder(g_listFormat[fff], listMap[iii], audio::drain::layout_planar, audio::drain::layout_interleaved, 37), 0);
+			EXPECT_EQ(checkReorder(g_listFormat[fff], listMap[iii], audio::drain::layout_interleaved, audio::drain::layout_planar, 37), 0);
+			EXPECT_EQ(checkReorder(g_listFormat[fff], listMap[iii], audio::drain::layout_planar, audio::drain::layout_planar, 37), 0);
+		}
+	}
+}
+
+TEST(TestChannelOrder, sameMap) {
+	MapCouple map(test::getMap(2), test::getMap(2));
+	ememory::SharedPtr<audio::drain::ChannelReorder> algo = createReorder(audio::format_int16, map);
+	EXPECT_EQ(algo->isPassThrough(), true);
+}
+
+TEST(TestChannelOrder, simdMatchGeneric) {
+	etk::Vector<MapCouple> listMap = getListMap();
+	for (size_t fff=0; fff<g_nbFormat; ++fff) {
+		for (size_t iii=0; iii<listMap.size(); ++iii) {
+			size_t nbChunk = 1003;
+			etk::Vector<uint8_t> data;
+			test::fillRandom(data, g_listFormat[fff], nbChunk*listMap[iii].m_input.size(), 99);
+			// the kernels are selected at the configuration
+			audio::drain::cpu::setSimdEnable(false);
+			ememory::SharedPtr<audio::drain::ChannelReorder> algoGeneric = createReorder(g_listFormat[fff], listMap[iii]);
+			audio::drain::cpu::setSimdEnable(true);
+			ememory::SharedPtr<audio::drain::ChannelReorder> algoSimd = createReorder(g_listFormat[fff], listMap[iii]);
+			audio::Time time;
+			void* reference = null;
+			void* output = null;
+			size_t nbReference = 0;
+			size_t nbOutput = 0;
+			algoGeneric->process(time, &data[0], nbChunk, reference, nbReference);
+			algoSimd->process(time, &data[0], nbChunk, output, nbOutput);
+			ASSERT_EQ(nbOutput, nbReference);
+			EXPECT_EQ(memcmp(output, reference, nbOutput*algoSimd->getOutputFormat().getChunkSize()), 0);
+		}
+	}
+}
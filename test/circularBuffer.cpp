@@ -0,0 +1,139 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2015, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <test-debug/debug.hpp>
+#include <etest/etest.hpp>
+#include <audio/drain/CircularBuffer.hpp>
+#include "common.hpp"
+
+TEST(TestCircularBuffer, lockFreeTime) {
+	audio::drain::CircularBuffer buffer;
+	buffer.setLockFree(true);
+	buffer.setCapacity(2000, sizeof(int16_t), 48000);
+	etk::Vector<int16_t> input;
+	test::createRamp(input, 480);
+	audio::Time time = audio::Time() + audio::Duration(10, 0);
+	// the writer set the time line: the reader get the time of the data
+	EXPECT_EQ(buffer.write(&input[0], 480, time), 0);
+	EXPECT_EQ(buffer.getReadTimeStamp(), time);
+	EXPECT_EQ(buffer.getWriteTimeStamp(), time + audio::Duration(0, 10000000));
+	// gap of 1ms: filled with 0
+	EXPECT_EQ(buffer.write(&input[0], 480, time + audio::Duration(0, 11000000)), 0);
+	EXPECT_EQ(buffer.getSize(), 1008);
+	etk::Vector<int16_t> output;
+	output.resize(1008);
+	EXPECT_EQ(buffer.read(&output[0], 1008), 0);
+	EXPECT_EQ(output[480], 0);
+	EXPECT_EQ(output[527], 0);
+	EXPECT_EQ(output[528], input[0]);
+	// empty buffer: a new time line
+	audio::Time newTime = time + audio::Duration(10, 0);
+	EXPECT_EQ(buffer.write(&input[0], 480, newTime), 0);
+	EXPECT_EQ(buffer.getReadTimeStamp(), newTime);
+}
+
+TEST(TestCircularBuffer, lockFreeOverwrite) {
+	audio::drain::CircularBuffer buffer;
+	buffer.setLockFree(true);
+	buffer.setOverwrite(true);
+	buffer.setCapacity(1000, sizeof(int16_t), 48000);
+	etk::Vector<int16_t> input;
+	test::createRamp(input, 800);
+	EXPECT_EQ(buffer.write(&input[0], 800), 0);
+	// the writer move the read position: the 600 oldest chunks are dropped
+	EXPECT_EQ(buffer.write(&input[0], 800), 600);
+	EXPECT_EQ(buffer.getSize(), 1000);
+	etk::Vector<int16_t> output;
+	output.resize(1000);
+	EXPECT_EQ(buffer.read(&output[0], 1000), 0);
+	EXPECT_EQ(output[0], input[600]);
+	EXPECT_EQ(output[199], input[799]);
+	EXPECT_EQ(output[200], input[0]);
+	EXPECT_EQ(output[999], input[799]);
+	// without overwrite: the newest chunks are dropped
+	buffer.setOverwrite(false);
+	EXPECT_EQ(buffer.write(&input[0], 800), 0);
+	EXPECT_EQ(buffer.write(&input[0], 800), 600);
+	EXPECT_EQ(buffer.read(&output[0], 1000), 0);
+	EXPECT_EQ(output[0], input[0]);
+	EXPECT_EQ(output[999], input[199]);
+}
+
+TEST(TestCircularBuffer, writevTime) {
+	for (size_t iii=0; iii<2; ++iii) {
+		audio::drain::CircularBuffer buffer;
+		buffer.setLockFree(iii == 1);
+		buffer.setCapacity(2000, sizeof(int16_t), 48000);
+		etk::Vector<int16_t> input;
+		test::createRamp(input, 480);
+		// the period in 2 pieces
+		audio::drain::CircularBufferWriteSpan span[2];
+		span[0].m_data = &input[0];
+		span[0].m_nbChunk = 100;
+		span[1].m_data = &input[100];
+		span[1].m_nbChunk = 380;
+		audio::Time time = audio::Time() + audio::Duration(10, 0);
+		EXPECT_EQ(buffer.writev(span, 2, time), 0);
+		EXPECT_EQ(buffer.getReadTimeStamp(), time);
+		// gap of 1ms: filled with 0 (same time line as write)
+		EXPECT_EQ(buffer.writev(span, 2, time + audio::Duration(0, 11000000)), 0);
+		EXPECT_EQ(buffer.getSize(), 1008);
+		// overlap of 5ms: only the 240 last chunks are written
+		EXPECT_EQ(buffer.writev(span, 2, time + audio::Duration(0, 16000000)), 0);
+		EXPECT_EQ(buffer.getSize(), 1248);
+		EXPECT_EQ(buffer.getWriteTimeStamp(), time + audio::Duration(0, 26000000));
+		etk::Vector<int16_t> output;
+		output.resize(1248);
+		EXPECT_EQ(buffer.read(&output[0], 1248), 0);
+		EXPECT_EQ(output[479], input[479]);
+		EXPECT_EQ(output[480], 0);
+		EXPECT_EQ(output[527], 0);
+		EXPECT_EQ(output[528], input[0]);
+		EXPECT_EQ(output[1008], input[240]);
+		EXPECT_EQ(output[1247], input[479]);
+	}
+}
+
+TEST(TestCircularBuffer, mirror) {
+	for (size_t iii=0; iii<2; ++iii) {
+		audio::drain::CircularBuffer buffer;
+		buffer.setLockFree(true);
+		buffer.setMirror(iii == 1);
+		buffer.setCapacity(2000, sizeof(int16_t), 48000);
+		if (    iii == 1
+		     && buffer.getMirror() == false) {
+			TEST_INFO("No mirrored memory on this platform");
+			continue;
+		}
+		// the mirrored capacity is rounded up to the memory pages
+		EXPECT_GE(buffer.getCapacity(), 2000);
+		size_t capacity = buffer.getCapacity();
+		etk::Vector<int16_t> input;
+		test::createRamp(input, 1500);
+		etk::Vector<int16_t> output;
+		output.resize(1500);
+		EXPECT_EQ(buffer.write(&input[0], 1500), 0);
+		EXPECT_EQ(buffer.read(&output[0], 1500), 0);
+		// the next data wrap at the end of the memory
+		EXPECT_EQ(buffer.write(&input[0], 1000), 0);
+		const void* data = null;
+		size_t nbChunk = buffer.peekContiguous(data, 1000);
+		if (iii == 1) {
+			// the second view continue the first one: no wrap for the reader
+			ASSERT_EQ(nbChunk, 1000);
+		} else {
+			ASSERT_EQ(nbChunk, capacity-1500);
+		}
+		EXPECT_EQ(memcmp(data, &input[0], nbChunk*sizeof(int16_t)), 0);
+		buffer.commit(nbChunk);
+		EXPECT_EQ(buffer.getSize(), 1000-nbChunk);
+		// the end of the data is read at the start of the memory
+		if (nbChunk != 1000) {
+			EXPECT_EQ(buffer.read(&output[0], 1000-nbChunk), 0);
+			EXPECT_EQ(memcmp(&output[0], &input[nbChunk], (1000-nbChunk)*sizeof(int16_t)), 0);
+		}
+	}
+}
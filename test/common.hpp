@@ -0,0 +1,138 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2015, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/Vector.hpp>
+#include <etk/String.hpp>
+#include <ememory/memory.hpp>
+#include <audio/drain/Process.hpp>
+
+/**
+ * @brief Helpers shared by all the tests.
+ */
+namespace test {
+	/**
+	 * @brief Get a map of channels (1: center, 2: left/right, more: the 5.1 and 7.1 order).
+	 * @param[in] _nbChannel Number of channel (8 maximum).
+	 * @return The map.
+	 */
+	inline etk::Vector<audio::channel> getMap(int32_t _nbChannel) {
+		static const audio::channel listChannel[] = {
+			audio::channel_frontLeft,
+			audio::channel_frontRight,
+			audio::channel_frontCenter,
+			audio::channel_lfe,
+			audio::channel_rearLeft,
+			audio::channel_rearRight,
+			audio::channel_surroundLeft,
+			audio::channel_surroundRight
+		};
+		etk::Vector<audio::channel> out;
+		if (_nbChannel == 1) {
+			out.pushBack(audio::channel_frontCenter);
+			return out;
+		}
+		for (int32_t iii=0; iii<_nbChannel && iii<8; ++iii) {
+			out.pushBack(listChannel[iii]);
+		}
+		return out;
+	}
+	/**
+	 * @brief Create an algo and set its formats.
+	 * @param[in] _input Input format of the algo.
+	 * @param[in] _output Output format of the algo.
+	 * @return The configured algo.
+	 */
+	template<typename T> ememory::SharedPtr<T> createAlgo(const audio::drain::IOFormatInterface& _input,
+	                                                      const audio::drain::IOFormatInterface& _output) {
+		ememory::SharedPtr<T> algo = T::create();
+		algo->setFormat(_input, _output);
+		return algo;
+	}
+	/**
+	 * @brief Fill a buffer with a pseudo random signal a little bigger than the full scale (the saturation is checked too).
+	 * @param[out] _buffer Buffer to fill (resized).
+	 * @param[in] _format Format of the samples.
+	 * @param[in] _nbSample Number of sample.
+	 * @param[in] _seed Seed of the generator (same seed: same signal).
+	 * @param[in] _scale Amplitude of the signal (1.0: full scale, no saturation).
+	 */
+	inline void fillRandom(etk::Vector<uint8_t>& _buffer, enum audio::format _format, size_t _nbSample, uint32_t _seed, double _scale=1.25) {
+		_buffer.resize(_nbSample*audio::getFormatBytes(_format));
+		uint32_t random = _seed;
+		for (size_t iii=0; iii<_nbSample; ++iii) {
+			random = random * 1664525U + 1013904223U;
+			// in [-_scale.._scale[
+			double value = (double(random >> 8) / double(1<<24) - 0.5) * 2.0 * _scale;
+			switch (_format) {
+				case audio::format_int16:
+					reinterpret_cast<int16_t*>(&_buffer[0])[iii] = int16_t(etk::avg(-32768.0, value*32768.0, 32767.0));
+					break;
+				case audio::format_int16_on_int32:
+					// the headroom is used
+					reinterpret_cast<int32_t*>(&_buffer[0])[iii] = int32_t(value*32768.0);
+					break;
+				case audio::format_int32:
+					// full range of the int32_t
+					reinterpret_cast<int32_t*>(&_buffer[0])[iii] = int32_t(random);
+					break;
+				case audio::format_float:
+					reinterpret_cast<float*>(&_buffer[0])[iii] = float(value);
+					break;
+				default:
+					break;
+			}
+		}
+	}
+	/**
+	 * @brief Get a sample of a buffer (raw value, not normalized).
+	 * @param[in] _format Format of the samples.
+	 * @param[in] _data Buffer.
+	 * @param[in] _id Id of the sample.
+	 * @return Value of the sample.
+	 */
+	inline double getValue(enum audio::format _format, const void* _data, size_t _id) {
+		switch (_format) {
+			case audio::format_int16:
+				return static_cast<const int16_t*>(_data)[_id];
+			case audio::format_int16_on_int32:
+			case audio::format_int32:
+				return static_cast<const int32_t*>(_data)[_id];
+			case audio::format_float:
+				return static_cast<const float*>(_data)[_id];
+			default:
+				break;
+		}
+		return 0.0;
+	}
+	/**
+	 * @brief Create a ramp in int16_t (different on each sample, no saturation).
+	 * @param[out] _buffer Buffer to fill (resized).
+	 * @param[in] _nbSample Number of sample.
+	 */
+	inline void createRamp(etk::Vector<int16_t>& _buffer, size_t _nbSample) {
+		_buffer.resize(_nbSample);
+		for (size_t iii=0; iii<_nbSample; ++iii) {
+			_buffer[iii] = int16_t(iii*7 - 16000);
+		}
+	}
+	/**
+	 * @brief Get the list of the type of the algos of the chain ("Algo1 Algo2 ...").
+	 * @param[in] _process Chain.
+	 * @return List of the types.
+	 */
+	inline etk::String getChain(audio::drain::Process& _process) {
+		etk::String out;
+		for (size_t iii=0; iii<_process.size(); ++iii) {
+			if (iii != 0) {
+				out += " ";
+			}
+			out += _process[iii]->getType();
+		}
+		return out;
+	}
+}
+
@@ -1,5 +1,5 @@
 /** @file
- * @author Edouard DUPIN 
+ * @author Edouard DUPIN
  * @copyright 2015, Edouard DUPIN, all right reserved
  * @license MPL v2.0 (see license file)
  */
@@ -7,6 +7,154 @@
 #include <test-debug/debug.hpp>
 #include <etest/etest.hpp>
 #include <audio/drain/Process.hpp>
+#include <audio/drain/BiquadCascade.hpp>
+#include <audio/drain/cpu.hpp>
+#include "common.hpp"
+extern "C" {
+	#include <math.h>
+}
 
+/**
+ * @brief Create the bank of the tests: a different filter on each stage and channel (the odd channels have one stage less).
+ */
+static void createBank(audio::drain::BiquadBank& _bank, size_t _nbChannel, size_t _nbStage) {
+	_bank.init(_nbChannel, _nbStage);
+	for (size_t iii=0; iii<_nbChannel; ++iii) {
+		for (size_t jjj=0; jjj<_nbStage - (iii%2); ++jjj) {
+			audio::drain::Biquad biquad;
+			biquad.setBiquad(static_cast<enum audio::algo::drain::biQuadType>(1 + (iii+jjj)%7),
+			                 200.0 + 700.0*jjj + 37.0*iii,
+			                 0.7 + 0.1*jjj,
+			                 (jjj%2 == 1 ? -6.0 : 4.0),
+			                 48000);
+			_bank.setBiquad(jjj, iii, biquad);
+		}
+	}
+}
+
+static void createSignal(etk::Vector<float>& _buffer, size_t _nbChannel, size_t _nbFrame) {
+	_buffer.resize(_nbChannel*_nbFrame);
+	for (size_t iii=0; iii<_buffer.size(); ++iii) {
+		_buffer[iii] = 0.5f * sinf(0.01f*float(iii)*float(1 + iii%_nbChannel)) + float((iii*7919)%1000)/4000.0f;
+	}
+}
+
+/**
+ * @brief Scalar reference of a cascade: direct form I in double on each channel.
+ */
+static void referenceCascade(const audio::drain::BiquadBank& _bank, etk::Vector<float>& _data, size_t _nbFrame) {
+	size_t nbChannel = _bank.getNbChannel();
+	for (size_t iii=0; iii<nbChannel; ++iii) {
+		etk::Vector<double> value;
+		value.resize(_nbFrame);
+		for (size_t kkk=0; kkk<_nbFrame; ++kkk) {
+			value[kkk] = _data[kkk*nbChannel + iii];
+		}
+		for (size_t jjj=0; jjj<_bank.getNbStage(); ++jjj) {
+			const audio::drain::Biquad& biquad = _bank.getBiquad(jjj, iii);
+			double x1 = 0.0;
+			double x2 = 0.0;
+			double y1 = 0.0;
+			double y2 = 0.0;
+			for (size_t kkk=0; kkk<_nbFrame; ++kkk) {
+				double y =   biquad.m_a[0]*value[kkk] + biquad.m_a[1]*x1 + biquad.m_a[2]*x2
+				           - biquad.m_b[0]*y1 - biquad.m_b[1]*y2;
+				x2 = x1;
+				x1 = value[kkk];
+				y2 = y1;
+				y1 = y;
+				value[kkk] = y;
+			}
+		}
+		for (size_t kkk=0; kkk<_nbFrame; ++kkk) {
+			_data[kkk*nbChannel + iii] = float(value[kkk]);
+		}
+	}
+}
+
+static double getMaxError(const etk::Vector<float>& _value, const etk::Vector<float>& _reference) {
+	double out = 0.0;
+	for (size_t iii=0; iii<_value.size(); ++iii) {
+		out = etk::max(out, double(fabs(_value[iii] - _reference[iii])));
+	}
+	return out;
+}
+
+TEST(TestEqualizer, passThrough) {
+	audio::drain::BiquadBank bank;
+	bank.init(2, 3);
+	audio::drain::BiquadCascade cascade;
+	cascade.init(2);
+	etk::Vector<float> reference;
+	createSignal(reference, 2, 500);
+	etk::Vector<float> data = reference;
+	cascade.process(bank, &data[0], 500);
+	EXPECT_EQ(getMaxError(data, reference), 0.0);
+}
+
+TEST(TestEqualizer, cascadeMatchReference) {
+	// all the lane width of the kernels and the remainder
+	static const size_t listNbChannel[] = {1, 2, 3, 4, 5, 6, 7, 8, 11};
+	for (size_t simd=0; simd<2; ++simd) {
+		// the kernels are selected at the configuration
+		audio::drain::cpu::setSimdEnable(simd == 1);
+		for (size_t iii=0; iii<sizeof(listNbChannel)/sizeof(size_t); ++iii) {
+			size_t nbChannel = listNbChannel[iii];
+			size_t nbFrame = 1000;
+			audio::drain::BiquadBank bank;
+			createBank(bank, nbChannel, 5);
+			etk::Vector<float> reference;
+			createSignal(reference, nbChannel, nbFrame);
+			etk::Vector<float> data = reference;
+			referenceCascade(bank, reference, nbFrame);
+			audio::drain::BiquadCascade cascade;
+			cascade.init(nbChannel);
+			// 3 calls: the filter memory is kept between the periods
+			cascade.process(bank, &data[0], 100);
+			cascade.process(bank, &data[100*nbChannel], 450);
+			cascade.process(bank, &data[550*nbChannel], 450);
+			double error = getMaxError(data, reference);
+			TEST_INFO("simd=" << simd << " nbChannel=" << nbChannel << " error=" << error);
+			// float accumulation on 5 stages
+			EXPECT_LT(error, 0.0005);
+		}
+	}
+	audio::drain::cpu::setSimdEnable(true);
+}
 
+TEST(TestEqualizer, simdMatchGeneric) {
+	for (size_t nbChannel=1; nbChannel<=8; ++nbChannel) {
+		size_t nbFrame = 2048;
+		audio::drain::BiquadBank bank;
+		createBank(bank, nbChannel, 4);
+		etk::Vector<float> reference;
+		createSignal(reference, nbChannel, nbFrame);
+		etk::Vector<float> data = reference;
+		audio::drain::cpu::setSimdEnable(false);
+		audio::drain::BiquadCascade cascadeGeneric;
+		cascadeGeneric.init(nbChannel);
+		audio::drain::cpu::setSimdEnable(true);
+		audio::drain::BiquadCascade cascadeSimd;
+		cascadeSimd.init(nbChannel);
+		cascadeGeneric.process(bank, &reference[0], nbFrame);
+		cascadeSimd.process(bank, &data[0], nbFrame);
+		// same operations in the same order (only the contraction of the multiply-add can change)
+		EXPECT_LT(getMaxError(data, reference), 0.00001);
+	}
+}
 
+TEST(TestEqualizer, response) {
+	// transition of a low shelf of +6dB: the DC gain reach 2x (+6dB) in steady state
+	audio::drain::BiquadBank bank;
+	bank.init(1, 1);
+	audio::drain::Biquad biquad;
+	biquad.setBiquad(audio::algo::drain::biQuadType_lowShelf, 500, 0.707, 6, 48000);
+	bank.setBiquad(0, 0, biquad);
+	EXPECT_FLOAT_EQ_DELTA(biquad.getResponse(10, 48000), 6.0f, 0.1f);
+	EXPECT_FLOAT_EQ_DELTA(biquad.getResponse(15000, 48000), 0.0f, 0.1f);
+	audio::drain::BiquadCascade cascade;
+	cascade.init(1);
+	etk::Vector<float> data(4800, 0.25f);
+	cascade.process(bank, &data[0], 4800);
+	EXPECT_FLOAT_EQ_DELTA(data[4799], 0.25f*powf(10.0f, 6.0f/20.0f), 0.001f);
+}
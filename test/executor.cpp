@@ -0,0 +1,105 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2015, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <test-debug/debug.hpp>
+#include <etest/etest.hpp>
+#include <audio/drain/Executor.hpp>
+#include <audio/drain/ProcessGroup.hpp>
+#include <echrono/Steady.hpp>
+#include "common.hpp"
+
+TEST(TestExecutor, allTaskOnce) {
+	audio::drain::Executor executor;
+	for (size_t nbWorker=0; nbWorker<4; ++nbWorker) {
+		executor.start(nbWorker);
+		EXPECT_EQ(executor.getNbWorker(), nbWorker);
+		for (size_t nbTask=1; nbTask<40; nbTask+=7) {
+			// each task write only its own result
+			etk::Vector<uint32_t> count;
+			count.resize(nbTask, 0);
+			EXPECT_EQ(executor.execute(nbTask, [&](size_t _taskId) {
+			                                   	count[_taskId]++;
+			                                   }), true);
+			for (size_t iii=0; iii<nbTask; ++iii) {
+				EXPECT_EQ(count[iii], 1);
+			}
+		}
+	}
+	executor.stop();
+	EXPECT_EQ(executor.getNbWorker(), 0);
+}
+
+TEST(TestExecutor, deadlineMiss) {
+	audio::drain::Executor executor;
+	executor.start(1);
+	executor.setDeadline(echrono::milliseconds(1));
+	EXPECT_EQ(executor.execute(2, [&](size_t _taskId) {
+	                                  	(void)_taskId;
+	                                  }), true);
+	EXPECT_EQ(executor.getNbDeadlineMiss(), 0);
+	EXPECT_EQ(executor.execute(2, [&](size_t _taskId) {
+	                                  	(void)_taskId;
+	                                  	// busy task of 5ms
+	                                  	echrono::Steady start = echrono::Steady::now();
+	                                  	while (echrono::Steady::now() - start < echrono::milliseconds(5)) {
+	                                  		
+	                                  	}
+	                                  }), false);
+	// only counted by the execution: the control side report it
+	EXPECT_EQ(executor.getNbDeadlineMiss(), 1);
+	audio::drain::ProcessMetricSnapshot metric;
+	executor.getMetric(metric);
+	EXPECT_EQ(metric.m_nbPeriod, 2);
+	EXPECT_EQ(metric.m_deadlineLast, 1000000);
+	EXPECT_GE(metric.m_timeMax, 5000000);
+	EXPECT_EQ(executor.reportDeadlineMiss(), 1);
+	EXPECT_EQ(executor.reportDeadlineMiss(), 0);
+}
+
+static ememory::SharedPtr<audio::drain::Process> createProcess() {
+	ememory::SharedPtr<audio::drain::Process> process(ETK_NEW(audio::drain::Process));
+	process->setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	process->setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+	process->updateInterAlgo();
+	return process;
+}
+
+TEST(TestExecutor, processGroup) {
+	size_t nbChunk = 480;
+	size_t nbProcess = 16;
+	etk::Vector<int16_t> input;
+	test::createRamp(input, nbChunk);
+	etk::Vector<float> reference;
+	audio::drain::Executor executor;
+	executor.start(3);
+	for (size_t iii=0; iii<2; ++iii) {
+		// same result in the caller thread and on the workers
+		audio::drain::ProcessGroup group;
+		for (size_t jjj=0; jjj<nbProcess; ++jjj) {
+			group.add(createProcess());
+		}
+		if (iii == 1) {
+			group.setDispatchFunction(executor.getDispatchFunction());
+		}
+		etk::Vector<void*> inData;
+		for (size_t jjj=0; jjj<nbProcess; ++jjj) {
+			inData.pushBack(&input[0]);
+		}
+		etk::Vector<void*> outData;
+		etk::Vector<size_t> outNbChunk;
+		audio::Time time;
+		EXPECT_EQ(group.process(time, inData, nbChunk, outData, outNbChunk), true);
+		ASSERT_EQ(outNbChunk.size(), nbProcess);
+		if (iii == 0) {
+			reference.resize(nbChunk*2);
+			memcpy(&reference[0], outData[0], nbChunk*2*sizeof(float));
+		}
+		for (size_t jjj=0; jjj<nbProcess; ++jjj) {
+			ASSERT_EQ(outNbChunk[jjj], nbChunk);
+			EXPECT_EQ(memcmp(outData[jjj], &reference[0], nbChunk*2*sizeof(float)), 0);
+		}
+	}
+}
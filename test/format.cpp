@@ -1,5 +1,5 @@
 /** @file
- * @author Edouard DUPIN 
+ * @author Edouard DUPIN
  * @copyright 2015, Edouard DUPIN, all right reserved
  * @license MPL v2.0 (see license file)
  */
@@ -7,4 +7,235 @@
 #include <test-debug/debug.hpp>
 #include <etest/etest.hpp>
 #include <audio/drain/Process.hpp>
+#include <audio/drain/FormatUpdate.hpp>
+#include "common.hpp"
+extern "C" {
+	#include <math.h>
+}
 
+static const enum audio::format g_listFormat[] = {
+	audio::format_int16,
+	audio::format_int16_on_int32,
+	audio::format_int32,
+	audio::format_float
+};
+static const size_t g_nbFormat = sizeof(g_listFormat)/sizeof(enum audio::format);
+
+/**
+ * @brief Scalar reference of a conversion (computed in double).
+ * @return Value of the output sample.
+ */
+static double referenceConvert(enum audio::format _input, const void* _data, size_t _id, enum audio::format _output) {
+	double value = 0.0;
+	switch (_input) {
+		case audio::format_int16:
+			value = static_cast<const int16_t*>(_data)[_id];
+			break;
+		case audio::format_int16_on_int32:
+		case audio::format_int32:
+			value = static_cast<const int32_t*>(_data)[_id];
+			break;
+		case audio::format_float:
+			value = static_cast<const float*>(_data)[_id];
+			break;
+		default:
+			break;
+	}
+	if (_input == audio::format_int16_on_int32) {
+		// the value out of the int16_t range saturate when the format change
+		if (_output != audio::format_float) {
+			value = etk::avg(-32768.0, value, 32767.0);
+		}
+	}
+	switch (_output) {
+		case audio::format_int16:
+			if (_input == audio::format_float) {
+				return trunc(etk::avg(-32768.0, value*32768.0, 32767.0));
+			}
+			if (_input == audio::format_int32) {
+				return floor(value/65536.0);
+			}
+			return value;
+		case audio::format_int16_on_int32:
+			if (_input == audio::format_float) {
+				return trunc(value*32768.0);
+			}
+			if (_input == audio::format_int32) {
+				return floor(value/65536.0);
+			}
+			return value;
+		case audio::format_int32:
+			if (_input == audio::format_float) {
+				return trunc(etk::avg(-2147483648.0, value*2147483647.0, 2147483520.0));
+			}
+			return value*65536.0;
+		case audio::format_float:
+			if (_input == audio::format_int32) {
+				return value/2147483647.0;
+			}
+			return value/32768.0;
+		default:
+			break;
+	}
+	return 0.0;
+}
+
+static ememory::SharedPtr<audio::drain::FormatUpdate> createConverter(enum audio::format _input, enum audio::format _output, int32_t _nbChannel) {
+	return test::createAlgo<audio::drain::FormatUpdate>(audio::drain::IOFormatInterface(test::getMap(_nbChannel), _input, 48000),
+	                                                    audio::drain::IOFormatInterface(test::getMap(_nbChannel), _output, 48000));
+}
+
+TEST(TestFormat, convertAllPairs) {
+	// the sizes check the end of the SIMD kernels
+	static const size_t listSize[] = {1, 3, 7, 8, 17, 64, 1001};
+	for (size_t iii=0; iii<g_nbFormat; ++iii) {
+		for (size_t jjj=0; jjj<g_nbFormat; ++jjj) {
+			if (iii == jjj) {
+				continue;
+			}
+			enum audio::format input = g_listFormat[iii];
+			enum audio::format output = g_listFormat[jjj];
+			// the intermediate float of the kernels can be 1 LSB away from the double reference
+			double delta = output == audio::format_float ? 0.000001 : 1.0;
+			if (    input == audio::format_float
+			     && output == audio::format_int32) {
+				// 24 bits of mantissa
+				delta = 256.0;
+			}
+			for (size_t kkk=0; kkk<sizeof(listSize)/sizeof(size_t); ++kkk) {
+				ememory::SharedPtr<audio::drain::FormatUpdate> algo = createConverter(input, output, 2);
+				etk::Vector<uint8_t> data;
+				test::fillRandom(data, input, listSize[kkk]*2, 42+kkk);
+				audio::Time time;
+				void* outputData = null;
+				size_t outputNbChunk = 0;
+				EXPECT_EQ(algo->process(time, &data[0], listSize[kkk], outputData, outputNbChunk), true);
+				ASSERT_EQ(outputNbChunk, listSize[kkk]);
+				size_t nbError = 0;
+				for (size_t sss=0; sss<outputNbChunk*2; ++sss) {
+					double reference = referenceConvert(input, &data[0], sss, output);
+					if (fabs(test::getValue(output, outputData, sss) - reference) > delta) {
+						if (nbError == 0) {
+							TEST_ERROR(input << " -> " << output << " [" << sss << "] " << test::getValue(output, outputData, sss) << " != " << reference);
+						}
+						nbError++;
+					}
+				}
+				EXPECT_EQ(nbError, 0);
+			}
+		}
+	}
+}
+
+TEST(TestFormat, sameFormat) {
+	for (size_t iii=0; iii<g_nbFormat; ++iii) {
+		ememory::SharedPtr<audio::drain::FormatUpdate> algo = createConverter(g_listFormat[iii], g_listFormat[iii], 2);
+		EXPECT_EQ(algo->isPassThrough(), true);
+		etk::Vector<uint8_t> data;
+		test::fillRandom(data, g_listFormat[iii], 64, 12);
+		audio::Time time;
+		void* outputData = null;
+		size_t outputNbChunk = 0;
+		EXPECT_EQ(algo->process(time, &data[0], 32, outputData, outputNbChunk), true);
+		EXPECT_EQ(outputData, static_cast<void*>(&data[0]));
+		EXPECT_EQ(outputNbChunk, 32);
+	}
+}
+
+/**
+ * @brief Convert a low level sinus in int16_t and get the quantization error.
+ */
+static void getQuantizationError(enum audio::format _input, enum audio::drain::dither _dither, etk::Vector<double>& _error) {
+	ememory::SharedPtr<audio::drain::FormatUpdate> algo = createConverter(_input, audio::format_int16, 1);
+	algo->setDither(_dither);
+	EXPECT_EQ(algo->needDither(), _dither != audio::drain::dither_none);
+	size_t nbSample = 48000;
+	etk::Vector<float> reference;
+	etk::Vector<uint8_t> data;
+	reference.resize(nbSample);
+	data.resize(nbSample*audio::getFormatBytes(_input));
+	for (size_t iii=0; iii<nbSample; ++iii) {
+		// ~3 LSB of amplitude: the truncation error is correlated with the signal
+		reference[iii] = 3.3f * sin(float(iii) * 0.01f);
+		if (_input == audio::format_float) {
+			reinterpret_cast<float*>(&data[0])[iii] = reference[iii] / 32768.0f;
+		} else {
+			reinterpret_cast<int32_t*>(&data[0])[iii] = int32_t(reference[iii] * 65536.0f);
+			reference[iii] = float(reinterpret_cast<int32_t*>(&data[0])[iii]) / 65536.0f;
+		}
+	}
+	_error.clear();
+	for (size_t iii=0; iii<nbSample; iii+=480) {
+		audio::Time time;
+		void* outputData = null;
+		size_t outputNbChunk = 0;
+		algo->process(time, &data[iii*audio::getFormatBytes(_input)], 480, outputData, outputNbChunk);
+		for (size_t jjj=0; jjj<outputNbChunk; ++jjj) {
+			_error.pushBack(double(static_cast<int16_t*>(outputData)[jjj]) - double(reference[iii+jjj]));
+		}
+	}
+}
+
+static double getMean(const etk::Vector<double>& _value) {
+	double out = 0.0;
+	for (size_t iii=0; iii<_value.size(); ++iii) {
+		out += _value[iii];
+	}
+	return out / double(etk::max(_value.size(), size_t(1)));
+}
+
+/**
+ * @brief Get the power of the low frequencies of a signal (sum of 32 samples).
+ */
+static double getLowFrequencyPower(const etk::Vector<double>& _value) {
+	double out = 0.0;
+	size_t nbBlock = 0;
+	for (size_t iii=0; iii+32<=_value.size(); iii+=32) {
+		double sum = 0.0;
+		for (size_t jjj=0; jjj<32; ++jjj) {
+			sum += _value[iii+jjj];
+		}
+		out += sum*sum;
+		nbBlock++;
+	}
+	return out / double(etk::max(nbBlock, size_t(1)));
+}
+
+TEST(TestFormat, ditherTpdf) {
+	for (size_t iii=0; iii<2; ++iii) {
+		enum audio::format input = iii == 0 ? audio::format_float : audio::format_int32;
+		etk::Vector<double> error;
+		getQuantizationError(input, audio::drain::dither_tpdf, error);
+		ASSERT_NE(error.size(), 0);
+		// rounding + triangular noise: no bias, never more than 1.5 LSB
+		EXPECT_FLOAT_EQ_DELTA(getMean(error), 0.0, 0.02);
+		double maxError = 0.0;
+		for (size_t jjj=0; jjj<error.size(); ++jjj) {
+			maxError = etk::max(maxError, fabs(error[jjj]));
+		}
+		EXPECT_LE(maxError, 1.5);
+		// the error of the noise is bigger than the half LSB of the rounding (variance 1/12 + 1/6)
+		double variance = 0.0;
+		for (size_t jjj=0; jjj<error.size(); ++jjj) {
+			variance += error[jjj]*error[jjj];
+		}
+		variance /= double(error.size());
+		EXPECT_FLOAT_EQ_DELTA(variance, 0.25, 0.03);
+	}
+}
+
+TEST(TestFormat, ditherShaped) {
+	for (size_t iii=0; iii<2; ++iii) {
+		enum audio::format input = iii == 0 ? audio::format_float : audio::format_int32;
+		etk::Vector<double> errorNone;
+		etk::Vector<double> errorTpdf;
+		etk::Vector<double> errorShaped;
+		getQuantizationError(input, audio::drain::dither_none, errorNone);
+		getQuantizationError(input, audio::drain::dither_tpdf, errorTpdf);
+		getQuantizationError(input, audio::drain::dither_shaped, errorShaped);
+		EXPECT_FLOAT_EQ_DELTA(getMean(errorShaped), 0.0, 0.02);
+		// the noise is moved in the high frequencies
+		EXPECT_LT(getLowFrequencyPower(errorShaped), getLowFrequencyPower(errorTpdf) * 0.5);
+		EXPECT_LT(getLowFrequencyPower(errorTpdf), getLowFrequencyPower(errorNone));
+	}
+}
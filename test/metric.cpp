@@ -0,0 +1,67 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2015, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <test-debug/debug.hpp>
+#include <etest/etest.hpp>
+#include <audio/drain/Metric.hpp>
+#include "common.hpp"
+
+TEST(TestMetric, endPointFillHistogram) {
+	audio::drain::EndPointMetric metric;
+	// bucket i: fill in [i/8, (i+1)/8[ of the capacity, full in the last one
+	metric.addFill(0, 800);
+	metric.addFill(99, 800);
+	metric.addFill(100, 800);
+	metric.addFill(450, 800);
+	metric.addFill(800, 800);
+	// no capacity: only counted as a process call
+	metric.addFill(10, 0);
+	metric.addUnderflow(20);
+	metric.addUnderflow(30);
+	metric.addOverflow(5);
+	metric.setDrift(0.999);
+	audio::drain::EndPointMetricSnapshot snapshot;
+	metric.getSnapshot(snapshot);
+	EXPECT_EQ(snapshot.m_nbProcess, 6);
+	EXPECT_EQ(snapshot.m_fillHistogram[0], 2);
+	EXPECT_EQ(snapshot.m_fillHistogram[1], 1);
+	EXPECT_EQ(snapshot.m_fillHistogram[4], 1);
+	EXPECT_EQ(snapshot.m_fillHistogram[7], 1);
+	EXPECT_EQ(snapshot.m_fillLevel, 10);
+	EXPECT_EQ(snapshot.m_fillCapacity, 0);
+	EXPECT_EQ(snapshot.m_nbUnderflow, 2);
+	EXPECT_EQ(snapshot.m_underflowChunk, 50);
+	EXPECT_EQ(snapshot.m_nbOverflow, 1);
+	EXPECT_EQ(snapshot.m_overflowChunk, 5);
+	EXPECT_EQ(snapshot.m_driftPpm, -1000);
+	metric.reset();
+	metric.getSnapshot(snapshot);
+	EXPECT_EQ(snapshot.m_nbProcess, 0);
+	EXPECT_EQ(snapshot.m_nbUnderflow, 0);
+	EXPECT_EQ(snapshot.m_fillHistogram[0], 0);
+}
+
+TEST(TestMetric, processLoad) {
+	audio::drain::ProcessMetric metric;
+	// 10ms of data: 2ms, 4ms, then 12ms (late)
+	metric.addPeriod(2000000, 10000000);
+	metric.addPeriod(4000000, 10000000);
+	metric.addPeriod(12000000, 10000000);
+	// unknow duration: never late
+	metric.addPeriod(1000000, 0);
+	audio::drain::ProcessMetricSnapshot snapshot;
+	metric.getSnapshot(snapshot);
+	EXPECT_EQ(snapshot.m_nbPeriod, 4);
+	EXPECT_EQ(snapshot.m_nbDeadlineMiss, 1);
+	EXPECT_EQ(snapshot.m_timeMax, 12000000);
+	EXPECT_EQ(snapshot.m_timeLast, 1000000);
+	EXPECT_FLOAT_EQ_DELTA(snapshot.getLoad(), 19.0f/30.0f, 0.0001f);
+	EXPECT_FLOAT_EQ_DELTA(snapshot.getLoadLast(), 0.0f, 0.0001f);
+	metric.reset();
+	metric.getSnapshot(snapshot);
+	EXPECT_EQ(snapshot.m_nbPeriod, 0);
+	EXPECT_FLOAT_EQ_DELTA(snapshot.getLoad(), 0.0f, 0.0001f);
+}
@@ -0,0 +1,71 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2015, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <test-debug/debug.hpp>
+#include <etest/etest.hpp>
+#include <audio/drain/Mixer.hpp>
+#include <audio/drain/EndPointCallback.hpp>
+#include "common.hpp"
+
+/**
+ * @brief Create an input of the mixer: the callback generate a ramp on its first call and the silence after.
+ */
+static ememory::SharedPtr<audio::drain::Process> createInput() {
+	ememory::SharedPtr<audio::drain::Process> process(ETK_NEW(audio::drain::Process));
+	size_t nbCall = 0;
+	ememory::SharedPtr<audio::drain::EndPointCallback> algo = audio::drain::EndPointCallback::create(
+	    [nbCall](void* _data, const audio::Time& _playTime, size_t _nbChunk, enum audio::format _format, uint32_t _frequency, const etk::Vector<audio::channel>& _map) mutable {
+	    	int16_t* data = static_cast<int16_t*>(_data);
+	    	for (size_t iii=0; iii<_nbChunk; ++iii) {
+	    		data[iii] = 0;
+	    		if (nbCall == 0) {
+	    			data[iii] = int16_t(iii*7 + 100);
+	    		}
+	    	}
+	    	nbCall++;
+	    });
+	algo->setInputFormat(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	algo->setOutputFormat(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	process->setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	process->setOutputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	process->pushBack(algo);
+	process->setSilenceDetection(true);
+	return process;
+}
+
+TEST(TestMixer, pullResidual) {
+	// mix in one block and in blocks smaller than the period
+	static const size_t listProcessBufferSize[] = {4096, 64};
+	for (size_t jjj=0; jjj<sizeof(listProcessBufferSize)/sizeof(size_t); ++jjj) {
+		audio::drain::Process process;
+		process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+		process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+		process.setProcessBufferSize(listProcessBufferSize[jjj]);
+		ememory::SharedPtr<audio::drain::Mixer> mixer = audio::drain::Mixer::create();
+		process.pushBack(mixer);
+		process.updateInterAlgo();
+		mixer->addInput(createInput());
+		EXPECT_EQ(mixer->getNbInput(), 1);
+		etk::Vector<int16_t> input(100, 0);
+		audio::Time time;
+		// the input compute 128 chunks at least: 28 are kept for the next period
+		for (size_t iii=0; iii<2; ++iii) {
+			void* output = null;
+			size_t outputNbChunk = 0;
+			EXPECT_EQ(process.process(time, &input[0], 100, output, outputNbChunk), true);
+			ASSERT_EQ(outputNbChunk, 100);
+			const int16_t* data = static_cast<const int16_t*>(output);
+			for (size_t kkk=0; kkk<100; ++kkk) {
+				size_t id = iii*100 + kkk;
+				int16_t reference = 0;
+				if (id < 128) {
+					reference = int16_t(id*7 + 100);
+				}
+				EXPECT_EQ(data[kkk], reference);
+			}
+		}
+	}
+}
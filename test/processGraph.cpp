@@ -0,0 +1,82 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2015, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <test-debug/debug.hpp>
+#include <etest/etest.hpp>
+#include <audio/drain/ProcessGraph.hpp>
+#include <audio/drain/Equalizer.hpp>
+#include "common.hpp"
+
+static ememory::SharedPtr<audio::drain::Process> createProcess() {
+	ememory::SharedPtr<audio::drain::Process> process(ETK_NEW(audio::drain::Process));
+	process->setInputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+	process->setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+	return process;
+}
+
+TEST(TestProcessGraph, fanOutEqualizer) {
+	size_t nbChunk = 480;
+	etk::Vector<uint8_t> input;
+	test::fillRandom(input, audio::format_float, nbChunk*2, 42, 0.5);
+	etk::Vector<uint8_t> reference = input;
+	audio::drain::ProcessGraph graph;
+	// pass-through: the output of the root is the buffer of the user
+	int32_t root = graph.addNode(createProcess());
+	ememory::SharedPtr<audio::drain::Process> equalizerProcess = createProcess();
+	ememory::SharedPtr<audio::drain::Equalizer> equalizer = audio::drain::Equalizer::create();
+	equalizerProcess->pushBack(equalizer);
+	// the equalizer first: writing in the shared buffer is seen by the next branch
+	int32_t filtered = graph.addNode(equalizerProcess, root);
+	int32_t direct = graph.addNode(createProcess(), root);
+	ASSERT_NE(filtered, -1);
+	ASSERT_NE(direct, -1);
+	graph.updateInterAlgo();
+	EXPECT_EQ(equalizer->setParameter("band", "{id:0, type:'peak', cut-frequency:1000, quality:2, gain:6}"), true);
+	audio::Time time;
+	EXPECT_EQ(graph.process(time, &input[0], nbChunk), true);
+	ASSERT_EQ(graph.getOutputNbChunk(filtered), nbChunk);
+	ASSERT_EQ(graph.getOutputNbChunk(direct), nbChunk);
+	size_t size = nbChunk*2*sizeof(float);
+	// nothing is written in the buffer of the user nor in the one of the other branch
+	EXPECT_EQ(memcmp(&input[0], &reference[0], size), 0);
+	EXPECT_EQ(memcmp(graph.getOutputData(direct), &reference[0], size), 0);
+	// the equalizer is really applied
+	EXPECT_NE(graph.getOutputData(filtered), &input[0]);
+	EXPECT_NE(memcmp(graph.getOutputData(filtered), &reference[0], size), 0);
+}
+
+TEST(TestProcessGraph, parentReconfigured) {
+	size_t nbChunk = 480;
+	etk::Vector<int16_t> input;
+	test::createRamp(input, nbChunk*2);
+	audio::drain::ProcessGraph graph;
+	ememory::SharedPtr<audio::drain::Process> root = createProcess();
+	root->setInputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_int16, 48000));
+	int32_t rootId = graph.addNode(root);
+	int32_t child = graph.addNode(createProcess(), rootId);
+	graph.updateInterAlgo();
+	audio::Time time;
+	EXPECT_EQ(graph.process(time, &input[0], nbChunk), true);
+	EXPECT_EQ(test::getChain(*graph[child]), "");
+	// the common part of the graph change its output (stereo then mono): the branch convert it
+	for (size_t iii=0; iii<2; ++iii) {
+		root->setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2-iii), audio::format_int16, 48000));
+		if (iii == 0) {
+			graph.updateInterAlgo();
+		}
+		// else: negotiated by the process
+		EXPECT_EQ(graph.process(time, &input[0], nbChunk), true);
+		EXPECT_EQ(graph[child]->getInputConfig(), root->getOutputConfig());
+		ASSERT_EQ(graph.getOutputNbChunk(child), nbChunk);
+		const float* output = static_cast<const float*>(graph.getOutputData(child));
+		// left of the frame 5 (mono: average of the 2 channels copied in the 2 channels)
+		float expected = float(input[10]);
+		if (iii == 1) {
+			expected = 0.5f * float(input[10] + input[11]);
+		}
+		EXPECT_FLOAT_EQ_DELTA(output[10], expected/32768.0f, 0.0001f);
+	}
+}
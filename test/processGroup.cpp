@@ -0,0 +1,65 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2015, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <test-debug/debug.hpp>
+#include <etest/etest.hpp>
+#include <audio/drain/ProcessGroup.hpp>
+#include <audio/drain/Volume.hpp>
+#include "common.hpp"
+
+static ememory::SharedPtr<audio::drain::Process> createProcess() {
+	ememory::SharedPtr<audio::drain::Process> process(ETK_NEW(audio::drain::Process));
+	process->setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	process->setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+	process->updateInterAlgo();
+	return process;
+}
+
+TEST(TestProcessGroup, hotPushBack) {
+	size_t nbChunk = 480;
+	etk::Vector<int16_t> input;
+	test::createRamp(input, nbChunk*20);
+	audio::drain::ProcessGroup group;
+	group.add(createProcess());
+	group.add(createProcess());
+	etk::String chain = test::getChain(*group[0]);
+	audio::drain::AlgoHandle<audio::drain::Volume> handle;
+	audio::Time time;
+	for (size_t iii=0; iii<20; ++iii) {
+		if (iii == 5) {
+			// a volume of 0dB does not change the data: the 2 chains give the same output
+			handle = group[1]->hotPushBack(audio::drain::Volume::create());
+			EXPECT_EQ(handle.isValid(), true);
+		} else if (iii == 15) {
+			EXPECT_EQ(group[1]->hotRemove(handle), true);
+		}
+		etk::Vector<void*> inData;
+		inData.pushBack(&input[iii*nbChunk]);
+		inData.pushBack(&input[iii*nbChunk]);
+		etk::Vector<void*> outData;
+		etk::Vector<size_t> outNbChunk;
+		EXPECT_EQ(group.process(time, inData, nbChunk, outData, outNbChunk), true);
+		// the change is used at the period boundary of the group
+		EXPECT_EQ(group[1]->getHotPending(), false);
+		if (    iii >= 5
+		     && iii < 15) {
+			EXPECT_EQ(test::getChain(*group[1]), chain + " Volume");
+		} else {
+			EXPECT_EQ(test::getChain(*group[1]), chain);
+		}
+		ASSERT_EQ(outNbChunk.size(), 2);
+		ASSERT_EQ(outNbChunk[0], nbChunk);
+		ASSERT_EQ(outNbChunk[1], nbChunk);
+		EXPECT_EQ(memcmp(outData[0], outData[1], nbChunk*2*sizeof(float)), 0);
+	}
+	// the periods are counted as with Process::process
+	for (size_t iii=0; iii<group.size(); ++iii) {
+		audio::drain::ProcessMetricSnapshot metric;
+		group[iii]->getMetric(metric);
+		EXPECT_EQ(metric.m_nbPeriod, 20);
+		EXPECT_EQ(metric.m_deadlineLast, 10000000);
+	}
+}
@@ -1,5 +1,5 @@
 /** @file
- * @author Edouard DUPIN 
+ * @author Edouard DUPIN
  * @copyright 2015, Edouard DUPIN, all right reserved
  * @license MPL v2.0 (see license file)
  */
@@ -7,4 +7,221 @@
 #include <test-debug/debug.hpp>
 #include <etest/etest.hpp>
 #include <audio/drain/Process.hpp>
+#include <audio/drain/Resampler.hpp>
+#include <audio/drain/cpu.hpp>
+#include "common.hpp"
+extern "C" {
+	#include <math.h>
+}
 
+static const float g_listRatio[][2] = {
+	{48000, 44100},
+	{44100, 48000},
+	{48000, 16000},
+	{16000, 48000},
+	{48000, 96000},
+	{22050, 48000}
+};
+static const size_t g_nbRatio = sizeof(g_listRatio)/sizeof(g_listRatio[0]);
+
+static ememory::SharedPtr<audio::drain::Resampler> createResampler(enum audio::format _format, int32_t _nbChannel, float _input, float _output) {
+	ememory::SharedPtr<audio::drain::Resampler> algo = audio::drain::Resampler::create();
+	algo->setNativeEngine(true);
+	algo->setFormat(audio::drain::IOFormatInterface(test::getMap(_nbChannel), _format, _input),
+	                audio::drain::IOFormatInterface(test::getMap(_nbChannel), _format, _output));
+	return algo;
+}
+
+/**
+ * @brief Create a sinus on all the channels.
+ */
+static void createSinus(etk::Vector<uint8_t>& _buffer, enum audio::format _format, int32_t _nbChannel, size_t _nbChunk, float _frequency, float _sampleRate) {
+	_buffer.resize(_nbChunk*_nbChannel*audio::getFormatBytes(_format));
+	for (size_t iii=0; iii<_nbChunk; ++iii) {
+		double value = 0.5 * sin(2.0*M_PI*double(iii)*_frequency/_sampleRate);
+		for (int32_t jjj=0; jjj<_nbChannel; ++jjj) {
+			size_t id = iii*_nbChannel+jjj;
+			switch (_format) {
+				case audio::format_int16:
+					reinterpret_cast<int16_t*>(&_buffer[0])[id] = int16_t(value*32767.0);
+					break;
+				case audio::format_int16_on_int32:
+					reinterpret_cast<int32_t*>(&_buffer[0])[id] = int32_t(value*32767.0);
+					break;
+				case audio::format_float:
+					reinterpret_cast<float*>(&_buffer[0])[id] = float(value);
+					break;
+				default:
+					break;
+			}
+		}
+	}
+}
+
+static double getValue(enum audio::format _format, const etk::Vector<uint8_t>& _data, size_t _id) {
+	switch (_format) {
+		case audio::format_int16:
+			return reinterpret_cast<const int16_t*>(&_data[0])[_id] / 32767.0;
+		case audio::format_int16_on_int32:
+			return reinterpret_cast<const int32_t*>(&_data[0])[_id] / 32767.0;
+		case audio::format_float:
+			return reinterpret_cast<const float*>(&_data[0])[_id];
+		default:
+			break;
+	}
+	return 0.0;
+}
+
+/**
+ * @brief Resample a buffer by periods of 480 input chunks.
+ */
+static void resample(const ememory::SharedPtr<audio::drain::Resampler>& _algo, etk::Vector<uint8_t>& _input, size_t _nbChunk, etk::Vector<uint8_t>& _output) {
+	size_t inputChunkSize = _algo->getInputFormat().getChunkSize();
+	size_t outputChunkSize = _algo->getOutputFormat().getChunkSize();
+	_output.clear();
+	for (size_t iii=0; iii<_nbChunk; iii+=480) {
+		audio::Time time;
+		void* outputData = null;
+		size_t outputNbChunk = 0;
+		size_t nbChunk = etk::min(size_t(480), _nbChunk-iii);
+		_algo->process(time, &_input[iii*inputChunkSize], nbChunk, outputData, outputNbChunk);
+		const uint8_t* data = static_cast<const uint8_t*>(outputData);
+		for (size_t jjj=0; jjj<outputNbChunk*outputChunkSize; ++jjj) {
+			_output.pushBack(data[jjj]);
+		}
+	}
+}
+
+TEST(TestResampling, outputSize) {
+	for (size_t iii=0; iii<g_nbRatio; ++iii) {
+		ememory::SharedPtr<audio::drain::Resampler> algo = createResampler(audio::format_float, 2, g_listRatio[iii][0], g_listRatio[iii][1]);
+		size_t nbChunk = size_t(g_listRatio[iii][0]);
+		etk::Vector<uint8_t> input;
+		etk::Vector<uint8_t> output;
+		createSinus(input, audio::format_float, 2, nbChunk, 1000, g_listRatio[iii][0]);
+		resample(algo, input, nbChunk, output);
+		// 1 second of input ==> 1 second of output, less the delay of the filter
+		double nbOutput = double(output.size() / algo->getOutputFormat().getChunkSize());
+		double expected = g_listRatio[iii][1];
+		TEST_INFO(g_listRatio[iii][0] << " -> " << g_listRatio[iii][1] << " : " << nbOutput << " chunks");
+		EXPECT_LE(nbOutput, expected + 1.0);
+		EXPECT_GE(nbOutput, expected * 0.99);
+	}
+}
+
+TEST(TestResampling, sinus) {
+	static const enum audio::format listFormat[] = {audio::format_int16, audio::format_int16_on_int32, audio::format_float};
+	for (size_t fff=0; fff<sizeof(listFormat)/sizeof(enum audio::format); ++fff) {
+		for (size_t iii=0; iii<g_nbRatio; ++iii) {
+			ememory::SharedPtr<audio::drain::Resampler> algo = createResampler(listFormat[fff], 1, g_listRatio[iii][0], g_listRatio[iii][1]);
+			size_t nbChunk = size_t(g_listRatio[iii][0]);
+			etk::Vector<uint8_t> input;
+			etk::Vector<uint8_t> output;
+			createSinus(input, listFormat[fff], 1, nbChunk, 1000, g_listRatio[iii][0]);
+			resample(algo, input, nbChunk, output);
+			size_t nbOutput = output.size() / algo->getOutputFormat().getChunkSize();
+			ASSERT_NE(nbOutput, 0);
+			// skip the start of the filter
+			size_t start = nbOutput / 4;
+			double power = 0.0;
+			size_t nbCrossing = 0;
+			for (size_t jjj=start; jjj<nbOutput; ++jjj) {
+				double value = getValue(listFormat[fff], output, jjj);
+				power += value*value;
+				if (    jjj > start
+				     && (value >= 0.0) != (getValue(listFormat[fff], output, jjj-1) >= 0.0)) {
+					nbCrossing++;
+				}
+			}
+			double duration = double(nbOutput-start) / g_listRatio[iii][1];
+			// amplitude 0.5 ==> rms 0.3535
+			EXPECT_FLOAT_EQ_DELTA(sqrt(power/double(nbOutput-start)), 0.3535, 0.01);
+			// same frequency: 2 crossing by period
+			EXPECT_FLOAT_EQ_DELTA(double(nbCrossing)/duration, 2000.0, 20.0);
+		}
+	}
+}
+
+TEST(TestResampling, qualityChange) {
+	ememory::SharedPtr<audio::drain::Resampler> algo = createResampler(audio::format_float, 1, 44100, 48000);
+	size_t nbChunk = 44100;
+	etk::Vector<uint8_t> input;
+	etk::Vector<uint8_t> output;
+	createSinus(input, audio::format_float, 1, nbChunk, 1000, 44100);
+	for (size_t iii=0; iii<nbChunk; iii+=441) {
+		// the new filter is used at the next period
+		if (iii == 441*30) {
+			algo->setQuality(3);
+		} else if (iii == 441*60) {
+			algo->setQuality(10);
+		}
+		audio::Time time;
+		void* outputData = null;
+		size_t outputNbChunk = 0;
+		algo->process(time, &input[iii*sizeof(float)], 441, outputData, outputNbChunk);
+		const uint8_t* data = static_cast<const uint8_t*>(outputData);
+		for (size_t jjj=0; jjj<outputNbChunk*sizeof(float); ++jjj) {
+			output.pushBack(data[jjj]);
+		}
+	}
+	EXPECT_EQ(algo->getQuality(), 10);
+	size_t nbOutput = output.size() / sizeof(float);
+	// 1 second of input ==> 1 second of output, less the delay of the filter
+	EXPECT_GE(nbOutput, size_t(48000*0.99));
+	// the history of the filter is kept: no jump in the sinus (1000Hz at 48kHz move of less than 0.066 by sample)
+	double maxDelta = 0.0;
+	for (size_t jjj=nbOutput/8; jjj<nbOutput; ++jjj) {
+		maxDelta = etk::max(maxDelta, fabs(getValue(audio::format_float, output, jjj) - getValue(audio::format_float, output, jjj-1)));
+	}
+	EXPECT_LT(maxDelta, 0.08);
+}
+
+TEST(TestResampling, int16OnInt32Block) {
+	for (size_t iii=0; iii<g_nbRatio; ++iii) {
+		size_t nbChunk = 4800;
+		etk::Vector<uint8_t> input;
+		etk::Vector<uint8_t> reference;
+		etk::Vector<uint8_t> output;
+		createSinus(input, audio::format_int16_on_int32, 2, nbChunk, 440, g_listRatio[iii][0]);
+		ememory::SharedPtr<audio::drain::Resampler> algoReference = createResampler(audio::format_int16_on_int32, 2, g_listRatio[iii][0], g_listRatio[iii][1]);
+		// the periods of 480 chunks are resampled by blocks of the float buffers
+		ememory::SharedPtr<audio::drain::Resampler> algo = createResampler(audio::format_int16_on_int32, 2, g_listRatio[iii][0], g_listRatio[iii][1]);
+		algo->setProcessBufferSize(100);
+		resample(algoReference, input, nbChunk, reference);
+		resample(algo, input, nbChunk, output);
+		ASSERT_EQ(output.size(), reference.size());
+		size_t nbError = 0;
+		for (size_t jjj=0; jjj<output.size(); ++jjj) {
+			if (output[jjj] != reference[jjj]) {
+				nbError++;
+			}
+		}
+		EXPECT_EQ(nbError, 0);
+	}
+}
+
+TEST(TestResampling, simdMatchGeneric) {
+	for (size_t iii=0; iii<g_nbRatio; ++iii) {
+		for (int32_t nbChannel=1; nbChannel<=2; ++nbChannel) {
+			size_t nbChunk = 4800;
+			etk::Vector<uint8_t> input;
+			etk::Vector<uint8_t> reference;
+			etk::Vector<uint8_t> output;
+			createSinus(input, audio::format_float, nbChannel, nbChunk, 440, g_listRatio[iii][0]);
+			// the kernels are selected at the configuration
+			audio::drain::cpu::setSimdEnable(false);
+			ememory::SharedPtr<audio::drain::Resampler> algoGeneric = createResampler(audio::format_float, nbChannel, g_listRatio[iii][0], g_listRatio[iii][1]);
+			audio::drain::cpu::setSimdEnable(true);
+			ememory::SharedPtr<audio::drain::Resampler> algoSimd = createResampler(audio::format_float, nbChannel, g_listRatio[iii][0], g_listRatio[iii][1]);
+			resample(algoGeneric, input, nbChunk, reference);
+			resample(algoSimd, input, nbChunk, output);
+			ASSERT_EQ(output.size(), reference.size());
+			double maxError = 0.0;
+			for (size_t jjj=0; jjj<output.size()/sizeof(float); ++jjj) {
+				maxError = etk::max(maxError, fabs(getValue(audio::format_float, output, jjj) - getValue(audio::format_float, reference, jjj)));
+			}
+			// only the order of the sums change
+			EXPECT_LT(maxError, 0.00001);
+		}
+	}
+}
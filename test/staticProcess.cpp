@@ -0,0 +1,76 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2015, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <test-debug/debug.hpp>
+#include <etest/etest.hpp>
+#include <audio/drain/StaticProcess.hpp>
+#include <audio/drain/Volume.hpp>
+#include <audio/drain/FormatUpdate.hpp>
+#include <audio/drain/Equalizer.hpp>
+#include "common.hpp"
+
+TEST(TestStaticProcess, sameAsAlgo) {
+	audio::drain::IOFormatInterface stereoFloat(test::getMap(2), audio::format_float, 48000);
+	audio::drain::IOFormatInterface stereoInt16(test::getMap(2), audio::format_int16, 48000);
+	audio::drain::StaticProcess<audio::drain::Volume, audio::drain::FormatUpdate> process;
+	process.get<0>().addVolumeStage(ememory::makeShared<audio::drain::VolumeElement>("FLOW", -6.0f));
+	process.get<0>().setRamp(audio::drain::volumeRamp_none, 0.0f);
+	audio::drain::IOFormatInterface format[3] = {stereoFloat, stereoFloat, stereoInt16};
+	ASSERT_EQ(process.configure(format, 480), true);
+	EXPECT_EQ(process.getInputConfig(), stereoFloat);
+	EXPECT_EQ(process.getOutputConfig(), stereoInt16);
+	EXPECT_EQ(process.getLatency(), audio::Duration(0));
+	// same algos called one after the other
+	ememory::SharedPtr<audio::drain::Volume> volume = test::createAlgo<audio::drain::Volume>(stereoFloat, stereoFloat);
+	volume->addVolumeStage(ememory::makeShared<audio::drain::VolumeElement>("FLOW", -6.0f));
+	volume->setRamp(audio::drain::volumeRamp_none, 0.0f);
+	ememory::SharedPtr<audio::drain::FormatUpdate> formatUpdate = test::createAlgo<audio::drain::FormatUpdate>(stereoFloat, stereoInt16);
+	for (size_t iii=0; iii<3; ++iii) {
+		etk::Vector<uint8_t> input;
+		test::fillRandom(input, audio::format_float, 480*2, iii+1);
+		audio::Time time;
+		void* outData = null;
+		size_t outNbChunk = 0;
+		EXPECT_EQ(process.process(time, &input[0], 480, outData, outNbChunk), true);
+		ASSERT_EQ(outNbChunk, 480);
+		void* refData = null;
+		size_t refNbChunk = 0;
+		volume->process(time, &input[0], 480, refData, refNbChunk);
+		void* refData2 = null;
+		size_t refNbChunk2 = 0;
+		formatUpdate->process(time, refData, refNbChunk, refData2, refNbChunk2);
+		ASSERT_EQ(refNbChunk2, 480);
+		EXPECT_EQ(memcmp(outData, refData2, 480*2*sizeof(int16_t)), 0);
+	}
+}
+
+TEST(TestStaticProcess, passThrough) {
+	audio::drain::IOFormatInterface stereoInt16(test::getMap(2), audio::format_int16, 48000);
+	audio::drain::StaticProcess<audio::drain::FormatUpdate> process;
+	audio::drain::IOFormatInterface format[2] = {stereoInt16, stereoInt16};
+	ASSERT_EQ(process.configure(format), true);
+	etk::Vector<int16_t> input;
+	test::createRamp(input, 480*2);
+	audio::Time time;
+	void* outData = null;
+	size_t outNbChunk = 0;
+	EXPECT_EQ(process.process(time, &input[0], 480, outData, outNbChunk), true);
+	// nothing to do: the data stay in the user buffer
+	EXPECT_EQ(outData, &input[0]);
+	EXPECT_EQ(outNbChunk, 480);
+}
+
+TEST(TestStaticProcess, unsupportedFormat) {
+	audio::drain::IOFormatInterface stereoDouble(test::getMap(2), audio::format_double, 48000);
+	audio::drain::StaticProcess<audio::drain::Equalizer> process;
+	audio::drain::IOFormatInterface format[2] = {stereoDouble, stereoDouble};
+	EXPECT_EQ(process.configure(format), false);
+	etk::Vector<double> input(480*2, 0.5);
+	audio::Time time;
+	void* outData = null;
+	size_t outNbChunk = 0;
+	EXPECT_EQ(process.process(time, &input[0], 480, outData, outNbChunk), false);
+}
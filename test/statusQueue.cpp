@@ -0,0 +1,80 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2015, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <test-debug/debug.hpp>
+#include <etest/etest.hpp>
+#include <audio/drain/StatusQueue.hpp>
+#include <audio/drain/Process.hpp>
+#include <audio/drain/EndPointWrite.hpp>
+#include "common.hpp"
+
+TEST(TestStatusQueue, fullQueue) {
+	// rounded up to a power of 2
+	audio::drain::StatusQueue queue(5);
+	audio::drain::StatusEvent event;
+	EXPECT_EQ(queue.pop(event), false);
+	for (size_t iii=0; iii<8; ++iii) {
+		event.m_status = audio::drain::status_endPointWriteUnderflow;
+		event.m_origin = null;
+		event.m_count = iii+1;
+		EXPECT_EQ(queue.post(event), true);
+	}
+	// full: the event is dropped (never wait)
+	EXPECT_EQ(queue.post(event), false);
+	EXPECT_EQ(queue.takeNbDrop(), 1);
+	EXPECT_EQ(queue.takeNbDrop(), 0);
+	for (size_t iii=0; iii<8; ++iii) {
+		ASSERT_EQ(queue.pop(event), true);
+		EXPECT_EQ(event.m_count, iii+1);
+	}
+	EXPECT_EQ(queue.pop(event), false);
+}
+
+TEST(TestStatusQueue, processCoalescing) {
+	audio::drain::Process process;
+	ememory::SharedPtr<audio::drain::EndPointWrite> algo = audio::drain::EndPointWrite::create();
+	algo->setName("EPW");
+	algo->setInputFormat(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	algo->setOutputFormat(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	algo->setBufferSize(size_t(1000));
+	process.pushBack(algo);
+	etk::String lastOrigin;
+	etk::String lastStatus;
+	uint32_t nbEvent = 0;
+	uint32_t nbOccurence = 0;
+	process.setStatusFunction([&](const etk::String& _origin, const etk::String& _status) {
+	                          	lastOrigin = _origin;
+	                          	lastStatus = _status;
+	                          	nbEvent++;
+	                          });
+	process.setStatusEventFunction([&](const etk::String& _origin, enum audio::drain::status _status, uint32_t _count) {
+	                               	EXPECT_EQ(_origin, "EPW");
+	                               	EXPECT_EQ(_status, audio::drain::status_endPointWriteUnderflow);
+	                               	nbOccurence += _count;
+	                               });
+	// the occurences in the min interval are coalesced
+	process.setStatusQueue(true, audio::Duration(10, 0));
+	audio::Time time;
+	void* output = null;
+	size_t outputNbChunk = 0;
+	for (size_t iii=0; iii<5; ++iii) {
+		// empty buffer: underflow
+		algo->process(time, null, 480, output, outputNbChunk);
+	}
+	// nothing given by the audio thread
+	EXPECT_EQ(nbEvent, 0);
+	EXPECT_EQ(nbOccurence, 0);
+	EXPECT_GE(process.flushStatus(), 1);
+	EXPECT_EQ(nbOccurence, 5);
+	EXPECT_EQ(process.flushStatus(), 0);
+	// without queue: the status function is called directly
+	process.setStatusQueue(false);
+	algo->process(time, null, 480, output, outputNbChunk);
+	EXPECT_EQ(nbEvent, 1);
+	EXPECT_EQ(lastOrigin, "EPW");
+	EXPECT_EQ(lastStatus, "EPW_UNDERFLOW");
+	EXPECT_EQ(nbOccurence, 5);
+}
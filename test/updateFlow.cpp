@@ -1,5 +1,5 @@
 /** @file
- * @author Edouard DUPIN 
+ * @author Edouard DUPIN
  * @copyright 2015, Edouard DUPIN, all right reserved
  * @license MPL v2.0 (see license file)
  */
@@ -7,4 +7,683 @@
 #include <test-debug/debug.hpp>
 #include <etest/etest.hpp>
 #include <audio/drain/Process.hpp>
+#include <audio/drain/EndPointWrite.hpp>
+#include <audio/drain/EndPointRead.hpp>
+#include <audio/drain/EndPointCallback.hpp>
+#include <audio/drain/Volume.hpp>
+#include <audio/drain/cpu.hpp>
+#include <echrono/Steady.hpp>
+#include <atomic>
+#include "common.hpp"
+extern "C" {
+	#include <math.h>
+}
 
+TEST(TestUpdateFlow, negotiationPassThrough) {
+	audio::drain::Process process;
+	process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_int16, 48000));
+	process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_int16, 48000));
+	process.updateInterAlgo();
+	EXPECT_EQ(process.size(), 0);
+	etk::Vector<int16_t> input;
+	test::createRamp(input, 2*480);
+	void* output = null;
+	size_t outputNbChunk = 0;
+	EXPECT_EQ(process.process(&input[0], 480, output, outputNbChunk), true);
+	ASSERT_EQ(outputNbChunk, 480);
+	EXPECT_EQ(memcmp(output, &input[0], 2*480*sizeof(int16_t)), 0);
+}
+
+TEST(TestUpdateFlow, negotiationInsertAlgo) {
+	// format only
+	{
+		audio::drain::Process process;
+		process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_int16, 48000));
+		process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+		process.updateInterAlgo();
+		EXPECT_EQ(test::getChain(process), "FormatUpdate");
+	}
+	// map only
+	{
+		audio::drain::Process process;
+		process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+		process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_int16, 48000));
+		process.updateInterAlgo();
+		EXPECT_EQ(test::getChain(process), "ChannelReorder");
+	}
+	// frequency only
+	{
+		audio::drain::Process process;
+		process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_int16, 44100));
+		process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_int16, 48000));
+		process.updateInterAlgo();
+		etk::String chain = test::getChain(process);
+		TEST_INFO("chain: " << chain);
+		EXPECT_NE(chain.find("Resampler"), etk::String::npos);
+	}
+	// the volume do the format conversion itself
+	{
+		audio::drain::Process process;
+		process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+		process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+		process.pushBack(audio::drain::Volume::create());
+		process.updateInterAlgo();
+		EXPECT_EQ(test::getChain(process), "ChannelReorder Volume");
+		etk::Vector<int16_t> input(480, 16384);
+		void* output = null;
+		size_t outputNbChunk = 0;
+		EXPECT_EQ(process.process(&input[0], 480, output, outputNbChunk), true);
+		ASSERT_EQ(outputNbChunk, 480);
+		EXPECT_FLOAT_EQ_DELTA(static_cast<float*>(output)[0], 0.5f, 0.0001f);
+		EXPECT_FLOAT_EQ_DELTA(static_cast<float*>(output)[959], 0.5f, 0.0001f);
+	}
+}
+
+TEST(TestUpdateFlow, negotiationCache) {
+	audio::drain::Process::clearNegotiationCache();
+	etk::String chain[2];
+	for (size_t iii=0; iii<2; ++iii) {
+		// the second configuration is solved by the cache: it must give the same chain
+		audio::drain::Process process;
+		process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 44100));
+		process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+		process.pushBack(audio::drain::Volume::create());
+		process.updateInterAlgo();
+		chain[iii] = test::getChain(process);
+		etk::Vector<int16_t> input(441, 1000);
+		void* output = null;
+		size_t outputNbChunk = 0;
+		EXPECT_EQ(process.process(&input[0], 441, output, outputNbChunk), true);
+	}
+	EXPECT_EQ(chain[0], chain[1]);
+}
+
+namespace {
+	/**
+	 * @brief Volume that only process float (same type than the Volume, other supported formats).
+	 */
+	class VolumeFloat : public audio::drain::Volume {
+		public:
+			static ememory::SharedPtr<VolumeFloat> create() {
+				ememory::SharedPtr<VolumeFloat> tmp(ETK_NEW(VolumeFloat));
+				tmp->init();
+				return tmp;
+			}
+			virtual etk::Vector<audio::format> getFormatSupportedInput() {
+				etk::Vector<audio::format> out;
+				out.pushBack(audio::format_float);
+				return out;
+			}
+			virtual etk::Vector<audio::format> getFormatSupportedOutput() {
+				return getFormatSupportedInput();
+			}
+			virtual void appendSupportedKey(audio::drain::NegotiationHash& _hash) const {
+				// same lists as the getters
+				for (size_t iii=0; iii<2; ++iii) {
+					_hash.add(1);
+					_hash.add(uint32_t(audio::format_float));
+				}
+				appendFrequencySupportedKey(_hash);
+				appendMapSupportedKey(_hash);
+				appendLayoutSupportedKey(_hash);
+			}
+	};
+}
+
+TEST(TestUpdateFlow, negotiationCacheSupportedList) {
+	audio::drain::Process::clearNegotiationCache();
+	etk::String chain[2];
+	etk::Vector<audio::format> volumeFormat[2];
+	for (size_t iii=0; iii<2; ++iii) {
+		// same types and formats: the second volume has other supported formats ==> no cache hit
+		audio::drain::Process process;
+		process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_int16, 48000));
+		process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_int16, 48000));
+		ememory::SharedPtr<audio::drain::Volume> volume;
+		if (iii == 0) {
+			volume = audio::drain::Volume::create();
+		} else {
+			volume = VolumeFloat::create();
+		}
+		process.pushBack(volume);
+		process.updateInterAlgo();
+		chain[iii] = test::getChain(process);
+		volumeFormat[iii].pushBack(volume->getInputFormat().getFormat());
+		volumeFormat[iii].pushBack(volume->getOutputFormat().getFormat());
+	}
+	TEST_INFO("chain: '" << chain[0] << "' / '" << chain[1] << "'");
+	EXPECT_EQ(chain[0], "Volume");
+	EXPECT_EQ(volumeFormat[1][0], audio::format_float);
+	EXPECT_EQ(volumeFormat[1][1], audio::format_float);
+}
+
+TEST(TestUpdateFlow, handle) {
+	audio::drain::Process process;
+	process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 44100));
+	process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+	ememory::SharedPtr<audio::drain::Volume> volume = audio::drain::Volume::create();
+	volume->setName("volume");
+	audio::drain::AlgoHandle<audio::drain::Volume> handle = process.pushBack(volume);
+	EXPECT_EQ(handle.isValid(), true);
+	EXPECT_EQ(process.get(handle), volume);
+	// the negotiation insert algos in the chain: the handle does not change
+	process.updateInterAlgo();
+	EXPECT_NE(process.size(), 1);
+	EXPECT_EQ(process.get(handle), volume);
+	EXPECT_EQ(process.getHandle<audio::drain::Volume>("volume").m_id, handle.m_id);
+	EXPECT_EQ(process.getHandle<audio::drain::EndPointWrite>("volume").isValid(), false);
+	EXPECT_EQ(process.getHandle<audio::drain::Volume>("unknow").isValid(), false);
+	EXPECT_EQ(process.get<audio::drain::Volume>("volume"), volume);
+	EXPECT_EQ(process.get<audio::drain::Algo>("volume"), volume);
+	EXPECT_EQ(process.hasType<audio::drain::Volume>(), true);
+	EXPECT_EQ(process.hasType<audio::drain::EndPointWrite>(), false);
+	// resolved once, then kept while the handles and the names do not change
+	audio::drain::AlgoNameCache<audio::drain::Volume> cache("volume");
+	EXPECT_EQ(process.get(cache), volume);
+	EXPECT_EQ(cache.m_handle.m_id, handle.m_id);
+	EXPECT_EQ(process.get(cache), volume);
+	// rename
+	volume->setName("volumeRenamed");
+	EXPECT_EQ(process.get(cache) == null, true);
+	EXPECT_EQ(process.get<audio::drain::Volume>("volumeRenamed"), volume);
+	volume->setName("volume");
+	EXPECT_EQ(process.get(cache), volume);
+	// replace: a new algo with the same name is found when the previous one is removed
+	ememory::SharedPtr<audio::drain::Volume> volume2 = audio::drain::Volume::create();
+	volume2->setName("volume");
+	audio::drain::AlgoHandle<audio::drain::Volume> handle2 = process.hotPushBack(volume2);
+	EXPECT_EQ(handle2.isValid(), true);
+	EXPECT_EQ(process.get(cache), volume);
+	etk::Vector<int16_t> input;
+	test::createRamp(input, 441);
+	void* data = null;
+	size_t dataNbChunk = 0;
+	process.process(&input[0], 441, data, dataNbChunk);
+	EXPECT_EQ(process.hotRemove(handle), true);
+	EXPECT_EQ(process.get(cache), volume2);
+	EXPECT_EQ(process.get<audio::drain::Volume>("volume"), volume2);
+	process.clear();
+	EXPECT_EQ(process.get(handle) == null, true);
+	EXPECT_EQ(process.hasType<audio::drain::Volume>(), false);
+}
+
+TEST(TestUpdateFlow, dotLabel) {
+	ememory::SharedPtr<audio::drain::Volume> volume = audio::drain::Volume::create();
+	volume->setName("volume");
+	volume->addVolumeStage(ememory::makeShared<audio::drain::VolumeElement>("FLOW"));
+	etk::String label = volume->getDotLabel();
+	EXPECT_NE(label.find("type='Volume'"), etk::String::npos);
+	EXPECT_NE(label.find("name='volume'"), etk::String::npos);
+	EXPECT_NE(label.find("FLOW="), etk::String::npos);
+	// cached until a change
+	EXPECT_EQ(volume->getDotLabel(), label);
+	EXPECT_EQ(volume->setParameter("FLOW", "-6dB"), true);
+	EXPECT_NE(volume->getDotLabel(), label);
+	label = volume->getDotLabel();
+	volume->setName("volume2");
+	EXPECT_NE(volume->getDotLabel().find("name='volume2'"), etk::String::npos);
+	label = volume->getDotLabel();
+	volume->setFormat(audio::drain::IOFormatInterface(test::getMap(2), audio::format_int16, 48000),
+	                  audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+	EXPECT_NE(volume->getDotLabel().find("format: "), etk::String::npos);
+}
+
+TEST(TestUpdateFlow, statistic) {
+	etk::Vector<int16_t> input;
+	test::createRamp(input, 441*10);
+	audio::drain::Process process;
+	process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 44100));
+	process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_float, 48000));
+	process.updateInterAlgo();
+	process.setStatisticEnable(true);
+	for (size_t iii=0; iii<10; ++iii) {
+		if (iii == 5) {
+			// applied by the audio thread at the next call of each algo
+			process.resetStatistics();
+			etk::Vector<audio::drain::AlgoStatistic> list = process.getStatistics();
+			for (size_t jjj=0; jjj<list.size(); ++jjj) {
+				EXPECT_EQ(list[jjj].m_nbCall, 0);
+			}
+		}
+		void* data = null;
+		size_t dataNbChunk = 0;
+		process.process(&input[iii*441], 441, data, dataNbChunk);
+	}
+	etk::Vector<audio::drain::AlgoStatistic> list = process.getStatistics();
+	ASSERT_EQ(list.size(), process.size());
+	EXPECT_EQ(list[0].m_type, process[0]->getType());
+	EXPECT_EQ(list[0].m_nbCall, 5);
+	EXPECT_EQ(list[0].m_nbChunk, 441*5);
+	EXPECT_LE(list[0].m_cycleMin, list[0].m_cycleMax);
+}
+
+TEST(TestUpdateFlow, hotSwap) {
+	etk::Vector<int16_t> input;
+	test::createRamp(input, 441*40);
+	etk::Vector<float> output[2];
+	for (size_t iii=0; iii<2; ++iii) {
+		audio::drain::Process process;
+		process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 44100));
+		process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_float, 48000));
+		process.updateInterAlgo();
+		etk::String chain = test::getChain(process);
+		ememory::SharedPtr<audio::drain::Algo> first = process[0];
+		audio::drain::AlgoHandle<audio::drain::Volume> handle;
+		for (size_t jjj=0; jjj<40; ++jjj) {
+			if (iii == 1) {
+				if (jjj == 10) {
+					// a volume of 0dB does not change the data: the output must be the same as without it
+					handle = process.hotPushBack(audio::drain::Volume::create());
+					EXPECT_EQ(handle.isValid(), true);
+					EXPECT_EQ(process.getHotPending(), true);
+					// sized by the control thread for the period of the chain: its first process does not allocate
+					EXPECT_GE(process.get(handle)->getProcessBufferSize(), process.getProcessBufferSize());
+					// only one change by period
+					EXPECT_EQ(process.hotPushBack(audio::drain::Volume::create()).isValid(), false);
+				} else if (jjj == 30) {
+					EXPECT_EQ(process.hotRemove(handle), true);
+				}
+			}
+			void* data = null;
+			size_t dataNbChunk = 0;
+			process.process(&input[jjj*441], 441, data, dataNbChunk);
+			for (size_t kkk=0; kkk<dataNbChunk; ++kkk) {
+				output[iii].pushBack(static_cast<float*>(data)[kkk]);
+			}
+			if (    iii == 1
+			     && jjj == 10) {
+				EXPECT_EQ(process.getHotPending(), false);
+				EXPECT_EQ(test::getChain(process), chain + " Volume");
+				// the algos of the chain are kept (with their state)
+				EXPECT_EQ(process[0], first);
+			}
+		}
+		EXPECT_EQ(test::getChain(process), chain);
+	}
+	ASSERT_EQ(output[0].size(), output[1].size());
+	EXPECT_EQ(memcmp(&output[0][0], &output[1][0], output[0].size()*sizeof(float)), 0);
+}
+
+TEST(TestUpdateFlow, processBatch) {
+	size_t nbChunk = 100000;
+	etk::Vector<int16_t> input;
+	test::createRamp(input, nbChunk);
+	etk::Vector<float> reference;
+	etk::Vector<float> output;
+	{
+		audio::drain::Process process;
+		process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+		process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+		process.updateInterAlgo();
+		for (size_t iii=0; iii<nbChunk; iii+=500) {
+			void* data = null;
+			size_t dataNbChunk = 0;
+			process.process(&input[iii], 500, data, dataNbChunk);
+			for (size_t jjj=0; jjj<dataNbChunk*2; ++jjj) {
+				reference.pushBack(static_cast<float*>(data)[jjj]);
+			}
+		}
+	}
+	{
+		audio::drain::Process process;
+		process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+		process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+		process.updateInterAlgo();
+		size_t nbCall = 0;
+		EXPECT_EQ(process.processBatch(audio::Time(), &input[0], nbChunk,
+		                               [&](const audio::Time& _time, const void* _data, size_t _nbChunk) {
+		                               	nbCall++;
+		                               	for (size_t jjj=0; jjj<_nbChunk*2; ++jjj) {
+		                               		output.pushBack(static_cast<const float*>(_data)[jjj]);
+		                               	}
+		                               }), true);
+		EXPECT_GT(nbCall, 1);
+	}
+	ASSERT_EQ(output.size(), reference.size());
+	EXPECT_EQ(memcmp(&output[0], &reference[0], output.size()*sizeof(float)), 0);
+}
+
+TEST(TestUpdateFlow, silenceDetection) {
+	// silence, signal, then silence while the resampler empty its history
+	static const bool listSignal[] = {false, false, true, false, false, false};
+	size_t nbPeriod = sizeof(listSignal)/sizeof(bool);
+	etk::Vector<int16_t> ramp;
+	test::createRamp(ramp, 441);
+	etk::Vector<int16_t> zero(441, 0);
+	etk::Vector<float> output[2];
+	etk::Vector<bool> silence;
+	for (size_t iii=0; iii<2; ++iii) {
+		audio::drain::Process process;
+		process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 44100));
+		process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+		process.setSilenceDetection(iii == 1);
+		EXPECT_EQ(process.getSilenceDetection(), iii == 1);
+		process.updateInterAlgo();
+		for (size_t jjj=0; jjj<nbPeriod; ++jjj) {
+			void* data = null;
+			size_t dataNbChunk = 0;
+			EXPECT_EQ(process.process(listSignal[jjj] == true ? &ramp[0] : &zero[0], 441, data, dataNbChunk), true);
+			for (size_t kkk=0; kkk<dataNbChunk*2; ++kkk) {
+				output[iii].pushBack(static_cast<float*>(data)[kkk]);
+			}
+			if (iii == 1) {
+				silence.pushBack(process.getOutputSilence());
+			}
+		}
+	}
+	// the silent path give the same data
+	ASSERT_EQ(output[0].size(), output[1].size());
+	size_t nbError = 0;
+	for (size_t iii=0; iii<output[0].size(); ++iii) {
+		if (fabs(output[0][iii] - output[1][iii]) > 0.0001f) {
+			nbError++;
+		}
+	}
+	EXPECT_EQ(nbError, 0);
+	ASSERT_EQ(silence.size(), nbPeriod);
+	EXPECT_EQ(silence[0], true);
+	EXPECT_EQ(silence[2], false);
+	// the last period is silent again
+	EXPECT_EQ(silence[nbPeriod-1], true);
+}
+
+TEST(TestUpdateFlow, flushDenormal) {
+	etk::Vector<uint8_t> input;
+	test::fillRandom(input, audio::format_float, 480*2, 42, 1.0);
+	// the end of the buffer is denormal
+	for (size_t iii=480; iii<480*2; ++iii) {
+		reinterpret_cast<float*>(&input[0])[iii] = 1.0e-39f;
+	}
+	etk::Vector<float> output[2];
+	for (size_t iii=0; iii<2; ++iii) {
+		audio::drain::Process process;
+		process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+		process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+		ememory::SharedPtr<audio::drain::Volume> volume = audio::drain::Volume::create();
+		volume->addVolumeStage(ememory::makeShared<audio::drain::VolumeElement>("FLOW", -6.0f));
+		volume->setRamp(audio::drain::volumeRamp_none, 0.0f);
+		process.pushBack(volume);
+		process.setFlushDenormal(iii == 1);
+		EXPECT_EQ(process.getFlushDenormal(), iii == 1);
+		process.updateInterAlgo();
+		void* data = null;
+		size_t dataNbChunk = 0;
+		EXPECT_EQ(process.process(&input[0], 480, data, dataNbChunk), true);
+		ASSERT_EQ(dataNbChunk, 480);
+		output[iii].resize(480*2);
+		memcpy(&output[iii][0], data, 480*2*sizeof(float));
+	}
+	// the normal floats are not changed
+	EXPECT_EQ(memcmp(&output[0][0], &output[1][0], 240*2*sizeof(float)), 0);
+	EXPECT_NE(output[0][480*2-1], 0.0f);
+	#ifdef DRAIN_SIMD_X86
+		EXPECT_EQ(output[1][480*2-1], 0.0f);
+	#endif
+	// the float unit of the caller is restored after the process
+	volatile float denormal = 1.0e-39f;
+	EXPECT_NE(denormal * 0.5f, 0.0f);
+}
+
+static ememory::SharedPtr<audio::drain::EndPointWrite> createEndPointWrite(size_t _bufferSize) {
+	ememory::SharedPtr<audio::drain::EndPointWrite> algo = audio::drain::EndPointWrite::create();
+	algo->setInputFormat(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	algo->setOutputFormat(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	algo->setBufferSize(_bufferSize);
+	return algo;
+}
+
+TEST(TestUpdateFlow, endPointWrite) {
+	ememory::SharedPtr<audio::drain::EndPointWrite> algo = createEndPointWrite(1000);
+	etk::Vector<int16_t> input;
+	test::createRamp(input, 600);
+	EXPECT_EQ(algo->write(&input[0], 600), 600);
+	EXPECT_EQ(algo->getBufferFillSize(), 600);
+	audio::Time time;
+	void* output = null;
+	size_t outputNbChunk = 0;
+	algo->process(time, null, 480, output, outputNbChunk);
+	ASSERT_EQ(outputNbChunk, 480);
+	EXPECT_EQ(memcmp(output, &input[0], 480*sizeof(int16_t)), 0);
+	// underflow: only the end of the data
+	algo->process(time, null, 480, output, outputNbChunk);
+	ASSERT_EQ(outputNbChunk, 120);
+	EXPECT_EQ(memcmp(output, &input[480], 120*sizeof(int16_t)), 0);
+	// empty buffer: no data (the next algos flush)
+	algo->process(time, null, 480, output, outputNbChunk);
+	EXPECT_EQ(outputNbChunk, 0);
+	audio::drain::EndPointMetricSnapshot metric;
+	algo->getMetric(metric);
+	EXPECT_EQ(metric.m_nbProcess, 3);
+	EXPECT_EQ(metric.m_nbUnderflow, 2);
+	EXPECT_EQ(metric.m_underflowChunk, 360+480);
+	EXPECT_EQ(metric.m_nbOverflow, 0);
+	algo->resetMetric();
+	algo->getMetric(metric);
+	EXPECT_EQ(metric.m_nbProcess, 0);
+	EXPECT_EQ(metric.m_nbUnderflow, 0);
+}
+
+TEST(TestUpdateFlow, endPointWriteOverflow) {
+	etk::Vector<int16_t> first(800, 1);
+	etk::Vector<int16_t> second(800, 2);
+	static const enum audio::drain::overflowPolicy listPolicy[] = {
+		audio::drain::overflowPolicy_dropNewest,
+		audio::drain::overflowPolicy_dropOldest,
+		audio::drain::overflowPolicy_reject
+	};
+	// chunks accepted by the second write, fill after a period of 480, last sample of the period
+	static const size_t listAccepted[] = {200, 800, 0};
+	static const size_t listFill[] = {520, 520, 320};
+	static const int16_t listLast[] = {1, 2, 1};
+	// a rejected write drop nothing: the producer retry later
+	static const uint64_t listOverflow[] = {1, 1, 0};
+	for (size_t iii=0; iii<sizeof(listPolicy)/sizeof(enum audio::drain::overflowPolicy); ++iii) {
+		ememory::SharedPtr<audio::drain::EndPointWrite> algo = createEndPointWrite(1000);
+		algo->setOverflowPolicy(listPolicy[iii]);
+		EXPECT_EQ(algo->getOverflowPolicy(), listPolicy[iii]);
+		EXPECT_EQ(algo->write(&first[0], 800), 800);
+		EXPECT_EQ(algo->getAvailableSpace(), 200);
+		EXPECT_EQ(algo->write(&second[0], 800), listAccepted[iii]);
+		audio::Time time;
+		void* output = null;
+		size_t outputNbChunk = 0;
+		algo->process(time, null, 480, output, outputNbChunk);
+		ASSERT_EQ(outputNbChunk, 480);
+		EXPECT_EQ(algo->getBufferFillSize(), listFill[iii]);
+		EXPECT_EQ(static_cast<int16_t*>(output)[0], 1);
+		EXPECT_EQ(static_cast<int16_t*>(output)[479], listLast[iii]);
+		audio::drain::EndPointMetricSnapshot metric;
+		algo->getMetric(metric);
+		EXPECT_EQ(metric.m_nbOverflow, listOverflow[iii]);
+	}
+}
+
+TEST(TestUpdateFlow, endPointWritev) {
+	ememory::SharedPtr<audio::drain::EndPointWrite> algo = createEndPointWrite(1000);
+	etk::Vector<int16_t> input;
+	test::createRamp(input, 480);
+	// the period in 3 pieces
+	audio::drain::CircularBufferWriteSpan span[3];
+	span[0].m_data = &input[0];
+	span[0].m_nbChunk = 100;
+	span[1].m_data = &input[100];
+	span[1].m_nbChunk = 300;
+	span[2].m_data = &input[400];
+	span[2].m_nbChunk = 80;
+	EXPECT_EQ(algo->writev(span, 3), 480);
+	audio::Time time;
+	void* output = null;
+	size_t outputNbChunk = 0;
+	algo->process(time, null, 480, output, outputNbChunk);
+	ASSERT_EQ(outputNbChunk, 480);
+	EXPECT_EQ(memcmp(output, &input[0], 480*sizeof(int16_t)), 0);
+}
+
+TEST(TestUpdateFlow, endPointWriteDrift) {
+	for (size_t iii=0; iii<2; ++iii) {
+		ememory::SharedPtr<audio::drain::EndPointWrite> algo = createEndPointWrite(4800);
+		algo->setDriftCompensation(iii == 1);
+		// the producer is 520ppm faster than the device: one more chunk every 4 periods
+		etk::Vector<int16_t> input(2400, 1000);
+		EXPECT_EQ(algo->write(&input[0], 2400), 2400);
+		audio::Time time;
+		bool valid = true;
+		for (size_t jjj=0; jjj<2000; ++jjj) {
+			algo->write(&input[0], jjj%4 == 0 ? 481 : 480);
+			void* output = null;
+			size_t outputNbChunk = 0;
+			algo->process(time, null, 480, output, outputNbChunk);
+			if (outputNbChunk != 480) {
+				valid = false;
+				continue;
+			}
+			// the interpolation of a constant signal is the same constant
+			for (size_t kkk=0; kkk<outputNbChunk; ++kkk) {
+				if (static_cast<int16_t*>(output)[kkk] != 1000) {
+					valid = false;
+				}
+			}
+		}
+		EXPECT_EQ(valid, true);
+		TEST_INFO("drift=" << (iii == 1) << " fill=" << algo->getBufferFillSize() << " ratio=" << algo->getDriftRatio());
+		if (iii == 0) {
+			// the fill level follow the drift
+			EXPECT_EQ(algo->getBufferFillSize(), 2400+500);
+			EXPECT_EQ(algo->getDriftRatio(), 1.0);
+		} else {
+			// read faster to stay at the middle of the buffer
+			EXPECT_LT(algo->getBufferFillSize(), 2400+150);
+			EXPECT_GT(algo->getDriftRatio(), 1.0003);
+			EXPECT_LE(algo->getDriftRatio(), 1.001);
+			audio::drain::EndPointMetricSnapshot metric;
+			algo->getMetric(metric);
+			EXPECT_GT(metric.m_driftPpm, 300);
+		}
+	}
+}
+
+TEST(TestUpdateFlow, endPointRead) {
+	ememory::SharedPtr<audio::drain::EndPointRead> algo = audio::drain::EndPointRead::create();
+	algo->setInputFormat(audio::drain::IOFormatInterface(test::getMap(2), audio::format_int16, 48000));
+	algo->setOutputFormat(audio::drain::IOFormatInterface(test::getMap(2), audio::format_int16, 48000));
+	algo->setBufferSize(size_t(1000));
+	etk::Vector<int16_t> input;
+	test::createRamp(input, 2*480);
+	audio::Time time;
+	for (size_t iii=0; iii<3; ++iii) {
+		void* output = null;
+		size_t outputNbChunk = 0;
+		algo->process(time, &input[0], 480, output, outputNbChunk);
+		time += audio::Duration(0, 10000000);
+	}
+	// 1440 chunks in a buffer of 1000
+	EXPECT_EQ(algo->getBufferFillSize(), 1000);
+	audio::drain::EndPointMetricSnapshot metric;
+	algo->getMetric(metric);
+	EXPECT_EQ(metric.m_nbProcess, 3);
+	EXPECT_EQ(metric.m_nbOverflow, 1);
+	etk::Vector<int16_t> output(2*1000, 0);
+	audio::Time readTime;
+	EXPECT_EQ(algo->read(&output[0], 480, readTime), 480);
+	EXPECT_EQ(memcmp(&output[0], &input[0], 2*480*sizeof(int16_t)), 0);
+	EXPECT_EQ(algo->read(&output[0], 800, readTime), 520);
+	EXPECT_EQ(algo->getBufferFillSize(), 0);
+}
+
+/**
+ * @brief Create a pull chain: the callback generate a ramp in mono int16_t, the output is in stereo float.
+ */
+static void createPullChain(audio::drain::Process& _process, std::atomic<size_t>& _counter) {
+	ememory::SharedPtr<audio::drain::EndPointCallback> algo = audio::drain::EndPointCallback::create(
+	    [&_counter](void* _data, const audio::Time& _playTime, size_t _nbChunk, enum audio::format _format, uint32_t _frequency, const etk::Vector<audio::channel>& _map) {
+	    	// called by the pipeline thread and read by the test
+	    	size_t counter = _counter.load();
+	    	int16_t* data = static_cast<int16_t*>(_data);
+	    	for (size_t iii=0; iii<_nbChunk; ++iii) {
+	    		data[iii] = int16_t((counter%4000)*7 - 14000);
+	    		counter++;
+	    	}
+	    	_counter.store(counter);
+	    });
+	algo->setInputFormat(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	algo->setOutputFormat(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	_process.setInputConfig(audio::drain::IOFormatInterface(test::getMap(1), audio::format_int16, 48000));
+	_process.setOutputConfig(audio::drain::IOFormatInterface(test::getMap(2), audio::format_float, 48000));
+	_process.pushBack(algo);
+	_process.updateInterAlgo();
+}
+
+/**
+ * @brief Wait the pipeline thread compute a number of chunk in advance (1 second maximum).
+ */
+static bool waitPipeline(audio::drain::Process& _process, size_t _nbChunk) {
+	echrono::Steady start = echrono::Steady::now();
+	while (_process.getPipelineSize() < _nbChunk) {
+		if ((echrono::Steady::now() - start).get() > 1000000000LL) {
+			return false;
+		}
+	}
+	return true;
+}
+
+TEST(TestUpdateFlow, pipelinePull) {
+	size_t chunkSize = 2*sizeof(float);
+	std::atomic<size_t> counterDirect(0);
+	audio::drain::Process processDirect;
+	createPullChain(processDirect, counterDirect);
+	std::atomic<size_t> counterPipeline(0);
+	audio::drain::Process processPipeline;
+	createPullChain(processPipeline, counterPipeline);
+	audio::Time time;
+	EXPECT_EQ(processPipeline.startPipeline(3, 480, time), true);
+	EXPECT_EQ(processPipeline.getPipelineEnable(), true);
+	// a chunk size different of the configuration is refused
+	etk::Vector<float> reference(2*480, 0.0f);
+	EXPECT_EQ(processPipeline.pull(time, &reference[0], 480, sizeof(int16_t)), false);
+	for (size_t iii=0; iii<10; ++iii) {
+		etk::Vector<float> output(2*480, 0.0f);
+		EXPECT_EQ(processDirect.pull(time, &reference[0], 480, chunkSize), true);
+		// the callback only copy the periods computed in advance: same stream as the direct pull
+		ASSERT_EQ(waitPipeline(processPipeline, 480), true);
+		EXPECT_EQ(processPipeline.pull(time, &output[0], 480, chunkSize), true);
+		EXPECT_EQ(memcmp(&output[0], &reference[0], output.size()*sizeof(float)), 0);
+	}
+	EXPECT_EQ(processPipeline.getPipelineUnderrun(), 0);
+	// the periods computed in advance add their latency
+	ASSERT_EQ(waitPipeline(processPipeline, 3*480), true);
+	EXPECT_EQ(processPipeline.getLatency().get(), processDirect.getLatency().get() + 3*10000000LL);
+	processPipeline.stopPipeline();
+	EXPECT_EQ(processPipeline.getPipelineEnable(), false);
+	EXPECT_EQ(processPipeline.getPipelineSize(), 0);
+	// the generator is never called from the audio callback: 10 periods read and 3 in advance
+	EXPECT_EQ(counterPipeline.load(), 13*480);
+	// back to the direct pull
+	etk::Vector<float> output(2*480, 0.0f);
+	EXPECT_EQ(processPipeline.pull(time, &output[0], 480, chunkSize), true);
+	EXPECT_EQ(counterPipeline.load(), 14*480);
+}
+
+TEST(TestUpdateFlow, pipelineUnderrun) {
+	size_t chunkSize = 2*sizeof(float);
+	std::atomic<size_t> counter(0);
+	audio::drain::Process process;
+	createPullChain(process, counter);
+	audio::Time time;
+	EXPECT_EQ(process.startPipeline(1, 480, time), true);
+	ASSERT_EQ(waitPipeline(process, 480), true);
+	// 2 periods requested with 1 ready: the end is set at 0
+	etk::Vector<float> output(2*960, 1.0f);
+	EXPECT_EQ(process.pull(time, &output[0], 960, chunkSize), true);
+	EXPECT_EQ(process.getPipelineUnderrun(), 1);
+	EXPECT_NE(output[2], 0.0f);
+	size_t nbNotZero = 0;
+	for (size_t iii=2*480; iii<output.size(); ++iii) {
+		if (output[iii] != 0.0f) {
+			nbNotZero++;
+		}
+	}
+	EXPECT_EQ(nbNotZero, 0);
+	process.stopPipeline();
+	EXPECT_EQ(process.startPipeline(0, 480, time), false);
+	EXPECT_EQ(process.getPipelineEnable(), false);
+}
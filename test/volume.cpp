@@ -0,0 +1,216 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2015, Edouard DUPIN, all right reserved
+ * @license MPL v2.0 (see license file)
+ */
+
+#include <test-debug/debug.hpp>
+#include <etest/etest.hpp>
+#include <audio/drain/Volume.hpp>
+#include <audio/drain/FormatUpdate.hpp>
+#include <audio/drain/cpu.hpp>
+#include "common.hpp"
+extern "C" {
+	#include <math.h>
+}
+
+/**
+ * @brief Create a volume without ramp: the new gain is applied directly at the next period.
+ */
+static ememory::SharedPtr<audio::drain::Volume> createVolume(enum audio::format _input, enum audio::format _output, float _volumedB) {
+	ememory::SharedPtr<audio::drain::Volume> algo = audio::drain::Volume::create();
+	algo->addVolumeStage(ememory::makeShared<audio::drain::VolumeElement>("FLOW", _volumedB));
+	algo->setRamp(audio::drain::volumeRamp_none, 0.0f);
+	algo->setFormat(audio::drain::IOFormatInterface(test::getMap(2), _input, 48000),
+	                audio::drain::IOFormatInterface(test::getMap(2), _output, 48000));
+	return algo;
+}
+
+template<typename TYPE_IN, typename TYPE_OUT>
+static void process(const ememory::SharedPtr<audio::drain::Volume>& _algo, etk::Vector<TYPE_IN>& _input, etk::Vector<TYPE_OUT>& _output) {
+	audio::Time time;
+	void* outputData = null;
+	size_t outputNbChunk = 0;
+	_algo->process(time, &_input[0], _input.size()/2, outputData, outputNbChunk);
+	_output.resize(outputNbChunk*2);
+	memcpy(&_output[0], outputData, _output.size()*sizeof(TYPE_OUT));
+}
+
+static void createAllInt16(etk::Vector<int16_t>& _buffer) {
+	_buffer.resize(65536);
+	for (size_t iii=0; iii<_buffer.size(); ++iii) {
+		_buffer[iii] = int16_t(int32_t(iii) - 32768);
+	}
+}
+
+TEST(TestVolume, gainTable) {
+	etk::Vector<float> input(2, 0.5f);
+	for (int32_t iii=-1200; iii<=400; iii+=37) {
+		float volumedB = float(iii) / 10.0f;
+		ememory::SharedPtr<audio::drain::Volume> algo = createVolume(audio::format_float, audio::format_float, volumedB);
+		etk::Vector<float> output;
+		process(algo, input, output);
+		ASSERT_EQ(output.size(), 2);
+		double reference = 0.5 * pow(10.0, double(volumedB)/20.0);
+		EXPECT_LT(fabs(double(output[0]) - reference) / reference, 0.000001);
+	}
+}
+
+TEST(TestVolume, roundingInt16) {
+	static const float listVolume[] = {-0.5f, -6.0f, -13.3f, -40.0f};
+	etk::Vector<int16_t> input;
+	createAllInt16(input);
+	for (size_t iii=0; iii<sizeof(listVolume)/sizeof(float); ++iii) {
+		ememory::SharedPtr<audio::drain::Volume> algo = createVolume(audio::format_int16, audio::format_int16, listVolume[iii]);
+		etk::Vector<int16_t> output;
+		process(algo, input, output);
+		ASSERT_EQ(output.size(), input.size());
+		double gain = pow(10.0, double(listVolume[iii])/20.0);
+		double mean = 0.0;
+		double maxError = 0.0;
+		for (size_t jjj=0; jjj<input.size(); ++jjj) {
+			double error = double(output[jjj]) - double(input[jjj])*gain;
+			mean += error;
+			maxError = etk::max(maxError, fabs(error));
+		}
+		mean /= double(input.size());
+		TEST_INFO(listVolume[iii] << "dB: mean=" << mean << " max=" << maxError);
+		// rounded: no bias, half a LSB + the precision of the Q16 coef
+		EXPECT_LT(fabs(mean), 0.01);
+		EXPECT_LT(maxError, 0.75);
+	}
+}
+
+TEST(TestVolume, saturationInt16) {
+	etk::Vector<int16_t> input;
+	input.pushBack(20000);
+	input.pushBack(-20000);
+	input.pushBack(100);
+	input.pushBack(-100);
+	ememory::SharedPtr<audio::drain::Volume> algo = createVolume(audio::format_int16, audio::format_int16, 12.0f);
+	etk::Vector<int16_t> output;
+	process(algo, input, output);
+	ASSERT_EQ(output.size(), 4);
+	EXPECT_EQ(output[0], 32767);
+	EXPECT_EQ(output[1], -32768);
+	EXPECT_EQ(output[2], 398);
+	EXPECT_EQ(output[3], -398);
+}
+
+TEST(TestVolume, simdMatchGeneric) {
+	static const float listVolume[] = {-0.1f, -6.0f, -25.0f, 0.0f, 3.0f, 12.0f, 60.0f};
+	etk::Vector<int16_t> input;
+	createAllInt16(input);
+	for (size_t iii=0; iii<sizeof(listVolume)/sizeof(float); ++iii) {
+		// the kernels are selected at the configuration
+		audio::drain::cpu::setSimdEnable(false);
+		ememory::SharedPtr<audio::drain::Volume> algoGeneric = createVolume(audio::format_int16, audio::format_int16, listVolume[iii]);
+		audio::drain::cpu::setSimdEnable(true);
+		ememory::SharedPtr<audio::drain::Volume> algoSimd = createVolume(audio::format_int16, audio::format_int16, listVolume[iii]);
+		etk::Vector<int16_t> reference;
+		etk::Vector<int16_t> output;
+		process(algoGeneric, input, reference);
+		process(algoSimd, input, output);
+		ASSERT_EQ(output.size(), reference.size());
+		size_t nbError = 0;
+		for (size_t jjj=0; jjj<output.size(); ++jjj) {
+			if (output[jjj] != reference[jjj]) {
+				nbError++;
+			}
+		}
+		EXPECT_EQ(nbError, 0);
+	}
+}
+
+TEST(TestVolume, precisionInt32) {
+	static const float listVolume[] = {-0.5f, -6.0f, 6.0f, 40.0f};
+	etk::Vector<int16_t> input;
+	createAllInt16(input);
+	for (size_t iii=0; iii<sizeof(listVolume)/sizeof(float); ++iii) {
+		ememory::SharedPtr<audio::drain::Volume> algo = createVolume(audio::format_int16, audio::format_int32, listVolume[iii]);
+		etk::Vector<int32_t> output;
+		process(algo, input, output);
+		ASSERT_EQ(output.size(), input.size());
+		double gain = pow(10.0, double(listVolume[iii])/20.0) * 65536.0;
+		double maxError = 0.0;
+		for (size_t jjj=0; jjj<input.size(); ++jjj) {
+			double reference = etk::min(etk::max(double(input[jjj])*gain, -2147483648.0), 2147483647.0);
+			maxError = etk::max(maxError, fabs(double(output[jjj]) - reference));
+		}
+		TEST_INFO(listVolume[iii] << "dB: max=" << maxError);
+		// Q30 coef on a 64 bits product: a few LSB of the int32 at full scale (no overflow on the gains > 1)
+		EXPECT_LT(maxError, 4.0);
+	}
+}
+
+TEST(TestVolume, stackedStages) {
+	etk::Vector<int16_t> input;
+	createAllInt16(input);
+	// 10 stages of -0.7dB == 1 stage of -7dB
+	ememory::SharedPtr<audio::drain::Volume> algoStacked = createVolume(audio::format_int16, audio::format_int16, -0.7f);
+	for (size_t iii=1; iii<10; ++iii) {
+		algoStacked->addVolumeStage(ememory::makeShared<audio::drain::VolumeElement>("STAGE_" + etk::toString(int32_t(iii)), -0.7f));
+	}
+	ememory::SharedPtr<audio::drain::Volume> algoSingle = createVolume(audio::format_int16, audio::format_int16, -7.0f);
+	etk::Vector<int16_t> reference;
+	etk::Vector<int16_t> output;
+	process(algoSingle, input, reference);
+	process(algoStacked, input, output);
+	ASSERT_EQ(output.size(), reference.size());
+	int32_t maxError = 0;
+	for (size_t iii=0; iii<output.size(); ++iii) {
+		maxError = etk::max(maxError, etk::abs(int32_t(output[iii]) - int32_t(reference[iii])));
+	}
+	EXPECT_LE(maxError, 1);
+}
+
+/**
+ * @brief Convert the format of a buffer with a FormatUpdate (stereo).
+ */
+template<typename TYPE_IN, typename TYPE_OUT>
+static void convert(enum audio::format _input, enum audio::format _output, etk::Vector<TYPE_IN>& _data, etk::Vector<TYPE_OUT>& _out) {
+	ememory::SharedPtr<audio::drain::FormatUpdate> algo = test::createAlgo<audio::drain::FormatUpdate>(audio::drain::IOFormatInterface(test::getMap(2), _input, 48000),
+	                                                                                                   audio::drain::IOFormatInterface(test::getMap(2), _output, 48000));
+	audio::Time time;
+	void* outputData = null;
+	size_t outputNbChunk = 0;
+	algo->process(time, &_data[0], _data.size()/2, outputData, outputNbChunk);
+	_out.resize(outputNbChunk*2);
+	memcpy(&_out[0], outputData, _out.size()*sizeof(TYPE_OUT));
+}
+
+TEST(TestVolume, fusedMatchUnfused) {
+	// the Volume fused with the FormatUpdate use the same int16 full scale as the FormatUpdate
+	static const float listVolume[] = {0.0f, -6.0f, -13.3f};
+	for (size_t iii=0; iii<sizeof(listVolume)/sizeof(float); ++iii) {
+		etk::Vector<int16_t> input;
+		createAllInt16(input);
+		// int16 -> float
+		etk::Vector<float> fused;
+		process(createVolume(audio::format_int16, audio::format_float, listVolume[iii]), input, fused);
+		etk::Vector<float> converted;
+		convert(audio::format_int16, audio::format_float, input, converted);
+		etk::Vector<float> unfused;
+		process(createVolume(audio::format_float, audio::format_float, listVolume[iii]), converted, unfused);
+		ASSERT_EQ(fused.size(), unfused.size());
+		size_t nbError = 0;
+		for (size_t jjj=0; jjj<fused.size(); ++jjj) {
+			if (fused[jjj] != unfused[jjj]) {
+				nbError++;
+			}
+		}
+		EXPECT_EQ(nbError, 0);
+		// float -> int16
+		etk::Vector<int16_t> fusedInt16;
+		process(createVolume(audio::format_float, audio::format_int16, listVolume[iii]), converted, fusedInt16);
+		etk::Vector<int16_t> unfusedInt16;
+		convert(audio::format_float, audio::format_int16, unfused, unfusedInt16);
+		ASSERT_EQ(fusedInt16.size(), unfusedInt16.size());
+		int32_t maxError = 0;
+		for (size_t jjj=0; jjj<fusedInt16.size(); ++jjj) {
+			maxError = etk::max(maxError, etk::abs(int32_t(fusedInt16[jjj]) - int32_t(unfusedInt16[jjj])));
+		}
+		// the FormatUpdate truncate: 1 LSB at most
+		EXPECT_LE(maxError, 1);
+	}
+}